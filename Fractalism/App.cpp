@@ -7,20 +7,21 @@ wxIMPLEMENT_APP(fractalism::App);
 namespace fractalism {
 
   bool App::OnInit() {
+    // Only the UI starts frames, headless runs would pile up spans.
+    Core::get<Timeline>().setEnabled(true);
     ui = new ui::UI();
+    Core::setStatusHandlers(
+      [](const std::string& message) { get<wxFrame>().GetStatusBar()->PushStatusText(message); },
+      []() { get<wxFrame>().GetStatusBar()->PopStatusText(); });
+    Core::setWarningHandler([](const std::string& message) { wxLogWarning("%s", message); });
     ui->Show(true);
     return true;
   }
 
   int App::OnExit() {
-    // When this method is called, the static instance is already cleared,
-    // but we need it to free the SVM.
-    wxAppConsole* instance = wxApp::GetInstance();
-    wxApp::SetInstance(this);
-    if (gpu) {
-      gpu->kernelManager.freeSvm();
-    }
-    wxApp::SetInstance(instance);
+    Core::setStatusHandlers(nullptr, nullptr);
+    Core::setWarningHandler(nullptr);
+    Core::shutdown();
     return wxApp::OnExit();
   }
 
@@ -42,6 +43,7 @@ namespace fractalism {
   }
 
   void App::render(std::vector<ui::ViewWindow*>& viewWindows) {
+    get<Timeline>().beginFrame();
     if (viewWindows.size()) {
       std::call_once(App::get<App>().setupGPU, [](std::vector<ui::ViewWindow*>& viewWindows) {
         std::optional<gpu::GPU>& gpu = App::get<App>().gpu;
@@ -58,7 +60,7 @@ namespace fractalism {
           throw AssertionError("Could not initialize GPU context.");
         }
         for (ui::ViewWindow* viewWindow : viewWindows) {
-          gpu->kernelManager.createBuffer();
+          App::get<gpu::opencl::ProgramManager>().createBuffer();
           viewWindow->init();
         }
       }, viewWindows);
@@ -68,11 +70,22 @@ namespace fractalism {
           viewWindow->maybeClearTexture();
         }
 
+        // The frame time is split between the windows still computing, by
+        // their priority.
+        cl_uint totalWeight = 0;
+        for (ui::ViewWindow *viewWindow : viewWindows) {
+          totalWeight += viewWindow->getSchedulingWeight();
+        }
+        for (ui::ViewWindow *viewWindow : viewWindows) {
+          viewWindow->setFrameBudget(totalWeight ?
+            gpu::opencl::FrameScheduler::frameTime * viewWindow->getSchedulingWeight() / totalWeight :
+            0.0);
+        }
+
         std::vector<cl::Event> waitEvents{}; // Not used yet.
         for (ui::ViewWindow *viewWindow : viewWindows) {
           viewWindow->enqueueRender(waitEvents);
         }
-        App::get<gpu::GPUContext>().queue.finish();
       } catch (const std::exception &e) {
         wxSafeShowMessage("Error", e.what());
         std::abort();
@@ -6,6 +6,7 @@
 #include <type_traits>
 #include <vector>
 
+#include <Fractalism/Core.hpp>
 #include <Fractalism/Exceptions.hpp>
 #include <Fractalism/GPU/GPU.hpp>
 #include <Fractalism/GPU/GPUContext.hpp>
@@ -58,7 +59,7 @@ public:
    * @param canvas The OpenGL canvas.
    */
   static inline void setGLContext(wxGLCanvas& canvas) {
-    get<gpu::GPUContext>().setCurrent(canvas);
+    get<gpu::GPU>().setCurrent(canvas);
   }
 
   /**
@@ -67,34 +68,8 @@ public:
   static inline void reloadShaders() { get<gpu::GPU>().reloadShaders(); }
 
   /**
-   * @brief Executes a callable with a status message.
-   * @tparam Callable The type of the callable.
-   * @tparam Args The types of the arguments to the callable.
-   * @param message The status message to display.
-   * @param callable The callable to execute.
-   * @param args The arguments to pass to the callable.
-   * @return The result of the callable.
-   */
-  template<typename Callable, typename... Args>
-  static inline std::invoke_result_t<Callable, Args...> doWithStatusMessage(
-      const std::string&& message,
-      Callable&& callable,
-      Args&&... args) {
-    wxStatusBar& statusBar = *get<wxFrame>().GetStatusBar();
-    statusBar.PushStatusText(message);
-    using Return = std::invoke_result_t<Callable, Args...>;
-    if constexpr (std::is_void_v<Return>) {
-      std::invoke(std::forward<Callable>(callable), std::forward<Args>(args)...);
-      statusBar.PopStatusText();
-    } else {
-      Return value = std::invoke(std::forward<Callable>(callable), std::forward<Args>(args)...);
-      statusBar.PopStatusText();
-      return value;
-    }
-  }
-
-  /**
-   * @brief Gets a reference to a specific type.
+   * @brief Gets a reference to a specific type. Display independent types are
+   * forwarded to Core::get.
    * @tparam T The type to get.
    * @return A reference to the requested type.
    */
@@ -103,8 +78,11 @@ public:
   get() {
     if constexpr (std::is_same_v<T, App>) {
       return *static_cast<App*>(wxApp::GetInstance());
-    } else if constexpr (std::is_same_v<T, Settings>) {
-      return get<App>().settings;
+    } else if constexpr (std::is_same_v<T, Settings>
+        || std::is_same_v<T, Timeline>
+        || std::is_same_v<T, gpu::GPUContext>
+        || std::is_same_v<T, gpu::opencl::ProgramManager>) {
+      return Core::get<T>();
     } else if constexpr (std::is_same_v<T, wxFrame>) {
       wxFrame* ui = get<App>().ui;
       if (ui == nullptr) {
@@ -118,10 +96,6 @@ public:
       } else [[unlikely]] {
         throw AssertionError("GPU manager has not been initialized.");
       }
-    } else if constexpr (std::is_same_v<T, gpu::GPUContext>) {
-      return get<gpu::GPU>().ctx;
-    } else if constexpr (std::is_same_v<T, gpu::opencl::ProgramManager>) {
-      return get<gpu::GPU>().kernelManager;
     } else if constexpr (std::is_same_v<T, gpu::opengl::GLShaderProgram>) {
       switch (get<Settings>().renderDimensions) {
       case options::Dimensions::two:
@@ -141,7 +115,6 @@ private:
   wxFrame* ui = nullptr;       ///< The main UI frame.
   std::once_flag setupGPU;     ///< Flag to ensure GPU setup is done once.
   std::optional<gpu::GPU> gpu; ///< The GPU manager.
-  Settings settings;           ///< The application settings.
 };
 } // namespace fractalism
 
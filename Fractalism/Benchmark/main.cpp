@@ -0,0 +1,394 @@
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <Fractalism/Core.hpp>
+#include <Fractalism/GPU/OpenCL/ImageTarget.hpp>
+#include <Fractalism/GPU/OpenCL/KernelExecutor.hpp>
+
+namespace fractalism::benchmark {
+  static constexpr const char usage[] =
+    "Usage: fractalism-benchmark [OPTION]...\n"
+    "\n"
+    "Times every generated kernel variant over a fixed set of viewspaces, in 2D\n"
+    "and 3D and in every precision the device supports, and writes the results\n"
+    "as JSON.\n"
+    "\n"
+    "  --output FILE       Where to write the report. Defaults to benchmark.json.\n"
+    "  --device-type TYPE  cpu, gpu or all. Defaults to cpu, so results are\n"
+    "                      comparable between machines running PoCL.\n"
+    "  --platform NAME     Only use platforms whose name contains NAME.\n"
+    "  --filter TEXT       Only run kernels whose name contains TEXT.\n"
+    "  --resolution-2d N   Edge length of the 2D runs. Defaults to 512.\n"
+    "  --resolution-3d N   Edge length of the 3D runs. Defaults to 64.\n"
+    "  --iterations N      Iterations per enqueue in escape mode. Defaults to 100.\n"
+    "  --repeats N         Timed enqueues per case. Defaults to 10.\n"
+    "  --help              Show this message.\n";
+
+  /**
+   * @struct Corpus
+   * @brief A viewspace every kernel variant is timed with.
+   */
+  struct Corpus {
+    const char* name; ///< Identifies the viewspace in the report.
+    real x;           ///< X-coordinate of the center.
+    real y;           ///< Y-coordinate of the center.
+    real zoom;        ///< Zoom level.
+  };
+
+  // Mostly escaping, mostly on the boundary, and mostly bounded, which is the
+  // worst case since no pixel stops early. The deep one is past
+  // Viewspace::zoomLimit() in either precision, around the Misiurewicz point
+  // i, so escape mode times the perturbed kernels.
+  static constexpr Corpus corpus[] = {
+    {"overview", -0.5, 0.0, 0.5},
+    {"boundary", -0.7435, 0.1314, 200.0},
+    {"interior", -0.15, 0.0, 3.0},
+    {"deep", 0.0, 1.0, 1.0e12}
+  };
+
+  static constexpr options::Space spaces[] = {
+    options::Space::phase,
+    options::Space::dynamical
+  };
+
+  static constexpr options::RenderMode renderModes[] = {
+    options::RenderMode::escape,
+    options::RenderMode::translated
+  };
+
+  static constexpr options::NumberSystem numberSystems[] = {
+    options::NumberSystem::complex,
+    options::NumberSystem::bicomplex,
+    options::NumberSystem::quaternion
+  };
+
+  /**
+   * @struct Arguments
+   * @brief The parsed command line.
+   */
+  struct Arguments {
+    std::string output = "benchmark.json";
+    gpu::DeviceSelection selection{.deviceType = CL_DEVICE_TYPE_CPU, .platformName = {}, .profiling = true};
+    std::string filter;
+    cl::size_type resolution2D = 512;
+    cl::size_type resolution3D = 64;
+    cl_uint iterations = 100;
+    size_t repeats = 10;
+  };
+
+  /**
+   * @struct Result
+   * @brief The measurements of one kernel variant with one viewspace.
+   */
+  struct Result {
+    std::string kernel;                          ///< The kernel name.
+    options::Precision precision;                ///< The precision of the kernel.
+    const Corpus* view;                          ///< The viewspace.
+    options::Dimensions dimensions;              ///< 2D or 3D.
+    cl::size_type resolution;                    ///< Edge length of the output.
+    std::optional<cl_ulong> privateMemSize;      ///< CL_KERNEL_PRIVATE_MEM_SIZE, if there is a device.
+    std::optional<size_t> workGroupSizeMultiple; ///< CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE, if there is a device.
+    std::vector<double> enqueueSeconds;          ///< Host time from enqueue to completion.
+    std::vector<double> kernelSeconds;           ///< Device time of the kernel alone, if profiled.
+    cl_ulong pixelIterations = 0;                ///< Upper bound of iterations done over all timed enqueues.
+    std::string error;                           ///< Why the case failed, empty on success.
+  };
+
+  static std::string escape(std::string_view text) {
+    std::string result;
+    for (char c : text) {
+      switch (c) {
+      case '"':
+        result += "\\\"";
+        break;
+      case '\\':
+        result += "\\\\";
+        break;
+      case '\n':
+        result += "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          result += std::format("\\u{:04x}", c);
+        } else {
+          result += c;
+        }
+      }
+    }
+    return result;
+  }
+
+  static std::string statistics(std::vector<double> samples) {
+    if (samples.empty()) {
+      return "null";
+    }
+    std::sort(samples.begin(), samples.end());
+    double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    return std::format(R"({{"min": {:e}, "median": {:e}, "mean": {:e}, "max": {:e}}})",
+      samples.front(), samples[samples.size() / 2], mean, samples.back());
+  }
+
+  template<typename T>
+  static std::string orNull(const std::optional<T>& value) {
+    return value ? std::format("{}", *value) : "null";
+  }
+
+  static void runCase(
+      Result& result,
+      gpu::opencl::KernelExecutor& kernel,
+      const Arguments& arguments,
+      bool perturbed) {
+    const gpu::GPUContext& ctx = Core::get<gpu::GPUContext>();
+    if (ctx.hasDevice()) {
+      cl::Kernel clKernel = Core::get<gpu::opencl::ProgramManager>().findKernel(
+        result.kernel,
+        result.precision,
+        Core::get<Settings>().numberSystem,
+        gpu::types::workStoreLayout(kernel.settings.renderMode, perturbed));
+      result.privateMemSize = clKernel.getWorkGroupInfo<CL_KERNEL_PRIVATE_MEM_SIZE>(ctx.device);
+      result.workGroupSizeMultiple = clKernel.getWorkGroupInfo<CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE>(ctx.device);
+    }
+    kernel.updateKernel();
+    kernel.waitForKernel();
+    kernel.clearTexture();
+
+    const cl::NDRange& range = Core::get<Settings>().resolution;
+    cl_ulong pixels = 1;
+    for (cl::size_type i = 0; i < range.dimensions(); i++) {
+      pixels *= range[i];
+    }
+
+    const bool restart = kernel.settings.renderMode == options::RenderMode::escape;
+    std::vector<cl::Event> waitEvents{};
+    // The first enqueue is not timed, some runtimes finish compiling lazily.
+    for (size_t i = 0; i <= arguments.repeats; i++) {
+      if (restart || !kernel.needsMore()) {
+        // Restart, so every sample runs the same iterations.
+        kernel.updateView();
+      }
+      cl_uint before = kernel.getCurrentIteration();
+      auto start = std::chrono::steady_clock::now();
+      cl::Event done = kernel.enqueue(waitEvents);
+      if (done()) {
+        done.wait();
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      if (i == 0) {
+        continue;
+      }
+      result.enqueueSeconds.push_back(elapsed.count());
+      result.pixelIterations += pixels * (kernel.getCurrentIteration() - before);
+      const cl::Event& kernelEvent = kernel.getKernelEvent();
+      if (done() && kernelEvent()) {
+        cl_ulong kernelStart = kernelEvent.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+        cl_ulong kernelEnd = kernelEvent.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+        result.kernelSeconds.push_back((kernelEnd - kernelStart) * 1.0e-9);
+      }
+    }
+  }
+
+  static void writeReport(const Arguments& arguments, const std::vector<Result>& results) {
+    std::ofstream stream(arguments.output);
+    if (!stream) {
+      throw FractalismError(std::format("Could not open {} for writing", arguments.output));
+    }
+    const gpu::GPUContext& ctx = Core::get<gpu::GPUContext>();
+    if (ctx.hasDevice()) {
+      stream << std::format(
+        "{{\n  \"device\": {{\"name\": \"{}\", \"version\": \"{}\", \"driver\": \"{}\"}},\n",
+        escape(ctx.device.getInfo<CL_DEVICE_NAME>()),
+        escape(ctx.device.getInfo<CL_DEVICE_VERSION>()),
+        escape(ctx.device.getInfo<CL_DRIVER_VERSION>()));
+    } else {
+      stream << "{\n  \"device\": {\"name\": \"host\", \"version\": null, \"driver\": null},\n";
+    }
+    stream << std::format("  \"iterationsPerEnqueue\": {},\n  \"repeats\": {},\n  \"results\": [",
+      arguments.iterations, arguments.repeats);
+
+    for (size_t i = 0; i < results.size(); i++) {
+      const Result& result = results[i];
+      // Device time is the better measure, host time also counts the launch
+      // overhead.
+      const std::vector<double>& seconds = result.kernelSeconds.empty() ? result.enqueueSeconds : result.kernelSeconds;
+      double total = std::accumulate(seconds.begin(), seconds.end(), 0.0);
+      stream << std::format(
+        "{}\n    {{\"kernel\": \"{}\", \"precision\": \"{}\", \"viewspace\": \"{}\", \"dimensions\": {}, \"resolution\": {}, "
+        "\"privateMemSize\": {}, \"preferredWorkGroupSizeMultiple\": {}, "
+        "\"enqueueSeconds\": {}, \"kernelSeconds\": {}, \"pixelIterationsPerSecond\": {}",
+        i ? "," : "",
+        result.kernel,
+        options::name(result.precision),
+        result.view->name,
+        result.dimensions == options::Dimensions::two ? 2 : 3,
+        result.resolution,
+        orNull(result.privateMemSize),
+        orNull(result.workGroupSizeMultiple),
+        statistics(result.enqueueSeconds),
+        statistics(result.kernelSeconds),
+        total > 0.0 ? std::format("{:e}", result.pixelIterations / total) : "null");
+      if (!result.error.empty()) {
+        stream << std::format(", \"error\": \"{}\"", escape(result.error));
+      }
+      stream << "}";
+    }
+    stream << "\n  ]\n}\n";
+  }
+
+  static int parseCount(int argc, char** argv, int& i) {
+    std::string_view name = argv[i];
+    if (++i == argc) {
+      throw FractalismError(std::format("{} needs a value", name));
+    }
+    int value = 0;
+    try {
+      value = std::stoi(argv[i]);
+    } catch (const std::exception&) {}
+    if (value <= 0) {
+      throw FractalismError(std::format("{} must be a positive number", name));
+    }
+    return value;
+  }
+
+  static Arguments parseArguments(int argc, char** argv) {
+    Arguments arguments;
+    for (int i = 1; i < argc; i++) {
+      std::string_view arg = argv[i];
+      if (arg == "--resolution-2d") {
+        arguments.resolution2D = parseCount(argc, argv, i);
+      } else if (arg == "--resolution-3d") {
+        arguments.resolution3D = parseCount(argc, argv, i);
+      } else if (arg == "--iterations") {
+        arguments.iterations = parseCount(argc, argv, i);
+      } else if (arg == "--repeats") {
+        arguments.repeats = parseCount(argc, argv, i);
+      } else if (arg == "--output" || arg == "--device-type" || arg == "--platform" || arg == "--filter") {
+        if (++i == argc) {
+          throw FractalismError(std::format("{} needs a value", arg));
+        }
+        std::string value = argv[i];
+        if (arg == "--output") {
+          arguments.output = value;
+        } else if (arg == "--platform") {
+          arguments.selection.platformName = value;
+        } else if (arg == "--filter") {
+          arguments.filter = value;
+        } else if (value == "cpu") {
+          arguments.selection.deviceType = CL_DEVICE_TYPE_CPU;
+        } else if (value == "gpu") {
+          arguments.selection.deviceType = CL_DEVICE_TYPE_GPU;
+        } else if (value == "all") {
+          arguments.selection.deviceType = CL_DEVICE_TYPE_ALL;
+        } else {
+          throw FractalismError(std::format("'{}' is not a valid device type", value));
+        }
+      } else {
+        throw FractalismError(std::format("Unknown option '{}'", arg));
+      }
+    }
+    return arguments;
+  }
+
+  static int run(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+      if (std::string_view(argv[i]) == "--help" || std::string_view(argv[i]) == "-h") {
+        std::cout << usage;
+        return 0;
+      }
+    }
+    Arguments arguments;
+    try {
+      arguments = parseArguments(argc, argv);
+    } catch (const FractalismError& e) {
+      std::cerr << e.what() << "\n\n" << usage;
+      return 2;
+    }
+
+    Core::setStatusHandlers([](const std::string& message) { std::clog << message << std::endl; }, nullptr);
+    Core::initCompute(arguments.selection);
+    Settings& settings = Core::get<Settings>();
+    settings.viewWindowSettings.assign(1, ViewWindowSettings(options::Space::phase, options::RenderMode::escape));
+    Core::get<gpu::opencl::ProgramManager>().createBuffer();
+
+    std::vector<options::Precision> precisions;
+    for (options::Precision precision : {options::Precision::fp32, options::Precision::fp64}) {
+      if (Core::get<gpu::GPUContext>().hasDevice()
+          ? Core::get<gpu::opencl::ProgramManager>().supports(precision)
+          : precision == gpu::types::hostPrecision) {
+        precisions.push_back(precision);
+      }
+    }
+
+    gpu::opencl::ImageTarget target;
+    gpu::opencl::KernelExecutor kernel(0, target);
+    std::vector<Result> results;
+    int failures = 0;
+    for (auto [dimensions, resolution] : {
+        std::pair(options::Dimensions::two, arguments.resolution2D),
+        std::pair(options::Dimensions::three, arguments.resolution3D)}) {
+      settings.renderDimensions = dimensions;
+      settings.setResolution(resolution);
+      Core::get<gpu::opencl::ProgramManager>().updateResolution();
+      for (const Corpus& view : corpus) {
+        for (options::Precision precision : precisions) {
+          for (options::Space space : spaces) {
+            for (options::RenderMode renderMode : renderModes) {
+              for (options::NumberSystem numberSystem : numberSystems) {
+                const bool perturbed = renderMode == options::RenderMode::escape
+                  && view.zoom > gpu::types::Viewspace::zoomLimit(precision, numberSystem, resolution);
+                std::string name = options::kernelName(space, renderMode, numberSystem, perturbed);
+                if (name.find(arguments.filter) == std::string::npos) {
+                  continue;
+                }
+                settings.numberSystem = numberSystem;
+                settings.precision = precision;
+                // The kernel executor holds a reference to this element.
+                ViewWindowSettings& window = settings.viewWindowSettings[0];
+                window = ViewWindowSettings(space, renderMode);
+                window.view.center = gpu::types::Number(view.x, view.y, 0.0);
+                window.view.zoom = view.zoom;
+                window.iterationsPerFrame = arguments.iterations;
+
+                std::clog << std::format("Timing {} in {} precision on {} in {}D", name, options::name(precision),
+                  view.name, dimensions == options::Dimensions::two ? 2 : 3) << std::endl;
+                Result& result = results.emplace_back(name, precision, &view, dimensions, resolution);
+                try {
+                  runCase(result, kernel, arguments, perturbed);
+                } catch (const std::exception& e) {
+                  // Keep going, so one broken variant still leaves numbers for
+                  // the rest.
+                  result.error = e.what();
+                  std::cerr << std::format("{} failed: {}", name, e.what()) << std::endl;
+                  failures++;
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+    writeReport(arguments, results);
+    std::clog << std::format("Wrote {} results to {}", results.size(), arguments.output) << std::endl;
+    return failures ? 1 : 0;
+  }
+}
+
+int main(int argc, char** argv) {
+  int result;
+  try {
+    result = fractalism::benchmark::run(argc, argv);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    result = 1;
+  }
+  fractalism::Core::shutdown();
+  return result;
+}
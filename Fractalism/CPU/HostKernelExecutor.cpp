@@ -0,0 +1,87 @@
+#include <Fractalism/CPU/HostKernelExecutor.hpp>
+
+#include <algorithm>
+#include <format>
+
+#include <Fractalism/CPU/ThreadPool.hpp>
+#include <Fractalism/Exceptions.hpp>
+
+namespace fractalism::cpu {
+  HostKernelExecutor::HostKernelExecutor() :
+        kernel(nullptr),
+        output{nullptr, 0, 0, 0},
+        workStore(),
+        volume(),
+        scatters(false),
+        writes(),
+        reference(nullptr),
+        referenceLength(0) {}
+
+  void HostKernelExecutor::setKernel(const std::string& name) {
+    host_kernel found = find_host_kernel(name.c_str());
+    if (!found) {
+      throw AssertionError(std::format("No host kernel named '{}'", name));
+    }
+    kernel = found;
+    scatters = host_kernel_scatters(name.c_str());
+    if (!scatters) {
+      writes = {};
+    }
+  }
+
+  void HostKernelExecutor::resize(const cl::NDRange& range) {
+    size_t itemCount = range[0] * range[1] * range[2];
+    workStore.assign(gpu::types::workStoreBlockCount(range), gpu::types::WorkStoreBlock{});
+    volume.assign(itemCount * 4, 0);
+    writes = {};
+    output = {volume.data(), range[0], range[1], range[2]};
+  }
+
+  void HostKernelExecutor::clear() {
+    std::fill(volume.begin(), volume.end(), cl_uchar(0));
+  }
+
+  void HostKernelExecutor::run(
+      const gpu::types::cltypes::viewspace& view,
+      const gpu::types::Number& parameter,
+      cl_uint lastIteration,
+      cl_uint maxIterations,
+      cl_uint totalIterations) {
+    if (!kernel) {
+      throw AssertionError("Host kernel has not been set.");
+    }
+    if (scatters) {
+      writes.resize(output.width * output.height * output.depth);
+    }
+    const host_kernel_args args = {
+      .output = &output,
+      .store = workStore.data(),
+      .view = view,
+      .parameter = parameter,
+      .last_iteration = lastIteration,
+      .max_iterations = maxIterations,
+      .total_iterations = totalIterations,
+      .reference = reference,
+      .reference_length = referenceLength,
+      .writes = scatters ? writes.data() : nullptr
+    };
+    // 2D tiles in x and y, one slice of z per tile.
+    const size_t tilesX = (output.width + tileSize - 1) / tileSize;
+    const size_t tilesY = (output.height + tileSize - 1) / tileSize;
+    const host_kernel run = kernel;
+    // The translated kernels write to texels owned by other tiles. Their
+    // writes are deferred and applied afterwards, in work item order.
+    ThreadPool::shared().parallelFor(tilesX * tilesY * output.depth, [&](size_t index) {
+      size_t x = (index % tilesX) * tileSize;
+      size_t y = ((index / tilesX) % tilesY) * tileSize;
+      size_t z = index / (tilesX * tilesY);
+      run(&args, host_tile{
+        .begin = {x, y, z},
+        .end = {std::min(x + tileSize, output.width), std::min(y + tileSize, output.height), z + 1}
+      });
+    });
+    if (scatters) {
+      apply_host_writes(&output, writes.data(), writes.size());
+    }
+  }
+}
@@ -0,0 +1,88 @@
+#ifndef _FRACTALISM_HOST_KERNEL_EXECUTOR_HPP_
+#define _FRACTALISM_HOST_KERNEL_EXECUTOR_HPP_
+
+#include <string>
+#include <vector>
+
+#include <Fractalism/CPU/HostKernels.h>
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+#include <Fractalism/GPU/Types.hpp>
+
+namespace fractalism::cpu {
+
+/**
+ * @class HostKernelExecutor
+ * @brief Runs the host-compiled kernels on the shared ThreadPool, for when
+ * there is no OpenCL device.
+ */
+class HostKernelExecutor {
+public:
+  static constexpr size_t tileSize = 16; ///< Tile width and height, in work items.
+
+  /**
+   * @brief Constructs a HostKernelExecutor with no kernel or storage.
+   */
+  HostKernelExecutor();
+
+  /**
+   * @brief Selects the kernel to run.
+   * @param name The kernel name, as built by options::kernelName().
+   * @throws AssertionError if there is no host kernel with that name.
+   */
+  void setKernel(const std::string& name);
+
+  /**
+   * @brief Resizes the work store and output volume.
+   * @param range The global work size.
+   */
+  void resize(const cl::NDRange& range);
+
+  /**
+   * @brief Clears the output volume.
+   */
+  void clear();
+
+  /**
+   * @brief Sets the reference orbit the perturbed kernels iterate relative to.
+   * @param points The orbit points. Must stay valid until the next call.
+   * @param length The number of orbit points.
+   */
+  inline void setReference(const real* points, cl_uint length) {
+    reference = points;
+    referenceLength = length;
+  }
+
+  /**
+   * @brief Runs the kernel over the whole range, and waits for it to finish.
+   * @param view The viewspace.
+   * @param parameter The fractal parameter.
+   * @param lastIteration The iteration the last run stopped at.
+   * @param maxIterations The iteration to stop at.
+   * @param totalIterations The iteration limit the colors are relative to.
+   */
+  void run(
+      const gpu::types::cltypes::viewspace& view,
+      const gpu::types::Number& parameter,
+      cl_uint lastIteration,
+      cl_uint maxIterations,
+      cl_uint totalIterations);
+
+  /**
+   * @brief Gets the RGBA8 output volume.
+   * @return The output volume data.
+   */
+  inline const cl_uchar* data() const { return volume.data(); }
+
+private:
+  host_kernel kernel;                                ///< The kernel to run.
+  host_volume output;                                ///< Describes the output volume.
+  std::vector<gpu::types::WorkStoreBlock> workStore; ///< The work store, one block per WORK_STORE_BLOCK_SIZE work items.
+  std::vector<cl_uchar> volume;                      ///< The output volume.
+  bool scatters;                                     ///< Whether the kernel writes the texels of other work items.
+  std::vector<host_texel_write> writes;              ///< The deferred writes of a scattering kernel, one per work item.
+  const real* reference;                             ///< The reference orbit of the perturbed kernels.
+  cl_uint referenceLength;                           ///< The number of reference orbit points.
+};
+} // namespace fractalism::cpu
+
+#endif
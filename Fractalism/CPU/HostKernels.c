@@ -0,0 +1,178 @@
+// Compiles KernelHeaders/kernels.h with the host C compiler.
+// interop.h takes care of the OpenCL keywords and vector types; the work-item
+// and image functions the kernels use are provided here.
+
+#define _USE_MATH_DEFINES
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <Fractalism/CPU/HostKernels.h>
+
+#if defined(_MSC_VER)
+  #include <intrin.h>
+  #define _THREAD_LOCAL_ __declspec(thread)
+#else
+  #include <stdatomic.h>
+  #define _THREAD_LOCAL_ _Thread_local
+#endif
+
+// Set per work item by the tile loops below.
+static _THREAD_LOCAL_ size_t host_global_id[3];
+static _THREAD_LOCAL_ size_t host_global_size[3];
+
+#define get_global_id(dimension) host_global_id[dimension]
+#define get_global_size(dimension) host_global_size[dimension]
+
+typedef host_volume* image3d_t;
+
+#define get_image_width(image) ((image)->width)
+#define get_image_height(image) ((image)->height)
+#define get_image_depth(image) ((image)->depth)
+
+// The host kernels are launched without active item lists, but the kernels
+// count them all the same.
+#if defined(_MSC_VER)
+  #define atomic_inc(pointer) ((unsigned int)_InterlockedIncrement((volatile long*)(pointer)) - 1u)
+#else
+  #define atomic_inc(pointer) atomic_fetch_add_explicit((_Atomic unsigned int*)(pointer), 1u, memory_order_relaxed)
+#endif
+
+// Where the work item of a scattering kernel defers its write to, set per
+// work item by the tile loops below. NULL for the other kernels.
+static _THREAD_LOCAL_ host_texel_write* host_write;
+
+static inline cl_uchar to_unorm_int8(float value) {
+  return (cl_uchar)(fminf(fmaxf(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+static inline void write_imagef(image3d_t image, int4 coord, float4 color) {
+  size_t index = (((size_t)coord.z * image->height) + (size_t)coord.y) * image->width + (size_t)coord.x;
+  cl_uchar* texel = image->data + 4 * index;
+  if (host_write) {
+    // Other threads may write the texel, see host_texel_write.
+    host_write->texel = (cl_uint)index;
+    texel = host_write->color;
+  }
+  texel[0] = to_unorm_int8(color.x);
+  texel[1] = to_unorm_int8(color.y);
+  texel[2] = to_unorm_int8(color.z);
+  texel[3] = to_unorm_int8(color.w);
+}
+
+// The work store is one contiguous host allocation.
+#define WORK_STORE_BUFFER_BYTES SIZE_MAX
+
+// The same formula as the OpenCL programs, with every number system in one
+// program.
+#include <Fractalism/KernelHeaders/formula.h>
+#define NUMBER_SYSTEMS \
+  cayley_dickson_construction(complex, real) \
+  cayley_dickson_construction(quaternion, complex) \
+  multicomplex_construction(bicomplex, complex)
+
+#include <Fractalism/KernelHeaders/kernels.h>
+
+#define define_host_kernel_loops(name, invocation) \
+static void host_##name(const host_kernel_args* args, host_tile tile) { \
+  work_store_buffer buffer = { args->store }; \
+  host_global_size[0] = args->output->width; \
+  host_global_size[1] = args->output->height; \
+  host_global_size[2] = args->output->depth; \
+  for (size_t z = tile.begin[2]; z < tile.end[2]; z++) { \
+    host_global_id[2] = z; \
+    for (size_t y = tile.begin[1]; y < tile.end[1]; y++) { \
+      host_global_id[1] = y; \
+      for (size_t x = tile.begin[0]; x < tile.end[0]; x++) { \
+        host_global_id[0] = x; \
+        host_write = args->writes ? &args->writes[(z * host_global_size[1] + y) * host_global_size[0] + x] : NULL; \
+        if (host_write) { \
+          host_write->texel = HOST_NO_TEXEL; \
+        } \
+        invocation; \
+      } \
+    } \
+  } \
+  host_write = NULL; \
+}
+
+#define host_kernel_arguments \
+  args->output, \
+  &buffer, \
+  NULL, \
+  args->view, \
+  args->parameter, \
+  args->last_iteration, \
+  args->max_iterations, \
+  args->total_iterations, \
+  NULL, \
+  NULL, \
+  NULL
+
+#define define_host_kernel(name) \
+  define_host_kernel_loops(name, name(host_kernel_arguments))
+#define define_host_perturbed_kernel(name) \
+  define_host_kernel_loops(name, name(host_kernel_arguments, args->reference, args->reference_length))
+
+#define X(number_system, ...) \
+  define_host_kernel(phase_escape_##number_system) \
+  define_host_kernel(phase_translated_##number_system) \
+  define_host_kernel(dynamical_escape_##number_system) \
+  define_host_kernel(dynamical_translated_##number_system) \
+  define_host_perturbed_kernel(phase_escape_perturbed_##number_system) \
+  define_host_perturbed_kernel(dynamical_escape_perturbed_##number_system)
+NUMBER_SYSTEMS
+#undef X
+
+typedef struct host_kernel_entry {
+  const char* name;
+  host_kernel kernel;
+  bool scatters;
+} host_kernel_entry;
+
+static const host_kernel_entry host_kernels[] = {
+#define X(number_system, ...) \
+  { "phase_escape_" #number_system, host_phase_escape_##number_system, false }, \
+  { "phase_translated_" #number_system, host_phase_translated_##number_system, true }, \
+  { "dynamical_escape_" #number_system, host_dynamical_escape_##number_system, false }, \
+  { "dynamical_translated_" #number_system, host_dynamical_translated_##number_system, true }, \
+  { "phase_escape_perturbed_" #number_system, host_phase_escape_perturbed_##number_system, false }, \
+  { "dynamical_escape_perturbed_" #number_system, host_dynamical_escape_perturbed_##number_system, false },
+NUMBER_SYSTEMS
+#undef X
+};
+
+#undef define_host_perturbed_kernel
+#undef define_host_kernel
+#undef host_kernel_arguments
+#undef define_host_kernel_loops
+
+static const host_kernel_entry* find_host_kernel_entry(const char* name) {
+  for (size_t i = 0; i < sizeof(host_kernels) / sizeof(host_kernels[0]); i++) {
+    if (strcmp(host_kernels[i].name, name) == 0) {
+      return &host_kernels[i];
+    }
+  }
+  return NULL;
+}
+
+host_kernel find_host_kernel(const char* name) {
+  const host_kernel_entry* entry = find_host_kernel_entry(name);
+  return entry ? entry->kernel : NULL;
+}
+
+bool host_kernel_scatters(const char* name) {
+  const host_kernel_entry* entry = find_host_kernel_entry(name);
+  return entry && entry->scatters;
+}
+
+void apply_host_writes(host_volume* output, const host_texel_write* writes, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (writes[i].texel != HOST_NO_TEXEL) {
+      memcpy(output->data + 4 * (size_t)writes[i].texel, writes[i].color, 4);
+    }
+  }
+}
@@ -0,0 +1,99 @@
+#ifndef _FRACTALISM_HOST_KERNELS_H_
+#define _FRACTALISM_HOST_KERNELS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+  // The kernel types live in gpu::types::cltypes on the C++ side.
+  #include <Fractalism/GPU/Types.hpp>
+  namespace fractalism::cpu {
+  using gpu::types::cltypes::number;
+  using gpu::types::cltypes::viewspace;
+  using gpu::types::cltypes::work_store_block;
+  extern "C" {
+#else
+  #include <Fractalism/KernelHeaders/cltypes.h>
+#endif
+
+/**
+ * @brief An RGBA8 volume that stands in for the image3d_t kernel output.
+ */
+typedef struct host_volume {
+  cl_uchar* data; ///< width * height * depth texels, 4 bytes each.
+  size_t width;   ///< The width of the volume.
+  size_t height;  ///< The height of the volume.
+  size_t depth;   ///< The depth of the volume.
+} host_volume;
+
+/**
+ * @brief The half-open box of work items [begin, end) to run.
+ */
+typedef struct host_tile {
+  size_t begin[3]; ///< The first work item of the tile.
+  size_t end[3];   ///< One past the last work item of the tile.
+} host_tile;
+
+/**
+ * @brief The texel a work item of the translated kernels writes, which is the
+ * texel of another work item. The writes are deferred and applied in work item
+ * order by apply_host_writes(), so no two threads write the same texel.
+ */
+typedef struct host_texel_write {
+  cl_uint texel;     ///< The index of the texel, HOST_NO_TEXEL if the work item wrote none.
+  cl_uchar color[4]; ///< The RGBA8 color.
+} host_texel_write;
+
+#define HOST_NO_TEXEL 0xFFFFFFFFu
+
+/**
+ * @brief The arguments of a kernel invocation, shared by every tile.
+ */
+typedef struct host_kernel_args {
+  host_volume* output;      ///< The output volume. Its size is the global size.
+  work_store_block* store;  ///< One work store block per WORK_STORE_BLOCK_SIZE work items.
+  viewspace view;           ///< The viewspace.
+  number parameter;         ///< The fractal parameter.
+  cl_uint last_iteration;   ///< The iteration the last invocation stopped at.
+  cl_uint max_iterations;   ///< The iteration to stop at.
+  cl_uint total_iterations; ///< The iteration limit the colors are relative to.
+  const real* reference;    ///< Perturbed kernels: the reference orbit.
+  cl_uint reference_length; ///< Perturbed kernels: the number of reference orbit points.
+  host_texel_write* writes; ///< Kernels that scatter: one write per work item, NULL for the others.
+} host_kernel_args;
+
+/**
+ * @brief Runs a kernel over a single tile.
+ */
+typedef void (*host_kernel)(const host_kernel_args* args, host_tile tile);
+
+/**
+ * @brief Finds a host-compiled kernel by name.
+ * @param name The kernel name, as built by options::kernelName().
+ * @return The kernel, or NULL if there is no kernel with that name.
+ */
+host_kernel find_host_kernel(const char* name);
+
+/**
+ * @brief Checks if a host-compiled kernel writes to the texels of other work
+ * items, which it then defers to host_kernel_args::writes.
+ * @param name The kernel name, as built by options::kernelName().
+ * @return True for the translated kernels.
+ */
+bool host_kernel_scatters(const char* name);
+
+/**
+ * @brief Applies the deferred writes of a scattering kernel, in work item
+ * order, so the last work item to write a texel wins.
+ * @param output The output volume.
+ * @param writes One write per work item.
+ * @param count The number of work items.
+ */
+void apply_host_writes(host_volume* output, const host_texel_write* writes, size_t count);
+
+#if defined(__cplusplus)
+  } // extern "C"
+  } // namespace fractalism::cpu
+#endif
+
+#endif // !_FRACTALISM_HOST_KERNELS_H_
@@ -0,0 +1,146 @@
+#include <Fractalism/CPU/ThreadPool.hpp>
+
+#include <algorithm>
+#include <utility>
+
+namespace fractalism::cpu {
+  ThreadPool::ThreadPool(size_t threadCount) :
+        workers(),
+        job(nullptr),
+        remaining(0),
+        error(),
+        generation(0),
+        stopping(false) {
+    // The calling thread also runs tasks, so it counts as one of the threads.
+    size_t workerCount = std::max<size_t>(threadCount, 1) - 1;
+    workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++) {
+      workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < workerCount; i++) {
+      workers[i]->thread = std::thread(&ThreadPool::work, this, i);
+    }
+  }
+
+  ThreadPool::~ThreadPool() {
+    {
+      std::lock_guard lock(stateMutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (std::unique_ptr<Worker>& worker : workers) {
+      worker->thread.join();
+    }
+  }
+
+  void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) {
+      return;
+    }
+    std::lock_guard jobLock(jobMutex);
+    if (workers.empty()) {
+      for (size_t i = 0; i < count; i++) {
+        task(i);
+      }
+      return;
+    }
+
+    // Publish the job before any task becomes visible. A worker still
+    // finishing the last job may pick up one of these tasks straight away.
+    {
+      std::lock_guard lock(stateMutex);
+      job = &task;
+      error = nullptr;
+      remaining = count;
+    }
+
+    // Hand each worker a contiguous run of indices, so neighbouring tiles
+    // stay on the same thread until someone has to steal them.
+    size_t perWorker = count / workers.size();
+    size_t extra = count % workers.size();
+    size_t next = 0;
+    for (size_t i = 0; i < workers.size(); i++) {
+      size_t runLength = perWorker + (i < extra ? 1 : 0);
+      std::lock_guard lock(workers[i]->mutex);
+      for (size_t j = 0; j < runLength; j++) {
+        workers[i]->tasks.push_back(next++);
+      }
+    }
+
+    {
+      std::lock_guard lock(stateMutex);
+      generation++;
+    }
+    wake.notify_all();
+
+    // Help out, rather than sitting idle.
+    runTasks(0);
+
+    std::unique_lock lock(stateMutex);
+    done.wait(lock, [this] { return remaining == 0; });
+    job = nullptr;
+    if (error) {
+      std::rethrow_exception(std::exchange(error, nullptr));
+    }
+  }
+
+  ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  void ThreadPool::work(size_t self) {
+    size_t lastGeneration = 0;
+    while (true) {
+      {
+        std::unique_lock lock(stateMutex);
+        wake.wait(lock, [this, lastGeneration] { return stopping || generation != lastGeneration; });
+        if (stopping) {
+          return;
+        }
+        lastGeneration = generation;
+      }
+      runTasks(self);
+    }
+  }
+
+  void ThreadPool::runTasks(size_t self) {
+    size_t index;
+    while (true) {
+      bool found = take(*workers[self], false, index);
+      for (size_t i = 1; !found && i < workers.size(); i++) {
+        found = take(*workers[(self + i) % workers.size()], true, index);
+      }
+      if (!found) {
+        return;
+      }
+      try {
+        (*job)(index);
+      } catch (...) {
+        std::lock_guard lock(stateMutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+      }
+      if (--remaining == 0) {
+        std::lock_guard lock(stateMutex);
+        done.notify_all();
+      }
+    }
+  }
+
+  bool ThreadPool::take(Worker& worker, bool steal, size_t& index) {
+    std::lock_guard lock(worker.mutex);
+    if (worker.tasks.empty()) {
+      return false;
+    }
+    if (steal) {
+      index = worker.tasks.back();
+      worker.tasks.pop_back();
+    } else {
+      index = worker.tasks.front();
+      worker.tasks.pop_front();
+    }
+    return true;
+  }
+}
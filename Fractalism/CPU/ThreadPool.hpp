@@ -0,0 +1,107 @@
+#ifndef _FRACTALISM_THREAD_POOL_HPP_
+#define _FRACTALISM_THREAD_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fractalism::cpu {
+
+/**
+ * @class ThreadPool
+ * @brief A work-stealing thread pool for running indexed tasks in parallel.
+ *
+ * Each worker owns a deque of task indices. Workers take from the front of
+ * their own deque, and steal from the back of the others' once theirs is empty.
+ */
+class ThreadPool {
+public:
+  /**
+   * @brief Constructs a ThreadPool.
+   * @param threadCount The number of worker threads. The thread calling
+   * parallelFor() also runs tasks.
+   */
+  ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+
+  /**
+   * @brief Destructor that stops and joins the worker threads.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * @brief Runs task(index) for every index in [0, count), and waits for all
+   * of them to finish.
+   * @param count The number of tasks.
+   * @param task The task to run.
+   * @throws The first exception thrown by a task, once all tasks are done.
+   */
+  void parallelFor(size_t count, const std::function<void(size_t)>& task);
+
+  /**
+   * @brief Gets the number of threads that run tasks, including the caller.
+   * @return The number of threads.
+   */
+  inline size_t getThreadCount() const { return workers.size() + 1; }
+
+  /**
+   * @brief Gets the pool shared by the host kernels.
+   * @return The shared pool, created on first use.
+   */
+  static ThreadPool& shared();
+
+private:
+  /**
+   * @struct Worker
+   * @brief A worker thread and its task deque.
+   */
+  struct Worker {
+    std::mutex mutex;          ///< Guards tasks.
+    std::deque<size_t> tasks;  ///< Task indices owned by this worker.
+    std::thread thread;        ///< The worker thread.
+  };
+
+  /**
+   * @brief The worker thread main loop.
+   * @param self The index of the worker.
+   */
+  void work(size_t self);
+
+  /**
+   * @brief Runs tasks until there are none left to take or steal.
+   * @param self The index of the worker to take from first.
+   */
+  void runTasks(size_t self);
+
+  /**
+   * @brief Takes a task from a worker's deque.
+   * @param worker The worker to take from.
+   * @param steal Whether to take from the back, rather than the front.
+   * @param index Set to the taken task index.
+   * @return True if a task was taken.
+   */
+  static bool take(Worker& worker, bool steal, size_t& index);
+
+  std::vector<std::unique_ptr<Worker>> workers; ///< The worker threads.
+  std::mutex jobMutex;                          ///< Serializes parallelFor() calls.
+  std::mutex stateMutex;                        ///< Guards the fields below.
+  std::condition_variable wake;                 ///< Wakes the workers for a new job.
+  std::condition_variable done;                 ///< Signals that the job is done.
+  const std::function<void(size_t)>* job;       ///< The current job.
+  std::atomic<size_t> remaining;                ///< Tasks not yet finished.
+  std::exception_ptr error;                     ///< The first task exception.
+  size_t generation;                            ///< Incremented for each job.
+  bool stopping;                                ///< Set when the pool is destroyed.
+};
+} // namespace fractalism::cpu
+
+#endif
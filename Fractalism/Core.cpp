@@ -0,0 +1,44 @@
+#include <Fractalism/Core.hpp>
+
+#include <iostream>
+
+namespace fractalism {
+  Core::~Core() {
+    release();
+  }
+
+  void Core::shutdown() {
+    get<Core>().release();
+  }
+
+  void Core::release() {
+    if (programManager) {
+      // The SVM has to go before the context it was allocated in.
+      programManager->freeSvm();
+      programManager.reset();
+    }
+    // The launches still being timed hold events of the context. The kept
+    // local sizes are stored already.
+    localSizes = gpu::opencl::LocalSizeTuner();
+    ctx.reset();
+  }
+
+  void Core::setStatusHandlers(PushStatus&& push, PopStatus&& pop) {
+    Core& core = get<Core>();
+    core.pushStatus = std::move(push);
+    core.popStatus = std::move(pop);
+  }
+
+  void Core::setWarningHandler(Warn&& warn) {
+    get<Core>().warningHandler = std::move(warn);
+  }
+
+  void Core::warn(const std::string& message) {
+    Core& core = get<Core>();
+    if (core.warningHandler) {
+      core.warningHandler(message);
+    } else {
+      std::cerr << "Warning: " << message << std::endl;
+    }
+  }
+}
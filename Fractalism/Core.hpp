@@ -0,0 +1,177 @@
+#ifndef _FRACTALISM_CORE_HPP_
+#define _FRACTALISM_CORE_HPP_
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <Fractalism/Exceptions.hpp>
+#include <Fractalism/GPU/GPUContext.hpp>
+#include <Fractalism/GPU/OpenCL/LocalSizeTuner.hpp>
+#include <Fractalism/GPU/OpenCL/ProgramManager.hpp>
+#include <Fractalism/Settings.hpp>
+#include <Fractalism/Timeline.hpp>
+
+namespace fractalism {
+
+/**
+ * @class Core
+ * @brief Owns the display independent state: the settings, the OpenCL context,
+ * the program manager, the local size tuner and the timeline.
+ *
+ * Nothing in here depends on wxWidgets, so the same compute code runs in the
+ * UI application and in the headless renderer.
+ */
+class Core {
+public:
+  using PushStatus = std::function<void(const std::string&)>; ///< Shows a status message.
+  using PopStatus = std::function<void()>;                    ///< Removes the last status message.
+  using Warn = std::function<void(const std::string&)>;       ///< Reports a recoverable problem.
+
+  /**
+   * @brief Releases the compute resources.
+   */
+  ~Core();
+
+  /**
+   * @brief Creates the OpenCL context and builds the program.
+   * @tparam Args The types of the GPUContext constructor arguments.
+   * @param args The GPUContext constructor arguments.
+   * @return The created GPU context.
+   */
+  template<typename... Args>
+  static inline const gpu::GPUContext& initCompute(Args&&... args) {
+    Core& core = get<Core>();
+    if (core.ctx) {
+      throw AssertionError("Compute context has already been initialized.");
+    }
+    core.ctx.emplace(std::forward<Args>(args)...);
+    core.programManager.emplace(*core.ctx);
+    return *core.ctx;
+  }
+
+  /**
+   * @brief Frees the SVM and releases the OpenCL context.
+   *
+   * Must be called while the OpenCL runtime is still loaded, i.e. before
+   * static destruction.
+   */
+  static void shutdown();
+
+  /**
+   * @brief Sets how status messages are shown.
+   * @param push Called with the message when a task starts.
+   * @param pop Called when the task is done.
+   */
+  static void setStatusHandlers(PushStatus&& push, PopStatus&& pop);
+
+  /**
+   * @brief Sets how warnings are reported. They go to stderr by default.
+   * @param warn Called with the warning message.
+   */
+  static void setWarningHandler(Warn&& warn);
+
+  /**
+   * @brief Reports a recoverable problem.
+   * @param message The warning message.
+   */
+  static void warn(const std::string& message);
+
+  /**
+   * @brief Executes a callable with a status message, as a task on the
+   * timeline.
+   * @tparam Callable The type of the callable.
+   * @tparam Args The types of the arguments to the callable.
+   * @param message The status message to display.
+   * @param callable The callable to execute.
+   * @param args The arguments to pass to the callable.
+   * @return The result of the callable.
+   */
+  template<typename Callable, typename... Args>
+  static inline std::invoke_result_t<Callable, Args...> doWithStatusMessage(
+      const std::string&& message,
+      Callable&& callable,
+      Args&&... args) {
+    Core& core = get<Core>();
+    if (core.pushStatus) {
+      core.pushStatus(message);
+    }
+    const Timeline::Clock::time_point start = Timeline::Clock::now();
+    using Return = std::invoke_result_t<Callable, Args...>;
+    if constexpr (std::is_void_v<Return>) {
+      std::invoke(std::forward<Callable>(callable), std::forward<Args>(args)...);
+      core.timeline.addSpan(message, Timeline::Category::task, start, Timeline::Clock::now() - start);
+      if (core.popStatus) {
+        core.popStatus();
+      }
+    } else {
+      Return value = std::invoke(std::forward<Callable>(callable), std::forward<Args>(args)...);
+      core.timeline.addSpan(message, Timeline::Category::task, start, Timeline::Clock::now() - start);
+      if (core.popStatus) {
+        core.popStatus();
+      }
+      return value;
+    }
+  }
+
+  /**
+   * @brief Gets a reference to a specific type.
+   * @tparam T The type to get.
+   * @return A reference to the requested type.
+   */
+  template<typename T>
+  static inline std::conditional_t<std::is_same_v<T, gpu::GPUContext>, const T&, T&>
+  get() {
+    if constexpr (std::is_same_v<T, Core>) {
+      static Core core;
+      return core;
+    } else if constexpr (std::is_same_v<T, Settings>) {
+      return get<Core>().settings;
+    } else if constexpr (std::is_same_v<T, Timeline>) {
+      return get<Core>().timeline;
+    } else if constexpr (std::is_same_v<T, gpu::opencl::LocalSizeTuner>) {
+      return get<Core>().localSizes;
+    } else if constexpr (std::is_same_v<T, gpu::GPUContext>) {
+      Core& core = get<Core>();
+      if (core.ctx) {
+        return *core.ctx;
+      } else [[unlikely]] {
+        throw AssertionError("Compute context has not been initialized.");
+      }
+    } else if constexpr (std::is_same_v<T, gpu::opencl::ProgramManager>) {
+      Core& core = get<Core>();
+      if (core.programManager) {
+        return *core.programManager;
+      } else [[unlikely]] {
+        throw AssertionError("Program manager has not been initialized.");
+      }
+    } else {
+      static_assert(false, "Invalid type requested.");
+      return *static_cast<T*>(nullptr);
+    }
+  }
+
+private:
+  Core() = default;
+
+  /**
+   * @brief Frees the SVM and releases the OpenCL context of this instance.
+   * Unlike shutdown(), it doesn't go through get(), so the destructor of the
+   * static instance can call it.
+   */
+  void release();
+
+  Settings settings;                                          ///< The application settings.
+  Timeline timeline;                                          ///< Where the time of each frame goes.
+  gpu::opencl::LocalSizeTuner localSizes;                     ///< The local sizes of the kernel launches.
+  std::optional<gpu::GPUContext> ctx;                         ///< The OpenCL context.
+  std::optional<gpu::opencl::ProgramManager> programManager;  ///< The OpenCL program manager.
+  PushStatus pushStatus;                                      ///< Shows a status message.
+  PopStatus popStatus;                                        ///< Removes the last status message.
+  Warn warningHandler;                                        ///< Reports a recoverable problem.
+};
+} // namespace fractalism
+
+#endif
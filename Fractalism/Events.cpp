@@ -11,7 +11,7 @@ namespace fractalism::events {
   DEFINE_EVENT(ViewMappingChanged);
   DEFINE_EVENT(ParameterChanged);
   DEFINE_EVENT(IterationModifierChanged);
-  DEFINE_EVENT(IterationsPerFrameChanged);
+  DEFINE_EVENT(PriorityChanged);
   DEFINE_EVENT(NumberSystemChanged);
   DEFINE_EVENT(RenderDimensionsChanged);
   DEFINE_EVENT(ResolutionChanged);
@@ -143,7 +143,7 @@ DECLARE_EVENT(ZoomChanged, StateChangeEvent<real>);
 DECLARE_EVENT(ViewMappingChanged, StateChangeEvent<gpu::types::ViewMapping>);
 DECLARE_EVENT(ParameterChanged, StateChangeEvent<gpu::types::Number>);
 DECLARE_EVENT(IterationModifierChanged, StateChangeEvent<real>);
-DECLARE_EVENT(IterationsPerFrameChanged, StateChangeEvent<cl_uint>);
+DECLARE_EVENT(PriorityChanged, StateChangeEvent<cl_uint>);
 DECLARE_EVENT(NumberSystemChanged, StateChangeEvent<options::NumberSystem>);
 DECLARE_EVENT(RenderDimensionsChanged, StateChangeEvent<options::Dimensions>);
 DECLARE_EVENT(ResolutionChanged, StateChangeEvent<cl::NDRange>);
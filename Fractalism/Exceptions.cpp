@@ -20,6 +20,11 @@ namespace fractalism {
       const std::source_location where) :
         FractalismError(what, where) {}
 
+  ParseError::ParseError(
+      const std::string& what,
+      const std::source_location where) :
+        FractalismError(what, where) {}
+
   GLError::GLError(
       const std::string& what,
       const std::source_location where) :
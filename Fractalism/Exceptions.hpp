@@ -41,6 +41,22 @@ public:
       const std::source_location where = std::source_location::current());
 };
 
+/**
+ * @class ParseError
+ * @brief Exception thrown when user supplied input can't be parsed.
+ */
+class ParseError : public FractalismError {
+public:
+  /**
+   * @brief Constructs a ParseError.
+   * @param what The error message.
+   * @param where The source location where the error occurred.
+   */
+  ParseError(
+      const std::string& what,
+      const std::source_location where = std::source_location::current());
+};
+
 /**
  * @class GLError
  * @brief Exception thrown for OpenGL errors.
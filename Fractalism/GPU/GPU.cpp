@@ -1,21 +1,68 @@
 #include <Fractalism/GPU/GPU.hpp>
 
 #include <Fractalism/App.hpp>
+#include <Fractalism/GPU/OpenGL/GLUtils.hpp>
 
 namespace fractalism::gpu {
+  static inline std::vector<cl_context_properties> glSharingProperties(const wxGLContext& glCtx, wxGLCanvas& canvas) {
+    return {
+      #if defined(__WXMSW__)
+        CL_GL_CONTEXT_KHR, (cl_context_properties)glCtx.GetGLRC(),
+        CL_WGL_HDC_KHR, (cl_context_properties)canvas.GetHDC(),
+      #elif defined(__WXMOTIF__) || defined(__WXX11__)
+        CL_GLX_DISPLAY_KHR, (cl_context_properties)canvas.GetXWindow(),
+      /* Copied from wx/glcanvas.h, add the GL context and DC for these ports
+      #elif defined(__WXGTK20__)
+        #include <wx/gtk/glcanvas.h>
+      #elif defined(__WXGTK__)
+        #include <wx/gtk1/glcanvas.h>
+      #elif defined(__WXMAC__)
+        #include <wx/osx/glcanvas.h>
+      #elif defined(__WXQT__)
+        #include <wx/qt/glcanvas.h>
+      */
+      #else
+        #error "wxGLCanvas not supported in this wxWidgets port"
+      #endif
+    };
+  }
+
+  static inline const GPUContext& createContext(const wxGLContext& glCtx, wxGLCanvas& canvas) {
+    if (!glCtx.IsOK()) {
+      throw GLError("Could not create OpenGL context.");
+    }
+    canvas.SetCurrent(glCtx);
+
+    glewExperimental = true;
+
+    GLenum err = glewInit();
+
+    if (err != GL_NO_ERROR) {
+      throw GLError("Could not initialize GLEW", err);
+    }
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_ALPHA_TEST);
+    glDisable(GL_CULL_FACE);
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    opengl::glutils::checkGLError();
+
+    return Core::initCompute(glSharingProperties(glCtx, canvas));
+  }
+
   GPU::GPU(wxGLCanvas& canvas) :
-        ctx(canvas),
+        glCtx(Core::doWithStatusMessage("Initializing OpenGL context...", [](wxGLCanvas& canvas) {return wxGLContext(&canvas);}, canvas)),
+        ctx(createContext(glCtx, canvas)),
         shader2D("Shaders/2d.vert", "Shaders/2d.frag"),
         shader3D("Shaders/3d.vert", "Shaders/3d.frag"),
-        renderer(),
-        kernelManager(ctx) {
+        renderer() {
     reloadShaders();
   }
 
   void GPU::reloadShaders() {
-    App::doWithStatusMessage("Loading shaders...", [](opengl::GLShaderProgram& shader2D, opengl::GLShaderProgram& shader3D) {
+    Core::doWithStatusMessage("Loading shaders...", [](opengl::GLShaderProgram& shader2D, opengl::GLShaderProgram& shader3D) {
       shader2D.load();
       shader3D.load();
     }, shader2D, shader3D);
   }
-}
\ No newline at end of file
+}
@@ -8,7 +8,6 @@
 #include <wx/glcanvas.h>
 
 #include <Fractalism/GPU/GPUContext.hpp>
-#include <Fractalism/GPU/OpenCL/ProgramManager.hpp>
 #include <Fractalism/GPU/OpenGL/GLRenderer.hpp>
 #include <Fractalism/GPU/OpenGL/GLShaderProgram.hpp>
 
@@ -16,8 +15,9 @@ namespace fractalism::gpu {
 
 /**
  * @struct GPU
- * @brief Manages the GPU context, shaders, and rendering for the Fractalism
- * application.
+ * @brief Manages the OpenGL context, shaders, and rendering for the Fractalism
+ * application. The OpenCL side is owned by Core, and shares objects with the
+ * OpenGL context created here.
  */
 struct GPU {
   /**
@@ -31,11 +31,17 @@ struct GPU {
    */
   void reloadShaders();
 
-  const GPUContext ctx;                 ///< The GPU context.
-  opengl::GLShaderProgram shader2D;     ///< The 2D shader program.
-  opengl::GLShaderProgram shader3D;     ///< The 3D shader program.
-  opengl::GLRenderer renderer;          ///< The OpenGL renderer.
-  opencl::ProgramManager kernelManager; ///< The OpenCL program manager.
+  /**
+   * @brief Sets the current OpenGL context to the specified canvas.
+   * @param canvas The OpenGL canvas.
+   */
+  inline void setCurrent(wxGLCanvas& canvas) const { canvas.SetCurrent(glCtx); }
+
+  wxGLContext glCtx;                ///< OpenGL context for device communication.
+  const GPUContext& ctx;            ///< The GPU context, shared with OpenGL.
+  opengl::GLShaderProgram shader2D; ///< The 2D shader program.
+  opengl::GLShaderProgram shader3D; ///< The 3D shader program.
+  opengl::GLRenderer renderer;      ///< The OpenGL renderer.
 };
 } // namespace fractalism::gpu
 
@@ -1,86 +1,204 @@
 #include <Fractalism/GPU/GPUContext.hpp>
 
+#include <algorithm>
 #include <format>
+#include <utility>
 
+#include <Fractalism/Core.hpp>
 #include <Fractalism/Exceptions.hpp>
-#include <Fractalism/GPU/OpenGL/GLUtils.hpp>
-#include <Fractalism/App.hpp>
+#include <Fractalism/GPU/OpenCL/ProgramCache.hpp>
+#include <Fractalism/GPU/Types.hpp>
+#include <Fractalism/Utils.hpp>
 
 namespace fractalism::gpu {
-  static inline cl::Context createContext(cl::Platform& platform, cl::Device& device, const wxGLContext& glCtx, wxGLCanvas& canvas) {
-    cl_context_properties ctxProps[] = {
-        CL_CONTEXT_PLATFORM, (cl_context_properties)platform(),
-        #if defined(__WXMSW__)
-          CL_GL_CONTEXT_KHR, (cl_context_properties)glCtx.GetGLRC(),
-          CL_WGL_HDC_KHR, (cl_context_properties)canvas.GetHDC(),
-        #elif defined(__WXMOTIF__) || defined(__WXX11__)
-          CL_GLX_DISPLAY_KHR, (cl_context_properties)canvas.GetXWindow(),
-        /* Copied from wx/glcanvas.h, add the GL context and DC for these ports
-        #elif defined(__WXGTK20__)
-          #include <wx/gtk/glcanvas.h>
-        #elif defined(__WXGTK__)
-          #include <wx/gtk1/glcanvas.h>
-        #elif defined(__WXMAC__)
-          #include <wx/osx/glcanvas.h>
-        #elif defined(__WXQT__)
-          #include <wx/qt/glcanvas.h>
-        */
-        #else
-          #error "wxGLCanvas not supported in this wxWidgets port"
-        #endif
-        0 };
-    return cl::Context(device, ctxProps);
+  static inline cl::Context createContext(
+      cl::Platform& platform,
+      cl::Device& device,
+      const std::vector<cl_context_properties>* glSharingProperties) {
+    std::vector<cl_context_properties> ctxProps{
+        CL_CONTEXT_PLATFORM, (cl_context_properties)platform() };
+    if (glSharingProperties) {
+      ctxProps.insert(ctxProps.end(), glSharingProperties->begin(), glSharingProperties->end());
+    }
+    ctxProps.push_back(0);
+    return cl::Context(device, ctxProps.data());
+  }
+
+  static inline void warnHostFallback(const std::string&& reason) {
+    Core::warn(std::format("{}. Rendering with the host CPU kernels instead.", reason));
   }
 
-  GPUContext::GPUContext(wxGLCanvas& canvas) :
-        glCtx(App::doWithStatusMessage("Initializing OpenGL context...", [](wxGLCanvas& canvas) {return wxGLContext(&canvas);}, canvas)) {
-    if (!glCtx.IsOK()) {
-      throw GLError("Could not create OpenGL context.");
+  static inline bool hasDevices(const cl::Platform& platform, cl_device_type deviceType) {
+    std::vector<cl::Device> devices;
+    try {
+      platform.getDevices(deviceType, &devices);
+    } catch (const cl::Error&) {
+      return false;
     }
-    canvas.SetCurrent(glCtx);
+    return !devices.empty();
+  }
 
-    glewExperimental = true;
+  static inline cl::Platform findPlatform(const DeviceSelection& selection) {
+    if (selection.deviceType == CL_DEVICE_TYPE_ALL && selection.platformName.empty()) {
+      return cl::Platform::get();
+    }
+    std::vector<cl::Platform> platforms;
+    cl::Platform::get(&platforms);
+    for (const cl::Platform& platform : platforms) {
+      if (platform.getInfo<CL_PLATFORM_NAME>().find(selection.platformName) != std::string::npos
+          && hasDevices(platform, selection.deviceType)) {
+        return platform;
+      }
+    }
+    return cl::Platform();
+  }
 
-    GLenum err = glewInit();
+  // A CPU device is split into a sub-device per NUMA node, each balanced on
+  // its own so a slab stays in the memory next to the cores computing it.
+  // Without nodes to split by, one core is left out, the host threads of the
+  // UI and the reference orbits run on it. Other devices are kept whole.
+  static inline std::vector<cl::Device> partitionHelper(const cl::Device& device) {
+    if (device.getInfo<CL_DEVICE_TYPE>() != CL_DEVICE_TYPE_CPU
+        || device.getInfo<CL_DEVICE_PARTITION_MAX_SUB_DEVICES>() < 2) {
+      return {device};
+    }
+    const std::vector<cl_device_partition_property> supported = device.getInfo<CL_DEVICE_PARTITION_PROPERTIES>();
+    auto supports = [&supported](cl_device_partition_property property) {
+      return std::find(supported.begin(), supported.end(), property) != supported.end();
+    };
+    cl::Device whole(device);
+    std::vector<cl::Device> subDevices;
+    try {
+      if (supports(CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN)
+          && (device.getInfo<CL_DEVICE_PARTITION_AFFINITY_DOMAIN>() & CL_DEVICE_AFFINITY_DOMAIN_NUMA)) {
+        const cl_device_partition_property byNode[] = {
+          CL_DEVICE_PARTITION_BY_AFFINITY_DOMAIN, CL_DEVICE_AFFINITY_DOMAIN_NUMA,
+          0};
+        whole.createSubDevices(byNode, &subDevices);
+      }
+      const cl_uint units = device.getInfo<CL_DEVICE_MAX_COMPUTE_UNITS>();
+      if (subDevices.size() < 2 && supports(CL_DEVICE_PARTITION_BY_COUNTS) && units > 2) {
+        const cl_device_partition_property allButOne[] = {
+          CL_DEVICE_PARTITION_BY_COUNTS, static_cast<cl_device_partition_property>(units - 1),
+          CL_DEVICE_PARTITION_BY_COUNTS_LIST_END,
+          0};
+        subDevices.clear();
+        whole.createSubDevices(allButOne, &subDevices);
+      }
+    } catch (const cl::Error&) {
+      // The driver lists partitions it can't create, the device stays whole.
+      subDevices.clear();
+    }
+    return subDevices.empty() ? std::vector<cl::Device>{device} : subDevices;
+  }
 
-    if (err != GL_NO_ERROR) {
-      throw GLError("Could not initialize GLEW", err);
+  // Every available device that can build the kernels, but main, CPU devices
+  // as sub-devices. A device some other platform exposes too is taken once.
+  static inline std::vector<cl::Device> findHelperDevices(const cl::Device& main) {
+    std::vector<cl::Platform> platforms;
+    cl::Platform::get(&platforms);
+    std::vector<std::pair<std::string, cl_uint>> taken{
+      {main.getInfo<CL_DEVICE_NAME>(), main.getInfo<CL_DEVICE_VENDOR_ID>()}};
+    std::vector<cl::Device> helpers;
+    for (const cl::Platform& platform : platforms) {
+      std::vector<cl::Device> devices;
+      try {
+        platform.getDevices(CL_DEVICE_TYPE_ALL, &devices);
+      } catch (const cl::Error&) {
+        continue;
+      }
+      std::vector<std::pair<std::string, cl_uint>> found;
+      for (const cl::Device& device : devices) {
+        if (device() == main()
+            || !device.getInfo<CL_DEVICE_AVAILABLE>()
+            || !device.getInfo<CL_DEVICE_COMPILER_AVAILABLE>()
+            || !device.getInfo<CL_DEVICE_IMAGE_SUPPORT>()) {
+          continue;
+        }
+        const std::pair<std::string, cl_uint> identity{
+          device.getInfo<CL_DEVICE_NAME>(),
+          device.getInfo<CL_DEVICE_VENDOR_ID>()};
+        if (std::find(taken.begin(), taken.end(), identity) != taken.end()) {
+          continue;
+        }
+        found.push_back(identity);
+        const std::vector<cl::Device> parts = partitionHelper(device);
+        helpers.insert(helpers.end(), parts.begin(), parts.end());
+      }
+      // Identical devices on one platform are separate devices.
+      taken.insert(taken.end(), found.begin(), found.end());
     }
+    return helpers;
+  }
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_ALPHA_TEST);
-    glDisable(GL_CULL_FACE);
-    glClearColor(0.0, 0.0, 0.0, 0.0);
-    opengl::glutils::checkGLError();
+  GPUContext::GPUContext(const DeviceSelection& selection) {
+    init(nullptr, selection);
+  }
 
-    App::doWithStatusMessage("Initializing OpenCL context...", [](GPUContext& ctx, wxGLCanvas& canvas) {
+  GPUContext::GPUContext(const std::vector<cl_context_properties>& glSharingProperties) {
+    // The UI sizes its frames by the measured kernel times, and splits them
+    // with the other devices by their measured speed.
+    init(&glSharingProperties, {.profiling = true, .helpers = true});
+  }
+
+  GPUContext::GPUContext(const cl::Device& device, bool profiling) : device(device) {
+    try {
+      cl::Platform platform(this->device.getInfo<CL_DEVICE_PLATFORM>());
+      clCtx = createContext(platform, this->device, nullptr);
+      initDevice(profiling);
+    } catch (const cl::Error& e) {
+      throw CLError("Could not create OpenCL context", e);
+    }
+  }
+
+  void GPUContext::init(
+      const std::vector<cl_context_properties>* glSharingProperties,
+      const DeviceSelection& selection) {
+    Core::doWithStatusMessage("Initializing OpenCL context...", [](
+        GPUContext& ctx,
+        const std::vector<cl_context_properties>* glSharingProperties,
+        const DeviceSelection& selection) {
+      // TODO: check platform.getInfo<CL_PLATFORM_EXTENSIONS>()
+      cl::Platform platform;
+      try {
+        platform = findPlatform(selection);
+      } catch (const cl::Error&) {}
+      if (!platform()) {
+        warnHostFallback("Could not find an OpenCL platform");
+        return;
+      }
       try {
-        // TODO: check platform.getInfo<CL_PLATFORM_EXTENSIONS>()
-        cl::Platform platform = cl::Platform::get();
-
-        cl_device_id deviceId = 0;
-        // Try to get the current GL context device
-        clGetGLContextInfoKHR_fn clGetGLContextInfo = reinterpret_cast<clGetGLContextInfoKHR_fn>(
-            clGetExtensionFunctionAddressForPlatform(platform(), "clGetGLContextInfoKHR"));
-        if (clGetGLContextInfo) {
-          cl_context_properties props[] = {
-            CL_CONTEXT_PLATFORM, (cl_context_properties)platform(),
-            0
-          };
-          clGetGLContextInfo(props, CL_CURRENT_DEVICE_FOR_GL_CONTEXT_KHR, sizeof(cl_uint), &deviceId, nullptr);
-          if (deviceId) {
-            ctx.device = deviceId;
+        if (glSharingProperties) {
+          cl_device_id deviceId = 0;
+          // Try to get the current GL context device
+          clGetGLContextInfoKHR_fn clGetGLContextInfo = reinterpret_cast<clGetGLContextInfoKHR_fn>(
+              clGetExtensionFunctionAddressForPlatform(platform(), "clGetGLContextInfoKHR"));
+          if (clGetGLContextInfo) {
+            cl_context_properties props[] = {
+              CL_CONTEXT_PLATFORM, (cl_context_properties)platform(),
+              0
+            };
+            clGetGLContextInfo(props, CL_CURRENT_DEVICE_FOR_GL_CONTEXT_KHR, sizeof(cl_uint), &deviceId, nullptr);
+            if (deviceId) {
+              ctx.device = deviceId;
+            }
           }
         }
         // If we couldn't get the proper device, use a bad and terrible fallback.
         if (ctx.device()) {
-          ctx.clCtx = createContext(platform, ctx.device, ctx.glCtx, canvas);
+          ctx.clCtx = createContext(platform, ctx.device, glSharingProperties);
         } else {
           std::vector<cl::Device> devices;
-          platform.getDevices(CL_DEVICE_TYPE_ALL, &devices);
+          try {
+            platform.getDevices(selection.deviceType, &devices);
+          } catch (const cl::Error& e) {
+            if (e.err() != CL_DEVICE_NOT_FOUND) {
+              throw;
+            }
+          }
           for (cl::Device& device : devices) {
             try {
-              ctx.clCtx = createContext(platform, device, ctx.glCtx, canvas);
+              ctx.clCtx = createContext(platform, device, glSharingProperties);
               ctx.device = device;
               break;
             } catch (const cl::Error&) {
@@ -88,71 +206,133 @@ namespace fractalism::gpu {
             }
           }
           if (!ctx.device()) {
-            throw CLError("Could not find CL/GL compatible device");
+            warnHostFallback(glSharingProperties ?
+              "Could not find CL/GL compatible device" :
+              "Could not find an OpenCL device");
+            return;
           }
         }
-
-        // TODO: verify SVM support
-        ctx.maxMemAllocSize = ctx.device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
-
-        ctx.queue = cl::CommandQueue(ctx.clCtx, ctx.device);
+        ctx.glSharing = glSharingProperties != nullptr;
+        ctx.initDevice(selection.profiling);
       }
       catch (const cl::Error& e) {
         throw CLError("Could not create OpenCL context", e);
       }
-    }, *this, canvas);
+      if (selection.helpers) {
+        ctx.initHelpers(selection.profiling);
+      }
+    }, *this, glSharingProperties, selection);
+  }
+
+  void GPUContext::initDevice(bool profiling) {
+    // TODO: verify SVM support
+    maxMemAllocSize = device.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+    globalMemSize = device.getInfo<CL_DEVICE_GLOBAL_MEM_SIZE>();
+    fp64 = device.getInfo<CL_DEVICE_DOUBLE_FP_CONFIG>() != 0;
+    glEvents = glSharing
+      && device.getInfo<CL_DEVICE_EXTENSIONS>().find("cl_khr_gl_event") != std::string::npos;
+
+    queueProperties = profiling ? CL_QUEUE_PROFILING_ENABLE : 0;
+    queue = createQueue();
   }
 
-  static inline void writeBuildLog(const cl::Device & device, const cl::Program & program) {
+  void GPUContext::initHelpers(bool profiling) {
+    std::vector<cl::Device> devices;
+    try {
+      devices = findHelperDevices(device);
+    } catch (const cl::Error& e) {
+      Core::warn(std::format("Could not list the other OpenCL devices: {}", e.what()));
+      return;
+    }
+    for (const cl::Device& helper : devices) {
+      try {
+        helpers.emplace_back(helper, profiling);
+      } catch (const CLError& e) {
+        Core::warn(std::format("{}. Frames are not split with that device.", e.what()));
+      }
+    }
+  }
+
+  cl::CommandQueue GPUContext::createQueue() const {
+    try {
+      return cl::CommandQueue(clCtx, device, queueProperties);
+    } catch (const cl::Error& e) {
+      throw CLError("Could not create OpenCL command queue", e);
+    }
+  }
+
+  static inline void writeBuildLog(const cl::Device & device, const cl::Program & program, const std::string& fileName) {
     cl::string log = program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device);
     if (log.empty() || log.size() == 1) {
       static constexpr const char successMessage[] = "Build successful, no errors or warnings.";
-      utils::writeToFile("cl_build.log", sizeof(successMessage) - 1, successMessage);
+      utils::writeToFile(fileName.c_str(), sizeof(successMessage) - 1, successMessage);
     }
     else {
-      utils::writeToFile("cl_build.log", log.size() - 1, log.c_str());
+      utils::writeToFile(fileName.c_str(), log.size() - 1, log.c_str());
     }
   }
 
   cl::Program GPUContext::buildProgram(
-      const std::string&& function,
-      const std::string&& numberSystemDefinitions,
-      double escapeValue) const {
-    return App::doWithStatusMessage("Creating OpenCL solver program...", [](
-        const GPUContext& ctx,
-        const std::string& function,
-        const std::string& numberSystemDefinitions,
-        double escapeValue) -> cl::Program {
-      cl::Program program;
-      try {
-        program = cl::Program(ctx.clCtx, std::format(
-          #if defined(USE_DOUBLE_MATH)
-          "#pragma OPENCL EXTENSION cl_khr_fp64 : enable"
-          #endif
-          R"SRC(
-          #define MAX_NUMBER_SYSTEM_SIZE {}
-          #define CL_DEVICE_MAX_MEM_ALLOC_SIZE {}
-          #define ESCAPE_VALUE {}
-          #define NUMBER_SYSTEMS {}
-          #define KERNEL_FUNCTION(add, sub, conj, mul, sqr, scale, modulus_sq) {}
-
-          #include "kernels.h")SRC",
-          MAX_NUMBER_SYSTEM_SIZE,
-          ctx.maxMemAllocSize,
-          escapeValue,
-          numberSystemDefinitions,
-          function));
-      } catch (const cl::Error& e) {
-        if (e.err() == CL_BUILD_PROGRAM_FAILURE) {
-          writeBuildLog(ctx.device, program);
-          throw CLBuildError("Could not build OpenCL program. See cl_build.log for more information.");
-        } else {
-          throw CLError("Could not build OpenCL program", e);
-        }
-      }
-      program.build("-I KernelHeaders -cl-kernel-arg-info");
-      writeBuildLog(ctx.device, program);
+      const std::string& function,
+      const std::string& perturbationFunction,
+      const std::string& numberSystemDefinitions,
+      const std::string& kernelNumberSystems,
+      size_t storeElements,
+      types::WorkStoreLayout storeLayout,
+      double escapeValue,
+      options::Precision precision,
+      const std::string& variant) const {
+    const std::string buildLog = std::format("cl_build_{}.log", variant);
+    const bool doubleMath = precision == options::Precision::fp64;
+    const std::string source = std::format(
+      R"SRC({}
+      #define USE_DOUBLE_MATH {}
+      #define MAX_NUMBER_SYSTEM_SIZE {}
+      #define WORK_STORE_ELEMENTS {}
+      #define WORK_STORE_CYCLES {}
+      #define WORK_STORE_REFERENCE_INDICES {}
+      #define WORK_STORE_BUFFER_BYTES {}
+      #define ESCAPE_VALUE {}
+      #define NUMBER_SYSTEMS {}
+      #define KERNEL_NUMBER_SYSTEMS {}
+      #define KERNEL_FUNCTION(add, sub, conj, mul, sqr, scale, modulus_sq) {}
+      #define PERTURBATION_FUNCTION(add, sub, conj, mul, sqr, scale, modulus_sq) {}
+
+      #include "kernels.h")SRC",
+      doubleMath ? "#pragma OPENCL EXTENSION cl_khr_fp64 : enable" : "",
+      doubleMath ? 1 : 0,
+      MAX_NUMBER_SYSTEM_SIZE,
+      storeElements,
+      storeLayout.cycles ? 1 : 0,
+      storeLayout.referenceIndices ? 1 : 0,
+      // The work store is chunked by the host's block size, which is at
+      // least as large as the program's.
+      maxMemAllocSize / sizeof(types::WorkStoreBlock) * sizeof(types::WorkStoreBlock),
+      escapeValue,
+      numberSystemDefinitions,
+      kernelNumberSystems,
+      function,
+      perturbationFunction);
+    const std::string buildOptions = std::format("-I {} -cl-kernel-arg-info", opencl::ProgramCache::includeDirectory);
+
+    const opencl::ProgramCache cache(device, maxMemAllocSize, source, buildOptions);
+    cl::Program program = cache.load(clCtx);
+    if (program()) {
       return program;
-    }, *this, function, numberSystemDefinitions, escapeValue);
+    }
+    try {
+      program = cl::Program(clCtx, source);
+      program.build(buildOptions.c_str());
+    } catch (const cl::Error& e) {
+      if (e.err() == CL_BUILD_PROGRAM_FAILURE) {
+        writeBuildLog(device, program, buildLog);
+        throw CLBuildError(std::format("Could not build OpenCL program. See {} for more information.", buildLog));
+      } else {
+        throw CLError("Could not build OpenCL program", e);
+      }
+    }
+    writeBuildLog(device, program, buildLog);
+    cache.store(program);
+    return program;
   }
 }
\ No newline at end of file
@@ -2,44 +2,105 @@
 #define _FRACTALISM_GPU_CONTEXT_HPP_
 
 #include <string>
+#include <vector>
 
 #include <Fractalism/GPU/OpenCL/CLCommon.hpp>
-#include <Fractalism/UI/UICommon.hpp>
-
-// we don't use glew in this header, but it must be included before gl.h
-#include <GL/glew.h>
-#include <wx/glcanvas.h>
+#include <Fractalism/GPU/Types.hpp>
+#include <Fractalism/Options.hpp>
 
 namespace fractalism::gpu {
 
+/**
+ * @struct DeviceSelection
+ * @brief Restricts which OpenCL device a headless GPUContext picks.
+ */
+struct DeviceSelection {
+  cl_device_type deviceType = CL_DEVICE_TYPE_ALL; ///< Only devices of this type are considered.
+  std::string platformName;                       ///< Only platforms whose name contains this are considered.
+  bool profiling = false;                         ///< Whether the queue records profiling information.
+  bool helpers = false;                           ///< Whether the other devices are set up as GPUContext::helpers.
+};
+
 /**
  * @struct GPUContext
- * @brief Manages the GPU context for OpenCL and OpenGL operations.
+ * @brief Manages the OpenCL context, optionally shared with OpenGL.
  */
 struct GPUContext {
   /**
-   * @brief Constructs a GPUContext with the specified OpenGL canvas.
-   * @param canvas The OpenGL canvas.
+   * @brief Constructs a GPUContext without OpenGL sharing, for headless
+   * rendering.
+   * @param selection Which device to pick. By default the first device of the
+   * default platform is used.
    */
-  GPUContext(wxGLCanvas &canvas);
+  GPUContext(const DeviceSelection& selection = {});
 
   /**
-   * @brief Builds an OpenCL program with the specified parameters.
+   * @brief Constructs a GPUContext that shares objects with an OpenGL context,
+   * for the UI. Its queues record profiling information.
+   * @param glSharingProperties The platform specific context properties
+   * identifying the current OpenGL context, without the terminating 0.
+   */
+  GPUContext(const std::vector<cl_context_properties>& glSharingProperties);
+
+  /**
+   * @brief Constructs a GPUContext without OpenGL sharing on a specific
+   * device, for a helper.
+   * @param device The device.
+   * @param profiling Whether its queues record profiling information.
+   * @throws CLError if the context could not be created.
+   */
+  GPUContext(const cl::Device& device, bool profiling);
+
+  /**
+   * @brief Builds an OpenCL program with the specified parameters, or loads
+   * it from the opencl::ProgramCache. Only touches the context, so it can run
+   * on a worker thread.
    * @param function The mathematical function to build the kernel around.
-   * @param numberSystemDefinitions The number system definitions.
+   * @param perturbationFunction Steps the distance dz of an orbit to the
+   * reference orbit point ref_z, given the distance dc of the constants. Must
+   * be the difference between function at ref_z + dz and at ref_z.
+   * @param numberSystemDefinitions The number systems to define the
+   * arithmetic of.
+   * @param kernelNumberSystems The number systems to generate kernels for.
+   * Each must be in numberSystemDefinitions.
+   * @param storeElements The number elements the work store keeps, the most
+   * of any kernel number system.
+   * @param storeLayout The planes the work store keeps.
    * @param escapeValue The escape value for the fractal computation.
+   * @param precision The precision of real in the program.
+   * @param variant Names the program in its build log, cl_build_<variant>.log.
    * @return The built OpenCL program.
    */
   cl::Program buildProgram(
-      const std::string&& function,
-      const std::string&& numberSystemDefinitions,
-      double escapeValue) const;
+      const std::string& function,
+      const std::string& perturbationFunction,
+      const std::string& numberSystemDefinitions,
+      const std::string& kernelNumberSystems,
+      size_t storeElements,
+      types::WorkStoreLayout storeLayout,
+      double escapeValue,
+      options::Precision precision,
+      const std::string& variant) const;
+
+  /**
+   * @brief Creates another in-order queue on the device, with the same
+   * properties as queue. Work on different queues may overlap.
+   * @return The new queue.
+   */
+  cl::CommandQueue createQueue() const;
+
+  /**
+   * @brief Checks if an OpenCL device was found.
+   * @return True if the OpenCL members are usable, false if rendering falls
+   * back to the host kernels.
+   */
+  inline bool hasDevice() const { return device() != nullptr; }
 
   /**
-   * @brief Sets the current OpenGL context to the specified canvas.
-   * @param canvas The OpenGL canvas.
+   * @brief Checks if OpenCL objects can be shared with OpenGL.
+   * @return True if the context was created with OpenGL sharing.
    */
-  inline void setCurrent(wxGLCanvas& canvas) const { canvas.SetCurrent(glCtx); }
+  inline bool sharesGL() const { return glSharing; }
 
   /**
    * @brief Implicit conversion to const cl::Context&.
@@ -53,13 +114,43 @@ struct GPUContext {
    */
   inline operator const cl_context& () const { return clCtx(); }
 
-  cl::Device device;            ///< OpenCL device used for computation.
-  cl::Context clCtx;            ///< OpenCL context for device communication.
-  cl::CommandQueue queue;       ///< Queue to manage OpenCL command execution.
-  cl_ulong maxMemAllocSize = 0; ///< Maximum memory allocatable on the device.
+  cl::Device device;               ///< OpenCL device used for computation. Null if there is none.
+  cl::Context clCtx;               ///< OpenCL context for device communication.
+  cl::CommandQueue queue;          ///< Queue to manage OpenCL command execution.
+  cl_ulong maxMemAllocSize = 0;    ///< Maximum memory allocatable on the device.
+  cl_ulong globalMemSize = 0;      ///< Total memory of the device.
+  bool fp64 = false;               ///< Whether the device supports double precision.
+  bool glEvents = false;           ///< Whether OpenCL can wait for OpenGL fences (cl_khr_gl_event).
+  std::vector<GPUContext> helpers; ///< The other usable devices, CPUs as sub-devices, each in a context of its own, which frames can be split with. See opencl::SlabBalancer.
 
 private:
-  wxGLContext glCtx; ///< OpenGL context for device communication.
+  /**
+   * @brief Picks a device and creates the context and queue.
+   * @param glSharingProperties The OpenGL sharing properties, or null for a
+   * headless context.
+   * @param selection Which device to pick.
+   */
+  void init(
+      const std::vector<cl_context_properties>* glSharingProperties,
+      const DeviceSelection& selection);
+
+  /**
+   * @brief Reads the limits of device and creates the queue, once the
+   * context exists.
+   * @param profiling Whether the queues record profiling information.
+   */
+  void initDevice(bool profiling);
+
+  /**
+   * @brief Sets up every other device that can run the kernels as a helper.
+   * CPU devices are split into a helper per NUMA node, or leave a core to the
+   * host. Devices that fail to are skipped with a warning.
+   * @param profiling Whether their queues record profiling information.
+   */
+  void initHelpers(bool profiling);
+
+  bool glSharing = false;                          ///< Whether the context shares objects with OpenGL.
+  cl_command_queue_properties queueProperties = 0; ///< The properties of every queue on the device.
 };
 } // namespace fractalism::gpu
 
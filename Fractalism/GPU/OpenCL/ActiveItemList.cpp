@@ -0,0 +1,199 @@
+#include <Fractalism/GPU/OpenCL/ActiveItemList.hpp>
+
+#include <cstdlib>
+#include <format>
+
+#include <Fractalism/Core.hpp>
+#include <Fractalism/Exceptions.hpp>
+
+namespace fractalism::gpu::opencl {
+  void ActiveItemList::resize(const cl::NDRange& range) {
+    lists[0] = cl::Buffer();
+    lists[1] = cl::Buffer();
+    count = cl::Buffer();
+    seeded = false;
+    const GPUContext& ctx = Core::get<GPUContext>();
+    const size_t listSize = range[0] * range[1] * range[2] * sizeof(cl_uint);
+    if (listSize > ctx.maxMemAllocSize) {
+      Core::warn("The active pixel list does not fit on the device. Every frame will cover the whole image.");
+      return;
+    }
+    try {
+      cl::Buffer newLists[2] = {
+        cl::Buffer(ctx.clCtx, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, listSize),
+        cl::Buffer(ctx.clCtx, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, listSize)
+      };
+      count = cl::Buffer(ctx.clCtx, CL_MEM_READ_WRITE, sizeof(cl_uint));
+      lists[0] = newLists[0];
+      lists[1] = newLists[1];
+    } catch (const cl::Error& e) {
+      count = cl::Buffer();
+      Core::warn(std::format(
+        "Could not allocate the active pixel list ({}). Every frame will cover the whole image.",
+        e.what()));
+    }
+  }
+
+  void ActiveItemList::seedLevel(
+      cl::Kernel& levelKernel,
+      const cl::CommandQueue& queue,
+      const cl::NDRange& fullRange,
+      cl_uint level,
+      cl_uint coarsestLevel,
+      const std::array<cl_uint, 3>& origin,
+      cl_uint totalIterations) {
+    const size_t stride = size_t(1) << level;
+    try {
+      levelKernel.setArg(0, static_cast<cl_uint>(fullRange[0]));
+      levelKernel.setArg(1, static_cast<cl_uint>(fullRange[1]));
+      levelKernel.setArg(2, static_cast<cl_uint>(fullRange[2]));
+      levelKernel.setArg(3, level);
+      levelKernel.setArg(4, coarsestLevel);
+      levelKernel.setArg(5, cl_uint4{origin[0], origin[1], origin[2], 0});
+    } catch (const cl::Error& e) {
+      throw CLError("Could not list the pixels of a level of detail", e);
+    }
+    seed(
+      levelKernel,
+      6,
+      queue,
+      cl::NDRange(
+        (fullRange[0] + stride - 1) / stride,
+        (fullRange[1] + stride - 1) / stride,
+        (fullRange[2] + stride - 1) / stride),
+      cl::NullRange,
+      totalIterations);
+  }
+
+  void ActiveItemList::seed(
+      cl::Kernel& listKernel,
+      cl_uint firstArg,
+      const cl::CommandQueue& queue,
+      const cl::NDRange& global,
+      const cl::NDRange& local,
+      cl_uint totalIterations) {
+    try {
+      listKernel.setArg(firstArg, lists[current]);
+      listKernel.setArg(firstArg + 1, count);
+      // The queue is in order, the read waits for the list.
+      queue.enqueueFillBuffer(count, cl_uint(0), 0, sizeof(cl_uint));
+      queue.enqueueNDRangeKernel(listKernel, cl::NullRange, global, local);
+      queue.enqueueReadBuffer(count, CL_FALSE, 0, sizeof(cl_uint), &itemCount, nullptr, &countRead);
+    } catch (const cl::Error& e) {
+      throw CLError("Could not list the pixels to compute", e);
+    }
+    seededIterations = totalIterations;
+    seeded = true;
+  }
+
+  cl::Event ActiveItemList::seedExposed(
+      cl::Kernel& exposeKernel,
+      const cl::CommandQueue& queue,
+      const cl::NDRange& fullRange,
+      const std::array<cl_uint, 3>& origin,
+      const std::array<cl_int, 3>& shift,
+      bool onlyExposed,
+      const std::vector<cl::Event>& waitEvents,
+      cl_uint totalIterations) {
+    cl::Event started;
+    try {
+      exposeKernel.setArg(2, cl_uint4{origin[0], origin[1], origin[2], 0});
+      exposeKernel.setArg(3, cl_int4{shift[0], shift[1], shift[2], 0});
+      if (onlyExposed) {
+        exposeKernel.setArg(5, lists[current]);
+        exposeKernel.setArg(6, count);
+      } else {
+        exposeKernel.setArg(5, sizeof(cl_mem), nullptr);
+        exposeKernel.setArg(6, sizeof(cl_mem), nullptr);
+      }
+      queue.enqueueFillBuffer(count, cl_uint(0), 0, sizeof(cl_uint), &waitEvents);
+      // One launch per moved axis, over the slab of pixels it exposed. The
+      // queue is in order, each waits for the last.
+      for (cl_uint axis = 0; axis < 3; axis++) {
+        if (!shift[axis]) {
+          continue;
+        }
+        size_t offset[3] = {0, 0, 0};
+        size_t size[3] = {fullRange[0], fullRange[1], fullRange[2]};
+        size[axis] = static_cast<size_t>(std::abs(shift[axis]));
+        offset[axis] = shift[axis] > 0 ? fullRange[axis] - size[axis] : 0;
+        exposeKernel.setArg(4, axis);
+        queue.enqueueNDRangeKernel(
+          exposeKernel,
+          cl::NDRange(offset[0], offset[1], offset[2]),
+          cl::NDRange(size[0], size[1], size[2]),
+          cl::NullRange,
+          nullptr,
+          &started);
+      }
+      if (onlyExposed) {
+        queue.enqueueReadBuffer(count, CL_FALSE, 0, sizeof(cl_uint), &itemCount, nullptr, &countRead);
+      }
+    } catch (const cl::Error& e) {
+      throw CLError("Could not start the pixels a pan exposed", e);
+    }
+    // Without the list, the pixels still iterating are only known to the
+    // kernel. A sweep over the whole output finds them, the rest exit early.
+    seededIterations = totalIterations;
+    seeded = onlyExposed;
+    return started;
+  }
+
+  bool ActiveItemList::isEmpty(cl_uint totalIterations) {
+    if (!seeded || seededIterations != totalIterations) {
+      return false;
+    }
+    countRead.wait();
+    return itemCount == 0;
+  }
+
+  cl::NDRange ActiveItemList::range(const cl::NDRange& fullRange, cl_uint totalIterations) {
+    if (!seeded || seededIterations != totalIterations) {
+      seeded = false;
+      return fullRange;
+    }
+    countRead.wait();
+    return cl::NDRange(itemCount);
+  }
+
+  cl::Event ActiveItemList::bind(cl::Kernel& kernel, cl_uint firstArg, const cl::CommandQueue& queue) {
+    cl::Event countReset;
+    try {
+      if (seeded) {
+        kernel.setArg(firstArg, lists[current]);
+      } else {
+        kernel.setArg(firstArg, sizeof(cl_mem), nullptr);
+      }
+      kernel.setArg(firstArg + 1, lists[1 - current]);
+      kernel.setArg(firstArg + 2, count);
+      queue.enqueueFillBuffer(count, cl_uint(0), 0, sizeof(cl_uint), nullptr, &countReset);
+    } catch (const cl::Error& e) {
+      throw CLError("Could not set up the active pixel list", e);
+    }
+    return countReset;
+  }
+
+  void ActiveItemList::unbind(cl::Kernel& kernel, cl_uint firstArg) {
+    try {
+      for (cl_uint i = 0; i < 3; i++) {
+        kernel.setArg(firstArg + i, sizeof(cl_mem), nullptr);
+      }
+    } catch (const cl::Error& e) {
+      throw CLError("Could not clear the active pixel list arguments", e);
+    }
+  }
+
+  void ActiveItemList::swap(
+      const cl::CommandQueue& queue,
+      const std::vector<cl::Event>& kernelDone,
+      cl_uint totalIterations) {
+    try {
+      queue.enqueueReadBuffer(count, CL_FALSE, 0, sizeof(cl_uint), &itemCount, &kernelDone, &countRead);
+    } catch (const cl::Error& e) {
+      throw CLError("Could not read the active pixel count", e);
+    }
+    current = 1 - current;
+    seededIterations = totalIterations;
+    seeded = true;
+  }
+}
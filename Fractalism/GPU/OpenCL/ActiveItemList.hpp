@@ -0,0 +1,166 @@
+#ifndef _FRACTALISM_ACTIVE_ITEM_LIST_HPP_
+#define _FRACTALISM_ACTIVE_ITEM_LIST_HPP_
+
+#include <array>
+#include <vector>
+
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+
+namespace fractalism::gpu::opencl {
+
+/**
+ * @class ActiveItemList
+ * @brief Tracks which work items of an escape time kernel are still iterating,
+ * so the following frame is only launched over those.
+ *
+ * The kernel appends every work item that neither escaped nor reached the
+ * iteration limit to the next list, and the lists swap after each frame. The
+ * first frame after a reset is launched over the whole output.
+ */
+class ActiveItemList {
+public:
+  static constexpr cl_uint argCount = 3; ///< The number of kernel arguments the lists take.
+
+  /**
+   * @brief Reallocates the lists for a new output size. If the device can't
+   * hold them, the list stays unusable and every frame covers the whole
+   * output.
+   * @param range The output dimensions.
+   */
+  void resize(const cl::NDRange& range);
+
+  /**
+   * @brief Makes the next frame cover the whole output again.
+   */
+  inline void reset() { seeded = false; }
+
+  /**
+   * @brief Makes the next frame cover only the pixels of one level of detail,
+   * listed on the device by the list_level_items kernel.
+   * @param levelKernel The list_level_items kernel of the current program.
+   * @param queue The queue to list the pixels on.
+   * @param fullRange The whole output.
+   * @param level The level, the pixels are every 2^level-th along each axis.
+   * @param coarsestLevel The first level, the others skip its pixels.
+   * @param origin Where the pixel at the top left of the screen is stored.
+   * @param totalIterations The current iteration limit.
+   */
+  void seedLevel(
+      cl::Kernel& levelKernel,
+      const cl::CommandQueue& queue,
+      const cl::NDRange& fullRange,
+      cl_uint level,
+      cl_uint coarsestLevel,
+      const std::array<cl_uint, 3>& origin,
+      cl_uint totalIterations);
+
+  /**
+   * @brief Makes the next frame cover only the pixels a kernel lists.
+   * @param listKernel The kernel, with all arguments but the list set.
+   * @param firstArg The index of the list argument, followed by its count.
+   * @param queue The queue to list the pixels on.
+   * @param global The global range of the kernel.
+   * @param local The local range of the kernel.
+   * @param totalIterations The current iteration limit.
+   */
+  void seed(
+      cl::Kernel& listKernel,
+      cl_uint firstArg,
+      const cl::CommandQueue& queue,
+      const cl::NDRange& global,
+      const cl::NDRange& local,
+      cl_uint totalIterations);
+
+  /**
+   * @brief Starts over the pixels a pan exposed, with the start_exposed_items
+   * kernel. Either the next frame covers only those, or the whole output, so
+   * they join the pixels still iterating.
+   * @param exposeKernel The start_exposed_items kernel of the current program,
+   * with the output and work store arguments set.
+   * @param queue The queue to start the pixels on.
+   * @param fullRange The whole output.
+   * @param origin Where the pixel at the top left of the screen is stored,
+   * after the pan.
+   * @param shift How many pixels the view moved along each axis.
+   * @param onlyExposed Whether the next frame covers only the exposed pixels.
+   * @param waitEvents The events to wait for.
+   * @param totalIterations The current iteration limit.
+   * @return The event of the pixels being started.
+   */
+  cl::Event seedExposed(
+      cl::Kernel& exposeKernel,
+      const cl::CommandQueue& queue,
+      const cl::NDRange& fullRange,
+      const std::array<cl_uint, 3>& origin,
+      const std::array<cl_int, 3>& shift,
+      bool onlyExposed,
+      const std::vector<cl::Event>& waitEvents,
+      cl_uint totalIterations);
+
+  /**
+   * @brief Checks if the lists could be allocated.
+   * @return True if the kernels can be launched over the list.
+   */
+  inline bool isUsable() const { return lists[0]() != nullptr; }
+
+  /**
+   * @brief Checks if the last frame left nothing to iterate. Waits for the
+   * last frame to finish.
+   * @param totalIterations The current iteration limit.
+   * @return True if there is nothing to launch.
+   */
+  bool isEmpty(cl_uint totalIterations);
+
+  /**
+   * @brief Gets the range to launch the next frame over. Waits for the last
+   * frame to finish.
+   * @param fullRange The whole output.
+   * @param totalIterations The current iteration limit. If it changed since
+   * the list was built, the whole output is launched, since items that stopped
+   * at the old limit have to continue.
+   * @return The global range of the next frame.
+   */
+  cl::NDRange range(const cl::NDRange& fullRange, cl_uint totalIterations);
+
+  /**
+   * @brief Sets the list arguments of a kernel and resets the count of the
+   * next list.
+   * @param kernel The kernel to set the arguments for.
+   * @param firstArg The index of the first of the three list arguments.
+   * @param queue The queue to reset the count on.
+   * @return The event of the count reset, to wait for before the kernel.
+   */
+  cl::Event bind(cl::Kernel& kernel, cl_uint firstArg, const cl::CommandQueue& queue);
+
+  /**
+   * @brief Sets null list arguments, so the kernel neither reads nor builds a
+   * list.
+   * @param kernel The kernel to set the arguments for.
+   * @param firstArg The index of the first of the three list arguments.
+   */
+  static void unbind(cl::Kernel& kernel, cl_uint firstArg);
+
+  /**
+   * @brief Makes the list built by the last frame the one the next frame is
+   * launched over.
+   * @param queue The queue the kernel was enqueued on.
+   * @param kernelDone The event of the kernel that built the list.
+   * @param totalIterations The iteration limit the kernel was run with.
+   */
+  void swap(
+      const cl::CommandQueue& queue,
+      const std::vector<cl::Event>& kernelDone,
+      cl_uint totalIterations);
+
+private:
+  cl::Buffer lists[2];            ///< The current and the next list of item indices.
+  cl::Buffer count;               ///< Device side length of the next list.
+  size_t current = 0;             ///< Index of the list the next frame reads.
+  cl_uint itemCount = 0;          ///< Length of the current list, once countRead completes.
+  cl::Event countRead;            ///< Completion of the read of itemCount.
+  cl_uint seededIterations = 0;   ///< The iteration limit the current list was built with.
+  bool seeded = false;            ///< Whether the current list is valid.
+};
+} // namespace fractalism::gpu::opencl
+
+#endif
@@ -1,12 +1,16 @@
 #include <Fractalism/GPU/OpenCL/CLUtils.hpp>
 
-#include <Fractalism/App.hpp>
+#include <Fractalism/Core.hpp>
 
 namespace fractalism::gpu::opencl {
 
-  const cl::Context& clutils::getClContext() { return App::get<GPUContext>().clCtx; }
-  const cl::CommandQueue& clutils::getQueue() { return App::get<GPUContext>().queue; }
-  cl_ulong clutils::getMaxMemAllocSize() { return App::get<GPUContext>().maxMemAllocSize; }
+  const cl::Context& clutils::getClContext() { return Core::get<GPUContext>().clCtx; }
+  const cl::CommandQueue& clutils::getQueue() { return Core::get<GPUContext>().queue; }
+  cl_ulong clutils::getMaxMemAllocSize() { return Core::get<GPUContext>().maxMemAllocSize; }
+
+  void clutils::traceTransfer(const cl::Event& event, const char* name) {
+    Core::get<Timeline>().record(event, name, Timeline::Category::transfer);
+  }
 
   const char* clutils::getCLErrorString(cl_int err) {
     switch (err) {
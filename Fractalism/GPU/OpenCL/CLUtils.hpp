@@ -35,6 +35,13 @@ const cl::CommandQueue& getQueue();
  */
 cl_ulong getMaxMemAllocSize();
 
+/**
+ * @brief Records an OpenCL command moving memory on the Timeline.
+ * @param event The event of the command.
+ * @param name The name of the span.
+ */
+void traceTransfer(const cl::Event& event, const char* name);
+
 template <class Callable, typename Type, typename... Args>
 concept SVMCallback = std::is_invocable_v<Callable, Type*, std::size_t, Args...>;
 
@@ -68,6 +75,7 @@ inline void modifySVM(
   } catch (const cl::Error& e) {
     throw CLError("Could not map OpenCL Shared Virtual Memory buffer", e);
   }
+  traceTransfer(mappedEvent, "Map SVM");
 
   cl::UserEvent modifiedEvent(getClContext());
   /*std::thread([&callback, ptr, count, &args...](
@@ -84,6 +92,7 @@ inline void modifySVM(
   } catch (const cl::Error& e) {
     throw CLError("Could not unmap OpenCL Shared Virtual Memory buffer", e);
   }
+  traceTransfer(doneEvent, "Unmap SVM");
 }
 } // namespace fractalism::gpu::opencl::clutils
 
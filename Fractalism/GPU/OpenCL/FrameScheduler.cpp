@@ -0,0 +1,98 @@
+#include <Fractalism/GPU/OpenCL/FrameScheduler.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace fractalism::gpu::opencl {
+  FrameScheduler::FrameScheduler() :
+        budget(0.0),
+        cost(0.0),
+        kernelTime(0.0),
+        lastSlice(0),
+        profiled(true),
+        pendingStart(),
+        pending(),
+        pendingItems(0.0),
+        pendingIterations(0) {}
+
+  cl_uint FrameScheduler::slice(const cl::NDRange& range, cl_uint fixedSlice) {
+    measure();
+    if (budget <= 0.0 || cost <= 0.0 || !profiled) {
+      lastSlice = fixedSlice;
+      return fixedSlice;
+    }
+    double iterations = budget / (cost * std::max(itemCount(range), 1.0));
+    if (lastSlice) {
+      iterations = std::min(iterations, lastSlice * maxGrowth);
+    }
+    iterations = std::clamp(iterations, 1.0, static_cast<double>(std::numeric_limits<cl_uint>::max()));
+    lastSlice = static_cast<cl_uint>(iterations);
+    return lastSlice;
+  }
+
+  size_t FrameScheduler::batch(const cl::NDRange& range, cl_uint iterations) {
+    measure();
+    const double items = itemCount(range);
+    if (budget <= 0.0 || cost <= 0.0 || !profiled) {
+      return static_cast<size_t>(items);
+    }
+    const double fitting = budget / (cost * std::max(iterations, 1u));
+    return static_cast<size_t>(std::clamp(fitting, 1.0, std::max(items, 1.0)));
+  }
+
+  void FrameScheduler::record(
+      const cl::Event& kernelStarted,
+      const cl::Event& kernelDone,
+      const cl::NDRange& range,
+      cl_uint iterations) {
+    if (!profiled || !iterations) {
+      return;
+    }
+    pendingStart = kernelStarted;
+    pending = kernelDone;
+    pendingItems = itemCount(range);
+    pendingIterations = iterations;
+  }
+
+  void FrameScheduler::reset() {
+    cost = 0.0;
+    lastSlice = 0;
+    pendingStart = cl::Event();
+    pending = cl::Event();
+  }
+
+  void FrameScheduler::measure() {
+    if (!pending()) {
+      return;
+    }
+    double seconds;
+    try {
+      if (pending.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() != CL_COMPLETE) {
+        // Measured on the next frame.
+        return;
+      }
+      const cl_ulong start = pendingStart.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+      const cl_ulong end = pending.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+      seconds = static_cast<double>(end - start) * 1e-9;
+    } catch (const cl::Error&) {
+      // The queue records no profiling information, the slice stays fixed.
+      profiled = false;
+      pendingStart = cl::Event();
+      pending = cl::Event();
+      return;
+    }
+    pendingStart = cl::Event();
+    pending = cl::Event();
+    kernelTime = seconds;
+    const double measured = seconds / (std::max(pendingItems, 1.0) * pendingIterations);
+    cost = cost > 0.0 ? smoothing * measured + (1.0 - smoothing) * cost : measured;
+  }
+
+  double FrameScheduler::itemCount(const cl::NDRange& range) {
+    double items = 1.0;
+    for (cl_uint axis = 0; axis < range.dimensions(); axis++) {
+      items *= static_cast<double>(range[axis]);
+    }
+    return items;
+  }
+}
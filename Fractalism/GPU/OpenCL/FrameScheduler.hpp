@@ -0,0 +1,113 @@
+#ifndef _FRACTALISM_FRAME_SCHEDULER_HPP_
+#define _FRACTALISM_FRAME_SCHEDULER_HPP_
+
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+
+namespace fractalism::gpu::opencl {
+
+/**
+ * @class FrameScheduler
+ * @brief Sizes the iteration slice of a window's frames to fit a share of
+ * the frame time, instead of a fixed number of iterations.
+ *
+ * The device time of each kernel is read from its profiling information once
+ * it completed, and kept as the time one work item takes per iteration. The
+ * next slice is the budget over that cost times the items it is launched
+ * over, so a restart after a view change, which launches a different number
+ * of items, is sized right from its first frame.
+ *
+ * A slice is at least an iteration. Frames whose single iteration over every
+ * item takes longer than the budget are launched a batch of tiles at a time
+ * instead, as many items as the budget fits.
+ */
+class FrameScheduler {
+public:
+  static constexpr double frameTime = 0.012; ///< The device time all windows' kernels may take per frame, leaving the rest of 60 Hz to drawing.
+  static constexpr double smoothing = 0.5;   ///< The weight of the newest kernel in the cost.
+  static constexpr double maxGrowth = 4.0;   ///< The most a slice grows over the last one, costs measured on short kernels are noisy.
+
+  /**
+   * @brief Constructs a scheduler with no budget, which keeps the fixed
+   * slice.
+   */
+  FrameScheduler();
+
+  /**
+   * @brief Sets the device time the window's next frame may take.
+   * @param seconds The budget, 0 for the fixed slice.
+   */
+  inline void setBudget(double seconds) { budget = seconds; }
+
+  /**
+   * @brief Checks if frames are sized to a budget.
+   * @return True if a budget is set.
+   */
+  inline bool hasBudget() const { return budget > 0.0; }
+
+  /**
+   * @brief Gets the device time of the last kernel measured.
+   * @return The time in seconds, 0 if none was measured.
+   */
+  inline double getKernelTime() const { return kernelTime; }
+
+  /**
+   * @brief Picks the iterations of the next kernel. Measures the last one
+   * if it completed.
+   * @param range The range the kernel is launched over.
+   * @param fixedSlice The slice to use without a budget or a measurement.
+   * @return The number of iterations, at least 1.
+   */
+  cl_uint slice(const cl::NDRange& range, cl_uint fixedSlice);
+
+  /**
+   * @brief Picks the items the next kernel is launched over. Measures the
+   * last one if it completed.
+   * @param range The range the slice is computed over, a batch at a time.
+   * @param iterations The slice.
+   * @return The number of items, at least 1 and at most the range's. The
+   * whole range without a budget or a measurement.
+   */
+  size_t batch(const cl::NDRange& range, cl_uint iterations);
+
+  /**
+   * @brief Records a kernel, to be measured once it completed.
+   * @param kernelStarted The event of the first launch of the kernel, from a
+   * queue with profiling enabled. A kernel may be launched in parts.
+   * @param kernelDone The event of its last launch, on the same in-order
+   * queue.
+   * @param range The range it was launched over.
+   * @param iterations The iterations it computed.
+   */
+  void record(const cl::Event& kernelStarted, const cl::Event& kernelDone, const cl::NDRange& range, cl_uint iterations);
+
+  /**
+   * @brief Forgets the cost, for a kernel of another program.
+   */
+  void reset();
+
+private:
+  /**
+   * @brief Folds the recorded kernel into the cost, if it completed.
+   */
+  void measure();
+
+  /**
+   * @brief Counts the work items of a range.
+   * @param range The range.
+   * @return The product of its dimensions.
+   */
+  static double itemCount(const cl::NDRange& range);
+
+  double budget;             ///< The device time the next frame may take, 0 for the fixed slice.
+  double cost;               ///< The time one work item takes per iteration, 0 until measured.
+  double kernelTime;         ///< The device time of the last kernel measured.
+  cl_uint lastSlice;         ///< The slice picked last, 0 after a reset.
+  bool profiled;             ///< Whether the queue has profiling information.
+  cl::Event pendingStart;    ///< The first launch of the kernel recorded last.
+  cl::Event pending;         ///< The last launch of the kernel recorded last, null once measured.
+  double pendingItems;       ///< The work items of pending.
+  cl_uint pendingIterations; ///< The iterations of pending.
+};
+} // namespace fractalism::gpu::opencl
+
+#endif
@@ -0,0 +1,73 @@
+#include <Fractalism/GPU/OpenCL/ImageTarget.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#include <Fractalism/Core.hpp>
+#include <Fractalism/Exceptions.hpp>
+
+namespace fractalism::gpu::opencl {
+  static inline size_t texelCount(const cl::NDRange& range) {
+    return range[0] * range[1] * range[2];
+  }
+
+  void ImageTarget::resize(const cl::NDRange& range) {
+    this->range = range;
+    texels.assign(texelCount(range) * 4, 0);
+    const GPUContext& ctx = Core::get<GPUContext>();
+    if (ctx.hasDevice()) {
+      try {
+        deviceImage = cl::Image3D(
+          ctx.clCtx,
+          CL_MEM_READ_WRITE,
+          cl::ImageFormat(CL_RGBA, CL_UNORM_INT8),
+          range[0],
+          range[1],
+          range[2]);
+      } catch (const cl::Error& e) {
+        throw CLError("Could not create OpenCL output image", e);
+      }
+    }
+  }
+
+  void ImageTarget::clear(const cl::CommandQueue& queue) {
+    std::fill(texels.begin(), texels.end(), 0);
+    if (deviceImage()) {
+      try {
+        queue.enqueueFillImage(
+          deviceImage,
+          cl_float4{0.0f, 0.0f, 0.0f, 0.0f},
+          {0, 0, 0},
+          {range[0], range[1], range[2]});
+      } catch (const cl::Error& e) {
+        throw CLError("Could not clear OpenCL output image", e);
+      }
+    }
+  }
+
+  void ImageTarget::upload(const cl::NDRange& range, const void* data) {
+    std::memcpy(texels.data(), data, texelCount(range) * 4);
+  }
+
+  const cl::Memory& ImageTarget::image() const {
+    return deviceImage;
+  }
+
+  const std::vector<cl_uchar>& ImageTarget::read() {
+    if (deviceImage()) {
+      try {
+        Core::get<GPUContext>().queue.enqueueReadImage(
+          deviceImage,
+          CL_TRUE,
+          {0, 0, 0},
+          {range[0], range[1], range[2]},
+          0,
+          0,
+          texels.data());
+      } catch (const cl::Error& e) {
+        throw CLError("Could not read OpenCL output image", e);
+      }
+    }
+    return texels;
+  }
+}
@@ -0,0 +1,42 @@
+#ifndef _FRACTALISM_IMAGE_TARGET_HPP_
+#define _FRACTALISM_IMAGE_TARGET_HPP_
+
+#include <vector>
+
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+#include <Fractalism/GPU/OpenCL/RenderTarget.hpp>
+
+namespace fractalism::gpu::opencl {
+
+/**
+ * @class ImageTarget
+ * @brief A render target in plain OpenCL image memory that can be read back to
+ * the host. Used when there is no OpenGL context.
+ */
+class ImageTarget : public RenderTarget {
+public:
+  void resize(const cl::NDRange& range) override;
+  void clear(const cl::CommandQueue& queue) override;
+  void upload(const cl::NDRange& range, const void* data) override;
+  const cl::Memory& image() const override;
+
+  /**
+   * @brief Reads the rendered volume. Blocks until the device is done.
+   * @return The texels, 4 bytes each, x varying fastest.
+   */
+  const std::vector<cl_uchar>& read();
+
+  /**
+   * @brief Gets the dimensions of the target.
+   * @return The dimensions, in texels.
+   */
+  inline const cl::NDRange& getRange() const { return range; }
+
+private:
+  cl::Image3D deviceImage;       ///< The kernel output, null without a device.
+  cl::NDRange range;             ///< The dimensions of the target.
+  std::vector<cl_uchar> texels;  ///< Host copy of the image.
+};
+} // namespace fractalism::gpu::opencl
+
+#endif
@@ -1,85 +1,1073 @@
 #include <Fractalism/GPU/OpenCL/KernelExecutor.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
 #include <Fractalism/GPU/OpenCL/ProgramManager.hpp>
-#include <Fractalism/GPU/OpenGL/GLUtils.hpp>
-#include <Fractalism/App.hpp>
+#include <Fractalism/Core.hpp>
 
 namespace fractalism::gpu::opencl {
   namespace KernelArg {
     enum KernelArg : cl_uint {
       output,
       buffer,
+      pages,
       view,
       parameter,
       lastIteration,
-      maxIterations
+      maxIterations,
+      totalIterations,
+      activeItems,
+      reference = activeItems + ActiveItemList::argCount,
+      referenceLength
+    };
+  }
+
+  namespace DistanceArg {
+    enum DistanceArg : cl_uint {
+      output,
+      view,
+      parameter,
+      maxIterations,
+      camera,
+      block
+    };
+  }
+
+  namespace ExposeArg {
+    enum ExposeArg : cl_uint {
+      output,
+      buffer
+    };
+  }
+
+  namespace ClassifyArg {
+    enum ClassifyArg : cl_uint {
+      output,
+      buffer
+    };
+  }
+
+  namespace LevelArg {
+    enum LevelArg : cl_uint {
+      pages = 8
     };
   }
 
-  KernelExecutor::KernelExecutor(size_t index) :
+  namespace SubdivideArg {
+    enum SubdivideArg : cl_uint {
+      output,
+      buffer
+    };
+  }
+
+  KernelExecutor::KernelExecutor(size_t index, RenderTarget& target) :
         index(index),
-        settings(App::get<Settings>().viewWindowSettings[index]),
+        settings(Core::get<Settings>().viewWindowSettings[index]),
+        target(target),
+        queue(),
         kernel(),
-        texture(),
-        clGlTextures(),
-        currentIteration(0) {}
+        levelKernel(),
+        exposeKernel(),
+        tileKernel(),
+        subdivideKernel(),
+        brickKernel(),
+        classifyKernel(),
+        regrantKernel(),
+        grantedKernel(),
+        program(),
+        swapPending(false),
+        hostKernel(),
+        currentIteration(0),
+        progressive(false),
+        subdivision(false),
+        level(0),
+        levelStarted(false),
+        levelIterations(0),
+        anchored(false),
+        anchor(),
+        anchorShift(),
+        pendingShift(),
+        panPending(false),
+        origin(),
+        frame(),
+        shown(),
+        held(false),
+        kernelEvent(),
+        frameDone(),
+        activeItems(),
+        subdivisions(),
+        scheduler(),
+        slabs(),
+        tiles(),
+        tiledIteration(0),
+        splitIterations(0),
+        focus(types::Coordinates::none),
+        pages(),
+        name(),
+        precision(types::hostPrecision),
+        perturbed(false),
+        reference(),
+        nextReference(),
+        referenceBuffer(),
+        canvasSize{1, 1},
+        tracedSize(),
+        tracedEye() {}
 
   void KernelExecutor::updateKernel() {
-    kernel = App::get<ProgramManager>().findKernel(
-      options::kernelName(
+    precision = choosePrecision();
+    perturbed = usesPerturbation(precision);
+    // The new kernel has none of the reference orbit arguments set.
+    reference = perturbation::ReferenceOrbit();
+    // The host kernels have no distance estimates, they show escape times.
+    const bool hostDistance = settings.renderMode == options::RenderMode::distance
+      && !Core::get<GPUContext>().hasDevice();
+    const options::RenderMode renderMode = hostDistance ? options::RenderMode::escape : settings.renderMode;
+    name = options::kernelName(
         settings.space,
-        settings.renderMode,
-        App::get<Settings>().numberSystem));
+        renderMode,
+        Core::get<Settings>().numberSystem,
+        perturbed);
+    if (Core::get<GPUContext>().hasDevice()) {
+      if (!queue()) {
+        // A queue per window, so the windows' frames can overlap.
+        queue = Core::get<GPUContext>().createQueue();
+        Core::get<Timeline>().nameQueue(
+          queue,
+          options::name(settings.space) + " " + options::name(settings.renderMode));
+      }
+      // The arguments are set once the program is built, until then the
+      // last frame stays up.
+      program = Core::get<ProgramManager>().requestProgram(
+        precision,
+        Core::get<Settings>().numberSystem,
+        types::workStoreLayout(renderMode, perturbed));
+      swapPending = true;
+      trySwap();
+      return;
+    }
+    hostKernel.setKernel(name);
     updateResolution();
     updateParameter();
   }
 
+  void KernelExecutor::waitForKernel() {
+    // Swapping in can pick yet another kernel, if the resolution or view
+    // changed while the program was built.
+    while (swapPending) {
+      program.wait();
+      trySwap();
+    }
+    // Swapping in the orbit can start another, if the settings moved past it.
+    while (perturbed && !updateReference(settings.getMaxIterations())) {
+      nextReference.wait();
+    }
+  }
+
+  bool KernelExecutor::trySwap() {
+    if (program.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      return false;
+    }
+    kernel = cl::Kernel(program.get(), name);
+    levelKernel = cl::Kernel(program.get(), "list_level_items");
+    exposeKernel = cl::Kernel(program.get(), "start_exposed_items");
+    tileKernel = cl::Kernel(program.get(), "list_tile_borders");
+    subdivideKernel = cl::Kernel(
+      program.get(),
+      "subdivide_rects_" + options::name(Core::get<Settings>().numberSystem));
+    brickKernel = cl::Kernel(program.get(), "build_occupancy_bricks");
+    classifyKernel = cl::Kernel(
+      program.get(),
+      "classify_bricks_" + options::name(Core::get<Settings>().numberSystem));
+    regrantKernel = cl::Kernel(program.get(), "regrant_pages");
+    grantedKernel = cl::Kernel(program.get(), "list_granted_items");
+    swapPending = false;
+    // Another precision or number system costs another time per iteration.
+    scheduler.reset();
+    // Only distance estimates, and escape frames computed to the limit at
+    // once, start from scratch, the other kernels keep a work store on the
+    // main device.
+    if (isDistance() || (settings.renderMode == options::RenderMode::escape && !perturbed)) {
+      slabs.setKernel(
+        name,
+        precision,
+        Core::get<Settings>().numberSystem,
+        options::name(settings.space) + " " + options::name(settings.renderMode));
+    } else {
+      slabs.free();
+    }
+    updateResolution();
+    updateParameter();
+    return true;
+  }
+
   void KernelExecutor::updateResolution() {
-    clGlTextures.clear();
-    texture.resize(App::get<Settings>().resolution);
-    clGlTextures = {texture};
-    kernel.setArg(KernelArg::output, clGlTextures[0]);
-    App::get<ProgramManager>().svmKernelArg(kernel, KernelArg::buffer);
+    if (swapPending) {
+      // trySwap() catches up.
+      return;
+    }
+    // Traced frames are an image of the canvas, whatever the resolution.
+    target.resize(isTraced() ?
+      cl::NDRange(canvasSize[0], canvasSize[1], 1) :
+      Core::get<Settings>().resolution);
+    // Nothing stored is kept.
+    origin = {0, 0, 0};
+    for (size_t axis = 0; axis < 3; axis++) {
+      frame.view.origin[axis] = 0;
+    }
+    anchored = false;
+    if (isDistance()) {
+      // The distance estimates start from scratch each frame, they need no
+      // work store.
+      kernel.setArg(DistanceArg::output, target.image());
+      Core::get<ProgramManager>().resizeBuffer(index, 0, sizeof(types::WorkStoreBlock));
+      const cl::NDRange& resolution = Core::get<Settings>().resolution;
+      if (isTraced()) {
+        slabs.resize(canvasSize[0], canvasSize[1]);
+      } else {
+        slabs.resize(static_cast<cl_uint>(resolution[0]), static_cast<cl_uint>(resolution[1]));
+      }
+    } else if (Core::get<GPUContext>().hasDevice()) {
+      kernel.setArg(KernelArg::output, target.image());
+      exposeKernel.setArg(ExposeArg::output, target.image());
+      subdivideKernel.setArg(SubdivideArg::output, target.image());
+      activeItems.resize(Core::get<Settings>().resolution);
+      subdivisions.resize(Core::get<Settings>().resolution);
+      // The store only keeps what the program's numbers and kernels need,
+      // float precision stores take half the memory.
+      const size_t blockSize = types::workStoreBlockSize(
+        precision,
+        Core::get<Settings>().getNumberSystemElementCount(),
+        types::workStoreLayout(settings.renderMode, perturbed));
+      // Escape voxels that finished only keep their color, a progressive 3D
+      // view only keeps the bricks still iterating.
+      const bool compactStore = settings.renderMode == options::RenderMode::escape
+        && progressive
+        && activeItems.isUsable();
+      pages.resize(Core::get<Settings>().resolution, blockSize, compactStore);
+      if (pages.isSparse() && !activeItems.isUsable()) {
+        // Without the list every launch covers the whole volume, restarting
+        // the voxels of the bricks without a page.
+        throw FractalismError("The active voxel list of the paged work store could not be allocated");
+      }
+      Core::get<ProgramManager>().resizeBuffer(
+        index,
+        WorkStorePages::blockCount(Core::get<Settings>().resolution, blockSize, compactStore),
+        blockSize);
+      pages.asKernelArg(kernel, KernelArg::pages);
+      pages.asKernelArg(levelKernel, LevelArg::pages);
+      classifyKernel.setArg(ClassifyArg::output, target.image());
+      const cl::NDRange& resolution = Core::get<Settings>().resolution;
+      if (resolution.dimensions() == 2) {
+        slabs.resize(static_cast<cl_uint>(resolution[0]), static_cast<cl_uint>(resolution[1]));
+      }
+    } else {
+      hostKernel.resize(Core::get<Settings>().resolution);
+    }
     updateView();
   }
 
   void KernelExecutor::updateView() {
-    settings.view.asKernelArg(kernel, KernelArg::view);
-    currentIteration = 0;
+    if (swapPending) {
+      return;
+    }
+    const options::Precision wanted = choosePrecision();
+    if (wanted != precision || usesPerturbation(wanted) != perturbed) {
+      // Zoomed across one of the Viewspace::zoomLimit()s.
+      updateKernel();
+      return;
+    }
+    if (Core::get<GPUContext>().hasDevice()) {
+      setViewArg();
+    }
+    if (!detectPan()) {
+      restart();
+    }
   }
 
   void KernelExecutor::updateParameter() {
-    App::get<Settings>().parameter.asKernelArg(kernel, KernelArg::parameter);
+    if (swapPending) {
+      return;
+    }
+    if (Core::get<GPUContext>().hasDevice()) {
+      Core::get<Settings>().parameter.asKernelArg(
+        kernel,
+        isDistance() ? static_cast<cl_uint>(DistanceArg::parameter) : static_cast<cl_uint>(KernelArg::parameter),
+        precision);
+    }
     if (settings.space == options::Space::dynamical) {
-      currentIteration = 0;
+      restart();
+    }
+  }
+
+  void KernelExecutor::clearTexture() {
+    target.clear(queue);
+    if (!Core::get<GPUContext>().hasDevice()) {
+      hostKernel.clear();
+    }
+  }
+
+  bool KernelExecutor::isFrameDone() const {
+    return !frameDone() || frameDone.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() == CL_COMPLETE;
+  }
+
+  const ShownFrame& KernelExecutor::getShownFrame() {
+    if (isFrameDone()) {
+      shown = frame;
+    }
+    return shown;
+  }
+
+  void KernelExecutor::setCanvasSize(cl_uint width, cl_uint height) {
+    const std::array<cl_uint, 2> size{std::max(width, 1u), std::max(height, 1u)};
+    if (size == canvasSize) {
+      return;
+    }
+    canvasSize = size;
+    if (isTraced()) {
+      updateResolution();
     }
   }
 
   bool KernelExecutor::needsMore() const {
-    return currentIteration < settings.getMaxIterations();
+    // Traced frames depend on the camera too, which moves without events.
+    return swapPending
+      || panPending
+      || held
+      || level > 0
+      || currentIteration < settings.getMaxIterations()
+      || (isTraced() && (tracedSize != canvasSize || tracedEye != settings.camera.getPosition()));
   }
 
   cl::Event KernelExecutor::enqueue(std::vector<cl::Event>& waitEvents) {
+    if (swapPending && (!trySwap() || swapPending)) {
+      return cl::Event();
+    }
+    // Pixels iterated against the orbit of another view would be wrong, the
+    // last frame stays up until the orbit of this one is computed.
+    if (perturbed && !updateReference(settings.getMaxIterations())) {
+      return cl::Event();
+    }
+    if (isDistance()) {
+      return enqueueDistance(waitEvents);
+    }
+    // Only escape time pixels stop iterating, translated points are drawn
+    // every frame.
+    const bool compact = Core::get<GPUContext>().hasDevice()
+      && settings.renderMode == options::RenderMode::escape
+      && activeItems.isUsable();
+    // Filled pixels are only as good as their border, which the perturbed
+    // kernels may get wrong.
+    const bool subdivided = compact
+      && subdivision
+      && !perturbed
+      && Core::get<Settings>().resolution[2] == 1
+      && subdivisions.isUsable();
+    if (panPending) {
+      // Rectangles still queued would cover pixels the pan moved.
+      if (compact && progressive && level == 0 && levelStarted && (!subdivided || subdivisions.isEmpty())) {
+        applyPan(waitEvents, settings.getMaxIterations());
+      } else {
+        // The coarse levels are quick to redo.
+        restart();
+      }
+    }
+    if (subdivided && level == 0 && levelStarted && levelIterations != settings.getMaxIterations()) {
+      // Filled pixels took their border's count at the old limit.
+      restart();
+    }
+    if (splitIterations && splitIterations != settings.getMaxIterations()) {
+      // The helpers' pixels kept nothing to go on from.
+      restart();
+    }
+    // The helper devices keep no work store. A flat escape frame computed
+    // from scratch to the limit at once needs none, so they take part of it.
+    const bool split = splitIterations != 0
+      || (settings.renderMode == options::RenderMode::escape
+        && !perturbed
+        && !subdivided
+        && !(compact && progressive)
+        && Core::get<Settings>().resolution.dimensions() == 2
+        && origin == std::array<cl_uint, 3>{0, 0, 0}
+        && currentIteration == 0
+        && tiles.isEmpty()
+        && slabs.hasHelpers());
+    if (!compact || !progressive) {
+      level = 0;
+      frame.level = 0;
+    }
+    // Until the subdivision is complete, the target holds pixels of the last
+    // frame between the rectangles, which stays on screen instead.
+    if (!subdivided || level > 0) {
+      frame.view = settings.view;
+      for (size_t axis = 0; axis < 3; axis++) {
+        frame.view.origin[axis] = origin[axis];
+      }
+    }
     cl_uint iterationsPerFrame = settings.getIterationsPerFrame();
-    cl_uint maxIterationsThisFrame = std::min(currentIteration + iterationsPerFrame, settings.getMaxIterations());
+    cl_uint totalIterations = settings.getMaxIterations();
+    cl_uint maxIterationsThisFrame = std::min(currentIteration + iterationsPerFrame, totalIterations);
+    if (!Core::get<GPUContext>().hasDevice()) {
+      hostKernel.run(
+        settings.view,
+        Core::get<Settings>().parameter,
+        currentIteration,
+        maxIterationsThisFrame,
+        totalIterations);
+      target.upload(Core::get<Settings>().resolution, hostKernel.data());
+      currentIteration = maxIterationsThisFrame;
+      return cl::Event();
+    }
+
+    cl::NDRange range = Core::get<Settings>().resolution;
+    if (compact && progressive && (level > 0 || !subdivided)) {
+      // Subdivision takes over after the coarsest level, which is quick and
+      // shows the new view meanwhile.
+      if (!advanceLevel(totalIterations, subdivided ? coarsestLevel : 0) && !subdivided) {
+        // Every level is done.
+        queue.enqueueMarkerWithWaitList(&waitEvents, &frameDone);
+        return frameDone;
+      }
+    }
+    if (subdivided && level == 0) {
+      if (!advanceSubdivision(waitEvents, totalIterations)) {
+        if (currentIteration < totalIterations) {
+          // A round of subdivision was queued, the next frame reads its
+          // counts.
+          held = true;
+          queue.enqueueMarkerWithWaitList(&waitEvents, &frameDone);
+          queue.flush();
+          return frameDone;
+        }
+        // Every rectangle is filled or computed, the frame goes on screen.
+        frame.level = 0;
+        frame.view = settings.view;
+        for (size_t axis = 0; axis < 3; axis++) {
+          frame.view.origin[axis] = origin[axis];
+        }
+        held = false;
+        frameDone = target.release(queue, waitEvents);
+        Core::get<Timeline>().record(frameDone, "Release frame", Timeline::Category::transfer);
+        queue.flush();
+        return frameDone;
+      }
+      range = activeItems.range(range, totalIterations);
+    } else if (compact && progressive) {
+      range = activeItems.range(range, totalIterations);
+    } else if (compact && !split) {
+      if (currentIteration == 0) {
+        activeItems.reset();
+      }
+      if (activeItems.isEmpty(totalIterations)) {
+        // Every pixel escaped or reached the limit in an earlier frame.
+        currentIteration = totalIterations;
+        queue.enqueueMarkerWithWaitList(&waitEvents, &frameDone);
+        return frameDone;
+      }
+      range = activeItems.range(range, totalIterations);
+    } else {
+      ActiveItemList::unbind(kernel, KernelArg::activeItems);
+    }
+    // Without a list every pixel is launched, a batch of tiles at a time. The
+    // slice goes on until every tile computed it.
+    const bool tiled = !compact || split;
+    const cl_uint depth = range.dimensions() > 2 ? static_cast<cl_uint>(range[2]) : 1;
+    if (tiled && !tiles.isEmpty()) {
+      maxIterationsThisFrame = tiledIteration;
+    } else {
+      // The levels and subdivisions may have started over. Translated points
+      // move one iteration per frame, so the animation shows every step.
+      if (settings.renderMode == options::RenderMode::escape) {
+        iterationsPerFrame = scheduler.slice(range, iterationsPerFrame);
+      }
+      maxIterationsThisFrame = std::min(currentIteration + iterationsPerFrame, totalIterations);
+      if (split) {
+        // The tiles keep the frames to their budget instead.
+        maxIterationsThisFrame = totalIterations;
+        splitIterations = totalIterations;
+      }
+      if (tiled) {
+        // Without a budget the frame is a single tile, unless it is split.
+        const cl_uint side = !scheduler.hasBudget() && !split ?
+          std::max({static_cast<cl_uint>(range[0]), static_cast<cl_uint>(range[1]), depth}) :
+          depth > 1 ? TileQueue::volumeSide : TileQueue::tileSide;
+        tiles.reset(static_cast<cl_uint>(range[0]), static_cast<cl_uint>(range[1]), depth, side);
+        tiledIteration = maxIterationsThisFrame;
+      }
+    }
+    std::vector<Tile> batch;
+    if (tiled) {
+      if (depth > 1) {
+        // Front to back, the voxels closest to the camera hide the others.
+        // The volume spans [-0.5, 0.5] around it.
+        const types::vec3 eye = settings.camera.getPosition();
+        tiles.setFocus(
+          (eye.x + 0.5) * static_cast<double>(range[0]),
+          (eye.y + 0.5) * static_cast<double>(range[1]),
+          (eye.z + 0.5) * static_cast<double>(depth));
+      } else {
+        const std::array<double, 2> focusPixel = focusedPixel(
+          static_cast<cl_uint>(range[0]),
+          static_cast<cl_uint>(range[1]));
+        tiles.setFocus(focusPixel[0], focusPixel[1]);
+      }
+      batch = tiles.take(split ?
+        slabs.batchPixels(static_cast<size_t>(range[0]) * range[1]) :
+        scheduler.batch(range, maxIterationsThisFrame - currentIteration));
+    }
     kernel.setArg(KernelArg::lastIteration, currentIteration);
     kernel.setArg(KernelArg::maxIterations, maxIterationsThisFrame);
+    kernel.setArg(KernelArg::totalIterations, totalIterations);
 
+    Timeline& timeline = Core::get<Timeline>();
     std::vector<cl::Event> bufferDoneEvent{cl::Event()};
-    App::get<ProgramManager>().useBuffer(index, waitEvents, bufferDoneEvent[0]);
-    const cl::CommandQueue& queue = App::get<GPUContext>().queue;
-    std::vector<cl::Event> glObjectsAcquired{cl::Event()};
-    queue.enqueueAcquireGLObjects(&clGlTextures, &bufferDoneEvent, glObjectsAcquired.data());
+    Core::get<ProgramManager>().useBuffer(index, waitEvents, bufferDoneEvent[0]);
+    timeline.record(bufferDoneEvent[0], "Restore work store", Timeline::Category::transfer);
+    Core::get<ProgramManager>().svmKernelArg(kernel, KernelArg::buffer, index);
+    std::vector<cl::Event> targetAcquired = target.acquire(queue, bufferDoneEvent);
+    recordAcquire(targetAcquired, bufferDoneEvent);
+    if (!tiled) {
+      targetAcquired.push_back(activeItems.bind(kernel, KernelArg::activeItems, queue));
+    }
+    // While its local size is tuned, the kernel is launched in parts. The
+    // queue is in order, the parts and tiles run one after the other.
     std::vector<cl::Event> kernelDone{cl::Event()};
-    queue.enqueueNDRangeKernel(
+    cl::Event kernelStarted;
+    LocalSizeTuner& localSizes = Core::get<LocalSizeTuner>();
+    auto launchKernel = [&](const cl::NDRange& offset, const cl::NDRange& global) {
+      const std::vector<LocalSizeTuner::Launch> launches = localSizes.plan(
+        Core::get<GPUContext>().device,
+        kernel,
+        name,
+        precision,
+        offset,
+        global,
+        LocalSizeTuner::Sweep::split);
+      for (const LocalSizeTuner::Launch& launch : launches) {
+        queue.enqueueNDRangeKernel(
+          kernel,
+          launch.offset,
+          launch.global,
+          launch.local,
+          kernelStarted() ? nullptr : &targetAcquired,
+          kernelDone.data());
+        localSizes.record(launch, kernelDone[0]);
+        timeline.record(kernelDone[0], name, Timeline::Category::kernel);
+        if (!kernelStarted()) {
+          kernelStarted = kernelDone[0];
+        }
+      }
+    };
+    size_t launched = 0;
+    if (split) {
+      kernelDone = slabs.enqueue(
+        queue,
+        kernel,
+        [this, totalIterations](cl::Kernel& helperKernel) {
+          setSplitArgs(helperKernel, totalIterations);
+        },
+        target.image(),
+        KernelArg::output,
+        targetAcquired,
+        batch);
+    } else if (tiled) {
+      for (const Tile& tile : batch) {
+        launchKernel(tile.offset(), tile.range());
+        launched += tile.pixels();
+      }
+    } else {
+      launchKernel(cl::NullRange, range);
+    }
+    Core::get<ProgramManager>().releaseBuffer(index, kernelDone[0]);
+    if (!tiled) {
+      activeItems.swap(queue, kernelDone, totalIterations);
+    }
+    // The balancer measures the devices of split frames.
+    if (!split) {
+      scheduler.record(
+        kernelStarted,
+        kernelDone[0],
+        tiled ? cl::NDRange(launched) : range,
+        maxIterationsThisFrame - currentIteration);
+    }
+    if (!tiled || tiles.isEmpty()) {
+      currentIteration = maxIterationsThisFrame;
+    }
+    kernelEvent = kernelDone[0];
+    if (subdivided && level == 0) {
+      // Kept off screen until the subdivision is complete.
+      held = true;
+      queue.enqueueMarkerWithWaitList(&kernelDone, &frameDone);
+      queue.flush();
+      return frameDone;
+    }
+    const std::vector<cl::Event> built = target.buildBricks(queue, brickKernel, frame.level, origin, kernelDone);
+    if (built[0]() != kernelDone[0]()) {
+      timeline.record(built[0], "Occupancy bricks", Timeline::Category::kernel);
+    }
+    held = false;
+    frameDone = target.release(queue, built);
+    timeline.record(frameDone, "Release frame", Timeline::Category::transfer);
+    // Nobody waits for the frame in the UI, start it right away.
+    queue.flush();
+    return frameDone;
+  }
+
+  cl::Event KernelExecutor::enqueueDistance(std::vector<cl::Event>& waitEvents) {
+    const bool traced = isTraced();
+    const cl_uint totalIterations = settings.getMaxIterations();
+    // Slices have no camera, a zero traced flag tells the kernel so.
+    types::cltypes::trace_camera camera{};
+    if (traced) {
+      camera = settings.camera.createTraceCamera(
+        static_cast<real>(canvasSize[0]) / static_cast<real>(canvasSize[1]),
+        canvasSize[1]);
+    }
+    setDistanceArgs(kernel, camera, totalIterations);
+    const cl::NDRange& resolution = Core::get<Settings>().resolution;
+    const cl_uint width = traced ? canvasSize[0] : static_cast<cl_uint>(resolution[0]);
+    const cl_uint height = traced ? canvasSize[1] : static_cast<cl_uint>(resolution[1]);
+    bool preview = false;
+    if (!levelStarted
+        || levelIterations != totalIterations
+        || (traced && (tracedSize != canvasSize || tracedEye != settings.camera.getPosition()))) {
+      // The tiles still queued for the last view are dropped. Without a
+      // budget the frame is a single tile.
+      tiles.reset(width, height, 1, slabs.hasBudget() ? TileQueue::tileSide : std::max(width, height));
+      preview = slabs.hasBudget();
+      levelStarted = true;
+      levelIterations = totalIterations;
+      currentIteration = 0;
+      tracedSize = canvasSize;
+      tracedEye = settings.camera.getPosition();
+    }
+    const std::array<double, 2> focusPixel = focusedPixel(width, height);
+    tiles.setFocus(focusPixel[0], focusPixel[1]);
+    level = 0;
+    frame.level = 0;
+    frame.traced = traced;
+    frame.view = settings.view;
+    for (size_t axis = 0; axis < 3; axis++) {
+      frame.view.origin[axis] = origin[axis];
+    }
+
+    Timeline& timeline = Core::get<Timeline>();
+    std::vector<cl::Event> targetAcquired = target.acquire(queue, waitEvents);
+    recordAcquire(targetAcquired, waitEvents);
+    if (preview) {
+      // A cheap pass over the whole view first, each computed pixel written
+      // over its block, so nothing of the last view is left when the tiles
+      // are presented as they come.
+      std::vector<cl::Event> previewDone{cl::Event()};
+      try {
+        kernel.setArg(DistanceArg::block, previewBlock);
+        queue.enqueueNDRangeKernel(
+          kernel,
+          cl::NullRange,
+          cl::NDRange((width + previewBlock - 1) / previewBlock, (height + previewBlock - 1) / previewBlock),
+          cl::NullRange,
+          &targetAcquired,
+          previewDone.data());
+        kernel.setArg(DistanceArg::block, cl_uint(1));
+      } catch (const cl::Error& e) {
+        throw CLError("Could not enqueue the preview of the distance estimated view", e);
+      }
+      timeline.record(previewDone[0], name + " preview", Timeline::Category::kernel);
+      targetAcquired = previewDone;
+    }
+    const std::vector<cl::Event> kernelDone = slabs.enqueue(
+      queue,
+      kernel,
+      [this, &camera, totalIterations](cl::Kernel& helperKernel) {
+        setDistanceArgs(helperKernel, camera, totalIterations);
+      },
+      target.image(),
+      DistanceArg::output,
+      targetAcquired,
+      tiles.take(slabs.batchPixels(static_cast<size_t>(width) * height)));
+    if (tiles.isEmpty()) {
+      currentIteration = totalIterations;
+    }
+    kernelEvent = kernelDone[0];
+    // Tiles not computed yet keep the preview's blocks, there are no empty
+    // bricks to skip. The helpers' slabs are uploaded by then.
+    frameDone = target.release(queue, kernelDone);
+    timeline.record(frameDone, "Release frame", Timeline::Category::transfer);
+    queue.flush();
+    return frameDone;
+  }
+
+  void KernelExecutor::setDistanceArgs(
+      cl::Kernel& kernel,
+      const types::cltypes::trace_camera& camera,
+      cl_uint totalIterations) {
+    settings.view.asKernelArg(kernel, DistanceArg::view, precision, origin);
+    Core::get<Settings>().parameter.asKernelArg(kernel, DistanceArg::parameter, precision);
+    kernel.setArg(DistanceArg::maxIterations, totalIterations);
+    kernel.setArg(DistanceArg::camera, camera);
+    kernel.setArg(DistanceArg::block, cl_uint(1));
+  }
+
+  void KernelExecutor::setSplitArgs(cl::Kernel& kernel, cl_uint totalIterations) {
+    settings.view.asKernelArg(kernel, KernelArg::view, precision, origin);
+    Core::get<Settings>().parameter.asKernelArg(kernel, KernelArg::parameter, precision);
+    kernel.setArg(KernelArg::buffer, sizeof(cl_mem), nullptr);
+    kernel.setArg(KernelArg::pages, sizeof(cl_mem), nullptr);
+    kernel.setArg(KernelArg::lastIteration, cl_uint(0));
+    kernel.setArg(KernelArg::maxIterations, totalIterations);
+    kernel.setArg(KernelArg::totalIterations, totalIterations);
+    ActiveItemList::unbind(kernel, KernelArg::activeItems);
+  }
+
+  std::array<double, 2> KernelExecutor::focusedPixel(cl_uint width, cl_uint height) const {
+    if (focus) {
+      return {(focus.x + 1.0) / 2.0 * width, (focus.y + 1.0) / 2.0 * height};
+    }
+    return {width / 2.0, height / 2.0};
+  }
+
+  void KernelExecutor::recordAcquire(
+      const std::vector<cl::Event>& acquired,
+      const std::vector<cl::Event>& waitEvents) {
+    // Targets without anything to acquire hand back the events they waited for.
+    for (const cl::Event& event : acquired) {
+      const bool waited = std::any_of(waitEvents.begin(), waitEvents.end(), [&event](const cl::Event& waitEvent) {
+        return waitEvent() == event();
+      });
+      if (!waited) {
+        Core::get<Timeline>().record(event, "Acquire frame", Timeline::Category::transfer);
+      }
+    }
+  }
+
+  bool KernelExecutor::isDistance() const {
+    return settings.renderMode == options::RenderMode::distance && Core::get<GPUContext>().hasDevice();
+  }
+
+  bool KernelExecutor::isTraced() const {
+    return isDistance() && Core::get<Settings>().renderDimensions == options::Dimensions::three;
+  }
+
+  void KernelExecutor::restart() {
+    // The tiles still queued belong to the last view.
+    tiles.clear();
+    splitIterations = 0;
+    currentIteration = 0;
+    level = progressive ? coarsestLevel : 0;
+    levelStarted = false;
+    frame.level = level;
+    // Whatever is kept off screen is computed again.
+    held = false;
+    anchored = true;
+    anchor = settings.view;
+    anchorShift = {0, 0, 0};
+    pendingShift = {0, 0, 0};
+    panPending = false;
+  }
+
+  bool KernelExecutor::detectPan() {
+    // The perturbed kernels compute relative to the view center, which moved.
+    // Pages belong to bricks on screen, which a pan moves.
+    if (!anchored
+        || perturbed
+        || pages.isSparse()
+        || !progressive
+        || settings.renderMode != options::RenderMode::escape
+        || !Core::get<GPUContext>().hasDevice()) {
+      return false;
+    }
+    const types::Viewspace& view = settings.view;
+    const types::cltypes::view_mapping mapping = static_cast<types::cltypes::viewspace>(view).mapping;
+    const types::cltypes::view_mapping anchorMapping = static_cast<types::cltypes::viewspace>(anchor).mapping;
+    if (view.zoom != anchor.zoom
+        || mapping.x != anchorMapping.x
+        || mapping.y != anchorMapping.y
+        || mapping.z != anchorMapping.z) {
+      return false;
+    }
+    const cl::NDRange& resolution = Core::get<Settings>().resolution;
+    const cl_char axes[3] = {mapping.x, mapping.y, mapping.z};
+    bool mapped[MAX_NUMBER_SYSTEM_SIZE] = {};
+    std::array<cl_long, 3> shift{};
+    for (size_t axis = 0; axis < 3; axis++) {
+      if (!axes[axis]) {
+        continue;
+      }
+      const size_t element = static_cast<size_t>(std::abs(axes[axis])) - 1;
+      mapped[element] = true;
+      // Pixel p of the new view is pixel p + pixels of the anchor, see
+      // apply_view_mapping_element().
+      const real pixels = (view.center.raw[element] - anchor.center.raw[element])
+        * std::copysign(view.zoom, real(axes[axis]))
+        * real(resolution[axis]) / 2.0;
+      shift[axis] = std::llround(pixels);
+      if (std::abs(pixels - real(shift[axis])) > panTolerance) {
+        return false;
+      }
+    }
+    for (size_t element = 0; element < MAX_NUMBER_SYSTEM_SIZE; element++) {
+      if (!mapped[element] && view.center.raw[element] != anchor.center.raw[element]) {
+        return false;
+      }
+    }
+    std::array<cl_int, 3> pending = pendingShift;
+    for (size_t axis = 0; axis < 3; axis++) {
+      const cl_long total = pending[axis] + shift[axis] - anchorShift[axis];
+      if (std::abs(total) >= static_cast<cl_long>(resolution[axis])) {
+        // Nothing on screen is kept.
+        return false;
+      }
+      pending[axis] = static_cast<cl_int>(total);
+    }
+    pendingShift = pending;
+    anchorShift = shift;
+    panPending = pendingShift != std::array<cl_int, 3>{0, 0, 0};
+    return true;
+  }
+
+  void KernelExecutor::applyPan(std::vector<cl::Event>& waitEvents, cl_uint totalIterations) {
+    const cl::NDRange& resolution = Core::get<Settings>().resolution;
+    for (size_t axis = 0; axis < 3; axis++) {
+      const cl_long size = static_cast<cl_long>(resolution[axis]);
+      origin[axis] = static_cast<cl_uint>((origin[axis] + pendingShift[axis] + size) % size);
+    }
+    setViewArg();
+    // Once the full resolution is done, the exposed pixels are all that is
+    // left, and they start from the first iteration.
+    const bool onlyExposed = currentIteration >= totalIterations || activeItems.isEmpty(totalIterations);
+    std::vector<cl::Event> bufferDoneEvent{cl::Event()};
+    Core::get<ProgramManager>().useBuffer(index, waitEvents, bufferDoneEvent[0]);
+    Core::get<ProgramManager>().svmKernelArg(exposeKernel, ExposeArg::buffer, index);
+    const cl::Event started = activeItems.seedExposed(
+      exposeKernel,
+      queue,
+      resolution,
+      origin,
+      pendingShift,
+      onlyExposed,
+      bufferDoneEvent,
+      totalIterations);
+    // The queue is in order, the frame's kernel runs after it.
+    Core::get<ProgramManager>().releaseBuffer(index, started);
+    if (onlyExposed) {
+      currentIteration = 0;
+    }
+    pendingShift = {0, 0, 0};
+    panPending = false;
+  }
+
+  void KernelExecutor::setViewArg() {
+    settings.view.asKernelArg(
       kernel,
-      cl::NullRange,
-      App::get<Settings>().resolution,
-      cl::NullRange,
-      &glObjectsAcquired,
-      kernelDone.data());
-    cl::Event releaseDone;
-    queue.enqueueReleaseGLObjects(&clGlTextures, &kernelDone, &releaseDone);
-    currentIteration = maxIterationsThisFrame;
-    return releaseDone;
+      isDistance() ? static_cast<cl_uint>(DistanceArg::view) : static_cast<cl_uint>(KernelArg::view),
+      precision,
+      origin);
+  }
+
+  bool KernelExecutor::advanceLevel(cl_uint totalIterations, cl_uint finestLevel) {
+    if ((level > 0 || pages.isSparse()) && levelIterations != totalIterations) {
+      // The coarser levels stopped at the old limit and the finer ones have
+      // nothing stored yet, so raising the limit can't pick up from here.
+      // Neither can the bricks filled from their corners.
+      restart();
+    }
+    while (true) {
+      if (!levelStarted) {
+        levelIterations = totalIterations;
+        if (level == coarsestLevel && pages.isSparse()) {
+          pages.reset(queue);
+        }
+        activeItems.seedLevel(
+          levelKernel,
+          queue,
+          Core::get<Settings>().resolution,
+          level,
+          coarsestLevel,
+          origin,
+          totalIterations);
+        levelStarted = true;
+      }
+      if (currentIteration < totalIterations && !activeItems.isEmpty(totalIterations)) {
+        return true;
+      }
+      // The frames from here on show this level.
+      frame.level = level;
+      if (level == 0) {
+        if (pages.isSparse() && pages.regrant(
+            regrantKernel,
+            grantedKernel,
+            queue,
+            Core::get<Settings>().resolution,
+            activeItems,
+            totalIterations)) {
+          // Another round, over the bricks that waited for a page.
+          currentIteration = 0;
+          continue;
+        }
+        currentIteration = totalIterations;
+        return false;
+      }
+      if (level == coarsestLevel && pages.isSparse()) {
+        classifyBricks(totalIterations);
+      }
+      if (level == finestLevel) {
+        // The full resolution is left to the caller.
+        level = 0;
+        levelStarted = false;
+        currentIteration = 0;
+        return false;
+      }
+      level--;
+      levelStarted = false;
+      currentIteration = 0;
+    }
+  }
+
+  bool KernelExecutor::advanceSubdivision(std::vector<cl::Event>& waitEvents, cl_uint totalIterations) {
+    if (!levelStarted) {
+      levelIterations = totalIterations;
+      const cl::NDRange& resolution = Core::get<Settings>().resolution;
+      subdivisions.seed(
+        tileKernel,
+        queue,
+        resolution,
+        origin,
+        focusedPixel(static_cast<cl_uint>(resolution[0]), static_cast<cl_uint>(resolution[1])),
+        activeItems,
+        totalIterations);
+      levelStarted = true;
+    }
+    // The counts of the last frame were read by the time it completed.
+    if (currentIteration < totalIterations && !activeItems.isEmpty(totalIterations)) {
+      return true;
+    }
+    if (subdivisions.isEmpty()) {
+      currentIteration = totalIterations;
+      return false;
+    }
+    // The borders of the queued rectangles are done. The round is a frame of
+    // its own, so the UI never waits for it.
+    std::vector<cl::Event> bufferDone{cl::Event()};
+    Core::get<ProgramManager>().useBuffer(index, waitEvents, bufferDone[0]);
+    Core::get<ProgramManager>().svmKernelArg(subdivideKernel, SubdivideArg::buffer, index);
+    Core::get<ProgramManager>().releaseBuffer(
+      index,
+      subdivisions.subdivide(subdivideKernel, queue, bufferDone, origin, activeItems, totalIterations));
+    currentIteration = 0;
+    return false;
+  }
+
+  void KernelExecutor::classifyBricks(cl_uint totalIterations) {
+    std::vector<cl::Event> noEvents;
+    cl::Event bufferDone;
+    Core::get<ProgramManager>().useBuffer(index, noEvents, bufferDone);
+    // A store is only restored on another queue after another window
+    // evicted it, which is rare enough to wait for.
+    bufferDone.wait();
+    Core::get<ProgramManager>().svmKernelArg(classifyKernel, ClassifyArg::buffer, index);
+    Core::get<ProgramManager>().releaseBuffer(index, pages.classify(classifyKernel, queue, totalIterations));
+  }
+
+  options::Precision KernelExecutor::choosePrecision() const {
+    if (!Core::get<GPUContext>().hasDevice()) {
+      return types::hostPrecision;
+    }
+    const ProgramManager& programs = Core::get<ProgramManager>();
+    const std::optional<options::Precision>& forced = Core::get<Settings>().precision;
+    // Single precision perturbation underflows past its maximum zoom.
+    const bool beyondFp32 = settings.view.zoom > types::Viewspace::maxZoomFor(options::Precision::fp32);
+    if (forced && programs.supports(*forced)
+        && !(beyondFp32 && *forced == options::Precision::fp32 && programs.supports(options::Precision::fp64))) {
+      return *forced;
+    }
+    if (!programs.supports(options::Precision::fp64)
+        || settings.view.zoom <= types::Viewspace::zoomLimit(
+          options::Precision::fp32,
+          Core::get<Settings>().numberSystem,
+          Core::get<Settings>().resolution[0])) {
+      return options::Precision::fp32;
+    }
+    return options::Precision::fp64;
+  }
+
+  bool KernelExecutor::usesPerturbation(options::Precision precision) const {
+    return settings.renderMode == options::RenderMode::escape
+      && settings.view.zoom > types::Viewspace::zoomLimit(
+        precision,
+        Core::get<Settings>().numberSystem,
+        Core::get<Settings>().resolution[0]);
+  }
+
+  bool KernelExecutor::updateReference(cl_uint totalIterations) {
+    if (nextReference.valid()) {
+      if (nextReference.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return false;
+      }
+      reference = nextReference.get();
+      bindReference();
+    }
+    const options::NumberSystem numberSystem = Core::get<Settings>().numberSystem;
+    const perturbation::BigNumber center = settings.view.getPreciseCenter();
+    const perturbation::BigNumber zero{};
+    perturbation::BigNumber parameter;
+    for (size_t element = 0; element < MAX_NUMBER_SYSTEM_SIZE; element++) {
+      parameter[element] = perturbation::BigReal(Core::get<Settings>().parameter.raw[element], center[element].precision());
+    }
+    // Phase space pixels differ from the center in c, dynamical space pixels
+    // in z0.
+    const bool phase = settings.space == options::Space::phase;
+    const perturbation::BigNumber& z0 = phase ? zero : center;
+    const perturbation::BigNumber& c = phase ? center : parameter;
+    if (reference.covers(z0, c, numberSystem, totalIterations)) {
+      return true;
+    }
+
+    const size_t pointSize = options::elementCount(numberSystem) * sizeof(real);
+    size_t maxLength = maxReferenceLength;
+    if (Core::get<GPUContext>().hasDevice()) {
+      maxLength = std::min(maxLength, static_cast<size_t>(Core::get<GPUContext>().maxMemAllocSize / pointSize));
+    }
+    // Deep orbits take seconds, which would freeze the UI. The arguments are
+    // copies, the settings may change meanwhile.
+    nextReference = std::async(std::launch::async, [z0, c, numberSystem, totalIterations, maxLength]() {
+      const Timeline::Clock::time_point start = Timeline::Clock::now();
+      perturbation::ReferenceOrbit orbit;
+      orbit.compute(z0, c, numberSystem, totalIterations, maxLength, ProgramManager::escapeValue);
+      Core::get<Timeline>().addSpan(
+        "Computing reference orbit",
+        Timeline::Category::task,
+        start,
+        Timeline::Clock::now() - start);
+      return orbit;
+    });
+    return false;
+  }
+
+  void KernelExecutor::bindReference() {
+    if (!Core::get<GPUContext>().hasDevice()) {
+      hostKernel.setReference(reference.data().data(), reference.length());
+      return;
+    }
+    try {
+      if (precision == types::hostPrecision) {
+        referenceBuffer = cl::Buffer(
+          Core::get<GPUContext>(),
+          CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+          reference.data().size() * sizeof(real),
+          const_cast<real*>(reference.data().data()));
+      } else {
+        std::vector<cl_float> points(reference.data().begin(), reference.data().end());
+        referenceBuffer = cl::Buffer(
+          Core::get<GPUContext>(),
+          CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+          points.size() * sizeof(cl_float),
+          points.data());
+      }
+    } catch (const cl::Error& e) {
+      throw CLError("Could not upload the reference orbit", e);
+    }
+    kernel.setArg(KernelArg::reference, referenceBuffer);
+    kernel.setArg(KernelArg::referenceLength, reference.length());
   }
 }
\ No newline at end of file
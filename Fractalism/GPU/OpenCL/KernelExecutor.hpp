@@ -1,29 +1,76 @@
 #ifndef _FRACTALISM_KERNEL_EXECUTOR_HPP_
 #define _FRACTALISM_KERNEL_EXECUTOR_HPP_
 
+#include <array>
+#include <future>
+#include <string>
+
+#include <Fractalism/CPU/HostKernelExecutor.hpp>
+#include <Fractalism/GPU/OpenCL/ActiveItemList.hpp>
 #include <Fractalism/GPU/OpenCL/CLCommon.hpp>
-#include <Fractalism/GPU/OpenGL/GLTexture3D.hpp>
+#include <Fractalism/GPU/OpenCL/FrameScheduler.hpp>
+#include <Fractalism/GPU/OpenCL/RenderTarget.hpp>
+#include <Fractalism/GPU/OpenCL/SlabBalancer.hpp>
+#include <Fractalism/GPU/OpenCL/SubdivisionQueue.hpp>
+#include <Fractalism/GPU/OpenCL/TileQueue.hpp>
+#include <Fractalism/GPU/OpenCL/WorkStorePages.hpp>
+#include <Fractalism/GPU/Types.hpp>
+#include <Fractalism/Perturbation/ReferenceOrbit.hpp>
 #include <Fractalism/ViewWindowSettings.hpp>
 
 namespace fractalism::gpu::opencl {
 
+/**
+ * @struct ShownFrame
+ * @brief What a frame in the render target holds, for drawing it.
+ */
+struct ShownFrame {
+  cl_uint level;                  ///< The finest level of detail it has every pixel of, see KernelExecutor::setProgressive(). Texels between its pixels are stale.
+  types::cltypes::viewspace view; ///< The view it was computed for, with the origin it is stored at.
+  bool traced;                    ///< Whether it is an image of the canvas traced from the camera, rather than the volume.
+};
+
 /**
  * @class KernelExecutor
  * @brief Manages the execution of OpenCL kernels for fractal rendering.
  */
 class KernelExecutor {
 public:
+  static constexpr size_t maxReferenceLength = size_t(1) << 20; ///< The most reference orbit points to keep.
+  static constexpr cl_uint coarsestLevel = 3;                   ///< Progressive rendering starts at 1/2^coarsestLevel of the resolution.
+  static constexpr real panTolerance = 1e-3;                    ///< How far from whole pixels a view move may be, in pixels, to count as a pan.
+  static constexpr cl_uint previewBlock = 1u << coarsestLevel;  ///< The side of the blocks the first pass of a distance estimated view computes a pixel of.
+  static_assert(WorkStorePages::pageSide == 1u << coarsestLevel, "Pages are bricks between the voxels of the coarsest level.");
+
   /**
    * @brief Constructs a KernelExecutor for a specific view window.
    * @param index The index of the view window.
+   * @param target Where to write the colors to. Must outlive the executor.
    */
-  KernelExecutor(size_t index);
+  KernelExecutor(size_t index, RenderTarget& target);
 
   /**
    * @brief Updates the kernel with the latest parameters.
+   *
+   * If the program of the new kernel is still being built, the executor
+   * keeps the last frame in the render target and swaps the kernel in on the
+   * first enqueue after the build finished.
    */
   void updateKernel();
 
+  /**
+   * @brief Checks if the kernel picked by the last updateKernel() is in use.
+   * @return False while its program is being built.
+   */
+  inline bool isReady() const { return !swapPending; }
+
+  /**
+   * @brief Blocks until the kernel picked by the last updateKernel() is in
+   * use, and has the reference orbit of the view if it is perturbed, for
+   * callers that have nothing to show in the meantime.
+   */
+  void waitForKernel();
+
   /**
    * @brief Updates the resolution of the kernel.
    */
@@ -31,6 +78,11 @@ public:
 
   /**
    * @brief Updates the view parameters of the kernel.
+   *
+   * A pan by whole pixels, while rendering progressively, keeps what was
+   * computed: the output and work store are ring buffers, so only their
+   * origin moves, and only the pixels the pan exposed start over. Paged work
+   * stores start over instead.
    */
   void updateView();
 
@@ -39,27 +91,327 @@ public:
    */
   void updateParameter();
 
+  /**
+   * @brief Clears the render target.
+   */
+  void clearTexture();
+
+  /**
+   * @brief Checks if the last enqueued frame is done. The UI keeps one frame
+   * per window in flight, and shows the one before it meanwhile.
+   * @return True if nothing is in flight.
+   */
+  bool isFrameDone() const;
+
+  /**
+   * @brief Makes escape mode render progressively after each reset: first
+   * every 2^coarsestLevel-th pixel along each axis, then every half as many,
+   * down to every pixel. Each level only computes the pixels the coarser
+   * ones did not. Needs a device and an active item list.
+   * @param progressive Whether to render progressively.
+   */
+  inline void setProgressive(bool progressive) { this->progressive = progressive; }
+
+  /**
+   * @brief Makes 2D escape views use Mariani-Silver subdivision after each
+   * reset instead of the finer progressive levels: only the borders of tiles
+   * are computed, tiles whose border took one iteration count are filled with
+   * it, and the others are split in four. Until every rectangle is filled or
+   * computed the frames stay off screen, and the coarsest level, or the last
+   * frame, stands in. Not used for perturbed kernels, whose pixels may differ
+   * from their border by more than the glitches.
+   * @param subdivision Whether to subdivide.
+   */
+  inline void setSubdivision(bool subdivision) { this->subdivision = subdivision; }
+
+  /**
+   * @brief Sets the device time the next escape frame may take. Its
+   * iterations are picked to fit, from the measured time of the last frames,
+   * instead of ViewWindowSettings::getIterationsPerFrame(). Needs a queue
+   * with profiling enabled.
+   * Distance estimated frames are computed a batch of tiles at a time
+   * instead, as many as fit, and so are the slices of escape and translated
+   * frames without an active item list once a single iteration over every
+   * pixel outlasts the budget.
+   * @param seconds The budget, 0 for the fixed iterations per frame and
+   * whole frames.
+   */
+  inline void setFrameBudget(double seconds) {
+    scheduler.setBudget(seconds);
+    slabs.setBudget(seconds);
+  }
+
+  /**
+   * @brief Sets the point the tiles of flat frames, and the rectangles of
+   * subdivided escape frames, are computed around first. The tiles of
+   * volumes are computed front to back from the camera instead.
+   * @param point The cursor, in [-1, 1] with y up, or
+   * types::Coordinates::none for the center of the view.
+   */
+  inline void setFocus(const types::Coordinates& point) { focus = point; }
+
+  /**
+   * @brief Sets the size of the canvas the frames are drawn on. 3D distance
+   * estimated views trace an image of that size instead of a volume of the
+   * resolution.
+   * @param width The width of the canvas, in pixels.
+   * @param height The height of the canvas, in pixels.
+   */
+  void setCanvasSize(cl_uint width, cl_uint height);
+
+  /**
+   * @brief Gets what the presented frame holds. Its view differs from the
+   * current one until a frame of the current view is done.
+   * @return The presented frame.
+   */
+  const ShownFrame& getShownFrame();
+
   /**
    * @brief Checks if more iterations are needed.
-   * @return True if more iterations are needed, false otherwise.
+   * @return True if more iterations or levels are needed, a finished frame is
+   * still kept off screen or the kernel is not ready, false otherwise.
    */
   bool needsMore() const;
 
+  /**
+   * @brief Gets the number of iterations done since the last reset.
+   * @return The current iteration count.
+   */
+  inline cl_uint getCurrentIteration() const { return currentIteration; }
+
+  /**
+   * @brief Gets the name of the kernel picked by the last updateKernel().
+   * @return The kernel name.
+   */
+  inline const std::string& getKernelName() const { return name; }
+
+  /**
+   * @brief Gets the precision of the kernel picked by the last
+   * updateKernel().
+   * @return The kernel precision.
+   */
+  inline options::Precision getPrecision() const { return precision; }
+
+  /**
+   * @brief Gets the event of the last enqueued kernel, without the render
+   * target synchronization around it.
+   * @return The kernel event. Null if nothing was enqueued on a device yet.
+   */
+  inline const cl::Event& getKernelEvent() const { return kernelEvent; }
+
   /**
    * @brief Enqueues the kernel for execution.
    * @param waitEvents A vector of events to wait for before executing the
    * kernel.
-   * @return An event representing the completion of the kernel execution.
+   * @return An event representing the completion of the frame, with its
+   * colors in the render target. Null if the host kernels were used, since
+   * they run synchronously, or if the kernel is not ready yet.
    */
   cl::Event enqueue(std::vector<cl::Event>& waitEvents);
 
+  /**
+   * @brief Checks if the kernel traces rays from the camera.
+   * @return True for 3D views in distance mode with a device.
+   */
+  bool isTraced() const;
+
   ViewWindowSettings& settings; ///< Settings for the view window.
-  opengl::GLTexture3D texture;  ///< OpenGL texture for rendering.
 private:
-  size_t index;      ///< Index of the view window.
-  cl::Kernel kernel; ///< OpenCL kernel for fractal rendering.
-  std::vector<cl::Memory> clGlTextures; ///< OpenCL-OpenGL shared textures.
-  cl_uint currentIteration;             ///< Current iteration count.
+  /**
+   * @brief Swaps in the kernel picked by updateKernel() if its program is
+   * built, and sets all of its arguments.
+   * @return True if the kernel is in use.
+   * @throws CLBuildError if the program could not be built.
+   */
+  bool trySwap();
+
+  /**
+   * @brief Enqueues a distance estimated kernel, which computes the whole
+   * frame at once, split with the helper devices.
+   * @param waitEvents A vector of events to wait for before executing the
+   * kernel.
+   * @return An event representing the completion of the frame.
+   */
+  cl::Event enqueueDistance(std::vector<cl::Event>& waitEvents);
+
+  /**
+   * @brief Sets the arguments of a distance estimated kernel but the
+   * output.
+   * @param kernel The kernel, of the main device or a helper.
+   * @param camera The camera to trace from.
+   * @param totalIterations The iteration limit.
+   */
+  void setDistanceArgs(cl::Kernel& kernel, const types::cltypes::trace_camera& camera, cl_uint totalIterations);
+
+  /**
+   * @brief Sets the arguments of a helper's escape kernel but the output,
+   * to compute its tiles from scratch to the limit without a work store.
+   * @param kernel The kernel of a helper.
+   * @param totalIterations The iteration limit.
+   */
+  void setSplitArgs(cl::Kernel& kernel, cl_uint totalIterations);
+
+  /**
+   * @brief Gets the pixel of an output the tiles are computed around first.
+   * @param width The width of the output.
+   * @param height The height of the output.
+   * @return The pixel under the focus, or the center without one.
+   */
+  std::array<double, 2> focusedPixel(cl_uint width, cl_uint height) const;
+
+  /**
+   * @brief Records the commands a render target enqueued to acquire its
+   * image on the Timeline.
+   * @param acquired The events target.acquire() returned.
+   * @param waitEvents The events it was passed.
+   */
+  void recordAcquire(const std::vector<cl::Event>& acquired, const std::vector<cl::Event>& waitEvents);
+
+  /**
+   * @brief Checks if the kernel is a distance estimated kernel. The host
+   * kernels have none, they show escape times instead.
+   * @return True in distance mode with a device.
+   */
+  bool isDistance() const;
+
+  /**
+   * @brief Starts over after the view or parameter changed, from the
+   * coarsest level if rendering progressively. Drops the levels in progress.
+   */
+  void restart();
+
+  /**
+   * @brief Checks if the view moved by whole pixels along its axes since the
+   * last restart(), and adds the move to the pending shift.
+   * @return False if the stored pixels can't be reused.
+   */
+  bool detectPan();
+
+  /**
+   * @brief Moves the origin by the pending shift and starts over the pixels
+   * it exposed. If the full resolution was done, the next frames compute
+   * only those, otherwise they continue along with the others.
+   * @param waitEvents The events to wait for.
+   * @param totalIterations The iteration limit.
+   */
+  void applyPan(std::vector<cl::Event>& waitEvents, cl_uint totalIterations);
+
+  /**
+   * @brief Sets the view argument of the kernel, with the current origin.
+   */
+  void setViewArg();
+
+  /**
+   * @brief Lists the pixels of the current level before its first frame,
+   * and moves on to the next finer level once a level is done. With a
+   * paged work store, the pages are handed out after the coarsest level, and
+   * handed over to the bricks that ran out of them after the full
+   * resolution, until none is left waiting.
+   * @param totalIterations The iteration limit.
+   * @param finestLevel The last level to compute. If it is not 0, level is
+   * set to 0 once it is done, and the full resolution left to the caller.
+   * @return False if every level down to finestLevel is done.
+   */
+  bool advanceLevel(cl_uint totalIterations, cl_uint finestLevel);
+
+  /**
+   * @brief Lists the tile borders before the first frame, and fills or
+   * splits the queued rectangles once the pixels listed last are done.
+   * @param waitEvents The events a subdivision has to wait for.
+   * @param totalIterations The iteration limit.
+   * @return True if the pixels listed last need a frame. False if a
+   * subdivision was queued instead, then currentIteration is 0, or if every
+   * rectangle is filled or computed.
+   */
+  bool advanceSubdivision(std::vector<cl::Event>& waitEvents, cl_uint totalIterations);
+
+  /**
+   * @brief Fills the bricks of a paged work store whose corners agree and
+   * hands pages to the others, once the coarsest level is done.
+   * @param totalIterations The iteration limit.
+   */
+  void classifyBricks(cl_uint totalIterations);
+
+  /**
+   * @brief Picks the precision for the current zoom level. Single precision
+   * is used as long as it tells the pixels apart, or if there is no double
+   * precision program.
+   * @return The precision of the kernel to use.
+   */
+  options::Precision choosePrecision() const;
+
+  /**
+   * @brief Checks if the current settings call for the perturbed kernels.
+   * @param precision The precision of the kernel.
+   * @return True in escape mode beyond Viewspace::zoomLimit().
+   */
+  bool usesPerturbation(options::Precision precision) const;
+
+  /**
+   * @brief Keeps the reference orbit up to date. If the view, parameter or
+   * iteration limit moved past it, a new one is computed on a worker thread
+   * and bound once a later call finds it done.
+   * @param totalIterations The iteration limit.
+   * @return True if the kernel has the reference orbit of the current
+   * settings bound.
+   */
+  bool updateReference(cl_uint totalIterations);
+
+  /**
+   * @brief Uploads the reference orbit and binds it to the kernel.
+   */
+  void bindReference();
+
+  size_t index;                            ///< Index of the view window.
+  RenderTarget& target;                    ///< Where the colors are written to.
+  cl::CommandQueue queue;                  ///< The queue of this window's frames.
+  cl::Kernel kernel;                       ///< OpenCL kernel for fractal rendering.
+  cl::Kernel levelKernel;                  ///< Lists the pixels of a level, from the program of kernel.
+  cl::Kernel exposeKernel;                 ///< Starts over the pixels a pan exposed, from the program of kernel.
+  cl::Kernel tileKernel;                   ///< Lists the tile borders to subdivide, from the program of kernel.
+  cl::Kernel subdivideKernel;              ///< Fills or splits the queued rectangles, from the program of kernel.
+  cl::Kernel brickKernel;                  ///< Builds the occupancy bricks of 3D frames, from the program of kernel.
+  cl::Kernel classifyKernel;               ///< Fills or hands pages to the bricks of a paged work store, from the program of kernel.
+  cl::Kernel regrantKernel;                ///< Hands the pages of finished bricks to those that waited, from the program of kernel.
+  cl::Kernel grantedKernel;                ///< Lists the voxels of the bricks handed a page, from the program of kernel.
+  std::shared_future<cl::Program> program; ///< The program of the kernel picked by updateKernel().
+  bool swapPending;                        ///< Whether kernel is still the one before updateKernel().
+  cpu::HostKernelExecutor hostKernel;      ///< Used instead of kernel when there is no OpenCL device.
+  cl_uint currentIteration;                ///< Current iteration count, of the current level.
+  bool progressive;                        ///< Whether escape mode renders coarse levels first.
+  bool subdivision;                        ///< Whether 2D escape views are subdivided instead.
+  cl_uint level;                           ///< The level being computed, 0 for the full resolution.
+  bool levelStarted;                       ///< Whether the pixels of level were listed.
+  cl_uint levelIterations;                 ///< The iteration limit the levels were computed with.
+  bool anchored;                           ///< Whether anchor is the view the stored pixels were computed for.
+  types::Viewspace anchor;                 ///< The view at the last restart(), pans are measured from it.
+  std::array<cl_long, 3> anchorShift;      ///< How many pixels the view moved from anchor, as far as detected.
+  std::array<cl_int, 3> pendingShift;      ///< How many pixels the view moved since the last applyPan().
+  bool panPending;                         ///< Whether pendingShift is waiting for the next enqueue.
+  std::array<cl_uint, 3> origin;           ///< Where the pixel at the top left of the screen is stored.
+  ShownFrame frame;                        ///< What the last enqueued frame holds.
+  ShownFrame shown;                        ///< What the presented frame holds.
+  bool held;                               ///< Whether the target has pixels the last released frame lacks, kept off screen until they make a whole frame.
+  cl::Event kernelEvent;                   ///< Completion of the last enqueued kernel.
+  cl::Event frameDone;                     ///< Completion of the last enqueued frame.
+  ActiveItemList activeItems;              ///< The pixels still iterating in escape mode.
+  SubdivisionQueue subdivisions;           ///< The rectangles left to fill or split.
+  FrameScheduler scheduler;                ///< Sizes the iterations of escape frames to their budget.
+  SlabBalancer slabs;                      ///< Splits distance estimated frames with the helper devices.
+  TileQueue tiles;                         ///< The tiles of the frame, or of the slice of escape or translated iterations, left to compute.
+  cl_uint tiledIteration;                  ///< The iteration the queued escape or translated tiles are computed to.
+  cl_uint splitIterations;                 ///< The limit the escape frame split with the helper devices is computed to, 0 if it is not split.
+  types::Coordinates focus;                ///< The point the tiles are computed around first, see setFocus().
+  WorkStorePages pages;                    ///< The page table of the work store, if it is paged.
+  std::string name;                        ///< The name of kernel.
+  options::Precision precision;            ///< The precision of kernel.
+  bool perturbed;                          ///< Whether kernel is a perturbed kernel.
+  perturbation::ReferenceOrbit reference;  ///< The reference orbit of the perturbed kernel.
+  std::future<perturbation::ReferenceOrbit> nextReference; ///< The reference orbit being computed, if any.
+  cl::Buffer referenceBuffer;              ///< The reference orbit on the device.
+  std::array<cl_uint, 2> canvasSize;       ///< The size of the canvas, see setCanvasSize().
+  std::array<cl_uint, 2> tracedSize;       ///< The canvas size the last traced frame was traced at.
+  types::vec3 tracedEye;                   ///< The camera position the last traced frame was traced from.
 };
 } // namespace fractalism::gpu::opencl
 
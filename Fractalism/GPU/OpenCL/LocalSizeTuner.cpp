@@ -0,0 +1,355 @@
+#include <Fractalism/GPU/OpenCL/LocalSizeTuner.hpp>
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+#include <Fractalism/GPU/OpenCL/ProgramCache.hpp>
+#include <Fractalism/Utils.hpp>
+
+namespace fractalism::gpu::opencl {
+  LocalSizeTuner::LocalSizeTuner() :
+        loaded(false),
+        entries(),
+        deviceNames(),
+        itemSizes() {}
+
+  std::vector<LocalSizeTuner::Launch> LocalSizeTuner::plan(
+      const cl::Device& device,
+      const cl::Kernel& kernel,
+      const std::string& name,
+      options::Precision precision,
+      const cl::NDRange& offset,
+      const cl::NDRange& global,
+      Sweep sweep) {
+    const cl_uint dimensions = static_cast<cl_uint>(global.dimensions());
+    const std::vector<Launch> runtimePick{Launch{offset, global, cl::NullRange, nullptr, 0, 0}};
+    if (dimensions == 0) {
+      return runtimePick;
+    }
+    Size origin{0, 0, 0};
+    Size extent{1, 1, 1};
+    for (cl_uint axis = 0; axis < dimensions; axis++) {
+      origin[axis] = offset.dimensions() ? offset[axis] : 0;
+      extent[axis] = global[axis];
+    }
+    load();
+    try {
+      if (!deviceNames.contains(device())) {
+        deviceNames[device()] = std::format(
+          "{} ({})",
+          device.getInfo<CL_DEVICE_NAME>(),
+          device.getInfo<CL_DRIVER_VERSION>());
+        itemSizes[device()] = device.getInfo<CL_DEVICE_MAX_WORK_ITEM_SIZES>();
+      }
+      const std::vector<size_t>& maxItemSizes = itemSizes[device()];
+      const Key key{deviceNames[device()], name, precision, dimensions};
+      auto found = entries.find(key);
+      if (found == entries.end()) {
+        found = entries.emplace(key, Entry{.candidates = candidatesFor(dimensions)}).first;
+      }
+      Entry& entry = found->second;
+      // The limit belongs to the kernel object, it depends on what its
+      // program was compiled to. A cheap query, unlike a failed launch.
+      const size_t maxGroupSize = kernel.getWorkGroupInfo<CL_KERNEL_WORK_GROUP_SIZE>(device);
+      if (entry.best < 0 && entry.profiled) {
+        measure(entry);
+      }
+      if (entry.best >= 0) {
+        const Size& size = entry.candidates[entry.best].size;
+        if (!fits(size, maxGroupSize, maxItemSizes, extent, dimensions)) {
+          return runtimePick;
+        }
+        return {Launch{offset, global, toLocalRange(size, dimensions), nullptr, 0, 0}};
+      }
+      if (!entry.profiled || entry.started >= trials) {
+        // Waiting for the last trials to complete.
+        return runtimePick;
+      }
+
+      const size_t trial = entry.started;
+      std::vector<Launch> launches;
+      std::vector<size_t> fitting;
+      if (sweep == Sweep::repeat) {
+        for (size_t index = 0; index < entry.candidates.size(); index++) {
+          if (fits(entry.candidates[index].size, maxGroupSize, maxItemSizes, extent, dimensions)) {
+            fitting.push_back(index);
+          }
+        }
+        if (fitting.size() < 2) {
+          return runtimePick;
+        }
+        // Rotated between trials, so no candidate always runs first on a
+        // cold cache.
+        for (size_t part = 0; part < fitting.size(); part++) {
+          const size_t index = fitting[(part + trial) % fitting.size()];
+          launches.push_back(Launch{
+            offset,
+            global,
+            toLocalRange(entry.candidates[index].size, dimensions),
+            &entry,
+            index,
+            trial});
+        }
+      } else {
+        // Split along the outermost axis with more than one item, in parts
+        // every candidate divides along it.
+        cl_uint axis = dimensions - 1;
+        while (axis > 0 && extent[axis] == 1) {
+          axis--;
+        }
+        size_t align = 1;
+        for (const Candidate& candidate : entry.candidates) {
+          align = std::max(align, candidate.size[axis]);
+        }
+        Size part = extent;
+        part[axis] = align;
+        for (size_t index = 0; index < entry.candidates.size(); index++) {
+          if (fits(entry.candidates[index].size, maxGroupSize, maxItemSizes, part, dimensions)) {
+            fitting.push_back(index);
+          }
+        }
+        if (fitting.size() < 2 || extent[axis] / fitting.size() < align) {
+          return runtimePick;
+        }
+        part[axis] = extent[axis] / fitting.size() / align * align;
+        // Rotated between trials, so each candidate runs on other pixels
+        // each time.
+        for (size_t partIndex = 0; partIndex < fitting.size(); partIndex++) {
+          const size_t index = fitting[(partIndex + trial) % fitting.size()];
+          Size partOrigin = origin;
+          partOrigin[axis] += partIndex * part[axis];
+          launches.push_back(Launch{
+            toRange(partOrigin, dimensions),
+            toRange(part, dimensions),
+            toLocalRange(entry.candidates[index].size, dimensions),
+            &entry,
+            index,
+            trial});
+        }
+        const size_t split = fitting.size() * part[axis];
+        if (split < extent[axis]) {
+          // The rest is left to the runtime and not timed.
+          Size restOrigin = origin;
+          restOrigin[axis] += split;
+          Size rest = extent;
+          rest[axis] -= split;
+          launches.push_back(Launch{
+            toRange(restOrigin, dimensions),
+            toRange(rest, dimensions),
+            cl::NullRange,
+            nullptr,
+            0,
+            trial});
+        }
+      }
+      entry.started++;
+      return launches;
+    } catch (const cl::Error&) {
+      // The runtime can always pick.
+      return runtimePick;
+    }
+  }
+
+  void LocalSizeTuner::record(const Launch& launch, const cl::Event& kernelDone) {
+    if (!launch.entry) {
+      return;
+    }
+    double items = 1.0;
+    for (cl_uint axis = 0; axis < launch.global.dimensions(); axis++) {
+      items *= static_cast<double>(launch.global[axis]);
+    }
+    launch.entry->pending.push_back(Pending{kernelDone, launch.candidate, launch.trial, items});
+  }
+
+  std::vector<LocalSizeTuner::Candidate> LocalSizeTuner::candidatesFor(cl_uint dimensions) {
+    std::vector<Size> sizes{{0, 0, 0}};
+    switch (dimensions) {
+    case 1:
+      sizes.insert(sizes.end(), {{64, 1, 1}, {128, 1, 1}, {256, 1, 1}});
+      break;
+    case 2:
+      // Square tiles share more of the orbit between neighbours, wide ones
+      // read whole cache lines of the rows.
+      sizes.insert(sizes.end(), {{8, 8, 1}, {16, 16, 1}, {32, 4, 1}});
+      break;
+    default:
+      // 2D views are launched with a depth of 1.
+      sizes.insert(sizes.end(), {{4, 4, 4}, {8, 8, 2}, {8, 8, 1}, {16, 16, 1}, {32, 4, 1}});
+      break;
+    }
+    std::vector<Candidate> candidates;
+    for (const Size& size : sizes) {
+      candidates.push_back(Candidate{.size = size});
+    }
+    return candidates;
+  }
+
+  bool LocalSizeTuner::fits(
+      const Size& size,
+      size_t maxGroupSize,
+      const std::vector<size_t>& maxItemSizes,
+      const Size& global,
+      cl_uint dimensions) {
+    if (size[0] == 0) {
+      return true;
+    }
+    size_t groupSize = 1;
+    for (cl_uint axis = 0; axis < dimensions; axis++) {
+      if (axis >= maxItemSizes.size() || size[axis] > maxItemSizes[axis] || global[axis] % size[axis] != 0) {
+        return false;
+      }
+      groupSize *= size[axis];
+    }
+    return groupSize <= maxGroupSize;
+  }
+
+  cl::NDRange LocalSizeTuner::toLocalRange(const Size& size, cl_uint dimensions) {
+    return size[0] == 0 ? cl::NullRange : toRange(size, dimensions);
+  }
+
+  cl::NDRange LocalSizeTuner::toRange(const Size& size, cl_uint dimensions) {
+    switch (dimensions) {
+    case 1: return cl::NDRange(size[0]);
+    case 2: return cl::NDRange(size[0], size[1]);
+    default: return cl::NDRange(size[0], size[1], size[2]);
+    }
+  }
+
+  void LocalSizeTuner::measure(Entry& entry) {
+    try {
+      // A trial is measured once all of its parts completed, their times are
+      // only compared to each other.
+      std::map<size_t, bool> complete;
+      for (const Pending& pending : entry.pending) {
+        const bool done = pending.kernelDone.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() == CL_COMPLETE;
+        auto [trial, inserted] = complete.try_emplace(pending.trial, done);
+        trial->second = trial->second && done;
+      }
+      for (const auto& [trial, done] : complete) {
+        if (!done) {
+          continue;
+        }
+        std::vector<std::pair<size_t, double>> times;
+        double total = 0.0;
+        for (const Pending& pending : entry.pending) {
+          if (pending.trial != trial) {
+            continue;
+          }
+          const cl_ulong start = pending.kernelDone.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+          const cl_ulong end = pending.kernelDone.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+          const double perItem = static_cast<double>(end - start) * 1e-9 / std::max(pending.items, 1.0);
+          times.emplace_back(pending.candidate, perItem);
+          total += perItem;
+        }
+        const double average = total / static_cast<double>(times.size());
+        if (average > 0.0) {
+          for (const auto& [candidate, perItem] : times) {
+            entry.candidates[candidate].relativeTime += perItem / average;
+            entry.candidates[candidate].trials++;
+          }
+        }
+        std::erase_if(entry.pending, [trial](const Pending& pending) { return pending.trial == trial; });
+      }
+    } catch (const cl::Error&) {
+      // The queue records no profiling information, the runtime picks.
+      entry.profiled = false;
+      entry.pending.clear();
+      return;
+    }
+    if (entry.started < trials || !entry.pending.empty()) {
+      return;
+    }
+    // Candidates that fit no trial keep the runtime's pick.
+    long best = 0;
+    double bestMean = 0.0;
+    for (size_t index = 0; index < entry.candidates.size(); index++) {
+      const Candidate& candidate = entry.candidates[index];
+      if (!candidate.trials) {
+        continue;
+      }
+      const double mean = candidate.relativeTime / static_cast<double>(candidate.trials);
+      if (bestMean == 0.0 || mean < bestMean) {
+        best = static_cast<long>(index);
+        bestMean = mean;
+      }
+    }
+    entry.best = best;
+    store();
+  }
+
+  void LocalSizeTuner::load() {
+    if (loaded) {
+      return;
+    }
+    loaded = true;
+    std::ifstream file(path());
+    std::string line;
+    while (std::getline(file, line)) {
+      // The device, the kernel, the precision, the dimensions and the local
+      // size, by tabs.
+      std::vector<std::string> fields;
+      std::istringstream stream(line);
+      for (std::string field; std::getline(stream, field, '\t');) {
+        fields.push_back(field);
+      }
+      if (fields.size() != 7) {
+        continue;
+      }
+      options::Precision precision;
+      if (fields[2] == options::name(options::Precision::fp32)) {
+        precision = options::Precision::fp32;
+      } else if (fields[2] == options::name(options::Precision::fp64)) {
+        precision = options::Precision::fp64;
+      } else {
+        continue;
+      }
+      try {
+        const cl_uint dimensions = static_cast<cl_uint>(std::stoul(fields[3]));
+        const Size size{std::stoul(fields[4]), std::stoul(fields[5]), std::stoul(fields[6])};
+        if (dimensions < 1 || dimensions > 3) {
+          continue;
+        }
+        Entry entry{.candidates = candidatesFor(dimensions)};
+        auto stored = std::find_if(
+          entry.candidates.begin(),
+          entry.candidates.end(),
+          [&size](const Candidate& candidate) { return candidate.size == size; });
+        if (stored == entry.candidates.end()) {
+          stored = entry.candidates.insert(entry.candidates.end(), Candidate{.size = size});
+        }
+        entry.best = static_cast<long>(stored - entry.candidates.begin());
+        entries.insert_or_assign(Key{fields[0], fields[1], precision, dimensions}, std::move(entry));
+      } catch (const std::logic_error&) {
+        // A damaged line, its kernel is swept again.
+      }
+    }
+  }
+
+  void LocalSizeTuner::store() const {
+    std::string data;
+    for (const auto& [key, entry] : entries) {
+      if (entry.best < 0) {
+        continue;
+      }
+      const Size& size = entry.candidates[entry.best].size;
+      data += std::format(
+        "{}\t{}\t{}\t{}\t{}\t{}\t{}\n",
+        std::get<0>(key),
+        std::get<1>(key),
+        options::name(std::get<2>(key)),
+        std::get<3>(key),
+        size[0],
+        size[1],
+        size[2]);
+    }
+    // Another process never loads half a file.
+    utils::replaceFile(path(), data);
+  }
+
+  std::filesystem::path LocalSizeTuner::path() {
+    return std::filesystem::path(ProgramCache::directory) / fileName;
+  }
+}
@@ -0,0 +1,212 @@
+#ifndef _FRACTALISM_LOCAL_SIZE_TUNER_HPP_
+#define _FRACTALISM_LOCAL_SIZE_TUNER_HPP_
+
+#include <array>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+#include <Fractalism/Options.hpp>
+
+namespace fractalism::gpu::opencl {
+
+/**
+ * @class LocalSizeTuner
+ * @brief Picks the local work size of the kernel launches per device, by
+ * timing the candidates against each other on the launches themselves.
+ *
+ * The first launches of a kernel program on a device with a given number of
+ * dimensions are trials, which run every candidate that fits, the runtime's
+ * own pick included, over the same work. Kernels that compute each pixel from
+ * scratch run the whole launch once per candidate. Kernels that update a
+ * work store can't be run twice, their launch is split into equal parts
+ * instead, a candidate each, rotated between trials. Each candidate's time
+ * per work item is compared to the others' in the same trial, so the trials
+ * rank the local sizes rather than the frames they ran on. After a few
+ * trials the candidate with the least relative time is kept, and stored
+ * beside the ProgramCache so later runs skip the sweep.
+ *
+ * Only candidates that divide the global size are used, the kernels don't
+ * check for work items past the end of the range. Queues without profiling
+ * information keep the runtime's pick until a stored one exists.
+ */
+class LocalSizeTuner {
+public:
+  static constexpr const char fileName[] = "local_sizes.txt"; ///< The file the picks are stored in, in ProgramCache::directory.
+  static constexpr size_t trials = 3;                         ///< The trials run before a candidate is kept.
+
+  /**
+   * @enum Sweep
+   * @brief How the launches of a kernel can be turned into trials.
+   */
+  enum class Sweep {
+    repeat, ///< The kernel computes its range from scratch, it can be launched once per candidate.
+    split   ///< The kernel updates state, the range is split between the candidates.
+  };
+
+private:
+  struct Entry;
+
+public:
+  /**
+   * @struct Launch
+   * @brief A part of a launch and its picked local size, to be recorded once
+   * enqueued.
+   */
+  struct Launch {
+    cl::NDRange offset; ///< The global offset of the part.
+    cl::NDRange global; ///< The global size of the part.
+    cl::NDRange local;  ///< The local size, cl::NullRange for the runtime's pick.
+    Entry* entry;       ///< The sweep the part is timed for, null if it is not.
+    size_t candidate;   ///< The index of the candidate in the sweep.
+    size_t trial;       ///< The trial the part belongs to.
+  };
+
+  /**
+   * @brief Constructs a tuner, the stored picks are loaded on first use.
+   */
+  LocalSizeTuner();
+
+  /**
+   * @brief Plans a launch. Outside a trial it is a single part.
+   * @param device The device the kernel runs on.
+   * @param kernel The kernel.
+   * @param name The name of the kernel.
+   * @param precision The precision of its program, the programs of each
+   * precision are tuned apart.
+   * @param offset The global offset of the launch, cl::NullRange for none.
+   * @param global The global size of the launch.
+   * @param sweep How the launch can be swept.
+   * @return The parts to enqueue in order, on an in-order queue. They cover
+   * the range once, or each all of it with Sweep::repeat. Their local size
+   * falls back to cl::NullRange if no candidate fits.
+   */
+  std::vector<Launch> plan(
+      const cl::Device& device,
+      const cl::Kernel& kernel,
+      const std::string& name,
+      options::Precision precision,
+      const cl::NDRange& offset,
+      const cl::NDRange& global,
+      Sweep sweep);
+
+  /**
+   * @brief Records an enqueued part, its time is measured once its trial
+   * completed.
+   * @param launch The part.
+   * @param kernelDone The completion of its kernel.
+   */
+  void record(const Launch& launch, const cl::Event& kernelDone);
+
+private:
+  using Key = std::tuple<std::string, std::string, options::Precision, cl_uint>; ///< The device, kernel name, precision and dimensions.
+  using Size = std::array<size_t, 3>;                                            ///< A size along each axis. As a local size, all 0 for the runtime's pick.
+
+  /**
+   * @struct Candidate
+   * @brief A local size and how it did.
+   */
+  struct Candidate {
+    Size size;                 ///< The local size.
+    size_t trials = 0;         ///< The trials it was measured in.
+    double relativeTime = 0.0; ///< The sum over those trials of its time per item over their average.
+  };
+
+  /**
+   * @struct Pending
+   * @brief A part of a trial not measured yet.
+   */
+  struct Pending {
+    cl::Event kernelDone; ///< The completion of the kernel.
+    size_t candidate;     ///< The index of its candidate.
+    size_t trial;         ///< Its trial.
+    double items;         ///< Its work items.
+  };
+
+  /**
+   * @struct Entry
+   * @brief The sweep of a kernel on a device.
+   */
+  struct Entry {
+    std::vector<Candidate> candidates; ///< The local sizes to try.
+    std::vector<Pending> pending;      ///< The parts not measured yet.
+    size_t started = 0;                ///< The trials started.
+    long best = -1;                    ///< The index of the kept candidate, -1 while sweeping.
+    bool profiled = true;              ///< Whether the queue has profiling information.
+  };
+
+  /**
+   * @brief Gets the candidates for a number of dimensions.
+   * @param dimensions The dimensions of the launches.
+   * @return The candidates, the runtime's pick first.
+   */
+  static std::vector<Candidate> candidatesFor(cl_uint dimensions);
+
+  /**
+   * @brief Checks if a local size fits a launch.
+   * @param size The local size.
+   * @param maxGroupSize CL_KERNEL_WORK_GROUP_SIZE of the kernel on the
+   * device.
+   * @param maxItemSizes CL_DEVICE_MAX_WORK_ITEM_SIZES of the device.
+   * @param global The global size of the launch.
+   * @param dimensions The dimensions of the launch.
+   * @return True if the launch can use it.
+   */
+  static bool fits(
+      const Size& size,
+      size_t maxGroupSize,
+      const std::vector<size_t>& maxItemSizes,
+      const Size& global,
+      cl_uint dimensions);
+
+  /**
+   * @brief Converts a local size to a range.
+   * @param size The local size.
+   * @param dimensions The dimensions of the launch.
+   * @return The range, cl::NullRange for the runtime's pick.
+   */
+  static cl::NDRange toLocalRange(const Size& size, cl_uint dimensions);
+
+  /**
+   * @brief Converts the sizes of a global offset or size to a range.
+   * @param size The size along each axis.
+   * @param dimensions The dimensions of the launch.
+   * @return The range.
+   */
+  static cl::NDRange toRange(const Size& size, cl_uint dimensions);
+
+  /**
+   * @brief Folds the completed trials of a sweep into its candidates, and
+   * keeps the best once enough completed.
+   * @param entry The sweep.
+   */
+  void measure(Entry& entry);
+
+  /**
+   * @brief Loads the stored picks, once.
+   */
+  void load();
+
+  /**
+   * @brief Stores the kept picks. Failing to is not an error, the sweep
+   * just runs again next time.
+   */
+  void store() const;
+
+  /**
+   * @brief Gets the file the picks are stored in.
+   * @return The path of the file.
+   */
+  static std::filesystem::path path();
+
+  bool loaded;                                           ///< Whether the stored picks were loaded.
+  std::map<Key, Entry> entries;                          ///< The sweeps, by device, kernel, precision and dimensions.
+  std::map<cl_device_id, std::string> deviceNames;       ///< The key of each device seen, its name and driver version.
+  std::map<cl_device_id, std::vector<size_t>> itemSizes; ///< CL_DEVICE_MAX_WORK_ITEM_SIZES of each device seen.
+};
+} // namespace fractalism::gpu::opencl
+
+#endif
@@ -0,0 +1,117 @@
+#include <Fractalism/GPU/OpenCL/ProgramCache.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+#include <Fractalism/Utils.hpp>
+
+namespace fractalism::gpu::opencl {
+  namespace {
+    // Bump when the file layout changes.
+    static constexpr const char magic[] = "FRACTALISM_CL_BINARY_1\n";
+    static constexpr size_t magicLength = sizeof(magic) - 1;
+
+    // 64 bit FNV-1a, which is stable between runs and platforms unlike
+    // std::hash.
+    static inline std::uint64_t hash(std::uint64_t state, std::string_view data) {
+      for (char c : data) {
+        state ^= static_cast<unsigned char>(c);
+        state *= 0x100000001b3ULL;
+      }
+      // Separate the fields, so moving bytes between them changes the key.
+      state ^= data.size();
+      return state * 0x100000001b3ULL;
+    }
+
+    // The kernels include these, so they are part of the source as much as
+    // the string passed to the compiler.
+    static std::uint64_t hashIncludes(std::uint64_t state) {
+      std::vector<std::filesystem::path> headers;
+      std::error_code error;
+      for (const auto& entry : std::filesystem::directory_iterator(ProgramCache::includeDirectory, error)) {
+        if (entry.is_regular_file()) {
+          headers.push_back(entry.path());
+        }
+      }
+      std::sort(headers.begin(), headers.end());
+      for (const std::filesystem::path& header : headers) {
+        state = hash(state, header.filename().string());
+        state = hash(state, utils::readFile(header.string().c_str()));
+      }
+      return state;
+    }
+  }
+
+  ProgramCache::ProgramCache(
+      const cl::Device& device,
+      cl_ulong maxMemAllocSize,
+      const std::string& source,
+      const std::string& options) :
+        device(device),
+        options(options),
+        path(pathOf(
+          device.getInfo<CL_DEVICE_NAME>(),
+          device.getInfo<CL_DEVICE_VERSION>(),
+          device.getInfo<CL_DRIVER_VERSION>(),
+          maxMemAllocSize,
+          source,
+          options)) {}
+
+  std::filesystem::path ProgramCache::pathOf(
+      const std::string& deviceName,
+      const std::string& deviceVersion,
+      const std::string& driverVersion,
+      cl_ulong maxMemAllocSize,
+      const std::string& source,
+      const std::string& options) {
+    std::uint64_t key = 0xcbf29ce484222325ULL;
+    key = hash(key, source);
+    key = hash(key, options);
+    key = hashIncludes(key);
+    key = hash(key, deviceName);
+    key = hash(key, deviceVersion);
+    key = hash(key, driverVersion);
+    key = hash(key, std::to_string(maxMemAllocSize));
+    return std::filesystem::path(directory) / std::format("{:016x}.bin", key);
+  }
+
+  cl::Program ProgramCache::load(const cl::Context& context) const {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      return cl::Program();
+    }
+    std::vector<unsigned char> binary{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    if (binary.size() <= magicLength || !std::equal(magic, magic + magicLength, binary.begin())) {
+      return cl::Program();
+    }
+    binary.erase(binary.begin(), binary.begin() + magicLength);
+    try {
+      cl::Program program(context, {device}, {binary});
+      // Binaries still need to be built, which is cheap compared to
+      // compiling the source.
+      program.build({device}, options.c_str());
+      return program;
+    } catch (const cl::Error&) {
+      // Truncated, or the driver changed in a way the version does not tell.
+      return cl::Program();
+    }
+  }
+
+  void ProgramCache::store(const cl::Program& program) const {
+    try {
+      cl::Program::Binaries binaries = program.getInfo<CL_PROGRAM_BINARIES>();
+      if (binaries.size() != 1 || binaries[0].empty()) {
+        return;
+      }
+      std::string data(magic, magicLength);
+      data.append(reinterpret_cast<const char*>(binaries[0].data()), binaries[0].size());
+      // Another process never loads half a binary.
+      utils::replaceFile(path, data);
+    } catch (const cl::Error&) {}
+  }
+}
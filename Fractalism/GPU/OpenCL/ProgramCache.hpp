@@ -0,0 +1,86 @@
+#ifndef _FRACTALISM_PROGRAM_CACHE_HPP_
+#define _FRACTALISM_PROGRAM_CACHE_HPP_
+
+#include <filesystem>
+#include <string>
+
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+
+namespace fractalism::gpu::opencl {
+
+/**
+ * @class ProgramCache
+ * @brief Keeps the binaries of built OpenCL programs on disk, so later runs
+ * can skip compiling the kernels from source.
+ *
+ * A binary is keyed by everything that goes into it: the program source, the
+ * kernel headers it includes, the build options and the device and driver it
+ * was built for. Any change to one of them picks a different file, so stale
+ * binaries are never loaded, only left behind.
+ */
+class ProgramCache {
+public:
+  static constexpr const char directory[] = "cl_cache";             ///< Where the binaries are kept, relative to the working directory.
+  static constexpr const char includeDirectory[] = "KernelHeaders"; ///< The headers the program source includes.
+
+  /**
+   * @brief Computes the cache key of a program.
+   * @param device The device the program is built for.
+   * @param maxMemAllocSize CL_DEVICE_MAX_MEM_ALLOC_SIZE of the device.
+   * @param source The program source.
+   * @param options The build options.
+   */
+  ProgramCache(
+      const cl::Device& device,
+      cl_ulong maxMemAllocSize,
+      const std::string& source,
+      const std::string& options);
+
+  /**
+   * @brief Computes the file the binary of a program is cached in. Also
+   * depends on the headers in includeDirectory.
+   * @param deviceName CL_DEVICE_NAME of the device.
+   * @param deviceVersion CL_DEVICE_VERSION of the device.
+   * @param driverVersion CL_DRIVER_VERSION of the device.
+   * @param maxMemAllocSize CL_DEVICE_MAX_MEM_ALLOC_SIZE of the device.
+   * @param source The program source.
+   * @param options The build options.
+   * @return The path of the binary, in directory.
+   */
+  static std::filesystem::path pathOf(
+      const std::string& deviceName,
+      const std::string& deviceVersion,
+      const std::string& driverVersion,
+      cl_ulong maxMemAllocSize,
+      const std::string& source,
+      const std::string& options);
+
+  /**
+   * @brief Loads and builds the cached binary of the program.
+   * @param context The context to create the program in.
+   * @return The built program, or a null program if there is no usable
+   * binary.
+   */
+  cl::Program load(const cl::Context& context) const;
+
+  /**
+   * @brief Stores the binary of a built program. Failing to write the cache
+   * is not an error, the program is just built from source again next time.
+   * @param program The program, built for the device of the key.
+   */
+  void store(const cl::Program& program) const;
+
+  /**
+   * @brief Gets the file the binary is cached in.
+   * @return The path of the binary.
+   */
+  inline const std::filesystem::path& getPath() const { return path; }
+
+private:
+  cl::Device device;          ///< The device the program is built for.
+  std::string options;        ///< The build options.
+  std::filesystem::path path; ///< The file the binary is cached in.
+};
+} // namespace fractalism::gpu::opencl
+
+#endif
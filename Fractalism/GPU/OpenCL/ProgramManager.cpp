@@ -1,40 +1,201 @@
 #include <Fractalism/GPU/OpenCL/ProgramManager.hpp>
 
-#include <Fractalism/App.hpp>
+#include <algorithm>
+#include <cmath>
+#include <format>
+#include <limits>
+
+#include <Fractalism/Core.hpp>
+#include <Fractalism/Exceptions.hpp>
+#include <Fractalism/GPU/OpenCL/WorkStorePages.hpp>
+
+// The parameter names expand to themselves, the text is the body of the
+// macro, as the host kernels compile it.
+#define FORMULA_TEXT(...) FORMULA_STRINGIFY(__VA_ARGS__)
+#define FORMULA_STRINGIFY(...) #__VA_ARGS__
 
 namespace fractalism::gpu::opencl {
-  ProgramManager::ProgramManager(const GPUContext& ctx) : 
-        program(App::doWithStatusMessage("Building OpenCL program...", 
-          &GPUContext::buildProgram,
-          ctx,
-          "z = add(sqr(z), c)",
-          utils::cayleyDicksonConstruction("complex", "real") +
-          utils::cayleyDicksonConstruction("quaternion", "complex") +
-          utils::defineMulticomplexNumberSystem("bicomplex", "complex"),
-          8.0)),
-        svm() {}
+  static constexpr const char function[] = FORMULA_TEXT(
+    KERNEL_FUNCTION(add, sub, conj, mul, sqr, scale, modulus_sq));
+  static constexpr const char perturbationFunction[] = FORMULA_TEXT(
+    PERTURBATION_FUNCTION(add, sub, conj, mul, sqr, scale, modulus_sq));
+
+  // The arithmetic of a number system and every system it is built from.
+  static inline std::string numberSystemDefinitions(options::NumberSystem numberSystem) {
+    const std::string complex = utils::cayleyDicksonConstruction("complex", "real");
+    switch (numberSystem) {
+    case options::NumberSystem::complex:
+      return complex;
+    case options::NumberSystem::quaternion:
+      return complex + utils::cayleyDicksonConstruction("quaternion", "complex");
+    case options::NumberSystem::bicomplex:
+      return complex + utils::defineMulticomplexNumberSystem("bicomplex", "complex");
+    default:
+      throw AssertionError("Invalid number system");
+    }
+  }
+
+  // Only the number system itself gets kernels.
+  static inline std::string kernelNumberSystem(options::NumberSystem numberSystem) {
+    switch (numberSystem) {
+    case options::NumberSystem::complex:
+      return utils::cayleyDicksonConstruction("complex", "real");
+    case options::NumberSystem::quaternion:
+      return utils::cayleyDicksonConstruction("quaternion", "complex");
+    case options::NumberSystem::bicomplex:
+      return utils::defineMulticomplexNumberSystem("bicomplex", "complex");
+    default:
+      throw AssertionError("Invalid number system");
+    }
+  }
+
+  ProgramManager::ProgramManager(const GPUContext& ctx) :
+        ctx(ctx),
+        // The host kernels are compiled in, see CPU/HostKernels.c. Double
+        // precision needs both the device and the host's real to be double.
+        supported{
+          ctx.hasDevice(),
+          ctx.hasDevice() && ctx.fp64 && types::hostPrecision == options::Precision::fp64},
+        programs(),
+        helperPrograms(),
+        stores() {}
 
-  cl::Kernel ProgramManager::findKernel(const std::string& name) const {
-    return cl::Kernel(program, name);
+  std::shared_future<cl::Program> ProgramManager::requestProgram(
+      options::Precision precision,
+      options::NumberSystem numberSystem,
+      types::WorkStoreLayout storeLayout) {
+    if (!supports(precision)) {
+      throw AssertionError(std::format("There is no {} precision program", options::name(precision)));
+    }
+    auto [it, inserted] = programs.try_emplace(Variant(precision, numberSystem, storeLayout));
+    if (inserted) {
+      it->second = build(
+        ctx,
+        precision,
+        numberSystem,
+        storeLayout,
+        std::format(
+          "{}_{}{}{}",
+          options::name(precision),
+          options::name(numberSystem),
+          storeLayout.cycles ? "_cycles" : "",
+          storeLayout.referenceIndices ? "_perturbed" : ""));
+    }
+    return it->second;
+  }
+
+  std::shared_future<cl::Program> ProgramManager::requestHelperProgram(
+      size_t helper,
+      options::Precision precision,
+      options::NumberSystem numberSystem) {
+    if (!helperSupports(helper, precision)) {
+      throw AssertionError(std::format("Helper {} has no {} precision program", helper, options::name(precision)));
+    }
+    const types::WorkStoreLayout storeLayout = types::workStoreLayout(options::RenderMode::distance);
+    auto [it, inserted] = helperPrograms.try_emplace(HelperVariant(helper, Variant(precision, numberSystem, storeLayout)));
+    if (inserted) {
+      it->second = build(
+        ctx.helpers[helper],
+        precision,
+        numberSystem,
+        storeLayout,
+        std::format("helper{}_{}_{}", helper, options::name(precision), options::name(numberSystem)));
+    }
+    return it->second;
+  }
+
+  bool ProgramManager::helperSupports(size_t helper, options::Precision precision) const {
+    // Helpers run the same kernels, double precision needs the host's real
+    // to be double too.
+    return helper < ctx.helpers.size()
+      && (precision == options::Precision::fp32
+        || (ctx.helpers[helper].fp64 && types::hostPrecision == options::Precision::fp64));
+  }
+
+  std::shared_future<cl::Program> ProgramManager::build(
+      const GPUContext& device,
+      options::Precision precision,
+      options::NumberSystem numberSystem,
+      types::WorkStoreLayout storeLayout,
+      const std::string& variant) const {
+    // The worker gets copies of everything but the context. Destroying the
+    // last future waits for the build, so none outlives the manager.
+    return std::async(std::launch::async, &GPUContext::buildProgram,
+      &device,
+      std::string(function),
+      std::string(perturbationFunction),
+      numberSystemDefinitions(numberSystem),
+      kernelNumberSystem(numberSystem),
+      options::elementCount(numberSystem),
+      storeLayout,
+      escapeValue,
+      precision,
+      variant).share();
+  }
+
+  cl::Kernel ProgramManager::findKernel(
+      const std::string& name,
+      options::Precision precision,
+      options::NumberSystem numberSystem,
+      types::WorkStoreLayout storeLayout) {
+    return cl::Kernel(requestProgram(precision, numberSystem, storeLayout).get(), name);
   }
 
   void ProgramManager::createBuffer() {
-    svm.addBuffer();
+    if (Core::get<GPUContext>().hasDevice()) {
+      stores.add();
+    }
   }
 
   void ProgramManager::useBuffer(size_t index, std::vector<cl::Event>& waitEvents, cl::Event& doneEvent) {
-    return svm.useBuffer(index, waitEvents, doneEvent);
+    stores.use(index, waitEvents, doneEvent);
+  }
+
+  void ProgramManager::resizeBuffer(size_t index, size_t blockCount, size_t blockSize) {
+    stores.resize(index, blockCount, blockSize);
+  }
+
+  void ProgramManager::svmKernelArg(cl::Kernel& kernel, cl_uint argIndex, size_t index) const {
+    stores.asKernelArg(kernel, argIndex, index);
   }
 
-  void ProgramManager::svmKernelArg(cl::Kernel& kernel, cl_uint index) const {
-    svm.asKernelArg(kernel, index);
+  cl::size_type ProgramManager::maxResolution(options::Dimensions dimensions) const {
+    const GPUContext& ctx = Core::get<GPUContext>();
+    if (!ctx.hasDevice()) {
+      return std::numeric_limits<cl::size_type>::max();
+    }
+    // Each buffer is a single allocation, and together they share what the
+    // work stores leave of the device.
+    constexpr double denseBuffers = 5.0;
+    const double items = std::min(
+      static_cast<double>(ctx.maxMemAllocSize / sizeof(cl_uint)),
+      ctx.globalMemSize * (1.0 - WorkStores::deviceShare) / (denseBuffers * sizeof(cl_uint)));
+    const double exponent = dimensions == options::Dimensions::three ? 3.0 : 2.0;
+    cl::size_type side = static_cast<cl::size_type>(std::pow(items, 1.0 / exponent));
+    while (side > 0 && std::pow(static_cast<double>(side), exponent) > items) {
+      side--;
+    }
+    return side;
   }
 
   void ProgramManager::updateResolution() {
-    svm.resize(App::get<Settings>().resolution);
+    const Settings& settings = Core::get<Settings>();
+    const cl::size_type limit = maxResolution(settings.renderDimensions);
+    if (settings.resolution[0] > limit) {
+      // Falling back to whole frames would restart the voxels outside the
+      // pages of a paged store on every launch.
+      throw FractalismError(std::format(
+        "A resolution of {} does not fit on the device, {} does at most",
+        settings.resolution[0],
+        limit));
+    }
+    // The host kernels keep their own work store per window.
+    if (Core::get<GPUContext>().hasDevice()) {
+      stores.resize(WorkStorePages::blockCount(settings.resolution, sizeof(types::WorkStoreBlock), false));
+    }
   }
 
   void ProgramManager::freeSvm() {
-    svm.free();
+    stores.free();
   }
 }
\ No newline at end of file
@@ -3,10 +3,16 @@
 
 #include <Fractalism/GPU/GPUContext.hpp>
 #include <Fractalism/GPU/OpenCL/KernelExecutor.hpp>
-#include <Fractalism/GPU/OpenCL/SVMPtr.hpp>
+#include <Fractalism/GPU/OpenCL/WorkStores.hpp>
 #include <Fractalism/GPU/Types.hpp>
+#include <Fractalism/KernelHeaders/formula.h>
 #include <Fractalism/ViewWindowSettings.hpp>
+#include <array>
+#include <future>
+#include <map>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 namespace fractalism::gpu::opencl {
@@ -17,27 +23,102 @@ namespace fractalism::gpu::opencl {
  */
 class ProgramManager {
 public:
+  static constexpr double escapeValue = ESCAPE_VALUE; ///< The squared modulus at which orbits escape.
+
   /**
-   * @brief Constructs a ProgramManager with the given GPU context.
-   * @param ctx The GPU context.
+   * @brief Constructs a ProgramManager with the given GPU context. No program
+   * is built until it is requested.
+   * @param ctx The GPU context. Must outlive the manager.
    */
   ProgramManager(const GPUContext& ctx);
 
   /**
-   * @brief Finds an OpenCL kernel by name.
+   * @brief Starts building the program of a variant on a worker thread,
+   * unless it was requested before.
+   * @param precision The precision of the program.
+   * @param numberSystem The number system of the program.
+   * @param storeLayout The work store planes of the program, see
+   * types::workStoreLayout().
+   * @return The program, ready once the build finished. Getting it rethrows
+   * the build error, if any.
+   * @throws AssertionError if the precision is not supported.
+   */
+  std::shared_future<cl::Program> requestProgram(
+      options::Precision precision,
+      options::NumberSystem numberSystem,
+      types::WorkStoreLayout storeLayout);
+
+  /**
+   * @brief Starts building the program of a variant for one of the
+   * GPUContext::helpers on a worker thread, unless it was requested before.
+   * Helpers keep no work store, the program of the smallest layout runs
+   * every kernel they are given.
+   * @param helper The index of the helper.
+   * @param precision The precision of the program.
+   * @param numberSystem The number system of the program.
+   * @return The program, ready once the build finished. Getting it rethrows
+   * the build error, if any.
+   * @throws AssertionError if the helper does not support the precision.
+   */
+  std::shared_future<cl::Program> requestHelperProgram(
+      size_t helper,
+      options::Precision precision,
+      options::NumberSystem numberSystem);
+
+  /**
+   * @brief Finds an OpenCL kernel by name, waiting for its program to be
+   * built.
    * @param name The name of the kernel.
+   * @param precision The precision of the program to take it from.
+   * @param numberSystem The number system of the program to take it from.
+   * @param storeLayout The work store planes of the program to take it from.
    * @return The OpenCL kernel.
    */
-  cl::Kernel findKernel(const std::string& name) const;
+  cl::Kernel findKernel(
+      const std::string& name,
+      options::Precision precision,
+      options::NumberSystem numberSystem,
+      types::WorkStoreLayout storeLayout);
 
   /**
-   * @brief Creates a buffer for the program.
+   * @brief Checks if programs of a precision can be built. Double precision
+   * needs a device that supports it.
+   * @param precision The precision.
+   * @return True if kernels of that precision can be requested.
+   */
+  inline bool supports(options::Precision precision) const {
+    return supported[static_cast<size_t>(precision)];
+  }
+
+  /**
+   * @brief Checks if one of the GPUContext::helpers can build programs of a
+   * precision.
+   * @param helper The index of the helper.
+   * @param precision The precision.
+   * @return True if requestHelperProgram() can be called with it.
+   */
+  bool helperSupports(size_t helper, options::Precision precision) const;
+
+  /**
+   * @brief Gets the maximum zoom level the views can be rendered at, which
+   * is lower without double precision.
+   * @return Viewspace::maxZoomFor() of the best precision available.
+   */
+  inline real maxZoom() const {
+    if (!supports(options::Precision::fp64) && supports(options::Precision::fp32)) {
+      return types::Viewspace::maxZoomFor(options::Precision::fp32);
+    }
+    return types::Viewspace::maxZoom;
+  }
+
+  /**
+   * @brief Creates the work store of the next view window.
    */
   void createBuffer();
 
   /**
-   * @brief Uses a buffer for the program.
-   * @param index The index of the buffer.
+   * @brief Makes the work store of a window resident on the device.
+   * @param index The index of the window.
    * @param waitEvents A vector of events to wait for before using the buffer.
    * @param doneEvent The event to signal when the buffer is ready.
    */
@@ -47,25 +128,79 @@ public:
       cl::Event& doneEvent);
 
   /**
-   * @brief Sets a kernel argument to use the SVM buffer.
+   * @brief Records the last kernel using the work store of a window, which
+   * evicting the store has to wait for.
+   * @param index The index of the window.
+   * @param kernelDone The event of the kernel.
+   */
+  inline void releaseBuffer(size_t index, const cl::Event& kernelDone) { stores.release(index, kernelDone); }
+
+  /**
+   * @brief Sizes the work store of a window for the blocks of its program,
+   * dropping the contents if the size changes.
+   * @param index The index of the window.
+   * @param blockCount The number of program blocks.
+   * @param blockSize The size of a program block, see
+   * types::workStoreBlockSize().
+   */
+  void resizeBuffer(size_t index, size_t blockCount, size_t blockSize);
+
+  /**
+   * @brief Sets a kernel argument to use the work store of a window. The
+   * store may move while it is not in use, so this is set after each
+   * useBuffer().
    * @param kernel The kernel to set the argument for.
-   * @param index The index of the argument.
+   * @param argIndex The index of the argument.
+   * @param index The index of the window.
    */
-  void svmKernelArg(cl::Kernel& kernel, cl_uint index) const;
+  void svmKernelArg(cl::Kernel& kernel, cl_uint argIndex, size_t index) const;
+
+  /**
+   * @brief Gets the largest resolution the device can hold the output of. The
+   * output and the active item lists stay dense whether the work store is
+   * paged or not: the accumulator, the two textures it is shown from and the
+   * two lists take a uint per pixel or voxel each.
+   * @param dimensions The render dimensions.
+   * @return The largest side, unlimited for the host kernels.
+   */
+  cl::size_type maxResolution(options::Dimensions dimensions) const;
 
   /**
    * @brief Updates the resolution of the program.
+   * @throws FractalismError If the resolution is above maxResolution().
    */
   void updateResolution();
 
   /**
-   * @brief Frees the SVM buffer.
+   * @brief Frees the work stores.
    */
   void freeSvm();
 
 private:
-  cl::Program program;                           ///< The OpenCL program.
-  BackBufferedSvmArrayPtr<types::WorkStore> svm; ///< The SVM buffer.
+  using Variant = std::tuple<options::Precision, options::NumberSystem, types::WorkStoreLayout>; ///< Identifies a program.
+  using HelperVariant = std::pair<size_t, Variant>;                                              ///< Identifies a program of a helper.
+
+  /**
+   * @brief Starts building a program on a worker thread.
+   * @param device The context to build it for.
+   * @param precision The precision of the program.
+   * @param numberSystem The number system of the program.
+   * @param storeLayout The work store planes of the program.
+   * @param variant Names the program in its build log.
+   * @return The program, ready once the build finished.
+   */
+  std::shared_future<cl::Program> build(
+      const GPUContext& device,
+      options::Precision precision,
+      options::NumberSystem numberSystem,
+      types::WorkStoreLayout storeLayout,
+      const std::string& variant) const;
+
+  const GPUContext& ctx;                                                   ///< The context the programs are built for.
+  std::array<bool, 2> supported;                                           ///< Whether each options::Precision can be built.
+  std::map<Variant, std::shared_future<cl::Program>> programs;             ///< The requested programs.
+  std::map<HelperVariant, std::shared_future<cl::Program>> helperPrograms; ///< The requested programs of the helpers.
+  WorkStores stores;                                                       ///< The work store of each window.
 };
 } // namespace fractalism::gpu::opencl
 
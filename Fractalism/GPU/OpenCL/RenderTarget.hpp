@@ -0,0 +1,94 @@
+#ifndef _FRACTALISM_RENDER_TARGET_HPP_
+#define _FRACTALISM_RENDER_TARGET_HPP_
+
+#include <array>
+#include <vector>
+
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+
+namespace fractalism::gpu::opencl {
+
+/**
+ * @class RenderTarget
+ * @brief The RGBA8 volume a KernelExecutor writes its colors to.
+ */
+class RenderTarget {
+public:
+  virtual ~RenderTarget() = default;
+
+  /**
+   * @brief Reallocates the target.
+   * @param range The OpenCL NDRange specifying the new dimensions.
+   */
+  virtual void resize(const cl::NDRange& range) = 0;
+
+  /**
+   * @brief Clears the target.
+   * @param queue The queue the kernels writing the target run on. Null if
+   * there is no device.
+   */
+  virtual void clear(const cl::CommandQueue& queue) = 0;
+
+  /**
+   * @brief Replaces the contents with host RGBA8 data, for the host kernels.
+   * @param range The OpenCL NDRange specifying the dimensions.
+   * @param data The texel data, 4 bytes per texel.
+   */
+  virtual void upload(const cl::NDRange& range, const void* data) = 0;
+
+  /**
+   * @brief Gets the OpenCL image to pass as the kernel output argument.
+   * @return The OpenCL image.
+   */
+  virtual const cl::Memory& image() const = 0;
+
+  /**
+   * @brief Makes the image usable by OpenCL.
+   * @param queue The queue to enqueue on.
+   * @param waitEvents The events to wait for.
+   * @return The events the kernel has to wait for.
+   */
+  virtual std::vector<cl::Event> acquire(
+      const cl::CommandQueue& queue,
+      const std::vector<cl::Event>& waitEvents) {
+    return waitEvents;
+  }
+
+  /**
+   * @brief Builds the occupancy bricks of a 3D frame, for consumers that ray
+   * march the volume, after the kernel ran. They are published along with
+   * the frame by the next release().
+   * @param queue The queue to enqueue on.
+   * @param brickKernel The build_occupancy_bricks kernel.
+   * @param level The level of detail the frame has every pixel of.
+   * @param origin Where the pixel at the top left of the screen is stored.
+   * @param kernelDone The events of the kernel writing the image.
+   * @return The events release() has to wait for.
+   */
+  virtual std::vector<cl::Event> buildBricks(
+      const cl::CommandQueue& queue,
+      cl::Kernel& brickKernel,
+      cl_uint level,
+      const std::array<cl_uint, 3>& origin,
+      const std::vector<cl::Event>& kernelDone) {
+    return kernelDone;
+  }
+
+  /**
+   * @brief Hands the image back after the kernel ran, and publishes the
+   * frame to the consumer of the target.
+   * @param queue The queue to enqueue on.
+   * @param kernelDone The events of the kernel writing the image.
+   * @return An event representing the frame being ready for its consumer.
+   */
+  virtual cl::Event release(
+      const cl::CommandQueue& queue,
+      const std::vector<cl::Event>& kernelDone) {
+    cl::Event done;
+    queue.enqueueMarkerWithWaitList(&kernelDone, &done);
+    return done;
+  }
+};
+} // namespace fractalism::gpu::opencl
+
+#endif
@@ -398,146 +398,6 @@ public:
   size_t itemCount;    ///< Number of items in the SVM array.
   SVMPointer<T*> ptr;  ///< Pointer to the SVM array.
 };
-
-/**
- * @class BackBufferedSvmArrayPtr
- * @brief Manages back-buffered Shared Virtual Memory (SVM) pointers for OpenCL
- * device communication.
- * @tparam T Data type for SVM.
- */
-template<typename T>
-class BackBufferedSvmArrayPtr {
-public:
-  /**
-   * @brief Constructs a back-buffered SVM pointer array.
-   * @param itemCount Number of items in the array.
-   * @param flags Memory flags for SVM.
-   * @param alignment Alignment requirement.
-   */
-  BackBufferedSvmArrayPtr(
-      size_t itemCount,
-      cl_svm_mem_flags flags = CL_MEM_READ_WRITE,
-      cl_uint alignment = 0) :
-        ptr(itemCount, flags, alignment),
-        buffers(),
-        activeBufferIndex(0) {}
-
-  /**
-   * @brief Constructs a back-buffered SVM pointer array from an OpenCL NDRange.
-   * @param range The OpenCL NDRange.
-   * @param flags Memory flags for SVM.
-   * @param alignment Alignment requirement.
-   */
-  BackBufferedSvmArrayPtr(
-      cl::NDRange& range,
-      cl_svm_mem_flags flags = CL_MEM_READ_WRITE,
-      cl_uint alignment = 0) :
-        BackBufferedSvmArrayPtr(range[0] * range[1] * range[2], flags, alignment) {}
-
-  /**
-   * @brief Default constructor.
-   */
-  BackBufferedSvmArrayPtr() : BackBufferedSvmArrayPtr(0, 0) {}
-
-  /**
-   * @brief Resizes the SVM pointer array.
-   * @param itemCount The new number of items in the array.
-   */
-  void resize(size_t itemCount) {
-    ptr.free();
-    ptr = SVMPointerArray<T>(itemCount, ptr.ptr.flags, ptr.ptr.alignment);
-    for (std::vector<std::vector<T>>& buffer : buffers) {
-      buffer.resize(ptr.itemCount);
-      ptr.forEachUnmappedPointer([](
-          T* pointer,
-          size_t size,
-          size_t index,
-          std::vector<std::vector<T>>& buffer) {
-        buffer[index].resize(size);
-      }, buffer);
-    }
-  }
-
-  /**
-   * @brief Resizes the SVM pointer array from an OpenCL NDRange.
-   * @param range The OpenCL NDRange.
-   */
-  void resize(cl::NDRange& range) {
-    resize(range[0] * range[1] * range[2]);
-  }
-
-  /**
-   * @brief Adds a buffer to the back-buffered SVM pointer array.
-   */
-  void addBuffer() {
-    buffers.push_back(ptr.forEachUnmappedPointer([](
-        T* pointer,
-        size_t size,
-        size_t index) {
-      std::vector<T> bufferElement;
-      bufferElement.resize(size);
-      return bufferElement;
-    }));
-  }
-
-  /**
-   * @brief Removes a buffer from the back-buffered SVM pointer array.
-   */
-  void removeBuffer() {
-    buffers.resize(buffers.size() - 1);
-  }
-
-  /**
-   * @brief Uses a buffer for the back-buffered SVM pointer array.
-   * @param bufferIndex The index of the buffer to use.
-   * @param waitEvents A vector of events to wait for before using the buffer.
-   * @param doneEvent The event to signal when the buffer is ready.
-   */
-  void useBuffer(
-      size_t bufferIndex,
-      const std::vector<cl::Event>& waitEvents,
-      cl::Event& doneEvent) {
-    if (activeBufferIndex != bufferIndex) {
-      std::vector<std::vector<T>>& targetBuffer = buffers[bufferIndex];
-      // Get the currently used data out of the SVM, and put the target data into it.
-      ptr.modify(
-          [](T* data, size_t itemCount, size_t index, std::vector<std::vector<T>>& targetBuffer) {
-            utils::memswap(data, targetBuffer[index].data(), itemCount * sizeof(T));
-          },
-          waitEvents, doneEvent, targetBuffer);
-      // Put the data we got out of the SVM back into the last used buffer.
-      targetBuffer.swap(buffers[activeBufferIndex]);
-      activeBufferIndex = bufferIndex;
-    } else {
-      cl::UserEvent noOp(clutils::getClContext());
-      noOp.setStatus(CL_COMPLETE);
-      doneEvent = noOp;
-    }
-  }
-
-  /**
-   * @brief Frees the SVM pointers.
-   */
-  void free() {
-    ptr.free();
-    buffers.clear();
-    activeBufferIndex = 0;
-  }
-
-  /**
-   * @brief Sets the SVM pointer as a kernel argument.
-   * @param kernel The kernel to set the argument for.
-   * @param index The argument index.
-   */
-  void asKernelArg(cl::Kernel& kernel, cl_uint index) const {
-    ptr.asKernelArg(kernel, index);
-  }
-
-private:
-  SVMPointerArray<T> ptr;                           ///< Pointer to the SVM array.
-  std::vector<std::vector<std::vector<T>>>buffers;  ///< Buffers for back-buffering.
-  size_t activeBufferIndex;                         ///< Index of the active buffer.
-};
 } // namespace fractalism::gpu::opencl
 
 #endif // end inlude guard
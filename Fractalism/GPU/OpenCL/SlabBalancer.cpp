@@ -0,0 +1,399 @@
+#include <Fractalism/GPU/OpenCL/SlabBalancer.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+
+#include <Fractalism/Core.hpp>
+#include <Fractalism/Exceptions.hpp>
+#include <Fractalism/GPU/OpenCL/ProgramManager.hpp>
+
+namespace fractalism::gpu::opencl {
+  // Completes the user event the upload of a slab waits for, once the
+  // helper read it back. Events of other contexts can't be waited for.
+  static void CL_CALLBACK signalRead(cl_event, cl_int, void* data) {
+    cl::UserEvent* read = static_cast<cl::UserEvent*>(data);
+    // A failed read leaves the rows of an older frame, the frame goes on.
+    read->setStatus(CL_COMPLETE);
+    delete read;
+  }
+
+  SlabBalancer::SlabBalancer() :
+        name(),
+        precision(options::Precision::fp32),
+        helpers(),
+        mainSpeed(),
+        width(0),
+        height(0),
+        budget(0.0) {}
+
+  SlabBalancer::~SlabBalancer() {
+    waitForUploads();
+  }
+
+  void SlabBalancer::setKernel(
+      const std::string& name,
+      options::Precision precision,
+      options::NumberSystem numberSystem,
+      const std::string& track) {
+    const GPUContext& ctx = Core::get<GPUContext>();
+    if (helpers.empty()) {
+      helpers.resize(ctx.helpers.size());
+      for (size_t index = 0; index < helpers.size(); index++) {
+        // A queue per window, like the main device's.
+        helpers[index].device = ctx.helpers[index].device;
+        helpers[index].queue = ctx.helpers[index].createQueue();
+        Core::get<Timeline>().nameQueue(
+          helpers[index].queue,
+          std::format("{} on {}", track, ctx.helpers[index].device.getInfo<CL_DEVICE_NAME>()));
+      }
+    }
+    this->name = name;
+    this->precision = precision;
+    // Another kernel takes another time per pixel.
+    mainSpeed = Speed{};
+    for (size_t index = 0; index < helpers.size(); index++) {
+      Helper& helper = helpers[index];
+      helper.program = Core::get<ProgramManager>().helperSupports(index, precision) ?
+        Core::get<ProgramManager>().requestHelperProgram(index, precision, numberSystem) :
+        std::shared_future<cl::Program>();
+      helper.kernel = cl::Kernel();
+      helper.speed = Speed{};
+    }
+  }
+
+  void SlabBalancer::resize(cl_uint width, cl_uint height) {
+    waitForUploads();
+    this->width = width;
+    this->height = height;
+    for (Helper& helper : helpers) {
+      // Created on the first frame the helper takes a slab of.
+      helper.image = cl::Image3D();
+      helper.rows.clear();
+      helper.speed.start = cl::Event();
+      helper.speed.end = cl::Event();
+    }
+    mainSpeed.start = cl::Event();
+    mainSpeed.end = cl::Event();
+  }
+
+  void SlabBalancer::free() {
+    waitForUploads();
+    name.clear();
+    for (Helper& helper : helpers) {
+      helper.program = std::shared_future<cl::Program>();
+      helper.kernel = cl::Kernel();
+      helper.image = cl::Image3D();
+      helper.rows = std::vector<cl_uchar>();
+      helper.uploads.clear();
+      helper.speed = Speed{};
+    }
+    mainSpeed = Speed{};
+  }
+
+  bool SlabBalancer::hasHelpers() const {
+    return std::any_of(helpers.begin(), helpers.end(), [](const Helper& helper) {
+      return helper.program.valid();
+    });
+  }
+
+  size_t SlabBalancer::batchPixels(size_t framePixels) const {
+    if (budget <= 0.0) {
+      return framePixels;
+    }
+    if (mainSpeed.pixelsPerSecond <= 0.0) {
+      return std::min(unmeasuredPixels, framePixels);
+    }
+    // Helpers not measured yet are left out, their first slabs come out of
+    // the main device's share.
+    double speed = mainSpeed.pixelsPerSecond;
+    for (const Helper& helper : helpers) {
+      if (helper.kernel()) {
+        speed += helper.speed.pixelsPerSecond;
+      }
+    }
+    return std::min(std::max(static_cast<size_t>(budget * speed), size_t(1)), framePixels);
+  }
+
+  std::vector<cl::Event> SlabBalancer::enqueue(
+      const cl::CommandQueue& queue,
+      cl::Kernel& kernel,
+      const std::function<void(cl::Kernel&)>& setArgs,
+      const cl::Memory& output,
+      cl_uint outputArg,
+      const std::vector<cl::Event>& waitEvents,
+      const std::vector<Tile>& tiles) {
+    measure(mainSpeed);
+    std::vector<Helper*> ready;
+    for (size_t index = 0; index < helpers.size(); index++) {
+      if (prepare(helpers[index], index)) {
+        measure(helpers[index].speed);
+        ready.push_back(&helpers[index]);
+      }
+    }
+
+    // Devices not measured yet count as fast as the average of the others,
+    // or all the same before any was measured.
+    double measuredSpeed = 0.0;
+    size_t measuredCount = 0;
+    if (mainSpeed.pixelsPerSecond > 0.0) {
+      measuredSpeed += mainSpeed.pixelsPerSecond;
+      measuredCount++;
+    }
+    for (const Helper* helper : ready) {
+      if (helper->speed.pixelsPerSecond > 0.0) {
+        measuredSpeed += helper->speed.pixelsPerSecond;
+        measuredCount++;
+      }
+    }
+    const double unmeasured = measuredCount ? measuredSpeed / static_cast<double>(measuredCount) : 1.0;
+    double totalSpeed = speedOf(mainSpeed, unmeasured);
+    for (const Helper* helper : ready) {
+      totalSpeed += speedOf(helper->speed, unmeasured);
+    }
+    size_t totalPixels = 0;
+    for (const Tile& tile : tiles) {
+      totalPixels += tile.pixels();
+    }
+
+    // Each device takes the next tiles until it has its share. The main
+    // device goes first, its tiles need no upload.
+    size_t next = 0;
+    auto takeShare = [&tiles, &next](double share) {
+      std::vector<Tile> slab;
+      double covered = 0.0;
+      while (next < tiles.size() && (slab.empty() || covered < share)) {
+        slab.push_back(tiles[next]);
+        covered += static_cast<double>(tiles[next].pixels());
+        next++;
+      }
+      return slab;
+    };
+    std::vector<Tile> mainSlab = takeShare(totalPixels * speedOf(mainSpeed, unmeasured) / totalSpeed);
+    std::vector<std::vector<Tile>> slabs(ready.size());
+    for (size_t index = 0; index < ready.size(); index++) {
+      const double share = totalPixels * speedOf(ready[index]->speed, unmeasured) / totalSpeed;
+      if (share >= static_cast<double>(minPixels)) {
+        slabs[index] = takeShare(share);
+      }
+    }
+    // Rounding leaves the last tiles over.
+    mainSlab.insert(mainSlab.end(), tiles.begin() + next, tiles.end());
+
+    Timeline& timeline = Core::get<Timeline>();
+    LocalSizeTuner& localSizes = Core::get<LocalSizeTuner>();
+    const cl::Device& device = Core::get<GPUContext>().device;
+    std::vector<cl::Event> done{cl::Event()};
+    try {
+      cl::Event firstKernel;
+      double mainPixels = 0.0;
+      for (const Tile& tile : mainSlab) {
+        // While its local size is tuned, a tile is computed once per
+        // candidate.
+        const std::vector<LocalSizeTuner::Launch> launches = localSizes.plan(
+          device,
+          kernel,
+          name,
+          precision,
+          cl::NDRange(tile.x, tile.y),
+          cl::NDRange(tile.width, tile.height),
+          LocalSizeTuner::Sweep::repeat);
+        for (const LocalSizeTuner::Launch& launch : launches) {
+          queue.enqueueNDRangeKernel(
+            kernel,
+            launch.offset,
+            launch.global,
+            launch.local,
+            firstKernel() ? nullptr : &waitEvents,
+            done.data());
+          localSizes.record(launch, done[0]);
+          timeline.record(done[0], name, Timeline::Category::kernel);
+          if (!firstKernel()) {
+            firstKernel = done[0];
+          }
+        }
+        mainPixels += static_cast<double>(tile.pixels() * launches.size());
+      }
+      if (mainSpeed.profiled) {
+        mainSpeed.start = firstKernel;
+        mainSpeed.end = done[0];
+        mainSpeed.pixels = mainPixels;
+      }
+
+      const cl::Image3D target(output(), true);
+      for (size_t index = 0; index < ready.size(); index++) {
+        if (slabs[index].empty()) {
+          continue;
+        }
+        setArgs(ready[index]->kernel);
+        ready[index]->kernel.setArg(outputArg, ready[index]->image);
+        enqueueSlab(queue, *ready[index], target, slabs[index], done);
+      }
+    } catch (const cl::Error& e) {
+      throw CLError("Could not enqueue the tiles of a frame", e);
+    }
+    return done;
+  }
+
+  void SlabBalancer::enqueueSlab(
+      const cl::CommandQueue& queue,
+      Helper& helper,
+      const cl::Image3D& target,
+      const std::vector<Tile>& slab,
+      std::vector<cl::Event>& done) {
+    Timeline& timeline = Core::get<Timeline>();
+    LocalSizeTuner& localSizes = Core::get<LocalSizeTuner>();
+    const size_t rowPitch = static_cast<size_t>(width) * 4;
+    cl::Event firstKernel;
+    cl::Event lastRead;
+    double pixels = 0.0;
+    for (const Tile& tile : slab) {
+      const std::vector<LocalSizeTuner::Launch> launches = localSizes.plan(
+        helper.device,
+        helper.kernel,
+        name,
+        precision,
+        cl::NDRange(tile.x, tile.y),
+        cl::NDRange(tile.width, tile.height),
+        LocalSizeTuner::Sweep::repeat);
+      for (const LocalSizeTuner::Launch& launch : launches) {
+        cl::Event kernelDone;
+        helper.queue.enqueueNDRangeKernel(
+          helper.kernel,
+          launch.offset,
+          launch.global,
+          launch.local,
+          nullptr,
+          &kernelDone);
+        localSizes.record(launch, kernelDone);
+        timeline.record(kernelDone, name, Timeline::Category::kernel);
+        if (!firstKernel()) {
+          firstKernel = kernelDone;
+        }
+      }
+      helper.queue.enqueueReadImage(
+        helper.image,
+        CL_FALSE,
+        {tile.x, tile.y, 0},
+        {tile.width, tile.height, 1},
+        rowPitch,
+        0,
+        helper.rows.data() + tile.y * rowPitch + tile.x * 4,
+        nullptr,
+        &lastRead);
+      timeline.record(lastRead, "Read slab", Timeline::Category::transfer);
+      pixels += static_cast<double>(tile.pixels() * launches.size());
+    }
+    // The queue is in order, the last read completes after every other.
+    const cl::UserEvent read(Core::get<GPUContext>());
+    lastRead.setCallback(CL_COMPLETE, signalRead, new cl::UserEvent(read));
+    helper.queue.flush();
+    if (helper.speed.profiled) {
+      helper.speed.start = firstKernel;
+      helper.speed.end = lastRead;
+      helper.speed.pixels = pixels;
+    }
+
+    // The main device's queue is in order too, the uploads follow its
+    // kernels.
+    const std::vector<cl::Event> uploadWait{read};
+    helper.uploads.clear();
+    for (const Tile& tile : slab) {
+      cl::Event uploaded;
+      queue.enqueueWriteImage(
+        target,
+        CL_FALSE,
+        {tile.x, tile.y, 0},
+        {tile.width, tile.height, 1},
+        rowPitch,
+        0,
+        helper.rows.data() + tile.y * rowPitch + tile.x * 4,
+        helper.uploads.empty() ? &uploadWait : nullptr,
+        &uploaded);
+      timeline.record(uploaded, "Upload slab", Timeline::Category::transfer);
+      helper.uploads.push_back(uploaded);
+    }
+    done.push_back(helper.uploads.back());
+  }
+
+  bool SlabBalancer::prepare(Helper& helper, size_t index) {
+    if (!helper.program.valid()) {
+      return false;
+    }
+    const GPUContext& ctx = Core::get<GPUContext>().helpers[index];
+    try {
+      if (!helper.kernel()) {
+        if (helper.program.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+          return false;
+        }
+        helper.kernel = cl::Kernel(helper.program.get(), name);
+      }
+      if (!helper.image()) {
+        helper.image = cl::Image3D(
+          ctx.clCtx,
+          CL_MEM_WRITE_ONLY,
+          cl::ImageFormat(CL_RGBA, CL_UNORM_INT8),
+          width,
+          height,
+          1);
+        helper.rows.resize(static_cast<size_t>(width) * height * 4);
+      }
+    } catch (const FractalismError& e) {
+      Core::warn(std::format("{}. Frames are not split with {}.", e.what(), ctx.device.getInfo<CL_DEVICE_NAME>()));
+      helper.program = std::shared_future<cl::Program>();
+      helper.kernel = cl::Kernel();
+      return false;
+    } catch (const cl::Error& e) {
+      Core::warn(std::format(
+        "Could not set up {} to split frames with: {}",
+        ctx.device.getInfo<CL_DEVICE_NAME>(),
+        e.what()));
+      helper.program = std::shared_future<cl::Program>();
+      helper.kernel = cl::Kernel();
+      return false;
+    }
+    return true;
+  }
+
+  void SlabBalancer::measure(Speed& speed) {
+    if (!speed.end()) {
+      return;
+    }
+    double seconds;
+    try {
+      if (speed.end.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() != CL_COMPLETE) {
+        // Measured on the next frame.
+        return;
+      }
+      const cl_ulong start = speed.start.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+      const cl_ulong end = speed.end.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+      seconds = static_cast<double>(end - start) * 1e-9;
+    } catch (const cl::Error&) {
+      // The queue records no profiling information, the split stays even.
+      speed.profiled = false;
+      seconds = 0.0;
+    }
+    speed.start = cl::Event();
+    speed.end = cl::Event();
+    if (seconds <= 0.0) {
+      return;
+    }
+    const double measured = speed.pixels / seconds;
+    speed.pixelsPerSecond = speed.pixelsPerSecond > 0.0 ?
+      smoothing * measured + (1.0 - smoothing) * speed.pixelsPerSecond :
+      measured;
+  }
+
+  double SlabBalancer::speedOf(const Speed& speed, double unmeasured) {
+    return speed.pixelsPerSecond > 0.0 ? speed.pixelsPerSecond : unmeasured;
+  }
+
+  void SlabBalancer::waitForUploads() const {
+    for (const Helper& helper : helpers) {
+      // The queue is in order, the last upload completes after every other.
+      if (!helper.uploads.empty()) {
+        helper.uploads.back().wait();
+      }
+    }
+  }
+}
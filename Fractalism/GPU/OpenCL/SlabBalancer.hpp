@@ -0,0 +1,216 @@
+#ifndef _FRACTALISM_SLAB_BALANCER_HPP_
+#define _FRACTALISM_SLAB_BALANCER_HPP_
+
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+#include <Fractalism/GPU/OpenCL/TileQueue.hpp>
+#include <Fractalism/Options.hpp>
+
+namespace fractalism::gpu::opencl {
+
+/**
+ * @class SlabBalancer
+ * @brief Splits each batch of tiles of a window's frames into a slab per
+ * device, computed by the main device and the GPUContext::helpers in
+ * proportion to their measured speed.
+ *
+ * The main device takes the tiles of the batch that come first and writes
+ * them straight into the render target, which reaches OpenGL through the
+ * interop of the target. Each helper computes its slab in an image of its
+ * own context and reads it back to the host, and the main queue uploads it
+ * into the render target once the reads completed.
+ *
+ * The speed of a device is the pixels per second of its last slab, from the
+ * profiling information of its commands, the read back included for the
+ * helpers. Each batch is split by the latest speeds, so the devices move
+ * toward finishing together, and sized by all of them to fit the frame
+ * budget. Only frames whose pixels are computed from scratch can be split,
+ * the helpers share no work store: distance estimates, and escape frames
+ * computed to the iteration limit at once.
+ */
+class SlabBalancer {
+public:
+  static constexpr double smoothing = 0.5;                                            ///< The weight of the newest slab in the speed of a device.
+  static constexpr size_t minPixels = TileQueue::tileSide * TileQueue::tileSide / 2; ///< The fewest pixels worth a helper's slab, smaller shares stay on the main device.
+  static constexpr size_t unmeasuredPixels = size_t(1) << 16;                         ///< The pixels of a batch before the main device was measured.
+
+  /**
+   * @brief Constructs a balancer without a kernel, which leaves every tile to
+   * the main device.
+   */
+  SlabBalancer();
+
+  /**
+   * @brief Waits for the uploads of the helpers' slabs, which read from its
+   * memory.
+   */
+  ~SlabBalancer();
+
+  SlabBalancer(const SlabBalancer&) = delete;
+  SlabBalancer& operator=(const SlabBalancer&) = delete;
+
+  /**
+   * @brief Requests the programs of a kernel for the helpers that support its
+   * precision. Each helper joins the split once its program is built.
+   * @param name The name of the kernel.
+   * @param precision The precision of the program.
+   * @param numberSystem The number system of the program.
+   * @param track The name of the window's track on the Timeline, the
+   * helpers' queues are named after it.
+   */
+  void setKernel(
+      const std::string& name,
+      options::Precision precision,
+      options::NumberSystem numberSystem,
+      const std::string& track);
+
+  /**
+   * @brief Sizes the helpers' images for the frames.
+   * @param width The width of the frames, in pixels.
+   * @param height The height of the frames, in rows.
+   */
+  void resize(cl_uint width, cl_uint height);
+
+  /**
+   * @brief Drops the kernel and the helpers' images, for windows whose
+   * kernel can't be split.
+   */
+  void free();
+
+  /**
+   * @brief Checks if a helper takes slabs of the kernel, once its program is
+   * built.
+   * @return True if a helper has a program of the kernel.
+   */
+  bool hasHelpers() const;
+
+  /**
+   * @brief Sets the time the window's next batch may take.
+   * @param seconds The budget, 0 for whole frames.
+   */
+  inline void setBudget(double seconds) { budget = seconds; }
+
+  /**
+   * @brief Checks if batches are sized to a budget.
+   * @return False if every batch is a whole frame.
+   */
+  inline bool hasBudget() const { return budget > 0.0; }
+
+  /**
+   * @brief Picks the pixels of the next batch, what the devices did in the
+   * budget by their last slabs.
+   * @param framePixels The pixels of the whole frame, taken without a budget.
+   * @return The pixels, at least 1.
+   */
+  size_t batchPixels(size_t framePixels) const;
+
+  /**
+   * @brief Enqueues a batch of tiles, split between the devices. The batch
+   * before must be done, the helpers' slabs are read back into the same
+   * memory. Each kernel is recorded on the Timeline.
+   * @param queue The main device's queue.
+   * @param kernel The main device's kernel, with every argument set.
+   * @param setArgs Sets every argument but the output of a helper's kernel.
+   * @param output The image of the render target, usable by OpenCL.
+   * @param outputArg The index of the output argument.
+   * @param waitEvents The events to wait for.
+   * @param tiles The tiles, the ones to be done first first. Not empty.
+   * @return The events the batch is done after, the main device's last
+   * kernel first.
+   */
+  std::vector<cl::Event> enqueue(
+      const cl::CommandQueue& queue,
+      cl::Kernel& kernel,
+      const std::function<void(cl::Kernel&)>& setArgs,
+      const cl::Memory& output,
+      cl_uint outputArg,
+      const std::vector<cl::Event>& waitEvents,
+      const std::vector<Tile>& tiles);
+
+private:
+  /**
+   * @struct Speed
+   * @brief How fast a device computed its last slabs.
+   */
+  struct Speed {
+    double pixelsPerSecond = 0.0; ///< The smoothed speed, 0 until measured.
+    cl::Event start;              ///< The first command of the slab not measured yet, null once measured.
+    cl::Event end;                ///< The last command of that slab, on the same queue.
+    double pixels = 0.0;          ///< The pixels of that slab.
+    bool profiled = true;         ///< Whether the queue has profiling information.
+  };
+
+  /**
+   * @struct Helper
+   * @brief What a helper device keeps for this window.
+   */
+  struct Helper {
+    cl::Device device;                       ///< The helper device.
+    cl::CommandQueue queue;                  ///< The queue of this window's slabs.
+    std::shared_future<cl::Program> program; ///< The program of the kernel, invalid if the helper can't run it.
+    cl::Kernel kernel;                       ///< The kernel, null until its program is built.
+    cl::Image3D image;                       ///< The frame in the helper's context, only the slab is written.
+    std::vector<cl_uchar> rows;              ///< The slab read back, each tile where it is in the frame.
+    std::vector<cl::Event> uploads;          ///< The uploads of the last slab, which read rows.
+    Speed speed;                             ///< How fast the helper computes slabs.
+  };
+
+  /**
+   * @brief Creates the kernel and image of a helper once its program is
+   * built. A helper that fails to is dropped with a warning.
+   * @param helper The helper.
+   * @param index The index of the helper.
+   * @return True if the helper can take a slab.
+   */
+  bool prepare(Helper& helper, size_t index);
+
+  /**
+   * @brief Enqueues a helper's slab and the uploads of it.
+   * @param queue The main device's queue.
+   * @param helper The helper.
+   * @param target The image of the render target.
+   * @param slab The tiles of the slab.
+   * @param done Gets the uploads appended.
+   */
+  void enqueueSlab(
+      const cl::CommandQueue& queue,
+      Helper& helper,
+      const cl::Image3D& target,
+      const std::vector<Tile>& slab,
+      std::vector<cl::Event>& done);
+
+  /**
+   * @brief Folds the last slab of a device into its speed, if it completed.
+   * @param speed The speed of the device.
+   */
+  static void measure(Speed& speed);
+
+  /**
+   * @brief Gets the speed to split by, the average of the measured devices
+   * for the others.
+   * @param speed The speed of the device.
+   * @param unmeasured The speed of devices not measured yet.
+   * @return The speed in pixels per second.
+   */
+  static double speedOf(const Speed& speed, double unmeasured);
+
+  /**
+   * @brief Waits for the helpers' uploads, before their memory changes.
+   */
+  void waitForUploads() const;
+
+  std::string name;             ///< The name of the kernel.
+  options::Precision precision; ///< The precision of the kernel's programs.
+  std::vector<Helper> helpers;  ///< One per GPUContext::helpers.
+  Speed mainSpeed;              ///< How fast the main device computes slabs.
+  cl_uint width;                ///< The width of the frames.
+  cl_uint height;               ///< The height of the frames.
+  double budget;                ///< The time the next batch may take, 0 for whole frames.
+};
+} // namespace fractalism::gpu::opencl
+
+#endif
@@ -0,0 +1,148 @@
+#include <Fractalism/GPU/OpenCL/SubdivisionQueue.hpp>
+
+#include <algorithm>
+#include <format>
+#include <vector>
+
+#include <Fractalism/Core.hpp>
+#include <Fractalism/Exceptions.hpp>
+
+namespace fractalism::gpu::opencl {
+  namespace SubdivideArg {
+    enum SubdivideArg : cl_uint {
+      output,
+      buffer,
+      origin,
+      totalIterations,
+      rects,
+      nextRects,
+      nextRectCount,
+      items
+    };
+  }
+
+  void SubdivisionQueue::resize(const cl::NDRange& range) {
+    rects[0] = cl::Buffer();
+    rects[1] = cl::Buffer();
+    count = cl::Buffer();
+    rectCount = 0;
+    countRead = cl::Event();
+    if (range.dimensions() > 2 && range[2] > 1) {
+      return;
+    }
+    const GPUContext& ctx = Core::get<GPUContext>();
+    // Each split leaves quarters of at least 4 by 4 pixels, which no other
+    // rectangle of the round overlaps.
+    const size_t tiles = ((range[0] + tileSize - 2) / tileSize) * ((range[1] + tileSize - 2) / tileSize);
+    const size_t queueSize = (std::max(range[0] * range[1] / 16, tiles) + tiles) * sizeof(cl_uint4);
+    if (queueSize > ctx.maxMemAllocSize) {
+      Core::warn("The subdivision queue does not fit on the device. Every pixel will be computed.");
+      return;
+    }
+    try {
+      cl::Buffer newRects[2] = {
+        cl::Buffer(ctx.clCtx, CL_MEM_READ_WRITE, queueSize),
+        cl::Buffer(ctx.clCtx, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, queueSize)
+      };
+      count = cl::Buffer(ctx.clCtx, CL_MEM_READ_WRITE, sizeof(cl_uint));
+      rects[0] = newRects[0];
+      rects[1] = newRects[1];
+    } catch (const cl::Error& e) {
+      count = cl::Buffer();
+      Core::warn(std::format(
+        "Could not allocate the subdivision queue ({}). Every pixel will be computed.",
+        e.what()));
+    }
+  }
+
+  void SubdivisionQueue::seed(
+      cl::Kernel& tileKernel,
+      const cl::CommandQueue& queue,
+      const cl::NDRange& fullRange,
+      const std::array<cl_uint, 3>& origin,
+      const std::array<double, 2>& focus,
+      ActiveItemList& activeItems,
+      cl_uint totalIterations) {
+    const std::vector<cl_uint4> tiles = firstRects(fullRange, focus);
+    // The first queue is the only one the host writes, and the queues swap
+    // after every subdivision.
+    current = 0;
+    rectCount = static_cast<cl_uint>(tiles.size());
+    countRead = cl::Event();
+    try {
+      if (!tiles.empty()) {
+        queue.enqueueWriteBuffer(rects[current], CL_TRUE, 0, tiles.size() * sizeof(cl_uint4), tiles.data());
+      }
+      tileKernel.setArg(0, static_cast<cl_uint>(fullRange[0]));
+      tileKernel.setArg(1, static_cast<cl_uint>(fullRange[1]));
+      tileKernel.setArg(2, tileSize);
+      tileKernel.setArg(3, cl_uint4{origin[0], origin[1], origin[2], 0});
+    } catch (const cl::Error& e) {
+      throw CLError("Could not queue the tiles to subdivide", e);
+    }
+    activeItems.seed(tileKernel, 4, queue, cl::NDRange(fullRange[0], fullRange[1]), cl::NullRange, totalIterations);
+  }
+
+  std::vector<cl_uint4> SubdivisionQueue::firstRects(const cl::NDRange& fullRange, const std::array<double, 2>& focus) {
+    const cl_uint right = static_cast<cl_uint>(fullRange[0] - 1);
+    const cl_uint bottom = static_cast<cl_uint>(fullRange[1] - 1);
+    std::vector<cl_uint4> tiles;
+    for (cl_uint top = 0; top < bottom; top += tileSize) {
+      for (cl_uint left = 0; left < right; left += tileSize) {
+        tiles.push_back(cl_uint4{left, top, std::min(left + tileSize, right), std::min(top + tileSize, bottom)});
+      }
+    }
+    // The work groups of the first subdivision start in queue order, around
+    // the focus first.
+    const auto focusDistance = [&focus](const cl_uint4& tile) {
+      const double dx = (tile.s[0] + tile.s[2]) / 2.0 - focus[0];
+      const double dy = (tile.s[1] + tile.s[3]) / 2.0 - focus[1];
+      return dx * dx + dy * dy;
+    };
+    std::stable_sort(tiles.begin(), tiles.end(), [&focusDistance](const cl_uint4& a, const cl_uint4& b) {
+      return focusDistance(a) < focusDistance(b);
+    });
+    return tiles;
+  }
+
+  bool SubdivisionQueue::isEmpty() {
+    if (countRead()) {
+      countRead.wait();
+    }
+    return rectCount == 0;
+  }
+
+  cl::Event SubdivisionQueue::subdivide(
+      cl::Kernel& subdivideKernel,
+      const cl::CommandQueue& queue,
+      const std::vector<cl::Event>& waitEvents,
+      const std::array<cl_uint, 3>& origin,
+      ActiveItemList& activeItems,
+      cl_uint totalIterations) {
+    const size_t groups = isEmpty() ? 0 : rectCount;
+    try {
+      subdivideKernel.setArg(SubdivideArg::origin, cl_uint4{origin[0], origin[1], origin[2], 0});
+      subdivideKernel.setArg(SubdivideArg::totalIterations, totalIterations);
+      subdivideKernel.setArg(SubdivideArg::rects, rects[current]);
+      subdivideKernel.setArg(SubdivideArg::nextRects, rects[1 - current]);
+      subdivideKernel.setArg(SubdivideArg::nextRectCount, count);
+      queue.enqueueFillBuffer(count, cl_uint(0), 0, sizeof(cl_uint), &waitEvents);
+    } catch (const cl::Error& e) {
+      throw CLError("Could not subdivide the output", e);
+    }
+    activeItems.seed(
+      subdivideKernel,
+      SubdivideArg::items,
+      queue,
+      cl::NDRange(groups * groupSize),
+      cl::NDRange(groupSize),
+      totalIterations);
+    try {
+      queue.enqueueReadBuffer(count, CL_FALSE, 0, sizeof(cl_uint), &rectCount, nullptr, &countRead);
+    } catch (const cl::Error& e) {
+      throw CLError("Could not read the subdivision count", e);
+    }
+    current = 1 - current;
+    return countRead;
+  }
+}
@@ -0,0 +1,108 @@
+#ifndef _FRACTALISM_SUBDIVISION_QUEUE_HPP_
+#define _FRACTALISM_SUBDIVISION_QUEUE_HPP_
+
+#include <array>
+#include <vector>
+
+#include <Fractalism/GPU/OpenCL/ActiveItemList.hpp>
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+
+namespace fractalism::gpu::opencl {
+
+/**
+ * @class SubdivisionQueue
+ * @brief The rectangles of a 2D escape view that Mariani-Silver subdivision
+ * has yet to fill or split, kept on the device.
+ *
+ * Rendering starts with the borders of square tiles. Once the borders of the
+ * queued rectangles are done, the subdivide_rects kernel fills each one whose
+ * border took one iteration count, and splits the others in four, queueing the
+ * quarters and listing the lines between them in the active item list. The
+ * host only reads the counts, to size the launches.
+ */
+class SubdivisionQueue {
+public:
+  static constexpr cl_uint tileSize = 64;  ///< The side of the first rectangles, in pixels.
+  static constexpr size_t groupSize = 64;  ///< The work items per rectangle.
+
+  /**
+   * @brief Reallocates the queues for a new output size. Only 2D outputs are
+   * subdivided, for others and if the device can't hold the queues, the
+   * queue stays unusable.
+   * @param range The output dimensions.
+   */
+  void resize(const cl::NDRange& range);
+
+  /**
+   * @brief Checks if the queues could be allocated.
+   * @return True if the output can be subdivided.
+   */
+  inline bool isUsable() const { return rects[0]() != nullptr; }
+
+  /**
+   * @brief Starts over with the tiles covering the output, and makes the next
+   * frame cover their borders.
+   * @param tileKernel The list_tile_borders kernel of the current program.
+   * @param queue The queue to list the pixels on.
+   * @param fullRange The whole output.
+   * @param origin Where the pixel at the top left of the screen is stored.
+   * @param focus The pixel the tiles are queued around first.
+   * @param activeItems The list to seed.
+   * @param totalIterations The current iteration limit.
+   */
+  void seed(
+      cl::Kernel& tileKernel,
+      const cl::CommandQueue& queue,
+      const cl::NDRange& fullRange,
+      const std::array<cl_uint, 3>& origin,
+      const std::array<double, 2>& focus,
+      ActiveItemList& activeItems,
+      cl_uint totalIterations);
+
+  /**
+   * @brief Lists the tiles seed() queues. Tiles share their edges, the last
+   * ones end at the edge of the output.
+   * @param fullRange The whole output.
+   * @param focus The pixel the tiles are queued around first.
+   * @return The tiles, (left, top, right, bottom), closest to the focus
+   * first.
+   */
+  static std::vector<cl_uint4> firstRects(const cl::NDRange& fullRange, const std::array<double, 2>& focus);
+
+  /**
+   * @brief Checks if no rectangles are left. Waits for the last subdivision.
+   * @return True once the whole output is filled or computed.
+   */
+  bool isEmpty();
+
+  /**
+   * @brief Fills or splits the queued rectangles, whose borders have to be
+   * done, and makes the next frame cover the pixels still to compute. The
+   * counts are read without waiting, isEmpty() waits for them.
+   * @param subdivideKernel The subdivide_rects kernel of the current program,
+   * with the output and work store arguments set.
+   * @param queue The queue to subdivide on.
+   * @param waitEvents The events to wait for.
+   * @param origin Where the pixel at the top left of the screen is stored.
+   * @param activeItems The list to seed.
+   * @param totalIterations The current iteration limit.
+   * @return The event of the counts being read, after the subdivision.
+   */
+  cl::Event subdivide(
+      cl::Kernel& subdivideKernel,
+      const cl::CommandQueue& queue,
+      const std::vector<cl::Event>& waitEvents,
+      const std::array<cl_uint, 3>& origin,
+      ActiveItemList& activeItems,
+      cl_uint totalIterations);
+
+private:
+  cl::Buffer rects[2];   ///< The queued rectangles and the next ones, (left, top, right, bottom).
+  cl::Buffer count;      ///< Device side length of the next queue.
+  size_t current = 0;    ///< Index of the queue the next subdivision reads.
+  cl_uint rectCount = 0; ///< Length of the current queue, once countRead completes.
+  cl::Event countRead;   ///< Completion of the read of rectCount, null if it was written by the host.
+};
+} // namespace fractalism::gpu::opencl
+
+#endif
@@ -0,0 +1,61 @@
+#include <Fractalism/GPU/OpenCL/TileQueue.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace fractalism::gpu::opencl {
+  TileQueue::TileQueue() :
+        tiles(),
+        focus{0.0, 0.0, 0.5},
+        side(tileSide) {}
+
+  void TileQueue::reset(cl_uint width, cl_uint height, cl_uint depth, cl_uint side) {
+    tiles.clear();
+    this->side = std::max(side, 1u);
+    for (cl_uint z = 0; z < depth; z += this->side) {
+      for (cl_uint y = 0; y < height; y += this->side) {
+        for (cl_uint x = 0; x < width; x += this->side) {
+          tiles.push_back(Tile{
+            x,
+            y,
+            std::min(this->side, width - x),
+            std::min(this->side, height - y),
+            z,
+            std::min(this->side, depth - z)});
+        }
+      }
+    }
+    std::make_heap(tiles.begin(), tiles.end(), [this](const Tile& a, const Tile& b) { return farther(a, b); });
+  }
+
+  void TileQueue::setFocus(double x, double y, double z) {
+    // Small moves keep the order, the cursor moves a little every frame.
+    if (std::abs(x - focus[0]) < side && std::abs(y - focus[1]) < side && std::abs(z - focus[2]) < side) {
+      return;
+    }
+    focus = {x, y, z};
+    std::make_heap(tiles.begin(), tiles.end(), [this](const Tile& a, const Tile& b) { return farther(a, b); });
+  }
+
+  std::vector<Tile> TileQueue::take(size_t pixels) {
+    std::vector<Tile> taken;
+    size_t covered = 0;
+    while (!tiles.empty() && (taken.empty() || covered < pixels)) {
+      std::pop_heap(tiles.begin(), tiles.end(), [this](const Tile& a, const Tile& b) { return farther(a, b); });
+      taken.push_back(tiles.back());
+      covered += tiles.back().pixels();
+      tiles.pop_back();
+    }
+    return taken;
+  }
+
+  bool TileQueue::farther(const Tile& a, const Tile& b) const {
+    auto distanceSq = [this](const Tile& tile) {
+      const double dx = tile.x + tile.width / 2.0 - focus[0];
+      const double dy = tile.y + tile.height / 2.0 - focus[1];
+      const double dz = tile.z + tile.depth / 2.0 - focus[2];
+      return dx * dx + dy * dy + dz * dz;
+    };
+    return distanceSq(a) > distanceSq(b);
+  }
+}
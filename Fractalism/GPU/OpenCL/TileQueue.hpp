@@ -0,0 +1,117 @@
+#ifndef _FRACTALISM_TILE_QUEUE_HPP_
+#define _FRACTALISM_TILE_QUEUE_HPP_
+
+#include <array>
+#include <vector>
+
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+
+namespace fractalism::gpu::opencl {
+
+/**
+ * @struct Tile
+ * @brief A box of a frame, launched with its corner as the global offset.
+ * Tiles of flat frames are a single layer deep.
+ */
+struct Tile {
+  cl_uint x;         ///< The left column.
+  cl_uint y;         ///< The bottom row.
+  cl_uint width;     ///< The columns.
+  cl_uint height;    ///< The rows.
+  cl_uint z = 0;     ///< The first layer.
+  cl_uint depth = 1; ///< The layers.
+
+  /**
+   * @brief Counts the pixels of the tile.
+   * @return The width times the height times the depth.
+   */
+  inline size_t pixels() const { return static_cast<size_t>(width) * height * depth; }
+
+  /**
+   * @brief Gets the offset the tile is launched at.
+   * @return Its corner.
+   */
+  inline cl::NDRange offset() const { return cl::NDRange(x, y, z); }
+
+  /**
+   * @brief Gets the range the tile is launched over.
+   * @return Its size.
+   */
+  inline cl::NDRange range() const { return cl::NDRange(width, height, depth); }
+};
+
+/**
+ * @class TileQueue
+ * @brief The tiles of a frame left to compute, closest to a focus point
+ * first.
+ *
+ * Frames are dispatched a batch of tiles at a time, as many as fit the frame
+ * budget, so a heavy frame never holds up the UI for longer than a frame,
+ * and the pixels around the cursor, or the voxels closest to the camera, are
+ * done first. A view change drops the tiles still queued for the last view.
+ */
+class TileQueue {
+public:
+  static constexpr cl_uint tileSide = 64;   ///< The side of the tiles of flat frames, in pixels. Tiles on the edges are cut short.
+  static constexpr cl_uint volumeSide = 16; ///< The side of the tiles of volumes, as many voxels as a flat tile has pixels.
+
+  /**
+   * @brief Constructs an empty queue.
+   */
+  TileQueue();
+
+  /**
+   * @brief Queues every tile of a frame, dropping the ones still queued.
+   * @param width The width of the frame.
+   * @param height The height of the frame.
+   * @param depth The depth of the frame, 1 for flat frames.
+   * @param side The side of the tiles. A side as large as the frame queues
+   * it as a single tile.
+   */
+  void reset(cl_uint width, cl_uint height, cl_uint depth, cl_uint side);
+
+  /**
+   * @brief Drops the queued tiles.
+   */
+  inline void clear() { tiles.clear(); }
+
+  /**
+   * @brief Checks if every tile was taken.
+   * @return True if no tile is queued.
+   */
+  inline bool isEmpty() const { return tiles.empty(); }
+
+  /**
+   * @brief Moves the point the tiles closest to are taken first. The queued
+   * tiles are reordered if it moved by a tile or more.
+   * @param x The column of the point.
+   * @param y The row of the point.
+   * @param z The layer of the point. The middle of the single layer of flat
+   * frames by default. The camera of a volume may be outside of it.
+   */
+  void setFocus(double x, double y, double z = 0.5);
+
+  /**
+   * @brief Takes the tiles closest to the focus, until they cover a number
+   * of pixels.
+   * @param pixels The pixels to cover. At least one tile is taken.
+   * @return The tiles, closest first. Empty if none is queued.
+   */
+  std::vector<Tile> take(size_t pixels);
+
+private:
+  /**
+   * @brief Orders the heap, the tile closest to the focus on top.
+   * @param a A tile.
+   * @param b Another tile.
+   * @return True if a is farther from the focus than b.
+   */
+  bool farther(const Tile& a, const Tile& b) const;
+
+  std::vector<Tile> tiles;     ///< The queued tiles, a heap by farther().
+  std::array<double, 3> focus; ///< The point the closest tiles are taken first, in pixels.
+  cl_uint side;                ///< The side of the queued tiles.
+};
+} // namespace fractalism::gpu::opencl
+
+#endif
@@ -0,0 +1,153 @@
+#include <Fractalism/GPU/OpenCL/WorkStorePages.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include <Fractalism/Core.hpp>
+#include <Fractalism/Exceptions.hpp>
+#include <Fractalism/GPU/OpenCL/WorkStores.hpp>
+
+namespace fractalism::gpu::opencl {
+  namespace ClassifyArg {
+    enum ClassifyArg : cl_uint {
+      output,
+      buffer,
+      pages,
+      totalIterations
+    };
+  }
+
+  static constexpr size_t pageBlocks = WorkStorePages::pageVoxels / WORK_STORE_BLOCK_SIZE;
+  static_assert(WorkStorePages::pageVoxels % WORK_STORE_BLOCK_SIZE == 0, "Pages must be whole blocks.");
+
+  size_t WorkStorePages::blockCount(const cl::NDRange& range, size_t blockSize, bool compact) {
+    const Layout pages = layout(range, blockSize, compact);
+    if (!pages.sparse) {
+      return types::workStoreBlockCount(range);
+    }
+    return pages.coarseVoxels / WORK_STORE_BLOCK_SIZE + pages.capacity * pageBlocks;
+  }
+
+  WorkStorePages::Layout WorkStorePages::layout(const cl::NDRange& range, size_t blockSize, bool compact) {
+    Layout pages{0, 0, 0, false};
+    if (range.dimensions() < 3 || range[2] <= 1) {
+      return pages;
+    }
+    const size_t budget = static_cast<size_t>(
+      Core::get<GPUContext>().globalMemSize * WorkStores::deviceShare / blockSize);
+    if (!compact && types::workStoreBlockCount(range) <= budget) {
+      return pages;
+    }
+    pages.brickCount = ((range[0] + pageSide - 1) / pageSide)
+      * ((range[1] + pageSide - 1) / pageSide)
+      * ((range[2] + pageSide - 1) / pageSide);
+    pages.coarseVoxels = types::workStoreBlockCount(cl::NDRange(pages.brickCount)) * WORK_STORE_BLOCK_SIZE;
+    const size_t coarseBlocks = pages.coarseVoxels / WORK_STORE_BLOCK_SIZE;
+    // The corners are kept even if they alone exceed the budget.
+    pages.capacity = std::min(pages.brickCount, (budget - std::min(budget, coarseBlocks)) / pageBlocks);
+    if (compact) {
+      // The boundary is usually a small part of the bricks, the rest of it
+      // waits for the next round.
+      pages.capacity = std::min(pages.capacity, (pages.brickCount + compactShare - 1) / compactShare);
+    }
+    pages.sparse = true;
+    return pages;
+  }
+
+  void WorkStorePages::resize(const cl::NDRange& range, size_t blockSize, bool compact) {
+    table = cl::Buffer();
+    const Layout pages = layout(range, blockSize, compact);
+    brickCount = pages.brickCount;
+    capacity = pages.capacity;
+    if (!pages.sparse) {
+      return;
+    }
+    // No brick has a page until the coarsest level was classified.
+    std::vector<cl_uint> initial(headerSize + brickCount, WORK_STORE_NO_PAGE);
+    initial[PAGE_TABLE_COARSE_VOXELS] = static_cast<cl_uint>(pages.coarseVoxels);
+    initial[PAGE_TABLE_CAPACITY] = static_cast<cl_uint>(pages.capacity);
+    initial[PAGE_TABLE_USED] = 0;
+    try {
+      table = cl::Buffer(
+        Core::get<GPUContext>().clCtx,
+        CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+        initial.size() * sizeof(cl_uint),
+        initial.data());
+    } catch (const cl::Error& e) {
+      throw CLError("Could not allocate the work store page table", e);
+    }
+  }
+
+  void WorkStorePages::asKernelArg(cl::Kernel& kernel, cl_uint argIndex) const {
+    try {
+      if (table()) {
+        kernel.setArg(argIndex, table);
+      } else {
+        kernel.setArg(argIndex, sizeof(cl_mem), nullptr);
+      }
+    } catch (const cl::Error& e) {
+      throw CLKernelArgError("Work store page table", kernel, argIndex, e);
+    }
+  }
+
+  void WorkStorePages::reset(const cl::CommandQueue& queue) {
+    try {
+      queue.enqueueFillBuffer(table, cl_uint(0), PAGE_TABLE_USED * sizeof(cl_uint), sizeof(cl_uint));
+      queue.enqueueFillBuffer(
+        table,
+        cl_uint(WORK_STORE_NO_PAGE),
+        headerSize * sizeof(cl_uint),
+        brickCount * sizeof(cl_uint));
+    } catch (const cl::Error& e) {
+      throw CLError("Could not reset the work store page table", e);
+    }
+  }
+
+  cl::Event WorkStorePages::classify(cl::Kernel& classifyKernel, const cl::CommandQueue& queue, cl_uint totalIterations) {
+    cl::Event classified;
+    try {
+      classifyKernel.setArg(ClassifyArg::pages, table);
+      classifyKernel.setArg(ClassifyArg::totalIterations, totalIterations);
+      queue.enqueueNDRangeKernel(
+        classifyKernel,
+        cl::NullRange,
+        cl::NDRange(brickCount * groupSize),
+        cl::NDRange(groupSize),
+        nullptr,
+        &classified);
+    } catch (const cl::Error& e) {
+      throw CLError("Could not classify the work store bricks", e);
+    }
+    return classified;
+  }
+
+  bool WorkStorePages::regrant(
+      cl::Kernel& regrantKernel,
+      cl::Kernel& listKernel,
+      const cl::CommandQueue& queue,
+      const cl::NDRange& range,
+      ActiveItemList& activeItems,
+      cl_uint totalIterations) {
+    if (capacity == 0) {
+      return false;
+    }
+    cl_uint waiting = 0;
+    try {
+      regrantKernel.setArg(0, table);
+      queue.enqueueFillBuffer(table, cl_uint(0), PAGE_TABLE_USED * sizeof(cl_uint), sizeof(cl_uint));
+      queue.enqueueNDRangeKernel(regrantKernel, cl::NullRange, cl::NDRange(brickCount), cl::NullRange);
+      queue.enqueueReadBuffer(table, CL_TRUE, PAGE_TABLE_USED * sizeof(cl_uint), sizeof(cl_uint), &waiting);
+      listKernel.setArg(0, static_cast<cl_uint>(range[0]));
+      listKernel.setArg(1, static_cast<cl_uint>(range[1]));
+      listKernel.setArg(2, static_cast<cl_uint>(range[2]));
+      listKernel.setArg(3, table);
+    } catch (const cl::Error& e) {
+      throw CLError("Could not hand the work store pages over", e);
+    }
+    if (waiting == 0) {
+      return false;
+    }
+    activeItems.seed(listKernel, 4, queue, cl::NDRange(brickCount * groupSize), cl::NDRange(groupSize), totalIterations);
+    return true;
+  }
+}
@@ -0,0 +1,141 @@
+#ifndef _FRACTALISM_WORK_STORE_PAGES_HPP_
+#define _FRACTALISM_WORK_STORE_PAGES_HPP_
+
+#include <Fractalism/GPU/OpenCL/ActiveItemList.hpp>
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+#include <Fractalism/GPU/Types.hpp>
+
+namespace fractalism::gpu::opencl {
+
+/**
+ * @class WorkStorePages
+ * @brief The page table of a window's work store, for 3D views whose dense
+ * store would not fit in the budget of WorkStores, and for compact stores.
+ *
+ * A paged store keeps the first corner of every brick of pageSide voxels per
+ * side, which is all the coarsest progressive level computes. Once that level
+ * is done, the classify_bricks kernel fills the bricks whose corners agree
+ * and hands pages to the others, so the finer levels only compute the bricks
+ * the boundary of the fractal runs through. Bricks that find no page left
+ * wait, filled, until the full resolution is done: the pages are then taken
+ * back, their voxels finished, and handed to the waiting bricks, round after
+ * round. The table lives on the device, the host only reads the count of
+ * pages handed out.
+ *
+ * A compact store is paged even if its dense store fits, with pages for one
+ * in compactShare bricks: a finished voxel only keeps its color in the
+ * output, so only the bricks still iterating need their iteration state.
+ */
+class WorkStorePages {
+public:
+  static constexpr cl_uint pageSide = WORK_STORE_PAGE_SIDE;                    ///< The side of a brick, in voxels.
+  static constexpr size_t pageVoxels = size_t(pageSide) * pageSide * pageSide; ///< The voxels per page.
+  static constexpr size_t headerSize = PAGE_TABLE_HEADER;                      ///< The uints before the page of the first brick.
+  static constexpr size_t groupSize = 64;                                      ///< The work items per brick when classifying.
+  static constexpr size_t compactShare = 8;                                    ///< A compact store has pages for one in this many bricks.
+
+  /**
+   * @brief Gets the number of work store blocks a window needs.
+   * @param range The output dimensions.
+   * @param blockSize The size of a block of the window's program.
+   * @param compact Whether a 3D store is paged even if its dense store
+   * fits.
+   * @return The blocks of the dense store if it is not paged, of the paged
+   * store otherwise.
+   */
+  static size_t blockCount(const cl::NDRange& range, size_t blockSize, bool compact);
+
+  /**
+   * @brief Reallocates the page table for a new output size or program. Only
+   * 3D outputs whose dense store does not fit, or that are compact, are
+   * paged.
+   * @param range The output dimensions.
+   * @param blockSize The size of a block of the window's program.
+   * @param compact Whether a 3D store is paged even if its dense store
+   * fits. Its kernels have to render progressively from an active item
+   * list.
+   */
+  void resize(const cl::NDRange& range, size_t blockSize, bool compact);
+
+  /**
+   * @brief Checks if the store is paged.
+   * @return True if the page table is in use.
+   */
+  inline bool isSparse() const { return table() != nullptr; }
+
+  /**
+   * @brief Sets the page table as a kernel argument, null if the store is
+   * dense.
+   * @param kernel The kernel to set the argument for.
+   * @param argIndex The argument index.
+   */
+  void asKernelArg(cl::Kernel& kernel, cl_uint argIndex) const;
+
+  /**
+   * @brief Takes back every page, before the coarsest level starts over.
+   * @param queue The queue the kernels run on.
+   */
+  void reset(const cl::CommandQueue& queue);
+
+  /**
+   * @brief Fills or hands pages to the bricks, once the coarsest level is
+   * done.
+   * @param classifyKernel The classify_bricks kernel of the current program,
+   * with the output and work store arguments set.
+   * @param queue The queue the kernels run on.
+   * @param totalIterations The iteration limit.
+   * @return The event of the kernel.
+   */
+  cl::Event classify(cl::Kernel& classifyKernel, const cl::CommandQueue& queue, cl_uint totalIterations);
+
+  /**
+   * @brief Takes the pages back from the bricks that had one, once the full
+   * resolution is done, and hands them to the bricks that ran out of pages.
+   * The finished voxels only keep their colors in the output. Waits for the
+   * count of pages handed out.
+   * @param regrantKernel The regrant_pages kernel of the current program.
+   * @param listKernel The list_granted_items kernel of the current program.
+   * @param queue The queue the kernels run on.
+   * @param range The output dimensions.
+   * @param activeItems The list to seed with the voxels of the bricks that
+   * got a page.
+   * @param totalIterations The iteration limit.
+   * @return True if any brick got a page, false once none is waiting.
+   */
+  bool regrant(
+      cl::Kernel& regrantKernel,
+      cl::Kernel& listKernel,
+      const cl::CommandQueue& queue,
+      const cl::NDRange& range,
+      ActiveItemList& activeItems,
+      cl_uint totalIterations);
+
+private:
+  /**
+   * @struct Layout
+   * @brief How a paged store is laid out.
+   */
+  struct Layout {
+    size_t brickCount;   ///< The number of bricks, one corner voxel each.
+    size_t coarseVoxels; ///< The voxels of the region of corners, in whole blocks.
+    size_t capacity;     ///< The number of pages.
+    bool sparse;         ///< Whether the store is paged at all.
+  };
+
+  /**
+   * @brief Lays out the store of a range within the budget of WorkStores.
+   * @param range The output dimensions.
+   * @param blockSize The size of a block of the window's program.
+   * @param compact Whether a 3D store is paged even if its dense store
+   * fits.
+   * @return The layout.
+   */
+  static Layout layout(const cl::NDRange& range, size_t blockSize, bool compact);
+
+  cl::Buffer table;  ///< The header and the page of each brick, null if the store is dense.
+  size_t brickCount; ///< The number of bricks.
+  size_t capacity;   ///< The number of pages.
+};
+} // namespace fractalism::gpu::opencl
+
+#endif
@@ -0,0 +1,218 @@
+#include <Fractalism/GPU/OpenCL/WorkStores.hpp>
+
+#include <algorithm>
+
+#include <Fractalism/Core.hpp>
+#include <Fractalism/Exceptions.hpp>
+
+namespace fractalism::gpu::opencl {
+  WorkStores::WorkStores() :
+        stores(),
+        blockCount(0),
+        residentCount(0),
+        residentSize(0),
+        clock(0) {}
+
+  void WorkStores::add() {
+    stores.push_back(Store{SVMPointerArray<types::WorkStoreBlock>(0), {}, false, cl::Event(), 0, blockCount});
+  }
+
+  void WorkStores::resize(size_t blockCount) {
+    // The kernels start over after a resize, nothing is worth keeping.
+    for (Store& store : stores) {
+      freeDevice(store);
+      freeHost(store);
+      store.blockCount = blockCount;
+    }
+    this->blockCount = blockCount;
+  }
+
+  void WorkStores::resize(size_t index, size_t blockCount, size_t blockSize) {
+    // Each buffer holds as many program blocks as fit in its host blocks,
+    // see max_work_store_buffer_size. Only the last may be cut short.
+    const size_t hostSize = sizeof(types::WorkStoreBlock);
+    const size_t bufferBlocks = clutils::getMaxMemAllocSize() / hostSize;
+    const size_t programBufferBlocks = bufferBlocks * hostSize / blockSize;
+    const size_t hostCount = blockCount / programBufferBlocks * bufferBlocks
+      + ((blockCount % programBufferBlocks) * blockSize + hostSize - 1) / hostSize;
+    Store& store = stores[index];
+    if (hostCount == store.blockCount) {
+      return;
+    }
+    freeDevice(store);
+    freeHost(store);
+    store.blockCount = hostCount;
+  }
+
+  void WorkStores::use(size_t index, const std::vector<cl::Event>& waitEvents, cl::Event& doneEvent) {
+    Store& store = stores[index];
+    store.lastUse = ++clock;
+    if (store.device.itemCount) {
+      // The steady state, the store never left the device.
+      doneEvent = completed();
+      return;
+    }
+
+    const size_t storeSize = store.blockCount * sizeof(types::WorkStoreBlock);
+    const cl_ulong budget = static_cast<cl_ulong>(Core::get<GPUContext>().globalMemSize * deviceShare);
+    while (true) {
+      // A single store over the budget still gets allocated, it only
+      // cannot share the device.
+      if (residentCount && residentSize + storeSize > budget) {
+        evict(leastRecentlyUsed());
+        continue;
+      }
+      try {
+        store.device = SVMPointerArray<types::WorkStoreBlock>(store.blockCount);
+        break;
+      } catch (const CLSVMAllocationError&) {
+        // The budget is only an estimate of what is left for the stores.
+        if (!residentCount) {
+          throw;
+        }
+        Core::warn("Device memory is short, keeping fewer work stores on the device.");
+        evict(leastRecentlyUsed());
+      }
+    }
+    residentCount++;
+    residentSize += storeSize;
+
+    doneEvent = completed();
+    if (store.evicted) {
+      restore(store, waitEvents, doneEvent);
+    }
+    // Otherwise it was never computed, the kernels initialize it.
+  }
+
+  void WorkStores::release(size_t index, const cl::Event& kernelDone) {
+    stores[index].lastUser = kernelDone;
+  }
+
+  void WorkStores::asKernelArg(cl::Kernel& kernel, cl_uint argIndex, size_t index) const {
+    stores[index].device.asKernelArg(kernel, argIndex);
+  }
+
+  void WorkStores::free() {
+    for (Store& store : stores) {
+      freeDevice(store);
+      freeHost(store);
+    }
+    stores.clear();
+  }
+
+  WorkStores::Store& WorkStores::leastRecentlyUsed() {
+    // Only resident stores are candidates, the others sort last.
+    return *std::min_element(stores.begin(), stores.end(), [](const Store& a, const Store& b) {
+      return (a.device.itemCount ? a.lastUse : UINT64_MAX) < (b.device.itemCount ? b.lastUse : UINT64_MAX);
+    });
+  }
+
+  void WorkStores::evict(Store& store) {
+    const cl::CommandQueue& queue = clutils::getQueue();
+    const std::vector<cl::Event> kernelDone = store.lastUser() ?
+      std::vector<cl::Event>{store.lastUser} :
+      std::vector<cl::Event>{};
+    cl::Event copied;
+    try {
+      if (store.host.empty()) {
+        // Pinned memory is kept after restoring, the store is likely to be
+        // evicted again.
+        store.device.forEachUnmappedPointer([&queue](
+            types::WorkStoreBlock* pointer,
+            size_t itemCount,
+            size_t index,
+            std::vector<PinnedChunk>& host) {
+          const size_t size = itemCount * sizeof(types::WorkStoreBlock);
+          if (!size) {
+            host.push_back(PinnedChunk{cl::Buffer(), nullptr});
+            return;
+          }
+          cl::Buffer buffer(clutils::getClContext(), CL_MEM_READ_WRITE | CL_MEM_ALLOC_HOST_PTR, size);
+          void* data = queue.enqueueMapBuffer(buffer, CL_TRUE, CL_MAP_READ | CL_MAP_WRITE, 0, size);
+          host.push_back(PinnedChunk{buffer, data});
+        }, store.host);
+      }
+      // The queue is in order, waiting for the last copy waits for all.
+      store.device.forEachUnmappedPointer([&queue, &kernelDone, &copied](
+          types::WorkStoreBlock* pointer,
+          size_t itemCount,
+          size_t index,
+          std::vector<PinnedChunk>& host) {
+        if (itemCount) {
+          queue.enqueueMemcpySVM(
+            static_cast<types::WorkStoreBlock*>(host[index].data),
+            pointer,
+            CL_FALSE,
+            itemCount * sizeof(types::WorkStoreBlock),
+            &kernelDone,
+            &copied);
+        }
+      }, store.host);
+      if (copied()) {
+        copied.wait();
+      }
+    } catch (const cl::Error& e) {
+      throw CLError("Could not evict a work store to host memory", e);
+    }
+    store.evicted = true;
+    freeDevice(store);
+  }
+
+  void WorkStores::restore(Store& store, const std::vector<cl::Event>& waitEvents, cl::Event& doneEvent) {
+    const cl::CommandQueue& queue = clutils::getQueue();
+    try {
+      store.device.forEachUnmappedPointer([&queue, &waitEvents, &doneEvent](
+          types::WorkStoreBlock* pointer,
+          size_t itemCount,
+          size_t index,
+          const std::vector<PinnedChunk>& host) {
+        if (itemCount) {
+          queue.enqueueMemcpySVM(
+            pointer,
+            static_cast<const types::WorkStoreBlock*>(host[index].data),
+            CL_FALSE,
+            itemCount * sizeof(types::WorkStoreBlock),
+            &waitEvents,
+            &doneEvent);
+        }
+      }, store.host);
+      // The kernel waits for it on the window's queue.
+      queue.flush();
+    } catch (const cl::Error& e) {
+      throw CLError("Could not restore a work store to the device", e);
+    }
+    store.evicted = false;
+  }
+
+  cl::Event WorkStores::completed() {
+    cl::UserEvent noOp(clutils::getClContext());
+    noOp.setStatus(CL_COMPLETE);
+    return noOp;
+  }
+
+  void WorkStores::freeDevice(Store& store) {
+    if (!store.device.itemCount) {
+      return;
+    }
+    if (store.lastUser()) {
+      // SVM is freed right away, not in queue order.
+      store.lastUser.wait();
+      store.lastUser = cl::Event();
+    }
+    store.device.free();
+    residentCount--;
+    residentSize -= store.blockCount * sizeof(types::WorkStoreBlock);
+  }
+
+  void WorkStores::freeHost(Store& store) {
+    const cl::CommandQueue& queue = clutils::getQueue();
+    for (PinnedChunk& chunk : store.host) {
+      if (chunk.data) {
+        queue.enqueueUnmapMemObject(chunk.buffer, chunk.data);
+      }
+    }
+    // Released once the unmaps ran.
+    store.host.clear();
+    store.evicted = false;
+  }
+}
@@ -0,0 +1,157 @@
+#ifndef _FRACTALISM_WORK_STORES_HPP_
+#define _FRACTALISM_WORK_STORES_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+#include <Fractalism/GPU/OpenCL/SVMPtr.hpp>
+#include <Fractalism/GPU/Types.hpp>
+
+namespace fractalism::gpu::opencl {
+
+/**
+ * @class WorkStores
+ * @brief Keeps the work store of each view window resident on the device, so
+ * switching between windows costs nothing.
+ *
+ * The stores of all windows together may not fit in device memory. Once they
+ * exceed the budget, the least recently used store is copied into pinned host
+ * memory and freed, and copied back when its window renders again.
+ *
+ * A store is allocated in the host's blocks, but holds the smaller blocks of
+ * the program its window uses, which keep only the elements of its number
+ * system in its precision.
+ */
+class WorkStores {
+public:
+  static constexpr double deviceShare = 0.5; ///< The share of device memory the stores may take, the rest is left to images and programs.
+
+  /**
+   * @brief Constructs an empty set of work stores.
+   */
+  WorkStores();
+
+  /**
+   * @brief Adds a work store, which is allocated when it is first used.
+   */
+  void add();
+
+  /**
+   * @brief Resizes all work stores, dropping their contents.
+   * @param blockCount The number of host blocks per store, until its window
+   * sizes it for its program.
+   */
+  void resize(size_t blockCount);
+
+  /**
+   * @brief Sizes a work store for the blocks of a program, dropping its
+   * contents if its size changes.
+   * @param index The index of the store.
+   * @param blockCount The number of program blocks.
+   * @param blockSize The size of a program block, at most the size of a host
+   * block.
+   */
+  void resize(size_t index, size_t blockCount, size_t blockSize);
+
+  /**
+   * @brief Makes a work store resident, evicting others if needed.
+   * @param index The index of the store.
+   * @param waitEvents Events to wait for before restoring the store.
+   * @param doneEvent Set to the event of the store being ready.
+   */
+  void use(size_t index, const std::vector<cl::Event>& waitEvents, cl::Event& doneEvent);
+
+  /**
+   * @brief Records the last kernel using a work store, which evicting or
+   * freeing it has to wait for.
+   * @param index The index of the store.
+   * @param kernelDone The event of the kernel.
+   */
+  void release(size_t index, const cl::Event& kernelDone);
+
+  /**
+   * @brief Sets a resident work store as a kernel argument.
+   * @param kernel The kernel to set the argument for.
+   * @param argIndex The argument index.
+   * @param index The index of the store.
+   */
+  void asKernelArg(cl::Kernel& kernel, cl_uint argIndex, size_t index) const;
+
+  /**
+   * @brief Frees all work stores.
+   */
+  void free();
+
+private:
+  /**
+   * @struct PinnedChunk
+   * @brief Host memory the device can copy to directly, holding one chunk of
+   * an evicted store.
+   */
+  struct PinnedChunk {
+    cl::Buffer buffer; ///< The buffer owning the memory.
+    void* data;        ///< The buffer, mapped for the lifetime of the chunk.
+  };
+
+  /**
+   * @struct Store
+   * @brief The work store of one window.
+   */
+  struct Store {
+    SVMPointerArray<types::WorkStoreBlock> device; ///< The store on the device, empty while evicted.
+    std::vector<PinnedChunk> host;                 ///< The contents while evicted.
+    bool evicted;                                  ///< Whether host holds the contents.
+    cl::Event lastUser;                            ///< The last kernel using device.
+    std::uint64_t lastUse;                         ///< When the store was used last, for LRU eviction.
+    size_t blockCount;                             ///< The number of host blocks.
+  };
+
+  /**
+   * @brief Finds the resident store that was used the longest time ago.
+   * @return The store. Only resident if there is one.
+   */
+  Store& leastRecentlyUsed();
+
+  /**
+   * @brief Copies a store to pinned host memory and frees it on the device.
+   * @param store The store, resident.
+   */
+  void evict(Store& store);
+
+  /**
+   * @brief Copies an evicted store back to the device.
+   * @param store The store, allocated on the device.
+   * @param waitEvents Events to wait for before copying.
+   * @param doneEvent Set to the event of the last copy.
+   */
+  void restore(Store& store, const std::vector<cl::Event>& waitEvents, cl::Event& doneEvent);
+
+  /**
+   * @brief Makes an event that is already complete, for stores that need no
+   * copy.
+   * @return The event.
+   */
+  static cl::Event completed();
+
+  /**
+   * @brief Frees a store on the device, once no kernel uses it.
+   * @param store The store.
+   */
+  void freeDevice(Store& store);
+
+  /**
+   * @brief Frees the pinned host copy of a store.
+   * @param store The store.
+   */
+  static void freeHost(Store& store);
+
+  std::vector<Store> stores; ///< The store of each window.
+  size_t blockCount;         ///< The number of host blocks of a store its window has not sized yet.
+  size_t residentCount;      ///< The number of stores on the device.
+  size_t residentSize;       ///< The size of the stores on the device, in bytes.
+  std::uint64_t clock;       ///< Counts uses, for Store::lastUse.
+};
+} // namespace fractalism::gpu::opencl
+
+#endif
@@ -1,6 +1,10 @@
 #include <Fractalism/GPU/OpenGL/ArcballCamera.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
 
 namespace fractalism::gpu::opengl {
 
@@ -53,6 +57,21 @@ namespace fractalism::gpu::opengl {
     static constexpr const real fov = glm::radians(45.0);
     return glm::perspective(fov, aspect, zNear, zFar);
   }
+
+  types::cltypes::trace_camera ArcballCamera::createTraceCamera(real aspect, cl_uint height) const {
+    const types::mat4 view = createViewMatrix();
+    const glm::mat4 inverseViewProjection(glm::inverse(createProjectionMatrix(aspect) * view));
+    const glm::vec3 light = glm::normalize(glm::vec3(glm::inverse(view) * types::vec4(1.2, 1.0, 2.0, 0.0)));
+    types::cltypes::trace_camera camera{
+      {static_cast<cl_float>(position.x), static_cast<cl_float>(position.y), static_cast<cl_float>(position.z)},
+      {light.x, light.y, light.z}};
+    // glm is column major as well.
+    const float* matrix = glm::value_ptr(inverseViewProjection);
+    std::copy(matrix, matrix + 16, camera.inverse_view_projection);
+    camera.pixel_size = static_cast<cl_float>(2.0 * std::tan(glm::radians(45.0) / 2.0) / static_cast<real>(height));
+    camera.traced = 1;
+    return camera;
+  }
   
   void ArcballCamera::updatePosition() {
     position = types::vec3(
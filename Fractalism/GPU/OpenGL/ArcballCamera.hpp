@@ -53,6 +53,15 @@ public:
    */
   types::mat4 createProjectionMatrix(real aspect) const;
 
+  /**
+   * @brief Creates the camera the distance estimated kernels trace rays
+   * from, lit like the ray marcher lights the volume.
+   * @param aspect The aspect ratio of the view.
+   * @param height The height of the view, in pixels.
+   * @return The camera, for 3D views.
+   */
+  types::cltypes::trace_camera createTraceCamera(real aspect, cl_uint height) const;
+
 private:
   real radius;          ///< The radius of the camera's orbit.
   real yaw;             ///< The yaw angle of the camera.
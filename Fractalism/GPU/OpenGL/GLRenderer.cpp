@@ -1,4 +1,7 @@
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cmath>
 #include <glm/glm.hpp>
 #pragma warning(push)
 #pragma warning(disable : 4127)
@@ -7,7 +10,9 @@
 #include <glm/gtc/type_ptr.hpp>
 #pragma warning(pop)
 
+#include <Fractalism/GPU/OpenCL/KernelExecutor.hpp>
 #include <Fractalism/GPU/OpenGL/GLRenderer.hpp>
+#include <Fractalism/GPU/OpenGL/GLTextureTarget.hpp>
 #include <Fractalism/GPU/OpenGL/GLUniform.hpp>
 #include <Fractalism/GPU/OpenGL/GLUtils.hpp>
 #include <Fractalism/Exceptions.hpp>
@@ -30,6 +35,12 @@ namespace fractalism::gpu::opengl {
     };
     static constexpr auto normalMatrix = light::specular.next<glm::mat3>;
     static constexpr auto eyePosition = normalMatrix.next<glm::vec3>;
+    static constexpr auto level = eyePosition.next<int>;
+    static constexpr auto origin = level.next<glm::vec3>;
+    static constexpr auto previewScale = origin.next<glm::vec3>;
+    static constexpr auto previewOffset = previewScale.next<glm::vec3>;
+    static constexpr auto bricks = previewOffset.next<int>;
+    static constexpr auto brickSize = bricks.next<int>;
   };
 
   static constexpr const float zNear = 0.1f;
@@ -118,12 +129,46 @@ namespace fractalism::gpu::opengl {
     glutils::checkGLError();
   }
 
+  // Maps texture coordinates of the current view to those of the frame, so a
+  // frame of an earlier view stands in until one of the current view is done.
+  // Identity if the views are not related by a move and scale.
+  static void setPreviewUniforms(const types::cltypes::viewspace& current, const types::cltypes::viewspace& shown) {
+    glm::vec3 scale(1.0f);
+    glm::vec3 offset(0.0f);
+    const cl_char axes[3] = {current.mapping.x, current.mapping.y, current.mapping.z};
+    const cl_char shownAxes[3] = {shown.mapping.x, shown.mapping.y, shown.mapping.z};
+    const cl::NDRange& resolution = App::get<Settings>().resolution;
+    bool related = shown.zoom > 0.0 && std::equal(std::begin(axes), std::end(axes), std::begin(shownAxes));
+    bool mapped[MAX_NUMBER_SYSTEM_SIZE] = {};
+    for (size_t axis = 0; related && axis < 3; axis++) {
+      if (!axes[axis]) {
+        continue;
+      }
+      const size_t element = static_cast<size_t>(std::abs(axes[axis])) - 1;
+      mapped[element] = true;
+      // Pixel p of the current view is at pixel p * ratio + shift of the
+      // frame, see apply_view_mapping_element().
+      const real size = static_cast<real>(resolution[axis]);
+      const real ratio = shown.zoom / current.zoom;
+      const real shift = size / 2.0 * (1.0 - ratio)
+        + (current.center.raw[element] - shown.center.raw[element]) * std::copysign(shown.zoom, real(axes[axis])) * size / 2.0;
+      // Texel centers are half a pixel in.
+      scale[axis] = static_cast<float>(ratio);
+      offset[axis] = static_cast<float>((shift + 0.5 * (1.0 - ratio)) / size);
+    }
+    for (size_t element = 0; related && element < MAX_NUMBER_SYSTEM_SIZE; element++) {
+      related = mapped[element] || current.center.raw[element] == shown.center.raw[element];
+    }
+    Uniforms::previewScale = related ? scale : glm::vec3(1.0f);
+    Uniforms::previewOffset = related ? offset : glm::vec3(0.0f);
+  }
+
   inline static void setUniforms2D() {
     Uniforms::texture = 0;
     glutils::checkGLError();
   }
 
-  inline static void setUniforms3D(ArcballCamera& camera, real aspectRatio) {
+  inline static void setUniforms3D(ArcballCamera& camera, real aspectRatio, GLuint bricks) {
 
     glm::mat4 view = camera.createViewMatrix();
     glm::mat4 projection = camera.createProjectionMatrix(aspectRatio);
@@ -143,12 +188,21 @@ namespace fractalism::gpu::opengl {
     Uniforms::normalMatrix = glm::transpose(glm::mat3(inverseView));
 
     Uniforms::eyePosition = camera.getPosition();
+
+    // Without bricks every step is sampled.
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_3D, bricks);
+    glActiveTexture(GL_TEXTURE0);
+    Uniforms::bricks = 1;
+    Uniforms::brickSize = bricks ? static_cast<int>(GLTextureTarget::brickSize) : 0;
     glutils::checkGLError();
   }
 
   GLRenderer::GLRenderer() :
     VAOs{},
-    VBOs{} {
+    VBOs{},
+    queries(),
+    freeQueries() {
     glGenVertexArrays(2, VAOs);
     glGenBuffers(4, VBOs);
     glutils::checkGLError();
@@ -162,21 +216,50 @@ namespace fractalism::gpu::opengl {
   GLRenderer::~GLRenderer() {
     glDeleteVertexArrays(2, VAOs);
     glDeleteBuffers(4, VBOs);
+    for (const PendingQuery& pending : queries) {
+      freeQueries.push_back(pending.query);
+    }
+    if (!freeQueries.empty()) {
+      glDeleteQueries(static_cast<GLsizei>(freeQueries.size()), freeQueries.data());
+    }
   }
 
-  void GLRenderer::render(ViewWindowSettings& settings, wxGLCanvas& canvas, GLuint texture) const {
+  void GLRenderer::render(
+      ViewWindowSettings& settings,
+      wxGLCanvas& canvas,
+      GLuint texture,
+      GLuint bricks,
+      const opencl::ShownFrame& frame) {
     wxSize size = canvas.GetSize();
     int width = size.GetWidth();
     int height = size.GetHeight();
     App::setGLContext(canvas);
     glutils::checkGLError();
-    glUseProgram(App::get<GLShaderProgram>());
+    collectQueries();
+    GLuint query = 0;
+    if (freeQueries.empty()) {
+      glGenQueries(1, &query);
+    } else {
+      query = freeQueries.back();
+      freeQueries.pop_back();
+    }
+    const Timeline::Clock::time_point issued = Timeline::Clock::now();
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    // Traced frames are already an image of the canvas, drawn like 2D views.
+    options::Dimensions renderDimensions = frame.traced ?
+      options::Dimensions::two :
+      App::get<Settings>().renderDimensions;
+    glUseProgram(frame.traced ? App::get<gpu::GPU>().shader2D : App::get<GLShaderProgram>());
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glViewport(0, 0, width, height);
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_3D, texture);
+    Uniforms::level = static_cast<int>(frame.level);
+    Uniforms::origin = glm::vec3(frame.view.origin[0], frame.view.origin[1], frame.view.origin[2]);
+    // Traced pixels are the canvas', not the view's, there is no preview.
+    const types::cltypes::viewspace current = settings.view;
+    setPreviewUniforms(current, frame.traced ? current : frame.view);
 
-    options::Dimensions renderDimensions = App::get<Settings>().renderDimensions;
     glBindVertexArray(VAOs[utils::toUnderlyingType(renderDimensions)]);
     glutils::checkGLError();
     switch (renderDimensions) {
@@ -186,14 +269,41 @@ namespace fractalism::gpu::opengl {
       break;
     }
     case options::Dimensions::three: {
-      setUniforms3D(settings.camera, static_cast<real>(width) / static_cast<real>(height));
+      setUniforms3D(settings.camera, static_cast<real>(width) / static_cast<real>(height), bricks);
       glDrawElements(GL_TRIANGLES, sizeof(indices3D) / sizeof(GLushort), GL_UNSIGNED_SHORT, nullptr);
       break;
     }
     default: assert(("Invalid render dimensions.", false));
     }
+    glEndQuery(GL_TIME_ELAPSED);
+    queries.push_back(PendingQuery{
+      query,
+      issued,
+      "Draw " + options::name(settings.space) + " " + options::name(settings.renderMode)});
 
     canvas.SwapBuffers();
     glutils::checkGLError();
   }
+
+  void GLRenderer::collectQueries() {
+    while (!queries.empty()) {
+      const PendingQuery& pending = queries.front();
+      GLint available = GL_FALSE;
+      glGetQueryObjectiv(pending.query, GL_QUERY_RESULT_AVAILABLE, &available);
+      if (!available) {
+        // Queries complete in order.
+        return;
+      }
+      GLuint64 nanoseconds = 0;
+      glGetQueryObjectui64v(pending.query, GL_QUERY_RESULT, &nanoseconds);
+      App::get<Timeline>().addSpan(
+        pending.name,
+        Timeline::Category::draw,
+        pending.issued,
+        std::chrono::nanoseconds(nanoseconds),
+        Timeline::glTrack);
+      freeQueries.push_back(pending.query);
+      queries.pop_front();
+    }
+  }
 }
\ No newline at end of file
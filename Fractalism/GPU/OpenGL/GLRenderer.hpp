@@ -1,16 +1,28 @@
 #ifndef _FRACTALISM_GL_RENDERER_HPP_
 #define _FRACTALISM_GL_RENDERER_HPP_
 
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <Fractalism/Timeline.hpp>
 #include <Fractalism/UI/UICommon.hpp>
 #include <Fractalism/ViewWindowSettings.hpp>
 #include <GL/glew.h>
 #include <wx/glcanvas.h>
 
+namespace fractalism::gpu::opencl {
+  struct ShownFrame;
+}
+
 namespace fractalism::gpu::opengl {
 
 /**
  * @class GLRenderer
  * @brief Manages OpenGL rendering for the Fractalism application.
+ *
+ * Each draw is timed by a timer query, which is read back once OpenGL
+ * finished it, and recorded on the Timeline.
  */
 class GLRenderer {
 public:
@@ -29,12 +41,39 @@ public:
    * @param settings The settings for the view window.
    * @param canvas The OpenGL canvas to render to.
    * @param texture The OpenGL texture to use for rendering.
+   * @param bricks The occupancy bricks of texture, for skipping empty space
+   * in 3D. 0 if there are none.
+   * @param frame What the texture holds. If it was computed for another
+   * view, it is moved and scaled to the current one as a preview.
    */
-  void render(ViewWindowSettings& settings, wxGLCanvas& canvas, GLuint texture) const;
+  void render(
+      ViewWindowSettings& settings,
+      wxGLCanvas& canvas,
+      GLuint texture,
+      GLuint bricks,
+      const opencl::ShownFrame& frame);
 
 private:
-  GLuint VBOs[4]; ///< Vertex Buffer Objects for rendering.
-  GLuint VAOs[2]; ///< Vertex Array Objects for rendering.
+  /**
+   * @struct PendingQuery
+   * @brief A timer query of a draw OpenGL may not have finished.
+   */
+  struct PendingQuery {
+    GLuint query;                       ///< The GL_TIME_ELAPSED query.
+    Timeline::Clock::time_point issued; ///< When the draw was issued, where its span starts.
+    std::string name;                   ///< The name of the span.
+  };
+
+  /**
+   * @brief Records the draws whose queries are available on the Timeline,
+   * oldest first.
+   */
+  void collectQueries();
+
+  GLuint VBOs[4];                   ///< Vertex Buffer Objects for rendering.
+  GLuint VAOs[2];                   ///< Vertex Array Objects for rendering.
+  std::deque<PendingQuery> queries; ///< The draws not timed yet, oldest first.
+  std::vector<GLuint> freeQueries;  ///< Queries to reuse.
 };
 } // namespace fractalism::gpu::opengl
 
@@ -1,17 +1,19 @@
 #include <Fractalism/GPU/OpenGL/GLTexture3D.hpp>
 #include <Fractalism/GPU/OpenGL/GLUtils.hpp>
 #include <Fractalism/Exceptions.hpp>
-#include <Fractalism/App.hpp>
+#include <Fractalism/Core.hpp>
 
 namespace fractalism::gpu::opengl {
-  GLTexture3D::GLTexture3D(cl::NDRange& range) : id(0) {
+  GLTexture3D::GLTexture3D(const cl::NDRange& range) : id(0) {
     glGenTextures(1, &id);
     glBindTexture(GL_TEXTURE_3D, id);
     glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, range[0], range[1], range[2], 0, GL_RGBA, GL_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // A ring buffer, the shaders clamp to the edges of the screen instead.
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
     glBindTexture(GL_TEXTURE_3D, 0);
     glutils::checkGLError();
   }
@@ -34,21 +36,23 @@ namespace fractalism::gpu::opengl {
 
   GLTexture3D::operator cl::ImageGL() const {
     try {
-      return cl::ImageGL(App::get<GPUContext>(), CL_MEM_READ_WRITE, GL_TEXTURE_3D, 0, id);
+      return cl::ImageGL(Core::get<GPUContext>(), CL_MEM_READ_WRITE, GL_TEXTURE_3D, 0, id);
     } catch (const cl::Error &e) {
       throw CLError("Could not create OpenCL/OpenGL image", e);
     }
   }
 
-  void GLTexture3D::resize(cl::NDRange& range) {
+  void GLTexture3D::resize(const cl::NDRange& range) {
     free(); // These textures can get quite large. Don't hog more VRAM than absolutely needed.
     glGenTextures(1, &id);
     glBindTexture(GL_TEXTURE_3D, id);
     glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, range[0], range[1], range[2], 0, GL_RGBA, GL_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    // A ring buffer, the shaders clamp to the edges of the screen instead.
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_REPEAT);
     glBindTexture(GL_TEXTURE_3D, 0);
     glutils::checkGLError();
   }
@@ -58,6 +62,13 @@ namespace fractalism::gpu::opengl {
     glutils::checkGLError();
   }
 
+  void GLTexture3D::upload(const cl::NDRange& range, const void* data) const {
+    glBindTexture(GL_TEXTURE_3D, id);
+    glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, range[0], range[1], range[2], GL_RGBA, GL_UNSIGNED_BYTE, data);
+    glBindTexture(GL_TEXTURE_3D, 0);
+    glutils::checkGLError();
+  }
+
   void GLTexture3D::free() {
     glDeleteTextures(1, &id);
     id = 0;
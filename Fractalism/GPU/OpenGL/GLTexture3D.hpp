@@ -21,7 +21,7 @@ public:
    * @brief Constructs a GLTexture3D with the specified range.
    * @param range The OpenCL NDRange specifying the texture dimensions.
    */
-  GLTexture3D(cl::NDRange& range);
+  GLTexture3D(const cl::NDRange& range);
 
   /**
    * @brief Move constructor.
@@ -57,20 +57,27 @@ public:
    * @brief Resizes the texture to the specified range.
    * @param range The OpenCL NDRange specifying the new texture dimensions.
    */
-  void resize(cl::NDRange& range);
+  void resize(const cl::NDRange& range);
 
   /**
    * @brief Clears the texture.
    */
   void clear() const;
 
+  /**
+   * @brief Replaces the texture contents with host RGBA8 data.
+   * @param range The OpenCL NDRange specifying the texture dimensions.
+   * @param data The texel data, 4 bytes per texel.
+   */
+  void upload(const cl::NDRange& range, const void* data) const;
+
   /**
    * @brief Frees the texture resources.
    */
   void free();
 
 private:
-  GLuint id; ///< The OpenGL texture ID.
+  GLuint id = 0; ///< The OpenGL texture ID.
 };
 } // namespace fractalism::gpu::opengl
 
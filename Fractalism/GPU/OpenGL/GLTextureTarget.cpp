@@ -0,0 +1,255 @@
+#include <Fractalism/GPU/OpenGL/GLTextureTarget.hpp>
+
+#include <Fractalism/Core.hpp>
+
+namespace fractalism::gpu::opengl {
+  // From cl_khr_gl_event. Looked up at runtime, since it is an extension.
+  using CreateEventFromGLsync = cl_event (CL_API_CALL*)(cl_context, cl_GLsync, cl_int*);
+
+  static inline CreateEventFromGLsync createEventFromGLsync(const GPUContext& ctx) {
+    static const CreateEventFromGLsync function = reinterpret_cast<CreateEventFromGLsync>(
+      clGetExtensionFunctionAddressForPlatform(
+        ctx.device.getInfo<CL_DEVICE_PLATFORM>(),
+        "clCreateEventFromGLsyncKHR"));
+    return function;
+  }
+
+  GLTextureTarget::GLTextureTarget() :
+        textures(),
+        clGlTextures(),
+        accumulator(),
+        range(),
+        brickTextures(),
+        clGlBricks(),
+        bricks(),
+        brickRange(),
+        bricksBuilt(false),
+        bricksValid{false, false},
+        front(0),
+        pending(),
+        fence(nullptr) {}
+
+  GLTextureTarget::~GLTextureTarget() {
+    if (fence) {
+      glDeleteSync(fence);
+    }
+  }
+
+  void GLTextureTarget::resize(const cl::NDRange& range) {
+    this->range = range;
+    // Nothing may still be writing to the old textures.
+    promote(true);
+    const GPUContext& ctx = Core::get<GPUContext>();
+    for (size_t i = 0; i < textures.size(); i++) {
+      clGlTextures[i] = cl::ImageGL();
+      if (i != front && !ctx.hasDevice()) {
+        // The host kernels upload straight to the front.
+        textures[i].free();
+        continue;
+      }
+      textures[i].resize(range);
+      textures[i].clear();
+      if (ctx.hasDevice()) {
+        clGlTextures[i] = textures[i];
+      }
+    }
+    if (ctx.hasDevice()) {
+      try {
+        accumulator = cl::Image3D(
+          ctx.clCtx,
+          CL_MEM_READ_WRITE,
+          cl::ImageFormat(CL_RGBA, CL_UNORM_INT8),
+          range[0],
+          range[1],
+          range[2]);
+      } catch (const cl::Error& e) {
+        throw CLError("Could not create OpenCL output image", e);
+      }
+    }
+    resizeBricks();
+  }
+
+  void GLTextureTarget::clear(const cl::CommandQueue& queue) {
+    if (!accumulator()) {
+      textures[front].clear();
+      return;
+    }
+    // The textures on screen are replaced by the next frame, clearing them
+    // would only flicker.
+    try {
+      queue.enqueueFillImage(
+        accumulator,
+        cl_float4{0.0f, 0.0f, 0.0f, 0.0f},
+        {0, 0, 0},
+        {range[0], range[1], range[2]});
+    } catch (const cl::Error& e) {
+      throw CLError("Could not clear OpenCL output image", e);
+    }
+  }
+
+  void GLTextureTarget::upload(const cl::NDRange& range, const void* data) {
+    textures[front].upload(range, data);
+  }
+
+  const cl::Memory& GLTextureTarget::image() const {
+    return accumulator;
+  }
+
+  std::vector<cl::Event> GLTextureTarget::buildBricks(
+      const cl::CommandQueue& queue,
+      cl::Kernel& brickKernel,
+      cl_uint level,
+      const std::array<cl_uint, 3>& origin,
+      const std::vector<cl::Event>& kernelDone) {
+    if (!bricks()) {
+      return kernelDone;
+    }
+    std::vector<cl::Event> built{cl::Event()};
+    try {
+      brickKernel.setArg(0, accumulator);
+      brickKernel.setArg(1, cl_uint4{origin[0], origin[1], origin[2], 0});
+      brickKernel.setArg(2, brickSize);
+      brickKernel.setArg(3, level);
+      brickKernel.setArg(4, bricks);
+      queue.enqueueNDRangeKernel(brickKernel, cl::NullRange, brickRange, cl::NullRange, &kernelDone, built.data());
+    } catch (const cl::Error& e) {
+      throw CLError("Could not build the occupancy bricks", e);
+    }
+    bricksBuilt = true;
+    return built;
+  }
+
+  cl::Event GLTextureTarget::release(
+      const cl::CommandQueue& queue,
+      const std::vector<cl::Event>& kernelDone) {
+    // Only one frame is copied at a time, the back texture is the one not
+    // on screen.
+    promote(true);
+    const size_t back = 1 - front;
+    std::vector<cl::Event> waitEvents = kernelDone;
+    cl::Event glDone = glCommandsDone();
+    if (glDone()) {
+      waitEvents.push_back(glDone);
+    }
+    std::vector<cl::Memory> glObjects{clGlTextures[back]};
+    if (bricksBuilt) {
+      glObjects.push_back(clGlBricks[back]);
+    }
+    try {
+      Timeline& timeline = Core::get<Timeline>();
+      std::vector<cl::Event> acquired{cl::Event()};
+      queue.enqueueAcquireGLObjects(&glObjects, &waitEvents, acquired.data());
+      timeline.record(acquired[0], "Acquire GL objects", Timeline::Category::transfer);
+      std::vector<cl::Event> copied{cl::Event()};
+      queue.enqueueCopyImage(
+        accumulator,
+        clGlTextures[back],
+        {0, 0, 0},
+        {0, 0, 0},
+        {range[0], range[1], range[2]},
+        &acquired,
+        copied.data());
+      timeline.record(copied[0], "Copy frame to OpenGL", Timeline::Category::transfer);
+      if (bricksBuilt) {
+        // The queue is in order, the release waits for both copies.
+        queue.enqueueCopyImage(
+          bricks,
+          clGlBricks[back],
+          {0, 0, 0},
+          {0, 0, 0},
+          {brickRange[0], brickRange[1], brickRange[2]},
+          &acquired,
+          copied.data());
+        timeline.record(copied[0], "Copy bricks to OpenGL", Timeline::Category::transfer);
+      }
+      queue.enqueueReleaseGLObjects(&glObjects, &copied, &pending);
+    } catch (const cl::Error& e) {
+      throw CLError("Could not copy the frame to OpenGL", e);
+    }
+    bricksValid[back] = bricksBuilt;
+    bricksBuilt = false;
+    return pending;
+  }
+
+  GLuint GLTextureTarget::present() {
+    promote(false);
+    return textures[front];
+  }
+
+  GLuint GLTextureTarget::presentedBricks() const {
+    return bricksValid[front] ? static_cast<GLuint>(brickTextures[front]) : 0;
+  }
+
+  void GLTextureTarget::resizeBricks() {
+    // Only the ray marcher reads them, and only the kernels build them.
+    const bool marched = Core::get<GPUContext>().hasDevice() && range[2] > 1;
+    bricks = cl::Image3D();
+    bricksBuilt = false;
+    bricksValid = {false, false};
+    brickRange = marched ?
+      cl::NDRange(
+        (range[0] + brickSize - 1) / brickSize,
+        (range[1] + brickSize - 1) / brickSize,
+        (range[2] + brickSize - 1) / brickSize) :
+      cl::NDRange();
+    for (size_t i = 0; i < brickTextures.size(); i++) {
+      clGlBricks[i] = cl::ImageGL();
+      if (!marched) {
+        brickTextures[i].free();
+        continue;
+      }
+      brickTextures[i].resize(brickRange);
+      clGlBricks[i] = brickTextures[i];
+    }
+    if (!marched) {
+      return;
+    }
+    try {
+      bricks = cl::Image3D(
+        Core::get<GPUContext>().clCtx,
+        CL_MEM_READ_WRITE,
+        cl::ImageFormat(CL_RGBA, CL_UNORM_INT8),
+        brickRange[0],
+        brickRange[1],
+        brickRange[2]);
+    } catch (const cl::Error& e) {
+      throw CLError("Could not create OpenCL occupancy brick image", e);
+    }
+  }
+
+  void GLTextureTarget::promote(bool wait) {
+    if (!pending()) {
+      return;
+    }
+    if (wait) {
+      pending.wait();
+    } else if (pending.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() != CL_COMPLETE) {
+      return;
+    }
+    // Once the release completed, OpenGL sees the copied texels.
+    front = 1 - front;
+    pending = cl::Event();
+  }
+
+  cl::Event GLTextureTarget::glCommandsDone() {
+    const GPUContext& ctx = Core::get<GPUContext>();
+    if (fence) {
+      // The last copy is done, and with it the wait for this fence.
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+    CreateEventFromGLsync createEvent = ctx.glEvents ? createEventFromGLsync(ctx) : nullptr;
+    if (createEvent) {
+      fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+      glFlush();
+      cl_int error = CL_SUCCESS;
+      cl_event event = createEvent(ctx.clCtx(), reinterpret_cast<cl_GLsync>(fence), &error);
+      if (error == CL_SUCCESS) {
+        return cl::Event(event);
+      }
+    }
+    // Without cl_khr_gl_event, acquiring needs OpenGL to be done.
+    glFinish();
+    return cl::Event();
+  }
+}
@@ -0,0 +1,97 @@
+#ifndef _FRACTALISM_GL_TEXTURE_TARGET_HPP_
+#define _FRACTALISM_GL_TEXTURE_TARGET_HPP_
+
+#include <array>
+#include <vector>
+
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+#include <Fractalism/GPU/OpenCL/RenderTarget.hpp>
+#include <Fractalism/GPU/OpenGL/GLTexture3D.hpp>
+
+namespace fractalism::gpu::opengl {
+
+/**
+ * @class GLTextureTarget
+ * @brief A render target in OpenGL textures shared with OpenCL, so it can be
+ * drawn without a round trip through the host.
+ *
+ * The kernels write to an OpenCL only image, which keeps the pixels that
+ * stopped iterating between frames. Each finished frame is copied into the
+ * one of two textures that is not on screen, so computing the next frame
+ * never waits for OpenGL to draw the last one.
+ *
+ * 3D frames come with occupancy bricks, the highest alpha of each block of
+ * brickSize texels per side, which the ray marcher skips empty space with.
+ * They are double buffered along with the frames.
+ */
+class GLTextureTarget : public opencl::RenderTarget {
+public:
+  static constexpr cl_uint brickSize = 8; ///< The side of an occupancy brick, in texels.
+
+  GLTextureTarget();
+  ~GLTextureTarget();
+
+  void resize(const cl::NDRange& range) override;
+  void clear(const cl::CommandQueue& queue) override;
+  void upload(const cl::NDRange& range, const void* data) override;
+  const cl::Memory& image() const override;
+  std::vector<cl::Event> buildBricks(
+      const cl::CommandQueue& queue,
+      cl::Kernel& brickKernel,
+      cl_uint level,
+      const std::array<cl_uint, 3>& origin,
+      const std::vector<cl::Event>& kernelDone) override;
+  cl::Event release(
+      const cl::CommandQueue& queue,
+      const std::vector<cl::Event>& kernelDone) override;
+
+  /**
+   * @brief Gets the texture of the newest frame OpenCL finished writing.
+   * @return The OpenGL texture ID.
+   */
+  GLuint present();
+
+  /**
+   * @brief Gets the occupancy bricks of the texture present() returned last.
+   * @return The OpenGL texture ID, 0 if the frame has none.
+   */
+  GLuint presentedBricks() const;
+
+private:
+  /**
+   * @brief Shows the pending frame, if it is done.
+   * @param wait Whether to wait for the pending frame to be done.
+   */
+  void promote(bool wait);
+
+  /**
+   * @brief Reallocates the occupancy bricks for the current range, for 3D
+   * targets on a device, and frees them otherwise.
+   */
+  void resizeBricks();
+
+  /**
+   * @brief Makes OpenCL wait for the OpenGL commands issued so far, which
+   * may still read the back texture.
+   * @return The event to wait for before acquiring the back texture. Null
+   * if OpenGL already finished.
+   */
+  cl::Event glCommandsDone();
+
+  std::array<GLTexture3D, 2> textures;      ///< The textures frames are presented from.
+  std::array<cl::ImageGL, 2> clGlTextures;  ///< OpenCL-OpenGL shared textures, one per texture.
+  cl::Image3D accumulator;                  ///< The OpenCL image the kernels write to.
+  cl::NDRange range;                        ///< The size of the images.
+  std::array<GLTexture3D, 2> brickTextures; ///< The occupancy bricks of each texture.
+  std::array<cl::ImageGL, 2> clGlBricks;    ///< OpenCL-OpenGL shared brick textures.
+  cl::Image3D bricks;                       ///< The OpenCL image buildBricks() writes to, null for 2D targets.
+  cl::NDRange brickRange;                   ///< The size of the brick images.
+  bool bricksBuilt;                         ///< Whether bricks belongs to the frame the next release() copies.
+  std::array<bool, 2> bricksValid;          ///< Whether each texture has up to date bricks.
+  size_t front;                             ///< The index of the texture on screen.
+  cl::Event pending;                        ///< The copy into the back texture, null if it is not newer than the front.
+  GLsync fence;                             ///< The OpenGL fence the last copy waited for.
+};
+} // namespace fractalism::gpu::opengl
+
+#endif
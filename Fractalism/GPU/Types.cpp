@@ -1,8 +1,9 @@
 #include <Fractalism/GPU/Types.hpp>
 
+#include <algorithm>
 #include <cmath>
 
-#include <Fractalism/App.hpp>
+#include <Fractalism/Core.hpp>
 
 namespace fractalism::gpu::types {
   const Coordinates Coordinates::none = { std::nan(""), std::nan("") };
@@ -11,28 +12,100 @@ namespace fractalism::gpu::types {
 
   Number::Number(real x, real y, real z) : cltypes::number{x, y, z} {}
 
-  Viewspace::Viewspace() : center(), zoom(0.0), mapping{ 0, 0, 0 } {}
+  Viewspace::Viewspace() : center(), zoom(0.0), mapping{ 0, 0, 0 }, preciseCenter() {}
 
   Viewspace::Viewspace(real x, real y, real z, real zoom, cl_char xMapping, cl_char yMapping, cl_char zMapping)
-    : center(x, y, z), zoom(zoom), mapping{ xMapping, yMapping, zMapping } {}
+    : center(x, y, z), zoom(zoom), mapping{ xMapping, yMapping, zMapping }, preciseCenter() {}
 
   Viewspace::Viewspace(real x, real y, real z) :
         center(x, y, z),
         zoom(0.5),
-        mapping{ 1, 2, 3 } {}
+        mapping{ 1, 2, 3 },
+        preciseCenter() {}
 
-  void Viewspace::asKernelArg(cl::Kernel& kernel, cl_uint index) const {
-    cltypes::viewspace clViewspace = {
+  Viewspace& Viewspace::operator+=(const Coordinates& coordinates) {
+    const size_t precision = perturbation::precisionForZoom(zoom);
+    perturbation::BigNumber moved = getPreciseCenter();
+    Number offset;
+    offset.applyMapping(mapping, zoom, coordinates);
+    for (size_t element = 0; element < MAX_NUMBER_SYSTEM_SIZE; element++) {
+      moved[element] += perturbation::BigReal(offset.raw[element], precision);
+    }
+    setPreciseCenter(moved);
+    return *this;
+  }
+
+  perturbation::BigNumber Viewspace::getPreciseCenter() const {
+    const size_t precision = perturbation::precisionForZoom(zoom);
+    perturbation::BigNumber result;
+    for (size_t element = 0; element < MAX_NUMBER_SYSTEM_SIZE; element++) {
+      // The UI and scene specs edit center directly, which overrides the
+      // extra digits.
+      result[element] = preciseCenter[element].toReal() == center.raw[element]
+        ? preciseCenter[element].withPrecision(std::max(precision, preciseCenter[element].precision()))
+        : perturbation::BigReal(center.raw[element], precision);
+    }
+    return result;
+  }
+
+  void Viewspace::setPreciseCenter(const perturbation::BigNumber& value) {
+    preciseCenter = value;
+    for (size_t element = 0; element < MAX_NUMBER_SYSTEM_SIZE; element++) {
+      center.raw[element] = value[element].toReal();
+    }
+  }
+
+  Viewspace::operator cltypes::viewspace() const {
+    return {
       .center = center,
       .zoom = zoom,
       .mapping = {
         .x = mapping.x,
         .y = mapping.y,
-        .z = App::get<Settings>().renderDimensions == options::Dimensions::three ? mapping.z : 0
-      }
+        .z = Core::get<Settings>().renderDimensions == options::Dimensions::three ? mapping.z : static_cast<cl_char>(0)
+      },
+      .origin = {0, 0, 0}
     };
+  }
+
+  real Viewspace::zoomLimit(options::Precision precision, options::NumberSystem numberSystem, cl::size_type width) {
+    const real epsilon = precision == options::Precision::fp32
+      ? real(std::numeric_limits<cl_float>::epsilon())
+      : real(std::numeric_limits<cl_double>::epsilon());
+    // The view is 2 / zoom wide.
+    return 2.0 / (real(width) * epsilon * ulpsPerPixel * real(options::elementCount(numberSystem)));
+  }
+
+  real Viewspace::maxZoomFor(options::Precision precision) {
+    if (precision == options::Precision::fp32) {
+      return 1.0 / (real(std::numeric_limits<cl_float>::min()) * 1.0e8);
+    }
+    return maxZoom;
+  }
+
+  void Viewspace::asKernelArg(
+      cl::Kernel& kernel,
+      cl_uint index,
+      options::Precision precision,
+      const std::array<cl_uint, 3>& origin) const {
+    cltypes::viewspace clViewspace = *this;
+    for (size_t axis = 0; axis < 3; axis++) {
+      clViewspace.origin[axis] = origin[axis];
+    }
     try {
-      kernel.setArg(index, clViewspace);
+      if (precision == hostPrecision) {
+        kernel.setArg(index, clViewspace);
+      } else {
+        // A zoom past the limit would overflow, ProgramManager::maxZoom()
+        // keeps the views within it.
+        cltypes::fp32::viewspace fp32Viewspace = {
+          .center = center.toFp32(),
+          .zoom = static_cast<cl_float>(std::min(zoom, maxZoomFor(options::Precision::fp32))),
+          .mapping = clViewspace.mapping,
+          .origin = {origin[0], origin[1], origin[2]}
+        };
+        kernel.setArg(index, fp32Viewspace);
+      }
     }
     catch (const cl::Error& e) {
       throw CLError(std::format("Could not set Viewspace as kernel parameter #{}", index), e);
@@ -1,11 +1,16 @@
 #ifndef _FRACTALISM_TYPES_HPP_
 #define _FRACTALISM_TYPES_HPP_
 
+#include <array>
 #include <cmath>
+#include <compare>
 #include <glm/glm.hpp>
+#include <limits>
 
 #include <Fractalism/Exceptions.hpp>
 #include <Fractalism/KernelHeaders/interop.h>
+#include <Fractalism/Options.hpp>
+#include <Fractalism/Perturbation/BigReal.hpp>
 
 namespace fractalism::gpu::types {
 
@@ -15,7 +20,31 @@ using mat4 = glm::mat<4, 4, real, glm::defaultp>;
 
 namespace cltypes {
 #include <Fractalism/KernelHeaders/cltypes.h>
+
+/**
+ * The kernel argument layouts of the single precision program. The host
+ * keeps its own real, so arguments are converted on the way in.
+ */
+namespace fp32 {
+  _PACK_BEGIN_ struct number {
+    cl_float raw[MAX_NUMBER_SYSTEM_SIZE];
+  } _PACK_END_;
+
+  _PACK_BEGIN_ struct viewspace {
+    number center;
+    cl_float zoom;
+    view_mapping mapping;
+    cl_uint origin[3];
+  } _PACK_END_;
 }
+}
+
+/**
+ * @brief The precision of the host's real, and of the kernels that use the
+ * cltypes layouts as they are.
+ */
+inline constexpr options::Precision hostPrecision =
+  sizeof(real) == sizeof(cl_double) ? options::Precision::fp64 : options::Precision::fp32;
 
 template<typename T>
 concept HasKernelArgHandler = requires(T& t, cl::Kernel& kernel, cl_uint index) {
@@ -106,15 +135,35 @@ struct Number : public cltypes::number {
     return *this;
   }
 
+  /**
+   * @brief Converts the number to the single precision kernel layout.
+   * @return The single precision number.
+   */
+  inline cltypes::fp32::number toFp32() const {
+    cltypes::fp32::number result;
+    for (size_t element = 0; element < MAX_NUMBER_SYSTEM_SIZE; element++) {
+      result.raw[element] = static_cast<cl_float>(raw[element]);
+    }
+    return result;
+  }
+
   /**
    * @brief Sets the number as a kernel argument.
    * @param kernel The kernel to set the argument for.
    * @param index The index of the argument.
+   * @param precision The precision of the program the kernel is from.
    */
-  inline void asKernelArg(cl::Kernel& kernel, cl_uint index) const {
+  inline void asKernelArg(
+      cl::Kernel& kernel,
+      cl_uint index,
+      options::Precision precision = hostPrecision) const {
     const cltypes::number &internal = *this;
     try {
-      kernel.setArg(index, internal);
+      if (precision == hostPrecision) {
+        kernel.setArg(index, internal);
+      } else {
+        kernel.setArg(index, toFp32());
+      }
     } catch (const cl::Error& e) {
       throw CLKernelArgError("Could not set Number", kernel, index, e);
     }
@@ -128,8 +177,35 @@ struct Number : public cltypes::number {
  */
 struct Viewspace {
   
-  static constexpr real minZoom = 0.1;    ///< Minimum zoom level.
-  static constexpr real maxZoom = 1.0e15; ///< Maximum zoom level.
+  static constexpr real minZoom = 0.1; ///< Minimum zoom level.
+  /**
+   * Maximum zoom level, where the pixel offsets the perturbed kernels iterate
+   * get close to the smallest normal real.
+   */
+  static constexpr real maxZoom = 1.0 / (std::numeric_limits<real>::min() * 1.0e8);
+  static constexpr real ulpsPerPixel = 16.0; ///< How many ulps per number element a pixel has to span to be resolved.
+
+  /**
+   * @brief Gets the zoom level up to which a precision tells neighboring
+   * pixels apart. Every mul sums as many rounded products as the number
+   * system has elements, so the error bound grows with the element count.
+   * Beyond it, escape mode iterates relative to a high precision reference
+   * orbit instead.
+   * @param precision The precision.
+   * @param numberSystem The number system.
+   * @param width The width of the output, in pixels.
+   * @return The largest zoom level the precision resolves.
+   */
+  static real zoomLimit(options::Precision precision, options::NumberSystem numberSystem, cl::size_type width);
+
+  /**
+   * @brief Gets the maximum zoom level of a precision, where the pixel
+   * offsets its perturbed kernels iterate get close to its smallest normal
+   * number. Past it they underflow and the view turns to noise.
+   * @param precision The precision.
+   * @return maxZoom for double precision, a lower limit for single.
+   */
+  static real maxZoomFor(options::Precision precision);
 
   /**
    * @brief Default constructor initializing viewspace with zero zoom and
@@ -174,34 +250,136 @@ struct Viewspace {
   inline ViewMapping& operator=(const ViewMapping& value) {
     return mapping = value;
   }
-  inline Viewspace& operator+=(const Coordinates& coordinates) {
-    center.applyMapping(mapping, zoom, coordinates);
-    return *this;
-  }
+
+  /**
+   * @brief Moves the center, keeping the precision needed at the current zoom
+   * level.
+   * @param coordinates The offset, in the same units as applyMapping.
+   * @return This viewspace.
+   */
+  Viewspace& operator+=(const Coordinates& coordinates);
   inline Number operator+(const Coordinates& coordinates) const {
     Number result = center;
     result.applyMapping(mapping, zoom, coordinates);
     return result;
   }
 
+  /**
+   * @brief Gets the center in the precision needed at the current zoom level.
+   * Elements of center that were changed without going through operator+= or
+   * setPreciseCenter() are taken as they are.
+   * @return The high precision center.
+   */
+  perturbation::BigNumber getPreciseCenter() const;
+
+  /**
+   * @brief Sets the center in high precision, and center to its rounding.
+   * @param value The high precision center.
+   */
+  void setPreciseCenter(const perturbation::BigNumber& value);
+
+  /**
+   * @brief Converts the viewspace to the layout the kernels use.
+   * @return The kernel viewspace.
+   */
+  operator cltypes::viewspace() const;
+
   /**
    * @brief Sets the viewspace as a kernel argument.
    * @param kernel The kernel to set the argument for.
    * @param index The index of the argument.
+   * @param precision The precision of the program the kernel is from.
+   * @param origin Where the output and work store hold the pixel at the top
+   * left of the screen, they are ring buffers.
    */
-  void asKernelArg(cl::Kernel& kernel, cl_uint index) const;
+  void asKernelArg(
+      cl::Kernel& kernel,
+      cl_uint index,
+      options::Precision precision = hostPrecision,
+      const std::array<cl_uint, 3>& origin = {}) const;
 
   Number center;       ///< Center position of the viewspace.
   real zoom;           ///< Zoom factor for view rendering.
   ViewMapping mapping; ///< Axis mapping for rendering dimensions.
+
+private:
+  perturbation::BigNumber preciseCenter; ///< center, with the digits that don't fit in a real.
+};
+
+/**
+ * @struct WorkStoreBlock
+ * @brief Holds the computed fractal iteration values and iteration indices of
+ * WORK_STORE_BLOCK_SIZE consecutive work items, one plane per element.
+ */
+using WorkStoreBlock = cltypes::work_store_block;
+
+/**
+ * @brief Gets the number of work store blocks needed for a range.
+ * @param range The range of work items.
+ * @return The number of blocks, rounded up.
+ */
+inline size_t workStoreBlockCount(const cl::NDRange& range) {
+  return (range[0] * range[1] * range[2] + WORK_STORE_BLOCK_SIZE - 1) / WORK_STORE_BLOCK_SIZE;
+}
+
+/**
+ * @struct WorkStoreLayout
+ * @brief The optional planes of the work store blocks of a program. A
+ * program only keeps those its kernels read.
+ */
+struct WorkStoreLayout {
+  bool cycles;           ///< Whether blocks keep the cycle detection checkpoints, which the escape kernels read.
+  bool referenceIndices; ///< Whether blocks keep the reference orbit indices, which the perturbed kernels read.
+
+  /**
+   * @brief Orders layouts, so programs can be looked up by them.
+   */
+  auto operator<=>(const WorkStoreLayout&) const = default;
 };
 
 /**
- * @struct WorkStore
- * @brief Holds a computed fractal iteration value and associated iteration
- * index.
+ * @brief The layout of the host's blocks, which keep every plane.
  */
-using WorkStore = cltypes::work_store;
+inline constexpr WorkStoreLayout hostWorkStoreLayout{
+  .cycles = WORK_STORE_CYCLES != 0,
+  .referenceIndices = WORK_STORE_REFERENCE_INDICES != 0};
+
+/**
+ * @brief Gets the layout of the work store blocks a render mode's kernels
+ * need. Programs of other layouts lack the kernels or detect no cycles.
+ * @param renderMode The render mode.
+ * @param perturbed Whether the perturbed kernels are used, which detect no
+ * cycles.
+ * @return The layout.
+ */
+inline constexpr WorkStoreLayout workStoreLayout(options::RenderMode renderMode, bool perturbed = false) {
+  return {
+    .cycles = renderMode == options::RenderMode::escape && !perturbed,
+    .referenceIndices = perturbed};
+}
+
+/**
+ * @brief Gets the size of the work store blocks of a program, which only keep
+ * the elements of its number system, in its precision, and its planes.
+ * @param precision The precision of the program.
+ * @param elementCount The number of elements of its number system.
+ * @param layout The planes of the program.
+ * @return The size of a block, in bytes.
+ */
+inline constexpr size_t workStoreBlockSize(
+    options::Precision precision,
+    size_t elementCount,
+    WorkStoreLayout layout) {
+  const size_t realSize = precision == options::Precision::fp64 ? sizeof(cl_double) : sizeof(cl_float);
+  const size_t valuePlanes = layout.cycles ? 2 * elementCount : elementCount;
+  const size_t countPlanes = layout.referenceIndices ? 2 : 1;
+  // Mirrors cltypes::work_store_block.
+  return (valuePlanes * realSize + countPlanes * sizeof(cl_uint)) * WORK_STORE_BLOCK_SIZE;
+}
+
+static_assert(
+  workStoreBlockSize(hostPrecision, MAX_NUMBER_SYSTEM_SIZE, hostWorkStoreLayout) == sizeof(WorkStoreBlock),
+  "workStoreBlockSize() must match the layout of work_store_block.");
 } // namespace fractalism::gpu::types
 
 #endif
@@ -28,16 +28,78 @@ _EXTERN_C_DECL_
     number center;
     real zoom;
     view_mapping mapping;
+    cl_uint origin[3]; // Where the pixel/voxel at the top left of the screen is stored.
   } _PACK_END_;
 
   typedef struct viewspace viewspace;
 
-  _PACK_BEGIN_ struct work_store {
-    number value;
-    cl_uint i;
+  // The camera the distance kernels trace 3D views from. Single precision in
+  // every program, like the OpenGL camera it comes from.
+  _PACK_BEGIN_ struct trace_camera {
+    cl_float eye[3];
+    cl_float light[3];                    // Towards the light, normalized.
+    cl_float inverse_view_projection[16]; // Column major, from clip space to the volume.
+    cl_float pixel_size;                  // The width of a pixel one unit from the eye.
+    cl_uint traced;                       // Zero for 2D views, which are slices instead.
   } _PACK_END_;
 
-  typedef struct work_store work_store;
+  typedef struct trace_camera trace_camera;
+
+  #define WORK_STORE_BLOCK_SIZE 64
+
+  // The work store of a 3D view too large for the device is paged: only the
+  // bricks of WORK_STORE_PAGE_SIDE voxels per side that need one get a page.
+  // The side is the spacing of the coarsest progressive level.
+  #define WORK_STORE_PAGE_SIDE 8
+  #define WORK_STORE_NO_PAGE 0xFFFFFFFFu
+  // A brick that needs a page but found none left. It gets one once the
+  // bricks with a page are done and give theirs up.
+  #define WORK_STORE_STARVED 0xFFFFFFFEu
+
+  // A paged work store starts with one voxel per brick, its first corner,
+  // which the coarsest level computes. The pages follow. The page table
+  // starts with a header, then holds the page of each brick,
+  // WORK_STORE_NO_PAGE or WORK_STORE_STARVED.
+  #define PAGE_TABLE_COARSE_VOXELS 0 // The size of the region of corners, in whole blocks of voxels.
+  #define PAGE_TABLE_CAPACITY 1      // The number of pages in the store.
+  #define PAGE_TABLE_USED 2          // The number of pages handed out, may exceed the capacity.
+  #define PAGE_TABLE_HEADER 4
+
+  // The number elements a work store keeps. A program only keeps those of
+  // its number system, in its precision, so its blocks may be smaller than
+  // the host's, which keep every element.
+  #if !defined(WORK_STORE_ELEMENTS)
+    #define WORK_STORE_ELEMENTS MAX_NUMBER_SYSTEM_SIZE
+  #endif
+
+  // Whether a work store keeps the cycle detection checkpoints, which only
+  // the escape kernels read. The host keeps them.
+  #if !defined(WORK_STORE_CYCLES)
+    #define WORK_STORE_CYCLES 1
+  #endif
+
+  // Whether a work store keeps the reference orbit indices, which only the
+  // perturbed kernels read. The host keeps them.
+  #if !defined(WORK_STORE_REFERENCE_INDICES)
+    #define WORK_STORE_REFERENCE_INDICES 1
+  #endif
+
+  // The iteration state of WORK_STORE_BLOCK_SIZE consecutive work items, one
+  // plane per number element plus one per count. Neighboring work items
+  // access neighboring addresses, and every plane is aligned.
+  // Deliberately not packed, the layout is the same on the host and device.
+  struct work_store_block {
+    real value[WORK_STORE_ELEMENTS][WORK_STORE_BLOCK_SIZE];
+  #if WORK_STORE_CYCLES
+    real cycle[WORK_STORE_ELEMENTS][WORK_STORE_BLOCK_SIZE]; // Cycle detection checkpoint.
+  #endif
+    cl_uint i[WORK_STORE_BLOCK_SIZE];
+  #if WORK_STORE_REFERENCE_INDICES
+    cl_uint reference_index[WORK_STORE_BLOCK_SIZE]; // Perturbed kernels: the reference orbit point value is relative to.
+  #endif
+  };
+
+  typedef struct work_store_block work_store_block;
 
 _EXTERN_C_END_
 
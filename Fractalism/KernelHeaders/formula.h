@@ -0,0 +1,18 @@
+#ifndef _FRACTALISM_FORMULA_H_
+#define _FRACTALISM_FORMULA_H_
+
+// The fractal every kernel iterates. The host kernels include it, the OpenCL
+// programs get it as text from ProgramManager, which stringifies these macros.
+
+// The squared modulus at which orbits escape.
+#define ESCAPE_VALUE 8.0
+
+// Steps z, in the arithmetic of the number system passed in.
+#define KERNEL_FUNCTION(add, sub, conj, mul, sqr, scale, modulus_sq) z = add(sqr(z), c)
+
+// Steps the distance dz to the reference point ref_z:
+// (ref_z + dz)^2 + c + dc - (ref_z^2 + c), without assuming mul commutes.
+#define PERTURBATION_FUNCTION(add, sub, conj, mul, sqr, scale, modulus_sq) \
+  dz = add(add(add(mul(ref_z, dz), mul(dz, ref_z)), sqr(dz)), dc)
+
+#endif
@@ -16,19 +16,54 @@
   #define _ON_GPU_ 1
   // Defines to allow using the cl_* 
   #define cl_char char
+  #define cl_uchar uchar
   #define cl_uint uint
   #define cl_double double
   #define cl_float float
+  // Vector literals, spelled so the host compiler can provide its own.
+  #define make_float4(x, y, z, w) ((float4)((x), (y), (z), (w)))
+  #define make_int4(x, y, z, w) ((int4)((x), (y), (z), (w)))
 #else
   // We are in the host machine compiler.
   #define _ON_GPU_ 0
   // Include the OpenCL headers and #define a few CL keywords.
-  #include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+  #if defined(__cplusplus)
+    #include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+  #elif defined(__APPLE__)
+    #include <OpenCL/cl_platform.h>
+  #else
+    #include <CL/cl_platform.h>
+  #endif
   #define __constant const
   #define __global
   #define __write_only
   #define __kernel static
   #define convert_int_rte(value) (int)(value)
+
+  // Host stand-ins for the OpenCL C vector types used by the kernels.
+  typedef struct float4 {
+    float x;
+    float y;
+    float z;
+    float w;
+  } float4;
+
+  typedef struct int4 {
+    int x;
+    int y;
+    int z;
+    int w;
+  } int4;
+
+  static inline float4 make_float4(float x, float y, float z, float w) {
+    float4 result = { x, y, z, w };
+    return result;
+  }
+
+  static inline int4 make_int4(int x, int y, int z, int w) {
+    int4 result = { x, y, z, w };
+    return result;
+  }
 #endif
 
 // We have to have a max number system size set during build.
@@ -16,16 +16,23 @@ static inline float4 fractional_escape_color(real modulus_squared, unsigned int
   real value = ((((real)iteration) - log(log(modulus_squared) / 2.0) + ((real)M_LN2)) / (real)max_iterations);
   return (iteration < max_iterations) ?
     spectral_color((float) value) :
-    (float4)(0.0f, 0.0f, 0.0f, (float) (value * value));
+    make_float4(0.0f, 0.0f, 0.0f, (float) (value * value));
 }
 
-#if !defined(CL_DEVICE_MAX_MEM_ALLOC_SIZE)
-#error "Preprocessor macro CL_DEVICE_MAX_MEM_ALLOC_SIZE is not defined."
+#if !defined(WORK_STORE_BUFFER_BYTES)
+#error "Preprocessor macro WORK_STORE_BUFFER_BYTES is not defined."
 #endif
 
-__constant size_t max_work_store_buffer_size = CL_DEVICE_MAX_MEM_ALLOC_SIZE / sizeof(work_store);
+// Stored as the iteration count of a pixel a pan exposed, which the kernels
+// then initialize even though the rest of the store is being continued.
+#define WORK_ITEM_NOT_STARTED 0xFFFFFFFFu
+
+// The number of blocks in each work store buffer. The host allocates the
+// buffers in its own blocks, the program's may be smaller and leave the end
+// of each buffer unused.
+__constant size_t max_work_store_buffer_size = WORK_STORE_BUFFER_BYTES / sizeof(work_store_block);
 _PACK_BEGIN_ struct work_store_buffer {
-  __global work_store* p;
+  __global work_store_block* p;
 } _PACK_END_;
 
 typedef struct work_store_buffer work_store_buffer;
@@ -49,37 +56,337 @@ typedef struct work_item {
 
 typedef struct work_store_item {
   work_item item;
-  __global work_store* p;
+  work_item_location stored;
+  size_t index;
+  __global work_store_block* p;
+  size_t lane;
 } work_store_item;
 
-static inline work_item get_work_item() {
+// The output and work store are ring buffers, so a pan only moves their origin:
+// the pixel/voxel at a location on screen is stored at location + origin,
+// wrapped around.
+static inline work_item_location stored_location(work_item_location location, work_dimensions dimensions, viewspace view) {
+  return (work_item_location) {
+    (location.x + view.origin[0]) % dimensions.width,
+    (location.y + view.origin[1]) % dimensions.height,
+    (location.z + view.origin[2]) % dimensions.depth
+  };
+}
+
+// Without an active item list the kernel is launched over the whole output.
+// With one, it is launched over the list, and each work item looks up which
+// pixel/voxel it is. The list holds where items are stored.
+static inline work_item get_work_item(__write_only image3d_t output, __global const unsigned int* active_items, viewspace view) {
+  work_dimensions dimensions = {
+    get_image_width(output),
+    get_image_height(output),
+    get_image_depth(output)
+  };
+  if (!active_items) {
+    return (work_item) {
+      .location = {
+        get_global_id(0),
+        get_global_id(1),
+        get_global_id(2)
+      },
+      .dimensions = dimensions
+    };
+  }
+  size_t index = active_items[get_global_id(0)];
   return (work_item) {
     .location = {
-      get_global_id(0),
-      get_global_id(1),
-      get_global_id(2)
+      (index % dimensions.width + dimensions.width - view.origin[0]) % dimensions.width,
+      ((index / dimensions.width) % dimensions.height + dimensions.height - view.origin[1]) % dimensions.height,
+      (index / (dimensions.width * dimensions.height) + dimensions.depth - view.origin[2]) % dimensions.depth
     },
-    .dimensions = {
-      get_global_size(0),
-      get_global_size(1),
-      get_global_size(2)
-    }
+    .dimensions = dimensions
   };
 }
 
-static inline work_store_item get_work_store_item(__global work_store_buffer* buffer) {
-  work_item item = get_work_item();
+static inline __global work_store_block* get_work_store_block(__global work_store_buffer* buffer, size_t index) {
+  size_t block = index / WORK_STORE_BLOCK_SIZE;
+  return &buffer[block / max_work_store_buffer_size].p[block % max_work_store_buffer_size];
+}
+
+#define WORK_STORE_PAGE_VOXELS (WORK_STORE_PAGE_SIDE * WORK_STORE_PAGE_SIDE * WORK_STORE_PAGE_SIDE)
+#define WORK_STORE_NO_INDEX ((size_t)-1)
 
-  size_t index = (item.location.z * item.dimensions.height * item.dimensions.width) + (item.location.y * item.dimensions.width) + item.location.x;
+static inline size_t brick_index(work_item_location stored, work_dimensions dimensions) {
+  size_t bricks_x = (dimensions.width + WORK_STORE_PAGE_SIDE - 1) / WORK_STORE_PAGE_SIDE;
+  size_t bricks_y = (dimensions.height + WORK_STORE_PAGE_SIDE - 1) / WORK_STORE_PAGE_SIDE;
+  return ((stored.z / WORK_STORE_PAGE_SIDE) * bricks_y + stored.y / WORK_STORE_PAGE_SIDE) * bricks_x
+    + stored.x / WORK_STORE_PAGE_SIDE;
+}
+
+// Where a pixel/voxel is kept in the work store. Without a page table the
+// store is dense. Voxels of bricks without a page, or still waiting for one,
+// have no place in it.
+static inline size_t work_store_index(
+    __global const unsigned int* pages,
+    work_item_location stored,
+    work_dimensions dimensions) {
+  if (!pages) {
+    return (stored.z * dimensions.height + stored.y) * dimensions.width + stored.x;
+  }
+  size_t brick = brick_index(stored, dimensions);
+  if (((stored.x | stored.y | stored.z) & (WORK_STORE_PAGE_SIDE - 1)) == 0) {
+    return brick;
+  }
+  unsigned int page = pages[PAGE_TABLE_HEADER + brick];
+  if (page >= WORK_STORE_STARVED) {
+    return WORK_STORE_NO_INDEX;
+  }
+  return pages[PAGE_TABLE_COARSE_VOXELS]
+    + (size_t)page * WORK_STORE_PAGE_VOXELS
+    + ((stored.z % WORK_STORE_PAGE_SIDE) * WORK_STORE_PAGE_SIDE + stored.y % WORK_STORE_PAGE_SIDE) * WORK_STORE_PAGE_SIDE
+    + stored.x % WORK_STORE_PAGE_SIDE;
+}
+
+// p is null if the voxel has no place in the work store, or if there is no
+// work store, as on the helper devices.
+static inline work_store_item get_work_store_item(
+    __write_only image3d_t output,
+    __global work_store_buffer* buffer,
+    __global const unsigned int* pages,
+    __global const unsigned int* active_items,
+    viewspace view) {
+  work_item item = get_work_item(output, active_items, view);
+  work_item_location stored = stored_location(item.location, item.dimensions, view);
+
+  size_t index = (stored.z * item.dimensions.height * item.dimensions.width) + (stored.y * item.dimensions.width) + stored.x;
+  size_t store_index = work_store_index(pages, stored, item.dimensions);
 
   return (work_store_item) {
     item,
-    &buffer[index / max_work_store_buffer_size].p[index % max_work_store_buffer_size]
+    stored,
+    index,
+    store_index == WORK_STORE_NO_INDEX || !buffer ? 0 : get_work_store_block(buffer, store_index),
+    store_index % WORK_STORE_BLOCK_SIZE
   };
 }
 
+#if _ON_GPU_
+// Lists the pixels progressive rendering computes at a level of detail: every
+// 2^level-th pixel along each axis on screen, except those a coarser level
+// computed. Launched over the grid of the level, the list then seeds the
+// active items. With a paged work store, only pixels with a page are listed.
+__kernel void list_level_items(
+    unsigned int width,
+    unsigned int height,
+    unsigned int depth,
+    unsigned int level,
+    unsigned int coarsest_level,
+    uint4 origin,
+    __global unsigned int *items,
+    __global unsigned int *count,
+    __global const unsigned int *pages) {
+  size_t x = get_global_id(0) << level;
+  size_t y = get_global_id(1) << level;
+  size_t z = get_global_id(2) << level;
+  if (x >= width || y >= height || z >= depth) {
+    return;
+  }
+  if (level < coarsest_level && ((x | y | z) & ((2u << level) - 1)) == 0) {
+    return;
+  }
+  x = (x + origin.x) % width;
+  y = (y + origin.y) % height;
+  z = (z + origin.z) % depth;
+  // The bricks of a paged work store without a page were filled instead.
+  if (pages && work_store_index(pages, (work_item_location){x, y, z}, (work_dimensions){width, height, depth}) == WORK_STORE_NO_INDEX) {
+    return;
+  }
+  items[atomic_inc(count)] = (unsigned int)((z * height + y) * width + x);
+}
+
+// Once the full resolution is done, nothing reads the work store of the
+// bricks with a page again: a finished voxel lives on as its color in the
+// output, which its iteration count and escape fraction make up. Their pages
+// go to the bricks that ran out of them. Launched over the bricks, with
+// PAGE_TABLE_USED zeroed.
+__kernel void regrant_pages(__global unsigned int *pages) {
+  size_t entry = PAGE_TABLE_HEADER + get_global_id(0);
+  unsigned int page = pages[entry];
+  if (page == WORK_STORE_NO_PAGE) {
+    return;
+  }
+  if (page != WORK_STORE_STARVED) {
+    pages[entry] = WORK_STORE_NO_PAGE;
+    return;
+  }
+  page = atomic_inc(&pages[PAGE_TABLE_USED]);
+  if (page < pages[PAGE_TABLE_CAPACITY]) {
+    pages[entry] = page;
+  }
+}
+
+// Lists the voxels of the bricks regrant_pages handed a page to, all but the
+// corner the coarsest level computed. One work group per brick.
+__kernel void list_granted_items(
+    unsigned int width,
+    unsigned int height,
+    unsigned int depth,
+    __global const unsigned int *pages,
+    __global unsigned int *items,
+    __global unsigned int *count) {
+  size_t bricks_x = (width + WORK_STORE_PAGE_SIDE - 1) / WORK_STORE_PAGE_SIDE;
+  size_t bricks_y = (height + WORK_STORE_PAGE_SIDE - 1) / WORK_STORE_PAGE_SIDE;
+  size_t brick = get_group_id(0);
+  if (pages[PAGE_TABLE_HEADER + brick] >= WORK_STORE_STARVED) {
+    return;
+  }
+  size_t first_x = (brick % bricks_x) * WORK_STORE_PAGE_SIDE;
+  size_t first_y = ((brick / bricks_x) % bricks_y) * WORK_STORE_PAGE_SIDE;
+  size_t first_z = (brick / (bricks_x * bricks_y)) * WORK_STORE_PAGE_SIDE;
+  for (size_t k = get_local_id(0) + 1; k < WORK_STORE_PAGE_VOXELS; k += get_local_size(0)) {
+    size_t x = first_x + k % WORK_STORE_PAGE_SIDE;
+    size_t y = first_y + (k / WORK_STORE_PAGE_SIDE) % WORK_STORE_PAGE_SIDE;
+    size_t z = first_z + k / (WORK_STORE_PAGE_SIDE * WORK_STORE_PAGE_SIDE);
+    if (x < width && y < height && z < depth) {
+      items[atomic_inc(count)] = (unsigned int)((z * height + y) * width + x);
+    }
+  }
+}
+
+// Starts over the pixels a pan exposed: marks them not started in the work
+// store, clears them in the output and, if items is set, lists them. Launched
+// per panned axis over the pixels on screen the pan exposed along it, with the
+// origin already moved. Pixels an earlier axis exposed are skipped, so none is
+// listed twice.
+__kernel void start_exposed_items(
+    __write_only image3d_t output,
+    __global work_store_buffer *buffer,
+    uint4 origin,
+    int4 shift,
+    unsigned int axis,
+    __global unsigned int *items,
+    __global unsigned int *count) {
+  size_t size[3] = {get_image_width(output), get_image_height(output), get_image_depth(output)};
+  size_t location[3] = {get_global_id(0), get_global_id(1), get_global_id(2)};
+  int shifts[3] = {shift.x, shift.y, shift.z};
+  unsigned int origins[3] = {origin.x, origin.y, origin.z};
+  for (unsigned int earlier = 0; earlier < axis; earlier++) {
+    if (shifts[earlier] > 0 ?
+        location[earlier] >= size[earlier] - shifts[earlier] :
+        location[earlier] < (size_t)-shifts[earlier]) {
+      return;
+    }
+  }
+  for (unsigned int i = 0; i < 3; i++) {
+    location[i] = (location[i] + origins[i]) % size[i];
+  }
+  size_t index = (location[2] * size[1] + location[1]) * size[0] + location[0];
+  get_work_store_block(buffer, index)->i[index % WORK_STORE_BLOCK_SIZE] = WORK_ITEM_NOT_STARTED;
+  write_imagef(output, (int4)((int)location[0], (int)location[1], (int)location[2], 0), (float4)(0.0f));
+  if (items) {
+    items[atomic_inc(count)] = (unsigned int)index;
+  }
+}
+
+// Builds the occupancy bricks the 3D ray marcher skips empty space with. Each
+// texel of bricks is the highest alpha of brick_size texels per side of the
+// volume on screen, and of those the ray marcher reads from inside the brick:
+// filtering and the normals reach up to 2 grid steps out. While rendering
+// progressively only every 2^level-th texel is up to date, the others are
+// never read. Launched over bricks.
+__kernel void build_occupancy_bricks(
+    __read_only image3d_t volume,
+    uint4 origin,
+    unsigned int brick_size,
+    unsigned int level,
+    __write_only image3d_t bricks) {
+  int4 size = get_image_dim(volume);
+  int stride = 1 << level;
+  int4 brick = (int4)((int)get_global_id(0), (int)get_global_id(1), (int)get_global_id(2), 0);
+  int4 first = max(brick * (int)brick_size - 2 * stride, (int4)(0));
+  int4 last = min((brick + 1) * (int)brick_size - 1 + 2 * stride, size - 1);
+  first = (first + stride - 1) / stride * stride;
+  float occupancy = 0.0f;
+  for (int z = first.z; z <= last.z; z += stride) {
+    for (int y = first.y; y <= last.y; y += stride) {
+      for (int x = first.x; x <= last.x; x += stride) {
+        int4 stored = (int4)(
+          (x + (int)origin.x) % size.x,
+          (y + (int)origin.y) % size.y,
+          (z + (int)origin.z) % size.z,
+          0);
+        occupancy = max(occupancy, read_imagef(volume, stored).w);
+      }
+    }
+  }
+  write_imagef(bricks, brick, (float4)(occupancy));
+}
+#endif
+
+// Only the planes of the elements the number system uses are touched.
+static inline void load_work_store_planes(
+    __global real (*planes)[WORK_STORE_BLOCK_SIZE],
+    size_t lane,
+    real* raw,
+    size_t element_count) {
+  for (size_t element = 0; element < element_count; element++) {
+    raw[element] = planes[element][lane];
+  }
+}
+
+static inline void save_work_store_planes(
+    __global real (*planes)[WORK_STORE_BLOCK_SIZE],
+    size_t lane,
+    real* raw,
+    size_t element_count) {
+  for (size_t element = 0; element < element_count; element++) {
+    planes[element][lane] = raw[element];
+  }
+}
+
+// The cycle detection checkpoint of a work item. Programs without the planes
+// never detect cycles, see WORK_STORE_CYCLES.
+static inline void load_cycle_checkpoint(
+    __global work_store_block* block,
+    size_t lane,
+    real* raw,
+    size_t element_count) {
+#if WORK_STORE_CYCLES
+  load_work_store_planes(block->cycle, lane, raw, element_count);
+#endif
+}
+
+static inline void save_cycle_checkpoint(
+    __global work_store_block* block,
+    size_t lane,
+    real* raw,
+    size_t element_count) {
+#if WORK_STORE_CYCLES
+  save_work_store_planes(block->cycle, lane, raw, element_count);
+#endif
+}
+
+// Reference orbits are packed, element_count reals per point.
+static inline void load_reference_point(
+    __global const real* reference,
+    unsigned int n,
+    real* raw,
+    size_t element_count) {
+  for (size_t element = 0; element < element_count; element++) {
+    raw[element] = reference[n * element_count + element];
+  }
+}
+
+#if USE_DOUBLE_MATH
+  #define REAL_EPSILON DBL_EPSILON
+#else
+  #define REAL_EPSILON FLT_EPSILON
+#endif
+
+// An orbit point closer than this to the last checkpoint, relative to the
+// checkpoint's modulus outside the unit disk, is taken to be on a cycle.
+// Loose enough to catch cycles that converge slowly, tight enough to not
+// catch orbits that only pass close by. In real, so float programs never
+// compare in double.
+#define CYCLE_TOLERANCE_SQ (((real)64 * REAL_EPSILON) * ((real)64 * REAL_EPSILON))
+
 static inline float4 location_to_color(work_item item) {
-  return (float4)(
+  return make_float4(
     ((float)item.location.x) / ((float)item.dimensions.width),
     0.5 + ((float)item.location.z) / (2.0 * (float)item.dimensions.depth),
     ((float)item.location.y) / ((float)item.dimensions.height),
@@ -88,49 +395,183 @@ static inline float4 location_to_color(work_item item) {
              item.dimensions.depth*item.dimensions.depth)));
 }
 
-#define create_kernel(name, c_value, z0_value, condition, function, finish, number_system, number_system_type) \
+// If detect_cycles is set, the orbit is checked for cycles the way Brent's
+// algorithm does it: z is checkpointed whenever the iteration count reaches a
+// power of two, and compared to the checkpoint after every iteration. A point
+// on a cycle never escapes, so it jumps straight to total_iterations. The
+// checkpoint is kept in the work store, so detect_cycles needs
+// WORK_STORE_CYCLES.
+#define create_kernel(name, c_value, z0_value, condition, detect_cycles, function, finish, number_system, number_system_type) \
 __kernel void name##_##number_system( \
     __write_only image3d_t output, \
     __global work_store_buffer *buffer, \
+    __global const unsigned int *pages, \
     viewspace view, \
     number parameter, \
     unsigned int last_iteration, \
-    unsigned int max_iterations) { \
-  work_store_item store_item = get_work_store_item(buffer); \
+    unsigned int max_iterations, \
+    unsigned int total_iterations, \
+    __global const unsigned int *active_items, \
+    __global unsigned int *next_active_items, \
+    __global unsigned int *next_active_count) { \
+  work_store_item store_item = get_work_store_item(output, buffer, pages, active_items, view); \
   number_system_type c = c_value; \
   number_system_type z; \
+  number_system_type cycle_z; \
   unsigned int i; \
-  if (last_iteration == 0) { \
+  real raw[MAX_NUMBER_SYSTEM_SIZE]; \
+  /* Without a place in the work store, every launch starts over. */ \
+  if (last_iteration == 0 || !store_item.p || store_item.p->i[store_item.lane] == WORK_ITEM_NOT_STARTED) { \
     z = z0_value; \
+    cycle_z = z; \
     i = 0; \
   } else { \
-    work_store z_last = *store_item.p; \
-    z = number_system##_from_raw(z_last.value.raw, 0); \
-    i = z_last.i; \
+    load_work_store_planes(store_item.p->value, store_item.lane, raw, number_system##_element_count()); \
+    z = number_system##_from_raw(raw, 0); \
+    cycle_z = z; \
+    if (detect_cycles) { \
+      load_cycle_checkpoint(store_item.p, store_item.lane, raw, number_system##_element_count()); \
+      cycle_z = number_system##_from_raw(raw, 0); \
+    } \
+    i = store_item.p->i[store_item.lane]; \
   } \
   for (;(i < max_iterations) && (condition); i++) { \
     function; \
+    if (detect_cycles) { \
+      if (modulus_sq_##number_system(sub_##number_system(z, cycle_z)) \
+          < CYCLE_TOLERANCE_SQ * fmax((real)1, modulus_sq_##number_system(cycle_z))) { \
+        i = total_iterations; \
+        break; \
+      } \
+      /* i + 1 iterations are done, checkpoint if that is a power of two. */ \
+      if (((i + 1) & i) == 0) { \
+        cycle_z = z; \
+      } \
+    } \
+  } \
+  if (store_item.p) { \
+    number_system##_to_raw(z, raw, 0); \
+    save_work_store_planes(store_item.p->value, store_item.lane, raw, number_system##_element_count()); \
+    if (detect_cycles) { \
+      number_system##_to_raw(cycle_z, raw, 0); \
+      save_cycle_checkpoint(store_item.p, store_item.lane, raw, number_system##_element_count()); \
+    } \
+    store_item.p->i[store_item.lane] = i; \
+  } \
+  if (next_active_items && (condition) && i < total_iterations) { \
+    next_active_items[atomic_inc(next_active_count)] = (unsigned int)store_item.index; \
+    /* Launched over the whole output, every texel has to be written. */ \
+    if (active_items) { \
+      return; \
+    } \
   } \
-  number result = (number){{0.0}}; \
-  number_system##_to_raw(z, result.raw, 0);\
-  *store_item.p = (work_store){.i = i, .value = result}; \
   finish; \
 }
 
-#define write_fractional_escape(number_system) \
+// Perturbed kernels iterate the distance dz of each orbit to a reference orbit
+// the host computed in high precision, so a pixel only needs the precision of
+// its distance to the reference rather than of its position. function is
+// PERTURBATION_FUNCTION, which steps dz along with the reference point ref_z.
+// When the orbit comes closer to zero than it is to the reference, or the
+// reference ends, dz no longer follows the reference accurately. The pixel
+// then rebases: dz is taken relative to the start of the reference, and the
+// pixel follows it from there. Cycles are not detected, the distance to a
+// checkpoint is below the precision of z at these zoom levels.
+#define create_perturbed_kernel(name, dc_value, dz0_value, escape, function, number_system, number_system_type) \
+__kernel void name##_##number_system( \
+    __write_only image3d_t output, \
+    __global work_store_buffer *buffer, \
+    __global const unsigned int *pages, \
+    viewspace view, \
+    number parameter, \
+    unsigned int last_iteration, \
+    unsigned int max_iterations, \
+    unsigned int total_iterations, \
+    __global const unsigned int *active_items, \
+    __global unsigned int *next_active_items, \
+    __global unsigned int *next_active_count, \
+    __global const real *reference, \
+    unsigned int reference_length) { \
+  work_store_item store_item = get_work_store_item(output, buffer, pages, active_items, view); \
+  number_system_type dc = dc_value; \
+  number_system_type dz; \
+  number_system_type ref_z0; \
+  number_system_type ref_z; \
+  number_system_type z; \
+  unsigned int i; \
+  unsigned int n; \
+  real raw[MAX_NUMBER_SYSTEM_SIZE]; \
+  load_reference_point(reference, 0, raw, number_system##_element_count()); \
+  ref_z0 = number_system##_from_raw(raw, 0); \
+  if (last_iteration == 0 || !store_item.p) { \
+    dz = dz0_value; \
+    i = 0; \
+    n = 0; \
+  } else { \
+    load_work_store_planes(store_item.p->value, store_item.lane, raw, number_system##_element_count()); \
+    dz = number_system##_from_raw(raw, 0); \
+    i = store_item.p->i[store_item.lane]; \
+    n = store_item.p->reference_index[store_item.lane]; \
+    /* A shorter reference lacks the point dz is relative to. */ \
+    if (n >= reference_length) { \
+      dz = dz0_value; \
+      i = 0; \
+      n = 0; \
+    } \
+  } \
+  load_reference_point(reference, n, raw, number_system##_element_count()); \
+  ref_z = number_system##_from_raw(raw, 0); \
+  z = add_##number_system(ref_z, dz); \
+  for (;(i < max_iterations) && (modulus_sq_##number_system(z) < escape); i++) { \
+    if (modulus_sq_##number_system(z) < modulus_sq_##number_system(dz) || n + 1 >= reference_length) { \
+      dz = sub_##number_system(z, ref_z0); \
+      ref_z = ref_z0; \
+      n = 0; \
+    } \
+    function; \
+    n++; \
+    load_reference_point(reference, n, raw, number_system##_element_count()); \
+    ref_z = number_system##_from_raw(raw, 0); \
+    z = add_##number_system(ref_z, dz); \
+  } \
+  if (store_item.p) { \
+    number_system##_to_raw(dz, raw, 0); \
+    save_work_store_planes(store_item.p->value, store_item.lane, raw, number_system##_element_count()); \
+    store_item.p->i[store_item.lane] = i; \
+    store_item.p->reference_index[store_item.lane] = n; \
+  } \
+  if (next_active_items && (modulus_sq_##number_system(z) < escape) && i < total_iterations) { \
+    next_active_items[atomic_inc(next_active_count)] = (unsigned int)store_item.index; \
+    if (active_items) { \
+      return; \
+    } \
+  } \
+  write_fractional_escape(number_system, escape); \
+}
+
+// Colors are relative to the final iteration limit rather than the frame's,
+// so a pixel colored when it escapes does not have to be redrawn later.
+#define write_fractional_escape(number_system, escape) \
 write_imagef( \
     output, \
-    (int4)(store_item.item.location.x, store_item.item.location.y, store_item.item.location.z, 0), \
-    fractional_escape_color(modulus_sq_##number_system(z), max_iterations, i))
+    make_int4(store_item.stored.x, store_item.stored.y, store_item.stored.z, 0), \
+    fractional_escape_color( \
+        modulus_sq_##number_system(z), \
+        total_iterations, \
+        modulus_sq_##number_system(z) < escape ? total_iterations : i))
 
 #define write_translated_point(number_system) \
 int4 translated = reverse_view_mapping_##number_system(view, store_item.item, z); \
 if (translated.x >= 0 && translated.x < store_item.item.dimensions.width && \
     translated.y >= 0 && translated.y < store_item.item.dimensions.height && \
     translated.z >= 0 && translated.z < store_item.item.dimensions.depth) { \
+  work_item_location target = stored_location( \
+      (work_item_location) {translated.x, translated.y, translated.z}, \
+      store_item.item.dimensions, \
+      view); \
   write_imagef( \
       output, \
-      translated, \
+      make_int4(target.x, target.y, target.z, 0), \
       location_to_color(store_item.item)); \
 }
 
@@ -138,13 +579,15 @@ if (translated.x >= 0 && translated.x < store_item.item.dimensions.width && \
 create_kernel( \
   name##_escape, c_value, z0_value, \
   modulus_sq_##number_system(z) < escape, \
+  WORK_STORE_CYCLES, \
   function, \
-  write_fractional_escape(number_system), \
+  write_fractional_escape(number_system, escape), \
   number_system, \
   number_system_type) \
 create_kernel( \
   name##_translated, c_value, z0_value, \
   true, \
+  0, \
   function, \
   write_translated_point(number_system), \
   number_system, \
@@ -170,6 +613,282 @@ create_escape_and_translated_kernels( \
     number_system, \
     number_system_type)
 
+#if defined(PERTURBATION_FUNCTION) && WORK_STORE_REFERENCE_INDICES
+// Phase space follows the orbit of the view center, dynamical space the orbit
+// of the view center under the parameter.
+#define create_perturbed_kernels(function, escape, number_system, number_system_type) \
+create_perturbed_kernel( \
+    phase_escape_perturbed, \
+    view_offset_##number_system(view, store_item.item), \
+    zero_##number_system(), \
+    escape, \
+    function, \
+    number_system, \
+    number_system_type) \
+create_perturbed_kernel( \
+    dynamical_escape_perturbed, \
+    zero_##number_system(), \
+    view_offset_##number_system(view, store_item.item), \
+    escape, \
+    function, \
+    number_system, \
+    number_system_type)
+#else
+#define create_perturbed_kernels(function, escape, number_system, number_system_type)
+#endif
+
+#if _ON_GPU_
+// Mariani-Silver subdivision of the 2D escape views. The escape time regions
+// and the set are connected, so a rectangle whose border took one iteration
+// count throughout holds that count inside, and is filled from its border.
+// The others are split in four, and only the lines between the quarters are
+// computed. Rectangles are their borders on screen, (left, top, right,
+// bottom) inclusive, and are split until their inside is smaller than
+// SUBDIVISION_MIN_INTERIOR along an axis, then computed pixel by pixel.
+#define SUBDIVISION_MIN_INTERIOR 7
+
+static inline int4 stored_texel(size_t x, size_t y, size_t width, size_t height, uint4 origin) {
+  return (int4)((int)((x + origin.x) % width), (int)((y + origin.y) % height), 0, 0);
+}
+
+static inline size_t stored_texel_index(int4 texel, size_t width) {
+  return (size_t)texel.y * width + (size_t)texel.x;
+}
+
+// Walks the border clockwise from the top left corner.
+static inline int4 rect_border_texel(uint4 rect, size_t k, size_t width, size_t height, uint4 origin) {
+  size_t w = rect.z - rect.x;
+  size_t h = rect.w - rect.y;
+  if (k < w) {
+    return stored_texel(rect.x + k, rect.y, width, height, origin);
+  }
+  if (k < w + h) {
+    return stored_texel(rect.z, rect.y + (k - w), width, height, origin);
+  }
+  if (k < 2 * w + h) {
+    return stored_texel(rect.z - (k - w - h), rect.w, width, height, origin);
+  }
+  return stored_texel(rect.x, rect.w - (k - 2 * w - h), width, height, origin);
+}
+
+static inline void copy_work_store_lane(
+    __global const work_store_block* from,
+    size_t from_lane,
+    __global work_store_block* to,
+    size_t to_lane) {
+  for (size_t element = 0; element < WORK_STORE_ELEMENTS; element++) {
+    to->value[element][to_lane] = from->value[element][from_lane];
+#if WORK_STORE_CYCLES
+    to->cycle[element][to_lane] = from->cycle[element][from_lane];
+#endif
+  }
+  to->i[to_lane] = from->i[from_lane];
+#if WORK_STORE_REFERENCE_INDICES
+  to->reference_index[to_lane] = from->reference_index[from_lane];
+#endif
+}
+
+// Lists the borders of the first rectangles, square tiles of tile pixels
+// sharing their edges. Launched over the whole output.
+__kernel void list_tile_borders(
+    unsigned int width,
+    unsigned int height,
+    unsigned int tile,
+    uint4 origin,
+    __global unsigned int *items,
+    __global unsigned int *count) {
+  size_t x = get_global_id(0);
+  size_t y = get_global_id(1);
+  if (x % tile != 0 && y % tile != 0 && x != width - 1 && y != height - 1) {
+    return;
+  }
+  items[atomic_inc(count)] = (unsigned int)stored_texel_index(stored_texel(x, y, width, height, origin), width);
+}
+
+// One work group per rectangle, whose border is done. Every rectangle is
+// filled with the colors of its corners, interpolated, so the escape fraction
+// runs smoothly across it. That is final if the border is uniform, and stands
+// in for the pixels still to compute otherwise. Those are listed in items, the
+// quarters in next_rects.
+#define create_subdivision_kernel(number_system, number_system_type) \
+__kernel void subdivide_rects_##number_system( \
+    __write_only image3d_t output, \
+    __global work_store_buffer *buffer, \
+    uint4 origin, \
+    unsigned int total_iterations, \
+    __global const uint4 *rects, \
+    __global uint4 *next_rects, \
+    __global unsigned int *next_rect_count, \
+    __global unsigned int *items, \
+    __global unsigned int *item_count) { \
+  __local int border_uniform; \
+  __local float4 corner_colors[4]; \
+  size_t width = get_image_width(output); \
+  size_t height = get_image_height(output); \
+  uint4 rect = rects[get_group_id(0)]; \
+  size_t w = rect.z - rect.x; \
+  size_t h = rect.w - rect.y; \
+  if (w < 2 || h < 2) { \
+    return; \
+  } \
+  size_t corner_index = stored_texel_index(stored_texel(rect.x, rect.y, width, height, origin), width); \
+  __global work_store_block* corner = get_work_store_block(buffer, corner_index); \
+  size_t corner_lane = corner_index % WORK_STORE_BLOCK_SIZE; \
+  unsigned int i = corner->i[corner_lane]; \
+  if (get_local_id(0) == 0) { \
+    border_uniform = 1; \
+  } \
+  if (get_local_id(0) < 4) { \
+    size_t index = stored_texel_index(stored_texel( \
+        (get_local_id(0) & 1) ? rect.z : rect.x, \
+        (get_local_id(0) & 2) ? rect.w : rect.y, \
+        width, height, origin), width); \
+    __global work_store_block* block = get_work_store_block(buffer, index); \
+    size_t lane = index % WORK_STORE_BLOCK_SIZE; \
+    real raw[MAX_NUMBER_SYSTEM_SIZE]; \
+    load_work_store_planes(block->value, lane, raw, number_system##_element_count()); \
+    number_system_type z = number_system##_from_raw(raw, 0); \
+    corner_colors[get_local_id(0)] = fractional_escape_color( \
+        modulus_sq_##number_system(z), \
+        total_iterations, \
+        modulus_sq_##number_system(z) < ESCAPE_VALUE ? total_iterations : block->i[lane]); \
+  } \
+  barrier(CLK_LOCAL_MEM_FENCE); \
+  for (size_t k = get_local_id(0); k < 2 * (w + h); k += get_local_size(0)) { \
+    size_t index = stored_texel_index(rect_border_texel(rect, k, width, height, origin), width); \
+    if (get_work_store_block(buffer, index)->i[index % WORK_STORE_BLOCK_SIZE] != i) { \
+      atomic_and(&border_uniform, 0); \
+    } \
+  } \
+  barrier(CLK_LOCAL_MEM_FENCE); \
+  bool fill = border_uniform != 0; \
+  bool split = !fill && w > SUBDIVISION_MIN_INTERIOR && h > SUBDIVISION_MIN_INTERIOR; \
+  size_t mx = rect.x + w / 2; \
+  size_t my = rect.y + h / 2; \
+  for (size_t k = get_local_id(0); k < (w - 1) * (h - 1); k += get_local_size(0)) { \
+    size_t x = rect.x + 1 + k % (w - 1); \
+    size_t y = rect.y + 1 + k / (w - 1); \
+    int4 texel = stored_texel(x, y, width, height, origin); \
+    size_t index = stored_texel_index(texel, width); \
+    float fx = (float)(x - rect.x) / (float)w; \
+    float fy = (float)(y - rect.y) / (float)h; \
+    write_imagef( \
+        output, \
+        texel, \
+        mix(mix(corner_colors[0], corner_colors[1], fx), mix(corner_colors[2], corner_colors[3], fx), fy)); \
+    if (fill) { \
+      /* Later frames and pans find the pixel done. */ \
+      copy_work_store_lane(corner, corner_lane, get_work_store_block(buffer, index), index % WORK_STORE_BLOCK_SIZE); \
+    } else if (!split || x == mx || y == my) { \
+      items[atomic_inc(item_count)] = (unsigned int)index; \
+    } \
+  } \
+  if (split && get_local_id(0) == 0) { \
+    unsigned int first = atomic_add(next_rect_count, 4u); \
+    next_rects[first] = (uint4)(rect.x, rect.y, mx, my); \
+    next_rects[first + 1] = (uint4)(mx, rect.y, rect.z, my); \
+    next_rects[first + 2] = (uint4)(rect.x, my, mx, rect.w); \
+    next_rects[first + 3] = (uint4)(mx, my, rect.z, rect.w); \
+  } \
+}
+
+// One work group per brick of a paged work store, once the coarsest level is
+// done. A brick whose corners took one iteration count gets no page, and is
+// filled with the colors of its corners, interpolated. The others get a page
+// while any are left, so the finer levels compute them, or are filled too
+// until regrant_pages hands them one. The corners past the last brick corner
+// along an axis fall back to it.
+#define create_brick_classification_kernel(number_system, number_system_type) \
+__kernel void classify_bricks_##number_system( \
+    __write_only image3d_t output, \
+    __global work_store_buffer *buffer, \
+    __global unsigned int *pages, \
+    unsigned int total_iterations) { \
+  __local unsigned int corner_iterations[8]; \
+  __local float4 corner_colors[8]; \
+  __local int brick_filled; \
+  work_dimensions dimensions = {get_image_width(output), get_image_height(output), get_image_depth(output)}; \
+  size_t bricks_x = (dimensions.width + WORK_STORE_PAGE_SIDE - 1) / WORK_STORE_PAGE_SIDE; \
+  size_t bricks_y = (dimensions.height + WORK_STORE_PAGE_SIDE - 1) / WORK_STORE_PAGE_SIDE; \
+  size_t brick = get_group_id(0); \
+  work_item_location first = { \
+    (brick % bricks_x) * WORK_STORE_PAGE_SIDE, \
+    ((brick / bricks_x) % bricks_y) * WORK_STORE_PAGE_SIDE, \
+    (brick / (bricks_x * bricks_y)) * WORK_STORE_PAGE_SIDE \
+  }; \
+  work_item_location last = { \
+    min(first.x + WORK_STORE_PAGE_SIDE, (dimensions.width - 1) / WORK_STORE_PAGE_SIDE * WORK_STORE_PAGE_SIDE), \
+    min(first.y + WORK_STORE_PAGE_SIDE, (dimensions.height - 1) / WORK_STORE_PAGE_SIDE * WORK_STORE_PAGE_SIDE), \
+    min(first.z + WORK_STORE_PAGE_SIDE, (dimensions.depth - 1) / WORK_STORE_PAGE_SIDE * WORK_STORE_PAGE_SIDE) \
+  }; \
+  if (get_local_id(0) < 8) { \
+    size_t corner = get_local_id(0); \
+    work_item_location location = { \
+      (corner & 1) ? last.x : first.x, \
+      (corner & 2) ? last.y : first.y, \
+      (corner & 4) ? last.z : first.z \
+    }; \
+    size_t index = brick_index(location, dimensions); \
+    __global work_store_block* block = get_work_store_block(buffer, index); \
+    size_t lane = index % WORK_STORE_BLOCK_SIZE; \
+    real raw[MAX_NUMBER_SYSTEM_SIZE]; \
+    load_work_store_planes(block->value, lane, raw, number_system##_element_count()); \
+    number_system_type z = number_system##_from_raw(raw, 0); \
+    unsigned int i = block->i[lane]; \
+    corner_iterations[corner] = i; \
+    corner_colors[corner] = fractional_escape_color( \
+        modulus_sq_##number_system(z), \
+        total_iterations, \
+        modulus_sq_##number_system(z) < ESCAPE_VALUE ? total_iterations : i); \
+  } \
+  barrier(CLK_LOCAL_MEM_FENCE); \
+  if (get_local_id(0) == 0) { \
+    bool uniform = corner_iterations[0] != WORK_ITEM_NOT_STARTED; \
+    for (size_t corner = 1; corner < 8; corner++) { \
+      uniform = uniform && corner_iterations[corner] == corner_iterations[0]; \
+    } \
+    brick_filled = 1; \
+    if (!uniform) { \
+      /* Once the pages run out, the rest of the boundary waits coarse. */ \
+      unsigned int page = atomic_inc(&pages[PAGE_TABLE_USED]); \
+      if (page < pages[PAGE_TABLE_CAPACITY]) { \
+        pages[PAGE_TABLE_HEADER + brick] = page; \
+        brick_filled = 0; \
+      } else { \
+        pages[PAGE_TABLE_HEADER + brick] = WORK_STORE_STARVED; \
+      } \
+    } \
+  } \
+  barrier(CLK_LOCAL_MEM_FENCE); \
+  if (!brick_filled) { \
+    return; \
+  } \
+  for (size_t k = get_local_id(0) + 1; k < WORK_STORE_PAGE_VOXELS; k += get_local_size(0)) { \
+    size_t x = first.x + k % WORK_STORE_PAGE_SIDE; \
+    size_t y = first.y + (k / WORK_STORE_PAGE_SIDE) % WORK_STORE_PAGE_SIDE; \
+    size_t z = first.z + k / (WORK_STORE_PAGE_SIDE * WORK_STORE_PAGE_SIDE); \
+    if (x >= dimensions.width || y >= dimensions.height || z >= dimensions.depth) { \
+      continue; \
+    } \
+    float fx = min((float)(x - first.x) / (float)max(last.x - first.x, (size_t)1), 1.0f); \
+    float fy = min((float)(y - first.y) / (float)max(last.y - first.y, (size_t)1), 1.0f); \
+    float fz = min((float)(z - first.z) / (float)max(last.z - first.z, (size_t)1), 1.0f); \
+    float4 front = mix( \
+        mix(corner_colors[0], corner_colors[1], fx), \
+        mix(corner_colors[2], corner_colors[3], fx), \
+        fy); \
+    float4 back = mix( \
+        mix(corner_colors[4], corner_colors[5], fx), \
+        mix(corner_colors[6], corner_colors[7], fx), \
+        fy); \
+    write_imagef(output, (int4)((int)x, (int)y, (int)z, 0), mix(front, back, fz)); \
+  } \
+}
+#else
+#define create_subdivision_kernel(number_system, number_system_type)
+#define create_brick_classification_kernel(number_system, number_system_type)
+#endif
+
 static inline void apply_view_mapping_element(real* raw, real zoom, char view_mapping, int location, int range) {
   raw[abs(view_mapping)] = ((((real)location) / ((real)range)) * 2.0 - 1.0) / copysign(zoom, (real)(view_mapping));
 }
@@ -179,23 +898,245 @@ static inline int reverse_view_mapping_element(real* raw, real zoom, char view_m
 }
 
 #define create_view_mapping_functions(number_system, number_system_type) \
-static inline number_system_type apply_view_mapping_##number_system(viewspace view, work_item item) { \
+static inline number_system_type view_offset_##number_system(viewspace view, work_item item) { \
   real raw[MAX_NUMBER_SYSTEM_SIZE + 1] = {0.0}; \
   apply_view_mapping_element(raw, view.zoom, view.mapping.x, item.location.x, item.dimensions.width); \
   apply_view_mapping_element(raw, view.zoom, view.mapping.y, item.location.y, item.dimensions.height); \
   apply_view_mapping_element(raw, view.zoom, view.mapping.z, item.location.z, item.dimensions.depth); \
-  return add_##number_system(number_system##_from_raw(raw, 1), number_system##_from_raw(view.center.raw, 0)); \
+  return number_system##_from_raw(raw, 1); \
+} \
+static inline number_system_type apply_view_mapping_##number_system(viewspace view, work_item item) { \
+  return add_##number_system(view_offset_##number_system(view, item), number_system##_from_raw(view.center.raw, 0)); \
 } \
 static inline int4 reverse_view_mapping_##number_system(viewspace view, work_item item, number_system_type point) { \
   real raw[MAX_NUMBER_SYSTEM_SIZE + 1] = {0.0}; \
   number_system##_to_raw(sub_##number_system(point, number_system##_from_raw(view.center.raw, 0)), raw, 1); \
-  return (int4)( \
+  return make_int4( \
     reverse_view_mapping_element(raw, view.zoom, view.mapping.x, item.dimensions.width), \
     reverse_view_mapping_element(raw, view.zoom, view.mapping.y, item.dimensions.height), \
     reverse_view_mapping_element(raw, view.zoom, view.mapping.z, item.dimensions.depth), \
     0); \
 }
 
+#if _ON_GPU_
+// Distance estimation. The orbit is iterated along with its derivative by the
+// starting point (dynamical space) or by c (phase space): KERNEL_FUNCTION
+// runs on dual numbers, pairs of a number and its derivative, whose mul and
+// sqr follow the product rule. Once the orbit escapes, |z| log|z| / 2|dz|
+// estimates the distance to the set, and nothing of the set is closer than
+// a fraction of it. The estimate is only good far out, so orbits escape much
+// later than ESCAPE_VALUE.
+#define DISTANCE_ESCAPE_VALUE 1e8
+// Rays that neither hit the set nor leave the volume within this many steps
+// are taken to miss.
+#define DISTANCE_MAX_STEPS 256
+
+// The light of Shaders/3d.frag.
+#define DISTANCE_AMBIENT 0.75f
+#define DISTANCE_DIFFUSE 0.5f
+#define DISTANCE_SHININESS 10.0f
+
+static inline float4 trace_camera_column(trace_camera camera, size_t column) {
+  return (float4)(
+    camera.inverse_view_projection[column * 4],
+    camera.inverse_view_projection[column * 4 + 1],
+    camera.inverse_view_projection[column * 4 + 2],
+    camera.inverse_view_projection[column * 4 + 3]);
+}
+
+// The ray from the eye through the pixel's point on the far plane. Row 0 is
+// the bottom of the screen, as the 2D shader samples it.
+static inline float3 trace_camera_ray(trace_camera camera, size_t x, size_t y, size_t width, size_t height) {
+  float ndc_x = ((float)x + 0.5f) / (float)width * 2.0f - 1.0f;
+  float ndc_y = ((float)y + 0.5f) / (float)height * 2.0f - 1.0f;
+  float4 far_point = trace_camera_column(camera, 0) * ndc_x
+    + trace_camera_column(camera, 1) * ndc_y
+    + trace_camera_column(camera, 2)
+    + trace_camera_column(camera, 3);
+  float3 eye = (float3)(camera.eye[0], camera.eye[1], camera.eye[2]);
+  return normalize(far_point.xyz / far_point.w - eye);
+}
+
+// Writes the color of a pixel over the block of pixels it stands for, cut at
+// the edges of the output.
+static inline void write_distance_block(
+    __write_only image3d_t output,
+    size_t x,
+    size_t y,
+    unsigned int block,
+    size_t width,
+    size_t height,
+    float4 color) {
+  for (size_t dy = 0; dy < block && y + dy < height; dy++) {
+    for (size_t dx = 0; dx < block && x + dx < width; dx++) {
+      write_imagef(output, (int4)((int)(x + dx), (int)(y + dy), 0, 0), color);
+    }
+  }
+}
+
+#define create_distance_estimate(space, c_value, z0_value, function, number_system, number_system_type) \
+static inline real space##_distance_estimate_##number_system( \
+    number_system_type point, \
+    number_system_type parameter, \
+    unsigned int max_iterations, \
+    unsigned int* iterations) { \
+  real raw[MAX_NUMBER_SYSTEM_SIZE] = {1.0}; \
+  number_system_type one = number_system##_from_raw(raw, 0); \
+  dual_##number_system c = c_value; \
+  dual_##number_system z = z0_value; \
+  unsigned int i = 0; \
+  for (; i < max_iterations && modulus_sq_##number_system(z.v) < DISTANCE_ESCAPE_VALUE; i++) { \
+    function; \
+  } \
+  *iterations = i; \
+  if (modulus_sq_##number_system(z.v) < DISTANCE_ESCAPE_VALUE) { \
+    return 0.0; \
+  } \
+  real modulus = sqrt(modulus_sq_##number_system(z.v)); \
+  return 0.5 * modulus * log(modulus) / sqrt(modulus_sq_##number_system(z.d)); \
+}
+
+// Slices color each pixel by its iteration count, darkened within a pixel of
+// the set, so the boundary stays visible however thin it gets. Traced views
+// march camera rays through the volume of the 3D views, by the distance
+// estimate, until they are closer to the set than a pixel. The hit is lit by
+// the gradient of the estimate. With a block above 1 only every block-th
+// pixel along each axis is computed, and written over the whole block.
+#define create_distance_kernel(space, number_system, number_system_type) \
+__kernel void space##_distance_##number_system( \
+    __write_only image3d_t output, \
+    viewspace view, \
+    number parameter, \
+    unsigned int max_iterations, \
+    trace_camera camera, \
+    unsigned int block) { \
+  size_t width = get_image_width(output); \
+  size_t height = get_image_height(output); \
+  size_t x = get_global_id(0) * block; \
+  size_t y = get_global_id(1) * block; \
+  number_system_type c = number_system##_from_raw(parameter.raw, 0); \
+  unsigned int i; \
+  float4 color = (float4)(0.0f); \
+  if (!camera.traced) { \
+    work_item item = {.location = {x, y, 0}, .dimensions = {width, height, 1}}; \
+    real distance = space##_distance_estimate_##number_system( \
+        apply_view_mapping_##number_system(view, item), c, max_iterations, &i); \
+    real pixel = 2.0 / (view.zoom * (real)width); \
+    float shade = (float)clamp(distance / pixel, (real)0.0, (real)1.0); \
+    color = distance > 0.0 ? spectral_color((float)i / (float)max_iterations) * shade : (float4)(0.0f); \
+    color.w = 1.0f; \
+    write_distance_block(output, x, y, block, width, height, color); \
+    return; \
+  } \
+  float3 eye = (float3)(camera.eye[0], camera.eye[1], camera.eye[2]); \
+  float3 direction = trace_camera_ray(camera, x, y, width, height); \
+  /* Only the volume of the 3D views is traced, [-0.5, 0.5] along each axis. */ \
+  float3 near_planes = (-0.5f - eye) / direction; \
+  float3 far_planes = (0.5f - eye) / direction; \
+  float3 entries = fmin(near_planes, far_planes); \
+  float3 exits = fmax(near_planes, far_planes); \
+  float t = max(max(max(entries.x, entries.y), entries.z), 0.0f); \
+  float end = min(min(exits.x, exits.y), exits.z); \
+  /* Distances in the number system are 2 / zoom per unit of the volume. */ \
+  real scale = view.zoom / 2.0; \
+  bool hit = false; \
+  for (size_t step = 0; step < DISTANCE_MAX_STEPS && t < end; step++) { \
+    float3 position = eye + direction * t; \
+    float distance = (float)(scale * space##_distance_estimate_##number_system( \
+        volume_to_number_##number_system(view, position), c, max_iterations, &i)); \
+    float epsilon = camera.pixel_size * t; \
+    if (distance < epsilon) { \
+      hit = true; \
+      break; \
+    } \
+    t += distance; \
+  } \
+  if (hit) { \
+    float3 position = eye + direction * t; \
+    float h = max(camera.pixel_size * t, 1e-6f); \
+    unsigned int unused; \
+    float3 normal = (float3)( \
+      (float)(space##_distance_estimate_##number_system(volume_to_number_##number_system(view, position + (float3)(h, 0.0f, 0.0f)), c, max_iterations, &unused) \
+        - space##_distance_estimate_##number_system(volume_to_number_##number_system(view, position - (float3)(h, 0.0f, 0.0f)), c, max_iterations, &unused)), \
+      (float)(space##_distance_estimate_##number_system(volume_to_number_##number_system(view, position + (float3)(0.0f, h, 0.0f)), c, max_iterations, &unused) \
+        - space##_distance_estimate_##number_system(volume_to_number_##number_system(view, position - (float3)(0.0f, h, 0.0f)), c, max_iterations, &unused)), \
+      (float)(space##_distance_estimate_##number_system(volume_to_number_##number_system(view, position + (float3)(0.0f, 0.0f, h)), c, max_iterations, &unused) \
+        - space##_distance_estimate_##number_system(volume_to_number_##number_system(view, position - (float3)(0.0f, 0.0f, h)), c, max_iterations, &unused))); \
+    /* Inside the set the estimate is flat, face the camera. */ \
+    normal = length(normal) > 0.0f ? normalize(normal) : -direction; \
+    float3 light = (float3)(camera.light[0], camera.light[1], camera.light[2]); \
+    float cos_theta = max(dot(normal, light), 0.0f); \
+    float4 base = spectral_color((float)i / (float)max_iterations); \
+    color.xyz = base.xyz * (DISTANCE_AMBIENT + DISTANCE_DIFFUSE * cos_theta) \
+      + (float3)(pow(cos_theta, DISTANCE_SHININESS)); \
+    color.w = 1.0f; \
+  } \
+  write_distance_block(output, x, y, block, width, height, color); \
+}
+
+#define create_distance_kernels(function, number_system, number_system_type) \
+typedef struct dual_##number_system { \
+  number_system_type v; \
+  number_system_type d; \
+} dual_##number_system; \
+static inline dual_##number_system dual_add_##number_system(dual_##number_system x, dual_##number_system y) { \
+  return (dual_##number_system) {add_##number_system(x.v, y.v), add_##number_system(x.d, y.d)}; \
+} \
+static inline dual_##number_system dual_sub_##number_system(dual_##number_system x, dual_##number_system y) { \
+  return (dual_##number_system) {sub_##number_system(x.v, y.v), sub_##number_system(x.d, y.d)}; \
+} \
+static inline dual_##number_system dual_conj_##number_system(dual_##number_system x) { \
+  return (dual_##number_system) {conj_##number_system(x.v), conj_##number_system(x.d)}; \
+} \
+static inline dual_##number_system dual_mul_##number_system(dual_##number_system x, dual_##number_system y) { \
+  return (dual_##number_system) { \
+    mul_##number_system(x.v, y.v), \
+    add_##number_system(mul_##number_system(x.d, y.v), mul_##number_system(x.v, y.d))}; \
+} \
+static inline dual_##number_system dual_sqr_##number_system(dual_##number_system x) { \
+  return (dual_##number_system) { \
+    sqr_##number_system(x.v), \
+    add_##number_system(mul_##number_system(x.d, x.v), mul_##number_system(x.v, x.d))}; \
+} \
+static inline dual_##number_system dual_scale_##number_system(dual_##number_system x, real s) { \
+  return (dual_##number_system) {scale_##number_system(x.v, s), scale_##number_system(x.d, s)}; \
+} \
+static inline real dual_modulus_sq_##number_system(dual_##number_system x) { \
+  return modulus_sq_##number_system(x.v); \
+} \
+static inline number_system_type volume_to_number_##number_system(viewspace view, float3 position) { \
+  real raw[MAX_NUMBER_SYSTEM_SIZE + 1] = {0.0}; \
+  raw[abs(view.mapping.x)] = 2.0 * (real)position.x / copysign(view.zoom, (real)view.mapping.x); \
+  raw[abs(view.mapping.y)] = 2.0 * (real)position.y / copysign(view.zoom, (real)view.mapping.y); \
+  raw[abs(view.mapping.z)] = 2.0 * (real)position.z / copysign(view.zoom, (real)view.mapping.z); \
+  return add_##number_system(number_system##_from_raw(raw, 1), number_system##_from_raw(view.center.raw, 0)); \
+} \
+create_distance_estimate( \
+    phase, \
+    ((dual_##number_system) {point, one}), \
+    ((dual_##number_system) {zero_##number_system(), zero_##number_system()}), \
+    function, \
+    number_system, \
+    number_system_type) \
+create_distance_estimate( \
+    dynamical, \
+    ((dual_##number_system) {parameter, zero_##number_system()}), \
+    ((dual_##number_system) {point, one}), \
+    function, \
+    number_system, \
+    number_system_type) \
+create_distance_kernel(phase, number_system, number_system_type) \
+create_distance_kernel(dynamical, number_system, number_system_type)
+#else
+#define create_distance_kernels(function, number_system, number_system_type)
+#endif
+
+#if !defined(KERNEL_NUMBER_SYSTEMS)
+// Generate kernels for every number system. A program can limit them to the
+// ones it is built for, NUMBER_SYSTEMS then only supplies the arithmetic.
+#define KERNEL_NUMBER_SYSTEMS NUMBER_SYSTEMS
+#endif
+
 #define create_kernels(function, escape, number_system, number_system_type) \
 create_phase_kernels(function, escape, number_system, number_system_type) \
 create_dynamical_kernels(function, escape, number_system, number_system_type)
@@ -213,17 +1154,49 @@ create_dynamical_kernels(function, escape, number_system, number_system_type)
       modulus_sq_##number_system), \
     ESCAPE_VALUE, \
     number_system, \
+    number_system##_impl) \
+  create_perturbed_kernels( \
+    PERTURBATION_FUNCTION( \
+      add_##number_system, \
+      sub_##number_system, \
+      conj_##number_system, \
+      mul_##number_system, \
+      sqr_##number_system, \
+      scale_##number_system, \
+      modulus_sq_##number_system), \
+    ESCAPE_VALUE, \
+    number_system, \
+    number_system##_impl) \
+  create_subdivision_kernel(number_system, number_system##_impl) \
+  create_brick_classification_kernel(number_system, number_system##_impl) \
+  create_distance_kernels( \
+    KERNEL_FUNCTION( \
+      dual_add_##number_system, \
+      dual_sub_##number_system, \
+      dual_conj_##number_system, \
+      dual_mul_##number_system, \
+      dual_sqr_##number_system, \
+      dual_scale_##number_system, \
+      dual_modulus_sq_##number_system), \
+    number_system, \
     number_system##_impl)
-NUMBER_SYSTEMS;
+KERNEL_NUMBER_SYSTEMS;
 #undef X
 
 #undef create_kernels
+#undef create_perturbed_kernels
+#undef create_subdivision_kernel
+#undef create_brick_classification_kernel
+#undef create_distance_kernels
+#undef create_distance_kernel
+#undef create_distance_estimate
 #undef create_view_mapping_functions
 #undef create_dynamical_kernels
 #undef create_phase_kernels
 #undef create_escape_and_translated_kernels
 #undef write_translated_point
 #undef write_fractional_escape
+#undef create_perturbed_kernel
 #undef create_kernel
 
 _EXTERN_C_END_
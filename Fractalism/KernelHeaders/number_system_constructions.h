@@ -0,0 +1,26 @@
+#ifndef _FRACTALISM_NUMBER_SYSTEM_CONSTRUCTIONS_H_
+#define _FRACTALISM_NUMBER_SYSTEM_CONSTRUCTIONS_H_
+
+// Each construction expands to an X() entry for NUMBER_SYSTEMS, so the same
+// definitions can be used by the OpenCL program and by the host kernels.
+// The element system's operations are found by token-pasting its name, which
+// is why real must stay a typedef (see interop.h).
+
+// Not actually accurate for conj. There are n unique, valid conjugates for Cn.
+#define multicomplex_construction(number_system, element_system) X( \
+  /* number_system  */ number_system, \
+  /* element_system */ element_system, \
+  /* conj           */ (a, b), \
+  /* mul            */ (sub_##element_system(mul_##element_system(a, c), mul_##element_system(d, b)), add_##element_system(mul_##element_system(d, a), mul_##element_system(b, c))), \
+  /* sqr            */ (sub_##element_system(sqr_##element_system(a), sqr_##element_system(b)), scale_##element_system(mul_##element_system(a, b), 2.0)), \
+  /* modulus_sq     */ (modulus_sq_##element_system(a) + modulus_sq_##element_system(b)))
+
+#define cayley_dickson_construction(number_system, element_system) X( \
+  /* number_system  */ number_system, \
+  /* element_system */ element_system, \
+  /* conj           */ (conj_##element_system(a), neg_##element_system(b)), \
+  /* mul            */ (sub_##element_system(mul_##element_system(a, c), mul_##element_system(conj_##element_system(d), b)), add_##element_system(mul_##element_system(d, a), mul_##element_system(b, conj_##element_system(c)))), \
+  /* sqr            */ (sub_##element_system(sqr_##element_system(a), mul_##element_system(conj_##element_system(b), b)), add_##element_system(mul_##element_system(b, a), mul_##element_system(b, conj_##element_system(a)))), \
+  /* modulus_sq     */ (modulus_sq_##element_system(a) + modulus_sq_##element_system(b)))
+
+#endif // !_NUMBER_SYSTEM_CONSTRUCTIONS_H_
@@ -8,6 +8,8 @@
 #include "interop.h"
 #endif
 
+#include "number_system_constructions.h"
+
 _EXTERN_C_DECL_
 
 #define create_number_system_functions( \
@@ -1,6 +1,13 @@
 #ifndef _FRACTALISM_SPECTRAL_COLOR_H_
 #define _FRACTALISM_SPECTRAL_COLOR_H_
 
+#if defined(_MSC_VER)
+// Intellisense gets confused if we use the other (relative) #include format.
+#include <Fractalism/KernelHeaders/interop.h>
+#else
+#include "interop.h"
+#endif
+
 typedef struct range {
   float low;
   float high;
@@ -72,7 +79,7 @@ static float4 spectral_color(float value) {
   float value_sqr = value * value;
 
   // Use alpha to store the normalized value, squared for increased transparency.
-  return (float4)(
+  return make_float4(
     (r[0] * value_sqr) + (r[1] * value) + r[2],
     (g[0] * value_sqr) + (g[1] * value) + g[2],
     (b[0] * value_sqr) + (b[1] * value) + b[2],
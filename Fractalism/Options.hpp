@@ -20,8 +20,9 @@ enum class Dimensions : unsigned char {
  * @brief Represents the render modes.
  */
 enum class RenderMode : unsigned char {
-  escape,    ///< Escape time render mode.
-  translated ///< Translated render mode.
+  escape,     ///< Escape time render mode.
+  translated, ///< Translated render mode.
+  distance    ///< Distance estimated render mode, ray marched in 3D.
 };
 
 /**
@@ -35,6 +36,8 @@ inline constexpr const std::string name(const RenderMode renderMode) {
     return "escape";
   case RenderMode::translated:
     return "translated";
+  case RenderMode::distance:
+    return "distance";
   default:
     throw AssertionError("invalid render mode");
   }
@@ -111,16 +114,47 @@ inline constexpr size_t elementCount(const NumberSystem numberSystem) {
   }
 }
 
+/**
+ * @enum Precision
+ * @brief Represents the floating point precision of the device kernels.
+ */
+enum class Precision : unsigned char {
+  fp32, ///< Single precision.
+  fp64  ///< Double precision.
+};
+
+/**
+ * @brief Gets the name of the precision.
+ * @param precision The precision.
+ * @return The name of the precision as a string.
+ */
+inline constexpr const std::string name(const Precision precision) {
+  switch (precision) {
+  case Precision::fp32:
+    return "float";
+  case Precision::fp64:
+    return "double";
+  default:
+    throw AssertionError("invalid precision");
+  }
+}
+
 /**
  * @brief Constructs the kernel name based on space, render mode, and number
  * system.
  * @param space The space setting.
  * @param renderMode The render mode setting.
  * @param numberSystem The number system setting.
+ * @param perturbed Whether to iterate relative to a reference orbit. Only
+ * escape mode has perturbed kernels.
  * @return The kernel name as a string.
  */
-inline constexpr std::string kernelName(Space space, RenderMode renderMode, NumberSystem numberSystem) {
-  return options::name(space) + "_" + options::name(renderMode) + "_" + options::name(numberSystem);
+inline constexpr std::string kernelName(
+    Space space,
+    RenderMode renderMode,
+    NumberSystem numberSystem,
+    bool perturbed = false) {
+  return options::name(space) + "_" + options::name(renderMode) + (perturbed ? "_perturbed_" : "_") + options::name(numberSystem);
 }
 } // namespace fractalism::options
 
@@ -0,0 +1,237 @@
+#include <Fractalism/Perturbation/BigReal.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <format>
+#include <string>
+
+#include <Fractalism/Exceptions.hpp>
+
+namespace fractalism::perturbation {
+  BigReal::BigReal() : negative(false), limbs(1, 0) {}
+
+  BigReal::BigReal(real value, size_t fractionLimbs) : negative(std::signbit(value)), limbs(fractionLimbs + 1, 0) {
+    if (!std::isfinite(value) || std::abs(value) >= std::ldexp(real(1.0), limbBits)) {
+      throw AssertionError(std::format("{} does not fit in a BigReal", value));
+    }
+    // Every step is exact, multiplying by a power of two and taking away the
+    // integer part never rounds.
+    real remaining = std::abs(value);
+    for (size_t limb = limbs.size(); limb-- > 0;) {
+      real whole = std::floor(remaining);
+      limbs[limb] = static_cast<Limb>(whole);
+      remaining = std::ldexp(remaining - whole, limbBits);
+    }
+    if (isZero()) {
+      negative = false;
+    }
+  }
+
+  BigReal BigReal::parse(std::string_view text, size_t fractionLimbs) {
+    const auto fail = [&text]() {
+      return ParseError(std::format("'{}' is not a decimal number", text));
+    };
+
+    size_t position = 0;
+    bool negative = false;
+    if (position < text.size() && (text[position] == '-' || text[position] == '+')) {
+      negative = text[position++] == '-';
+    }
+    std::string digits;
+    long long point = -1;
+    for (; position < text.size(); position++) {
+      char character = text[position];
+      if (std::isdigit(static_cast<unsigned char>(character))) {
+        digits.push_back(character);
+      } else if (character == '.' && point < 0) {
+        point = static_cast<long long>(digits.size());
+      } else {
+        break;
+      }
+    }
+    if (digits.empty()) {
+      throw fail();
+    }
+    if (point < 0) {
+      point = static_cast<long long>(digits.size());
+    }
+    if (position < text.size() && (text[position] == 'e' || text[position] == 'E')) {
+      std::string exponent(text.substr(position + 1));
+      size_t used = 0;
+      try {
+        point += std::stoll(exponent, &used);
+      } catch (const std::exception&) {
+        throw fail();
+      }
+      if (used != exponent.size()) {
+        throw fail();
+      }
+    } else if (position != text.size()) {
+      throw fail();
+    }
+
+    // The digits before the (shifted) decimal point are the integer part.
+    unsigned long long whole = 0;
+    for (long long digit = 0; digit < std::min(point, static_cast<long long>(digits.size())); digit++) {
+      whole = whole * 10 + static_cast<unsigned long long>(digits[digit] - '0');
+      if (whole > UINT32_MAX) {
+        throw ParseError(std::format("'{}' is too large", text));
+      }
+    }
+    for (long long zero = static_cast<long long>(digits.size()); zero < point; zero++) {
+      whole *= 10;
+      if (whole > UINT32_MAX) {
+        throw ParseError(std::format("'{}' is too large", text));
+      }
+    }
+
+    // The fraction is accumulated from its last digit, x = (x + digit) / 10,
+    // with a guard limb against the truncation of every division.
+    BigReal result(0.0, fractionLimbs + 1);
+    for (long long digit = static_cast<long long>(digits.size()); digit-- > std::max(point, 0LL);) {
+      result.limbs.back() = static_cast<Limb>(digits[digit] - '0');
+      result.divideMagnitude(10);
+    }
+    for (long long zero = point; zero < 0; zero++) {
+      result.divideMagnitude(10);
+    }
+    result.limbs.back() = static_cast<Limb>(whole);
+    result = result.withPrecision(fractionLimbs);
+    result.negative = negative && !result.isZero();
+    return result;
+  }
+
+  BigReal BigReal::withPrecision(size_t fractionLimbs) const {
+    BigReal result;
+    result.negative = negative;
+    result.limbs.assign(fractionLimbs + 1, 0);
+    // Align the integer limbs, dropping or padding the least significant end.
+    const size_t shared = std::min(limbs.size(), result.limbs.size());
+    std::copy(limbs.end() - shared, limbs.end(), result.limbs.end() - shared);
+    if (result.isZero()) {
+      result.negative = false;
+    }
+    return result;
+  }
+
+  real BigReal::toReal() const {
+    real result = 0.0;
+    const long long integerLimb = static_cast<long long>(precision());
+    for (size_t limb = limbs.size(); limb-- > 0;) {
+      if (limbs[limb]) {
+        result += std::ldexp(static_cast<real>(limbs[limb]), static_cast<int>((static_cast<long long>(limb) - integerLimb) * limbBits));
+      }
+    }
+    return negative ? -result : result;
+  }
+
+  bool BigReal::isZero() const {
+    return std::all_of(limbs.begin(), limbs.end(), [](Limb limb) { return limb == 0; });
+  }
+
+  BigReal BigReal::operator-() const {
+    BigReal result = *this;
+    result.negative = !negative && !isZero();
+    return result;
+  }
+
+  BigReal BigReal::operator+(const BigReal& other) const {
+    const size_t fractionLimbs = std::max(precision(), other.precision());
+    BigReal result = withPrecision(fractionLimbs);
+    const BigReal addend = other.withPrecision(fractionLimbs);
+    if (result.negative == addend.negative) {
+      result.addMagnitude(addend);
+    } else if (compareMagnitude(result, addend) >= 0) {
+      result.subtractMagnitude(addend);
+    } else {
+      BigReal larger = addend;
+      larger.subtractMagnitude(result);
+      result = larger;
+    }
+    if (result.isZero()) {
+      result.negative = false;
+    }
+    return result;
+  }
+
+  BigReal BigReal::operator-(const BigReal& other) const {
+    return *this + -other;
+  }
+
+  BigReal BigReal::operator*(const BigReal& other) const {
+    const size_t fractionLimbs = std::max(precision(), other.precision());
+    const BigReal a = withPrecision(fractionLimbs);
+    const BigReal b = other.withPrecision(fractionLimbs);
+    const size_t count = fractionLimbs + 1;
+
+    std::vector<Limb> product(2 * count, 0);
+    for (size_t i = 0; i < count; i++) {
+      if (!a.limbs[i]) {
+        continue;
+      }
+      std::uint64_t carry = 0;
+      for (size_t j = 0; j < count; j++) {
+        std::uint64_t sum = static_cast<std::uint64_t>(a.limbs[i]) * b.limbs[j] + product[i + j] + carry;
+        product[i + j] = static_cast<Limb>(sum);
+        carry = sum >> limbBits;
+      }
+      product[i + count] = static_cast<Limb>(carry);
+    }
+    // The product has twice the fractional limbs, drop the lower half.
+    if (product.back()) {
+      throw AssertionError("BigReal multiplication overflowed");
+    }
+    BigReal result;
+    result.limbs.assign(product.begin() + fractionLimbs, product.begin() + fractionLimbs + count);
+    result.negative = (a.negative != b.negative) && !result.isZero();
+    return result;
+  }
+
+  int BigReal::compareMagnitude(const BigReal& a, const BigReal& b) {
+    for (size_t limb = a.limbs.size(); limb-- > 0;) {
+      if (a.limbs[limb] != b.limbs[limb]) {
+        return a.limbs[limb] < b.limbs[limb] ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+
+  void BigReal::addMagnitude(const BigReal& other) {
+    std::uint64_t carry = 0;
+    for (size_t limb = 0; limb < limbs.size(); limb++) {
+      std::uint64_t sum = static_cast<std::uint64_t>(limbs[limb]) + other.limbs[limb] + carry;
+      limbs[limb] = static_cast<Limb>(sum);
+      carry = sum >> limbBits;
+    }
+    if (carry) {
+      throw AssertionError("BigReal addition overflowed");
+    }
+  }
+
+  void BigReal::subtractMagnitude(const BigReal& other) {
+    std::int64_t borrow = 0;
+    for (size_t limb = 0; limb < limbs.size(); limb++) {
+      std::int64_t difference = static_cast<std::int64_t>(limbs[limb]) - other.limbs[limb] - borrow;
+      borrow = difference < 0;
+      limbs[limb] = static_cast<Limb>(difference + (borrow << limbBits));
+    }
+  }
+
+  void BigReal::divideMagnitude(Limb divisor) {
+    std::uint64_t remainder = 0;
+    for (size_t limb = limbs.size(); limb-- > 0;) {
+      std::uint64_t current = (remainder << limbBits) | limbs[limb];
+      limbs[limb] = static_cast<Limb>(current / divisor);
+      remainder = current % divisor;
+    }
+  }
+
+  size_t precisionForZoom(real zoom) {
+    // A pixel is about 1/(zoom * resolution) wide. 64 guard bits cover the
+    // resolution and the error a long orbit accumulates.
+    constexpr real guardBits = 64.0;
+    real bits = std::max(real(0.0), std::log2(std::max(zoom, real(1.0)))) + guardBits;
+    return static_cast<size_t>(std::ceil(bits / real(BigReal::limbBits)));
+  }
+}
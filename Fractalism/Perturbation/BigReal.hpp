@@ -0,0 +1,131 @@
+#ifndef _FRACTALISM_BIG_REAL_HPP_
+#define _FRACTALISM_BIG_REAL_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include <Fractalism/KernelHeaders/interop.h>
+
+namespace fractalism::perturbation {
+
+/**
+ * @class BigReal
+ * @brief A signed fixed-point number with an arbitrary number of fractional
+ * bits, for the coordinates and reference orbits of deep zooms.
+ *
+ * The magnitude is stored as 32 bit limbs, least significant first. The last
+ * limb is the integer part, the ones before it the fraction. Operands of
+ * different precision are widened to the larger one, and products are
+ * truncated to it.
+ */
+class BigReal {
+public:
+  using Limb = std::uint32_t;
+  static constexpr size_t limbBits = 32; ///< Bits per limb.
+
+  /**
+   * @brief Constructs a zero without fractional limbs.
+   */
+  BigReal();
+
+  /**
+   * @brief Constructs a BigReal from a real, rounded towards zero to the
+   * given precision.
+   * @param value The value. Its integer part must fit in a limb.
+   * @param fractionLimbs The number of fractional limbs.
+   * @throws AssertionError if the value is not finite or too large.
+   */
+  BigReal(real value, size_t fractionLimbs);
+
+  /**
+   * @brief Parses a decimal number such as "-1.25" or "3.5e-20", with more
+   * digits than a real can hold.
+   * @param text The text to parse.
+   * @param fractionLimbs The number of fractional limbs.
+   * @return The parsed value, rounded towards zero.
+   * @throws ParseError if the text is not a decimal number, or its integer
+   * part does not fit in a limb.
+   */
+  static BigReal parse(std::string_view text, size_t fractionLimbs);
+
+  /**
+   * @brief Gets the number of fractional limbs.
+   * @return The precision, in limbs.
+   */
+  inline size_t precision() const { return limbs.size() - 1; }
+
+  /**
+   * @brief Converts to the given precision, truncating or zero extending the
+   * fraction.
+   * @param fractionLimbs The number of fractional limbs.
+   * @return The converted value.
+   */
+  BigReal withPrecision(size_t fractionLimbs) const;
+
+  /**
+   * @brief Converts to the nearest real.
+   * @return The value as a real.
+   */
+  real toReal() const;
+
+  /**
+   * @brief Checks if the value is zero.
+   * @return True if every limb is zero.
+   */
+  bool isZero() const;
+
+  BigReal operator-() const;
+  BigReal operator+(const BigReal& other) const;
+  BigReal operator-(const BigReal& other) const;
+  BigReal operator*(const BigReal& other) const;
+  inline BigReal& operator+=(const BigReal& other) { return *this = *this + other; }
+  inline BigReal& operator-=(const BigReal& other) { return *this = *this - other; }
+  bool operator==(const BigReal& other) const = default;
+
+private:
+  /**
+   * @brief Compares the magnitudes of two values of the same precision.
+   * @return Negative, zero or positive as |a| is less than, equal to or
+   * greater than |b|.
+   */
+  static int compareMagnitude(const BigReal& a, const BigReal& b);
+
+  /**
+   * @brief Adds the magnitude of other to this one, of the same precision.
+   */
+  void addMagnitude(const BigReal& other);
+
+  /**
+   * @brief Subtracts the smaller magnitude of other from this one, of the
+   * same precision.
+   */
+  void subtractMagnitude(const BigReal& other);
+
+  /**
+   * @brief Divides the magnitude by a small divisor, rounding towards zero.
+   */
+  void divideMagnitude(Limb divisor);
+
+  bool negative;           ///< The sign. Zero is never negative.
+  std::vector<Limb> limbs; ///< The magnitude, least significant limb first.
+};
+
+/**
+ * @brief The elements of a hypercomplex number in high precision, in the same
+ * order as gpu::types::Number.
+ */
+using BigNumber = std::array<BigReal, MAX_NUMBER_SYSTEM_SIZE>;
+
+/**
+ * @brief Gets the precision needed to address individual pixels at a zoom
+ * level, with enough guard bits to keep a long reference orbit accurate.
+ * @param zoom The zoom level.
+ * @return The number of fractional limbs.
+ */
+size_t precisionForZoom(real zoom);
+} // namespace fractalism::perturbation
+
+#endif
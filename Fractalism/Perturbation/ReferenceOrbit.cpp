@@ -0,0 +1,150 @@
+#include <Fractalism/Perturbation/ReferenceOrbit.hpp>
+
+#include <algorithm>
+#include <span>
+
+namespace fractalism::perturbation {
+  namespace {
+    enum class Construction {
+      cayleyDickson,
+      multicomplex
+    };
+
+    using Elements = std::vector<BigReal>;
+    using ElementSpan = std::span<const BigReal>;
+    using ConstructionSpan = std::span<const Construction>;
+
+    // Outermost construction first. These must match the program built by
+    // ProgramManager.
+    static ConstructionSpan constructions(options::NumberSystem numberSystem) {
+      static constexpr Construction complex[] = {Construction::cayleyDickson};
+      static constexpr Construction quaternion[] = {Construction::cayleyDickson, Construction::cayleyDickson};
+      static constexpr Construction bicomplex[] = {Construction::multicomplex, Construction::cayleyDickson};
+      switch (numberSystem) {
+      case options::NumberSystem::complex:
+        return complex;
+      case options::NumberSystem::quaternion:
+        return quaternion;
+      case options::NumberSystem::bicomplex:
+        return bicomplex;
+      default:
+        throw AssertionError("Invalid number system");
+      }
+    }
+
+    static Elements concat(Elements&& first, const Elements& second) {
+      first.insert(first.end(), second.begin(), second.end());
+      return std::move(first);
+    }
+
+    static Elements add(ElementSpan x, ElementSpan y) {
+      Elements result(x.begin(), x.end());
+      for (size_t element = 0; element < result.size(); element++) {
+        result[element] += y[element];
+      }
+      return result;
+    }
+
+    static Elements sub(ElementSpan x, ElementSpan y) {
+      Elements result(x.begin(), x.end());
+      for (size_t element = 0; element < result.size(); element++) {
+        result[element] -= y[element];
+      }
+      return result;
+    }
+
+    static Elements conj(ElementSpan x, ConstructionSpan levels) {
+      if (levels.empty() || levels.front() == Construction::multicomplex) {
+        return Elements(x.begin(), x.end());
+      }
+      // Cayley-Dickson: conj((a, b)) = (conj(a), -b)
+      const size_t half = x.size() / 2;
+      Elements result = conj(x.first(half), levels.subspan(1));
+      for (const BigReal& element : x.subspan(half)) {
+        result.push_back(-element);
+      }
+      return result;
+    }
+
+    static Elements mul(ElementSpan x, ElementSpan y, ConstructionSpan levels) {
+      if (levels.empty()) {
+        return {x.front() * y.front()};
+      }
+      const size_t half = x.size() / 2;
+      const ElementSpan a = x.first(half), b = x.subspan(half);
+      const ElementSpan c = y.first(half), d = y.subspan(half);
+      const ConstructionSpan inner = levels.subspan(1);
+      if (levels.front() == Construction::cayleyDickson) {
+        // (a, b)(c, d) = (ac - conj(d)b, da + b conj(c))
+        return concat(
+          sub(mul(a, c, inner), mul(conj(d, inner), b, inner)),
+          add(mul(d, a, inner), mul(b, conj(c, inner), inner)));
+      }
+      // Multicomplex: (a, b)(c, d) = (ac - db, da + bc)
+      return concat(
+        sub(mul(a, c, inner), mul(d, b, inner)),
+        add(mul(d, a, inner), mul(b, c, inner)));
+    }
+  }
+
+  ReferenceOrbit::ReferenceOrbit() :
+        z0(),
+        c(),
+        numberSystem(options::NumberSystem::complex),
+        elementCount(options::elementCount(options::NumberSystem::complex)),
+        complete(false),
+        points() {}
+
+  bool ReferenceOrbit::covers(
+      const BigNumber& z0,
+      const BigNumber& c,
+      options::NumberSystem numberSystem,
+      cl_uint iterations) const {
+    return !points.empty()
+      && z0 == this->z0
+      && c == this->c
+      && numberSystem == this->numberSystem
+      && (complete || length() > iterations);
+  }
+
+  void ReferenceOrbit::compute(
+      const BigNumber& z0,
+      const BigNumber& c,
+      options::NumberSystem numberSystem,
+      cl_uint iterations,
+      size_t maxLength,
+      real escape) {
+    this->z0 = z0;
+    this->c = c;
+    this->numberSystem = numberSystem;
+    elementCount = options::elementCount(numberSystem);
+
+    const ConstructionSpan levels = constructions(numberSystem);
+    // The kernels step to the next point before checking the current one.
+    maxLength = std::max(maxLength, size_t(2));
+    const size_t limit = std::clamp(static_cast<size_t>(iterations) + 1, size_t(2), maxLength);
+    Elements z(z0.begin(), z0.begin() + elementCount);
+    const Elements constant(c.begin(), c.begin() + elementCount);
+    points.clear();
+    points.reserve(limit * elementCount);
+    complete = false;
+    while (true) {
+      real modulusSquared = 0.0;
+      for (const BigReal& element : z) {
+        real value = element.toReal();
+        points.push_back(value);
+        modulusSquared += value * value;
+      }
+      if (!(modulusSquared < escape) && length() >= 2) {
+        complete = true;
+        break;
+      }
+      if (length() == limit) {
+        complete = limit == maxLength;
+        break;
+      }
+      // Same as KERNEL_FUNCTION: z = add(sqr(z), c)
+      z = add(mul(z, z, levels), constant);
+    }
+  }
+}
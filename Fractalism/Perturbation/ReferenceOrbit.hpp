@@ -0,0 +1,87 @@
+#ifndef _FRACTALISM_REFERENCE_ORBIT_HPP_
+#define _FRACTALISM_REFERENCE_ORBIT_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include <Fractalism/Options.hpp>
+#include <Fractalism/Perturbation/BigReal.hpp>
+
+namespace fractalism::perturbation {
+
+/**
+ * @class ReferenceOrbit
+ * @brief The orbit of one point computed in high precision on the host, which
+ * the perturbed kernels iterate their pixels relative to.
+ *
+ * Only the orbit itself is kept, rounded to real. The pixels iterate their
+ * small distance to it, which needs no more precision than a real has.
+ */
+class ReferenceOrbit {
+public:
+  /**
+   * @brief Constructs an empty orbit.
+   */
+  ReferenceOrbit();
+
+  /**
+   * @brief Checks if the orbit has the given inputs and is long enough.
+   * @param z0 The starting point.
+   * @param c The constant.
+   * @param numberSystem The number system.
+   * @param iterations The number of iterations the pixels will run.
+   * @return True if the orbit does not need to be recomputed.
+   */
+  bool covers(
+      const BigNumber& z0,
+      const BigNumber& c,
+      options::NumberSystem numberSystem,
+      cl_uint iterations) const;
+
+  /**
+   * @brief Computes the orbit of z0 under z = z^2 + c, until it escapes or
+   * has iterations + 1 points.
+   *
+   * The arithmetic follows the constructions in
+   * KernelHeaders/number_system_constructions.h, and the function the one
+   * ProgramManager builds the kernels with. The orbit always has at least two
+   * points, even if z0 escapes.
+   * @param z0 The starting point.
+   * @param c The constant.
+   * @param numberSystem The number system.
+   * @param iterations The number of iterations the pixels will run.
+   * @param maxLength The most points to keep. Pixels that outlive a
+   * truncated orbit rebase onto its start.
+   * @param escape The squared modulus at which the orbit stops.
+   */
+  void compute(
+      const BigNumber& z0,
+      const BigNumber& c,
+      options::NumberSystem numberSystem,
+      cl_uint iterations,
+      size_t maxLength,
+      real escape);
+
+  /**
+   * @brief Gets the orbit points, elementCount() reals each.
+   * @return The orbit, starting at z0.
+   */
+  inline const std::vector<real>& data() const { return points; }
+
+  /**
+   * @brief Gets the number of orbit points.
+   * @return The number of points.
+   */
+  inline cl_uint length() const { return static_cast<cl_uint>(points.size() / elementCount); }
+
+private:
+  BigNumber z0;                      ///< The starting point of the orbit.
+  BigNumber c;                       ///< The constant of the orbit.
+  options::NumberSystem numberSystem; ///< The number system of the orbit.
+  size_t elementCount;               ///< The number of elements per point.
+  bool complete;                     ///< True if the orbit escaped or reached its limit.
+  std::vector<real> points;          ///< The orbit points, rounded to real.
+};
+} // namespace fractalism::perturbation
+
+#endif
@@ -0,0 +1,59 @@
+#include <Fractalism/Render/ImageWriter.hpp>
+
+#include <format>
+#include <fstream>
+
+#include <Fractalism/Exceptions.hpp>
+
+namespace fractalism::render {
+  static inline std::ofstream openOutput(const std::filesystem::path& path) {
+    if (path.has_parent_path()) {
+      std::filesystem::create_directories(path.parent_path());
+    }
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+      throw FractalismError(std::format("Could not open {} for writing", path.string()));
+    }
+    return file;
+  }
+
+  static inline void checkWritten(const std::filesystem::path& path, std::ofstream& file) {
+    file.flush();
+    if (!file) {
+      throw FractalismError(std::format("Could not write {}", path.string()));
+    }
+  }
+
+  void writeImage(
+      const std::filesystem::path& path,
+      const cl::NDRange& range,
+      const std::vector<cl_uchar>& texels) {
+    if (range[2] != 1) {
+      throw AssertionError("Only 2D images can be written as PAM.");
+    }
+    std::ofstream file = openOutput(path);
+    file << std::format(
+      "P7\nWIDTH {}\nHEIGHT {}\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n",
+      range[0],
+      range[1]);
+    const size_t rowSize = range[0] * 4;
+    for (size_t row = range[1]; row > 0; row--) {
+      file.write(reinterpret_cast<const char*>(texels.data() + (row - 1) * rowSize), rowSize);
+    }
+    checkWritten(path, file);
+  }
+
+  void writeVolume(
+      const std::filesystem::path& path,
+      const cl::NDRange& range,
+      const std::vector<cl_uchar>& texels) {
+    std::ofstream file = openOutput(path);
+    file << std::format(
+      "NRRD0004\ntype: uint8\ndimension: 4\nsizes: 4 {} {} {}\nkinds: RGBA-color domain domain domain\nencoding: raw\n\n",
+      range[0],
+      range[1],
+      range[2]);
+    file.write(reinterpret_cast<const char*>(texels.data()), range[0] * range[1] * range[2] * 4);
+    checkWritten(path, file);
+  }
+}
@@ -0,0 +1,38 @@
+#ifndef _FRACTALISM_IMAGE_WRITER_HPP_
+#define _FRACTALISM_IMAGE_WRITER_HPP_
+
+#include <filesystem>
+#include <vector>
+
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+
+namespace fractalism::render {
+
+/**
+ * @brief Writes a 2D RGBA8 image as a Netpbm PAM file.
+ *
+ * Rows are flipped so the image looks the way it does in the UI, where the
+ * first row of the texture is at the bottom.
+ * @param path The file to write.
+ * @param range The image dimensions. The third dimension must be 1.
+ * @param texels The texels, 4 bytes each, x varying fastest.
+ */
+void writeImage(
+    const std::filesystem::path& path,
+    const cl::NDRange& range,
+    const std::vector<cl_uchar>& texels);
+
+/**
+ * @brief Writes a 3D RGBA8 volume as an NRRD file, which ParaView, 3D Slicer
+ * and most other volume tools can open.
+ * @param path The file to write.
+ * @param range The volume dimensions.
+ * @param texels The voxels, 4 bytes each, x varying fastest.
+ */
+void writeVolume(
+    const std::filesystem::path& path,
+    const cl::NDRange& range,
+    const std::vector<cl_uchar>& texels);
+} // namespace fractalism::render
+
+#endif
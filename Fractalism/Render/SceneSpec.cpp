@@ -0,0 +1,273 @@
+#include <Fractalism/Render/SceneSpec.hpp>
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <initializer_list>
+#include <map>
+#include <sstream>
+#include <utility>
+
+#include <Fractalism/Exceptions.hpp>
+#include <Fractalism/Perturbation/BigReal.hpp>
+#include <Fractalism/Settings.hpp>
+
+namespace fractalism::render {
+  struct Value {
+    std::string text;
+    size_t line;
+  };
+
+  using Section = std::map<std::string, Value>;
+
+  static inline std::string trim(const std::string& text) {
+    constexpr const char whitespace[] = " \t\r";
+    size_t begin = text.find_first_not_of(whitespace);
+    if (begin == std::string::npos) {
+      return "";
+    }
+    return text.substr(begin, text.find_last_not_of(whitespace) - begin + 1);
+  }
+
+  class SectionReader {
+  public:
+    SectionReader(const std::filesystem::path& file, const std::string& name, Section&& values) :
+          file(file),
+          name(name),
+          values(std::move(values)) {}
+
+    template<typename T>
+    T get(const std::string& key, T fallback) {
+      auto it = values.find(key);
+      if (it == values.end()) {
+        return fallback;
+      }
+      Value value = it->second;
+      values.erase(it);
+      std::istringstream stream(value.text);
+      T result{};
+      if (!(stream >> result) || !(stream >> std::ws).eof()) {
+        throw error(value, std::format("'{}' is not a valid value for {}", value.text, key));
+      }
+      return result;
+    }
+
+    template<typename T>
+    std::vector<T> getArray(const std::string& key, size_t minCount, size_t maxCount) {
+      auto it = values.find(key);
+      if (it == values.end()) {
+        return {};
+      }
+      Value value = it->second;
+      values.erase(it);
+      std::istringstream stream(value.text);
+      std::vector<T> result;
+      T element{};
+      while (stream >> element) {
+        result.push_back(element);
+      }
+      if (!stream.eof() || result.size() < minCount || result.size() > maxCount) {
+        throw error(value, std::format("{} takes {} to {} numbers", key, minCount, maxCount));
+      }
+      return result;
+    }
+
+    /**
+     * Like getArray, but keeps every digit, for centers deeper than a real
+     * can resolve.
+     */
+    std::vector<perturbation::BigReal> getPreciseArray(
+        const std::string& key,
+        size_t minCount,
+        size_t maxCount,
+        size_t fractionLimbs) {
+      auto it = values.find(key);
+      if (it == values.end()) {
+        return {};
+      }
+      Value value = it->second;
+      values.erase(it);
+      std::istringstream stream(value.text);
+      std::vector<perturbation::BigReal> result;
+      std::string element;
+      while (stream >> element) {
+        try {
+          result.push_back(perturbation::BigReal::parse(element, fractionLimbs));
+        } catch (const ParseError& e) {
+          throw error(value, std::format("{} takes {} to {} numbers", key, minCount, maxCount));
+        }
+      }
+      if (result.size() < minCount || result.size() > maxCount) {
+        throw error(value, std::format("{} takes {} to {} numbers", key, minCount, maxCount));
+      }
+      return result;
+    }
+
+    template<typename E>
+    E getEnum(const std::string& key, E fallback, std::initializer_list<E> options) {
+      auto it = values.find(key);
+      if (it == values.end()) {
+        return fallback;
+      }
+      Value value = it->second;
+      values.erase(it);
+      for (E option : options) {
+        if (options::name(option) == value.text) {
+          return option;
+        }
+      }
+      throw error(value, std::format("'{}' is not a valid value for {}", value.text, key));
+    }
+
+    inline std::string getString(const std::string& key, const std::string& fallback) {
+      auto it = values.find(key);
+      if (it == values.end()) {
+        return fallback;
+      }
+      std::string result = it->second.text;
+      values.erase(it);
+      return result;
+    }
+
+    /**
+     * Everything that was understood has been consumed by now, so whatever is
+     * left is a typo.
+     */
+    void checkAllUsed() const {
+      if (!values.empty()) {
+        const auto& [key, value] = *values.begin();
+        throw error(value, std::format("Unknown key '{}' in scene [{}]", key, name));
+      }
+    }
+
+  private:
+    ParseError error(const Value& value, const std::string& message) const {
+      return ParseError(std::format("{}:{}: {}", file.string(), value.line, message));
+    }
+
+    const std::filesystem::path& file;
+    std::string name;
+    Section values;
+  };
+
+  static inline Scene readScene(
+      const std::filesystem::path& file,
+      const std::filesystem::path& outputDirectory,
+      const std::string& name,
+      Section&& values) {
+    SectionReader reader(file, name, std::move(values));
+    const Settings defaults;
+
+    options::Space space = reader.getEnum("space", options::Space::phase,
+      {options::Space::phase, options::Space::dynamical});
+    options::RenderMode renderMode = reader.getEnum("render_mode", options::RenderMode::escape,
+      {options::RenderMode::escape, options::RenderMode::translated, options::RenderMode::distance});
+    options::NumberSystem numberSystem = reader.getEnum("number_system", options::NumberSystem::complex,
+      {options::NumberSystem::complex, options::NumberSystem::bicomplex, options::NumberSystem::quaternion});
+
+    Scene scene{
+      .name = name,
+      .numberSystem = numberSystem,
+      .dimensions = options::Dimensions::two,
+      .resolution = reader.get<cl::size_type>("resolution", 512),
+      .parameter = defaults.parameter,
+      .window = ViewWindowSettings(space, renderMode),
+      .translatedIterations = reader.get<cl_uint>("iterations", Scene::defaultTranslatedIterations),
+      .precision = {},
+      .output = {}
+    };
+
+    switch (reader.get<int>("dimensions", 2)) {
+    case 2:
+      scene.dimensions = options::Dimensions::two;
+      break;
+    case 3:
+      scene.dimensions = options::Dimensions::three;
+      break;
+    default:
+      throw ParseError(std::format("{}: dimensions of scene [{}] must be 2 or 3", file.string(), name));
+    }
+    if (scene.resolution == 0) {
+      throw ParseError(std::format("{}: resolution of scene [{}] must be positive", file.string(), name));
+    }
+
+    gpu::types::Viewspace& view = scene.window.view;
+    view.zoom = reader.get<real>("zoom", view.zoom);
+    std::vector<perturbation::BigReal> center = reader.getPreciseArray(
+      "center", 1, MAX_NUMBER_SYSTEM_SIZE, perturbation::precisionForZoom(view.zoom));
+    if (!center.empty()) {
+      perturbation::BigNumber preciseCenter{};
+      std::copy(center.begin(), center.end(), preciseCenter.begin());
+      view.setPreciseCenter(preciseCenter);
+    }
+    std::vector<real> parameter = reader.getArray<real>("parameter", 1, MAX_NUMBER_SYSTEM_SIZE);
+    std::copy(parameter.begin(), parameter.end(), scene.parameter.raw);
+    std::vector<int> mapping = reader.getArray<int>("mapping", 2, 3);
+    if (!mapping.empty()) {
+      view.mapping = {
+        static_cast<cl_char>(mapping[0]),
+        static_cast<cl_char>(mapping[1]),
+        mapping.size() > 2 ? static_cast<cl_char>(mapping[2]) : view.mapping.z
+      };
+    }
+    scene.window.iterationModifier = reader.get<real>("iteration_modifier", scene.window.iterationModifier);
+    scene.window.iterationsPerFrame = reader.get<cl_uint>("iterations_per_frame", scene.window.iterationsPerFrame);
+
+    std::string precision = reader.getString("precision", "auto");
+    if (precision == options::name(options::Precision::fp32)) {
+      scene.precision = options::Precision::fp32;
+    } else if (precision == options::name(options::Precision::fp64)) {
+      scene.precision = options::Precision::fp64;
+    } else if (precision != "auto") {
+      throw ParseError(std::format("{}: precision of scene [{}] must be auto, float or double", file.string(), name));
+    }
+
+    // 3D distance scenes are traced from the camera into an image.
+    const bool image = scene.dimensions == options::Dimensions::two || renderMode == options::RenderMode::distance;
+    std::filesystem::path output = reader.getString("output", name + (image ? ".pam" : ".nrrd"));
+    scene.output = output.is_absolute() ? output : outputDirectory / output;
+
+    reader.checkAllUsed();
+    return scene;
+  }
+
+  std::vector<Scene> readScenes(
+      const std::filesystem::path& file,
+      const std::filesystem::path& outputDirectory) {
+    std::ifstream stream(file);
+    if (!stream) {
+      throw ParseError(std::format("Could not open scene spec {}", file.string()));
+    }
+
+    Section defaults;
+    std::vector<std::pair<std::string, Section>> sections;
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(stream, line); lineNumber++) {
+      line = trim(line.substr(0, line.find_first_of("#;")));
+      if (line.empty()) {
+        continue;
+      }
+      if (line.front() == '[') {
+        if (line.back() != ']' || line.size() < 3) {
+          throw ParseError(std::format("{}:{}: Malformed section header", file.string(), lineNumber));
+        }
+        // Every scene starts out with the file wide defaults.
+        sections.emplace_back(trim(line.substr(1, line.size() - 2)), defaults);
+        continue;
+      }
+      size_t equals = line.find('=');
+      if (equals == std::string::npos) {
+        throw ParseError(std::format("{}:{}: Expected 'key = value'", file.string(), lineNumber));
+      }
+      Section& section = sections.empty() ? defaults : sections.back().second;
+      section[trim(line.substr(0, equals))] = {trim(line.substr(equals + 1)), lineNumber};
+    }
+
+    std::vector<Scene> scenes;
+    scenes.reserve(sections.size());
+    for (auto& [name, values] : sections) {
+      scenes.push_back(readScene(file, outputDirectory, name, std::move(values)));
+    }
+    return scenes;
+  }
+}
@@ -0,0 +1,68 @@
+#ifndef _FRACTALISM_SCENE_SPEC_HPP_
+#define _FRACTALISM_SCENE_SPEC_HPP_
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+#include <Fractalism/GPU/Types.hpp>
+#include <Fractalism/Options.hpp>
+#include <Fractalism/ViewWindowSettings.hpp>
+
+namespace fractalism::render {
+
+/**
+ * @struct Scene
+ * @brief Everything needed to render one image or volume headlessly.
+ */
+struct Scene {
+  static constexpr cl_uint defaultTranslatedIterations = 100; ///< Iterations to run in translated mode if none are given.
+
+  std::string name;                            ///< The section name of the scene.
+  options::NumberSystem numberSystem;          ///< The number system.
+  options::Dimensions dimensions;              ///< 2D image or 3D volume.
+  cl::size_type resolution;                    ///< The edge length of the output, in pixels/voxels.
+  gpu::types::Number parameter;                ///< The fractal parameter.
+  ViewWindowSettings window;                   ///< Space, render mode, viewspace and iteration settings.
+  cl_uint translatedIterations;                ///< How many iterations to run in translated mode.
+  std::optional<options::Precision> precision; ///< The kernel precision, or empty to pick it from the zoom level.
+  std::filesystem::path output;                ///< Where to write the result.
+};
+
+/**
+ * @brief Reads the scenes from a scene spec file.
+ *
+ * The file is INI-like. Each <tt>[name]</tt> section is a scene, and keys before
+ * the first section are defaults for all scenes in the file:
+ * @code
+ * # Lines starting with '#' or ';' are comments.
+ * resolution = 1024
+ *
+ * [mandelbrot]
+ * number_system = complex     # complex, bicomplex or quaternion
+ * space = phase               # phase or dynamical
+ * render_mode = escape        # escape, translated or distance
+ * dimensions = 2              # 2 writes a .pam image, 3 a .nrrd volume (distance: a .pam
+ *                             # image traced from the camera)
+ * center = -0.5 0 0 0         # as many digits as the zoom level needs
+ * zoom = 0.5                  # very deep zooms use perturbation in escape mode
+ * mapping = 1 2 3             # 1-based element per axis, negative flips it
+ * parameter = 0.3577 0.1117 0 0
+ * iteration_modifier = 125    # escape and distance mode iteration limit, as in the UI
+ * iterations_per_frame = 100
+ * iterations = 100            # translated mode iteration count
+ * precision = auto            # auto, float or double
+ * output = mandelbrot.pam     # defaults to the section name
+ * @endcode
+ * @param file The spec file.
+ * @param outputDirectory Relative output paths are resolved against this.
+ * @return The scenes, in file order.
+ */
+std::vector<Scene> readScenes(
+    const std::filesystem::path& file,
+    const std::filesystem::path& outputDirectory);
+} // namespace fractalism::render
+
+#endif
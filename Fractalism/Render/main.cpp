@@ -0,0 +1,151 @@
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+#include <Fractalism/Core.hpp>
+#include <Fractalism/GPU/OpenCL/ImageTarget.hpp>
+#include <Fractalism/GPU/OpenCL/KernelExecutor.hpp>
+#include <Fractalism/Render/ImageWriter.hpp>
+#include <Fractalism/Render/SceneSpec.hpp>
+
+namespace fractalism::render {
+  static constexpr const char usage[] =
+    "Usage: fractalism-render [--output-dir DIR] SCENE_SPEC...\n"
+    "\n"
+    "Renders every scene in the given scene spec files without a display.\n"
+    "2D scenes and traced distance scenes are written as PAM images, other 3D\n"
+    "scenes as NRRD volumes.\n"
+    "See Render/SceneSpec.hpp for the spec format.\n"
+    "\n"
+    "  --output-dir DIR  Resolve relative output paths against DIR instead of\n"
+    "                    the working directory.\n"
+    "  --help            Show this message.\n";
+
+  static void renderScene(
+      const Scene& scene,
+      gpu::opencl::KernelExecutor& kernel,
+      gpu::opencl::ImageTarget& target) {
+    Settings& settings = Core::get<Settings>();
+    settings.numberSystem = scene.numberSystem;
+    settings.renderDimensions = scene.dimensions;
+    cl::NDRange previousResolution = settings.resolution;
+    settings.setResolution(scene.resolution);
+    settings.parameter = scene.parameter;
+    settings.precision = scene.precision;
+    // The kernel executor holds a reference to this element.
+    settings.viewWindowSettings[0] = scene.window;
+
+    if (previousResolution.dimensions() != settings.resolution.dimensions()
+        || previousResolution[0] != settings.resolution[0]) {
+      try {
+        Core::get<gpu::opencl::ProgramManager>().updateResolution();
+      } catch (const FractalismError&) {
+        // The stores still have the previous size, the next scene compares
+        // against it.
+        settings.resolution = previousResolution;
+        throw;
+      }
+    }
+    // Traced frames are an image of the canvas, give it the scene's resolution.
+    kernel.setCanvasSize(static_cast<cl_uint>(scene.resolution), static_cast<cl_uint>(scene.resolution));
+    kernel.updateKernel();
+    kernel.waitForKernel();
+    kernel.clearTexture();
+
+    const bool translated = scene.window.renderMode == options::RenderMode::translated;
+    const cl_uint iterations = translated ? scene.translatedIterations : scene.window.getMaxIterations();
+    std::vector<cl::Event> waitEvents{};
+    while (kernel.getCurrentIteration() < iterations) {
+      if (translated) {
+        // Same as the UI: only the latest iteration is shown.
+        kernel.clearTexture();
+      }
+      cl::Event done = kernel.enqueue(waitEvents);
+      if (done()) {
+        done.wait();
+      }
+    }
+
+    const std::vector<cl_uchar>& texels = target.read();
+    if (scene.dimensions == options::Dimensions::two || kernel.isTraced()) {
+      writeImage(scene.output, target.getRange(), texels);
+    } else {
+      writeVolume(scene.output, target.getRange(), texels);
+    }
+  }
+
+  static int run(int argc, char** argv) {
+    std::filesystem::path outputDirectory;
+    std::vector<std::filesystem::path> specs;
+    for (int i = 1; i < argc; i++) {
+      std::string_view arg = argv[i];
+      if (arg == "--help" || arg == "-h") {
+        std::cout << usage;
+        return 0;
+      } else if (arg == "--output-dir") {
+        if (++i == argc) {
+          std::cerr << "--output-dir needs a value\n\n" << usage;
+          return 2;
+        }
+        outputDirectory = argv[i];
+      } else {
+        specs.emplace_back(arg);
+      }
+    }
+    if (specs.empty()) {
+      std::cerr << usage;
+      return 2;
+    }
+
+    // Parse everything up front, so a typo in the last file doesn't waste a
+    // night of rendering.
+    std::vector<Scene> scenes;
+    for (const std::filesystem::path& spec : specs) {
+      std::vector<Scene> specScenes = readScenes(spec, outputDirectory);
+      scenes.insert(scenes.end(), specScenes.begin(), specScenes.end());
+    }
+    if (scenes.empty()) {
+      std::cerr << "No scenes to render.\n";
+      return 0;
+    }
+
+    Core::setStatusHandlers([](const std::string& message) { std::clog << message << std::endl; }, nullptr);
+    Core::initCompute();
+    Core::get<Settings>().viewWindowSettings.assign(1, scenes.front().window);
+    Core::get<gpu::opencl::ProgramManager>().updateResolution();
+    Core::get<gpu::opencl::ProgramManager>().createBuffer();
+
+    gpu::opencl::ImageTarget target;
+    gpu::opencl::KernelExecutor kernel(0, target);
+    int failures = 0;
+    for (const Scene& scene : scenes) {
+      std::clog << std::format("Rendering [{}] to {}", scene.name, scene.output.string()) << std::endl;
+      try {
+        renderScene(scene, kernel, target);
+      } catch (const std::exception& e) {
+        // Keep going, one bad scene shouldn't cost the rest of the batch.
+        std::cerr << std::format("Could not render [{}]: {}", scene.name, e.what()) << std::endl;
+        failures++;
+      }
+    }
+    if (failures) {
+      std::cerr << std::format("{} of {} scenes failed.", failures, scenes.size()) << std::endl;
+    }
+    return failures ? 1 : 0;
+  }
+}
+
+int main(int argc, char** argv) {
+  int result;
+  try {
+    result = fractalism::render::run(argc, argv);
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    result = 1;
+  }
+  fractalism::Core::shutdown();
+  return result;
+}
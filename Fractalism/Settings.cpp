@@ -1,7 +1,5 @@
 #include <Fractalism/Settings.hpp>
 
-#include <Fractalism/App.hpp>
-
 namespace fractalism {
   Settings::Settings() :
         parameter(0.357712765957447, 0.111702127659575, 0.0),
@@ -13,5 +11,6 @@ namespace fractalism {
                 ViewWindowSettings(options::Space::phase, options::RenderMode::translated),
                 ViewWindowSettings(options::Space::dynamical, options::RenderMode::escape),
                 ViewWindowSettings(options::Space::dynamical, options::RenderMode::translated)
-        } {}
+        },
+        precision() {}
 }
\ No newline at end of file
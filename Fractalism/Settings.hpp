@@ -2,6 +2,7 @@
 #define _FRACTALISM_SETTINGS_HPP_
 
 #include <limits>
+#include <optional>
 #include <vector>
 
 #include <Fractalism/GPU/Types.hpp>
@@ -22,6 +23,7 @@ public:
   cl::NDRange resolution;                             ///< The resolution setting.
   gpu::types::Number parameter;                       ///< The fractal parameter.
   std::vector<ViewWindowSettings> viewWindowSettings; ///< The view window settings.
+  std::optional<options::Precision> precision;        ///< Forces the device precision. Chosen per window from the zoom level if empty.
 
   /**
    * @brief Constructs a Settings object with default values.
@@ -7,7 +7,37 @@ in vec2 texcoords;
 // We use a 3D texture in 2D rendering so that we can
 // use the same OpenCL kernels for 2D and 3D
 layout (location = 0) uniform sampler3D mainTexture;
+// While rendering progressively, only every 2^level-th texel is up to date.
+layout (location = 10) uniform int level;
+// The texture is a ring buffer, the top left of the screen is stored at the
+// origin texel.
+layout (location = 11) uniform vec3 origin;
+// Until a frame of the current view is done, the last frame stands in for it,
+// moved and scaled to the current view.
+layout (location = 12) uniform vec3 previewScale;
+layout (location = 13) uniform vec3 previewOffset;
+
+vec3 snapToLevel(vec3 position) {
+  if (level == 0) {
+    return position;
+  }
+  vec3 size = vec3(textureSize(mainTexture, 0));
+  float stride = float(1 << level);
+  return (floor(position * size / stride) * stride + 0.5) / size;
+}
+
+// Clamped to the edges of the screen rather than of the texture, which wraps.
+vec3 toStored(vec3 position) {
+  vec3 size = vec3(textureSize(mainTexture, 0));
+  return clamp(snapToLevel(position), 0.5 / size, 1.0 - 0.5 / size) + origin / size;
+}
 
 void main() {
-  FragColor = vec4(texture(mainTexture, vec3(texcoords, 0)).rgb, 1.0);
+  vec3 position = vec3(texcoords, 0) * previewScale + previewOffset;
+  if (any(lessThan(position, vec3(0.0))) || any(greaterThan(position, vec3(1.0)))) {
+    // Not in the frame yet.
+    FragColor = vec4(0.0, 0.0, 0.0, 1.0);
+    return;
+  }
+  FragColor = vec4(texture(mainTexture, toStored(position)).rgb, 1.0);
 }
\ No newline at end of file
@@ -18,6 +18,20 @@ layout (location = 2) uniform Material material;
 layout (location = 4) uniform Light light;
 layout (location = 8) uniform mat3 normalMatrix;
 layout (location = 9) uniform vec3 eyePosition;
+// While rendering progressively, only every 2^level-th texel is up to date.
+layout (location = 10) uniform int level;
+// The texture is a ring buffer, the front top left corner is stored at the
+// origin texel.
+layout (location = 11) uniform vec3 origin;
+// Until a frame of the current view is done, the last frame stands in for it,
+// moved and scaled to the current view.
+layout (location = 12) uniform vec3 previewScale;
+layout (location = 13) uniform vec3 previewOffset;
+// The highest alpha of each brickSize texels per side on screen, and of the
+// texels sampling inside them reads. Built along with the frame, 0 if there
+// are none.
+layout (location = 14) uniform sampler3D bricks;
+layout (location = 15) uniform int brickSize;
 
 in vec3 worldspacePosition;
 
@@ -29,6 +43,47 @@ const vec3 cMax = vec3(0.5);
 const vec3 cMin = -cMax;
 const bool withinVolume = all(lessThan(abs(eyePosition), vec3(0.5)));
 
+vec3 snapToLevel(vec3 position) {
+  if (level == 0) {
+    return position;
+  }
+  vec3 size = vec3(textureSize(volume, 0));
+  float stride = float(1 << level);
+  return (floor(position * size / stride) * stride + 0.5) / size;
+}
+
+// Clamped to the edges of the volume rather than of the texture, which wraps.
+vec3 toStored(vec3 position) {
+  vec3 size = vec3(textureSize(volume, 0));
+  position = position * previewScale + previewOffset;
+  return clamp(snapToLevel(position), 0.5 / size, 1.0 - 0.5 / size) + origin / size;
+}
+
+// Finds where the ray leaves the brick around position if the brick is empty,
+// so the steps through it can be skipped. Bricks are screen aligned in the
+// shown frame, the preview moves and scales them. The edge bricks reach past
+// the volume, which toStored() clamps to.
+float skipEmpty(vec3 position, vec3 start, vec3 end, float t) {
+  if (brickSize == 0) {
+    return t;
+  }
+  ivec3 size = textureSize(volume, 0);
+  ivec3 count = textureSize(bricks, 0);
+  ivec3 texel = clamp(ivec3(floor((position * previewScale + previewOffset) * vec3(size))), ivec3(0), size - 1);
+  ivec3 brick = min(texel / brickSize, count - 1);
+  if (texelFetch(bricks, brick, 0).a > 0.0) {
+    return t;
+  }
+  vec3 low = mix(vec3(brick * brickSize) / vec3(size), vec3(-1e30), equal(brick, ivec3(0)));
+  vec3 high = mix(vec3((brick + 1) * brickSize) / vec3(size), vec3(1e30), equal(brick, count - 1));
+  low = (low - previewOffset) / previewScale;
+  high = (high - previewOffset) / previewScale;
+  vec3 direction = end - start;
+  vec3 exits = (mix(min(low, high), max(low, high), greaterThan(direction, vec3(0.0))) - start) / direction;
+  exits = mix(exits, vec3(1e30), equal(direction, vec3(0.0)));
+  return max(t, min(exits.x, min(exits.y, exits.z)));
+}
+
 void main() {
   vec3 start, end;
   // for detailed explanation of this algorithm, see /RayMarching.md
@@ -57,18 +112,26 @@ void main() {
   }
   float stepSize = 1.0 / (distance(start, end) * samplesPerUnit);
   vec4 totalColor = vec4(0.0);
+  // Normals are taken across the up to date texels.
+  vec3 texelStride = float(1 << level) / vec3(textureSize(volume, 0));
 
   float t = 0.0;
   // Ray march until reaching the end of the volume, or color saturation
   while (t < 1.0 && totalColor.a < 1.0) {
     vec3 position = mix(start, end, t);
+    float skipTo = skipEmpty(position, start, end, t);
+    if (skipTo > t) {
+      // Back on the grid of steps, so skipped bricks leave no seams.
+      t = max(t + stepSize, ceil(skipTo / stepSize) * stepSize);
+      continue;
+    }
 
-    vec4 currentColor = texture(volume, position);
+    vec4 currentColor = texture(volume, toStored(position));
         
     float cos_theta;
     // Calculate cos(theta) between the light and the surface normal
     {
-#define get_alpha(x, y, z) textureOffset(volume, position, ivec3(x, y, z)).a
+#define get_alpha(x, y, z) texture(volume, toStored(position + vec3(x, y, z) * texelStride)).a
       vec3 normal = vec3(
         (get_alpha(-1, 0, 0) - get_alpha(1, 0, 0)),
         (get_alpha(0, -1, 0) - get_alpha(0, 1, 0)),
@@ -0,0 +1,61 @@
+#ifndef _FRACTALISM_CHECK_HPP_
+#define _FRACTALISM_CHECK_HPP_
+
+#include <format>
+#include <iostream>
+
+namespace fractalism::tests {
+
+/**
+ * @brief Counts the failed checks of the test.
+ * @return The count. The test fails if it is not 0.
+ */
+inline int& failures() {
+  static int count = 0;
+  return count;
+}
+
+/**
+ * @brief Reports a check that failed.
+ * @param passed Whether the check passed.
+ * @param expression The checked expression.
+ * @param file The file of the check.
+ * @param line The line of the check.
+ */
+inline void check(bool passed, const char* expression, const char* file, int line) {
+  if (!passed) {
+    std::cerr << std::format("{}:{}: Check failed: {}\n", file, line, expression);
+    failures()++;
+  }
+}
+
+/**
+ * @brief Checks if a function throws an exception of a type.
+ * @tparam E The type of the exception.
+ * @param function The function.
+ * @return True if it threw an E.
+ */
+template<typename E, typename F>
+bool throws(F&& function) {
+  try {
+    function();
+  } catch (const E&) {
+    return true;
+  } catch (...) {
+    return false;
+  }
+  return false;
+}
+
+/**
+ * @brief The exit code of the test.
+ * @return 0 if every check passed, 1 otherwise.
+ */
+inline int result() {
+  return failures() ? 1 : 0;
+}
+} // namespace fractalism::tests
+
+#define FRACTALISM_CHECK(condition) ::fractalism::tests::check(static_cast<bool>(condition), #condition, __FILE__, __LINE__)
+
+#endif
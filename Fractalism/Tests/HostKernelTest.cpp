@@ -0,0 +1,143 @@
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <Fractalism/CPU/HostKernelExecutor.hpp>
+#include <Fractalism/Tests/Check.hpp>
+
+namespace fractalism::tests {
+  using cpu::HostKernelExecutor;
+  using gpu::types::Number;
+  using gpu::types::cltypes::viewspace;
+
+  static constexpr cl_uint iterations = 64;
+
+  // Small differences of the math library may move the escape boundary by a
+  // texel here and there, but no further.
+  static constexpr int channelTolerance = 2;
+  static constexpr double texelTolerance = 0.01;
+
+  /**
+   * @struct Render
+   * @brief A host kernel run compared against a baseline image.
+   */
+  struct Render {
+    std::string kernel;   ///< The kernel name.
+    cl::NDRange range;    ///< The size of the output volume.
+    viewspace view;       ///< The viewspace.
+    Number parameter;     ///< The fractal parameter.
+    std::string baseline; ///< The baseline image in the baseline directory.
+  };
+
+  static std::vector<Render> renders() {
+    return {
+      Render{
+        "phase_escape_complex",
+        cl::NDRange(64, 64, 1),
+        viewspace{Number(-0.5, 0.0, 0.0), 0.5, {1, 2, 0}, {0, 0, 0}},
+        Number(),
+        "phase_escape_complex.pam"},
+      Render{
+        "dynamical_escape_quaternion",
+        cl::NDRange(16, 16, 16),
+        viewspace{Number(), 0.6, {1, 2, 3}, {0, 0, 0}},
+        Number(-0.2, 0.6, 0.2),
+        "dynamical_escape_quaternion.pam"},
+      // Scatters its writes, which are deferred to keep the image stable.
+      Render{
+        "phase_translated_complex",
+        cl::NDRange(64, 64, 1),
+        viewspace{Number(-0.5, 0.0, 0.0), 0.5, {1, 2, 0}, {0, 0, 0}},
+        Number(),
+        "phase_translated_complex.pam"}
+    };
+  }
+
+  // The slices of a volume are stacked vertically.
+  static std::string pamHeader(const cl::NDRange& range) {
+    return std::format(
+      "P7\nWIDTH {}\nHEIGHT {}\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n",
+      range[0],
+      range[1] * range[2]);
+  }
+
+  static std::vector<cl_uchar> run(const Render& render, const std::vector<cl_uint>& passes) {
+    HostKernelExecutor executor;
+    executor.setKernel(render.kernel);
+    executor.resize(render.range);
+    cl_uint lastIteration = 0;
+    for (cl_uint maxIterations : passes) {
+      executor.run(render.view, render.parameter, lastIteration, maxIterations, iterations);
+      lastIteration = maxIterations;
+    }
+    const size_t size = render.range[0] * render.range[1] * render.range[2] * 4;
+    return std::vector<cl_uchar>(executor.data(), executor.data() + size);
+  }
+
+  static void matchesBaseline(const Render& render, const std::filesystem::path& directory, bool update) {
+    const std::vector<cl_uchar> image = run(render, {iterations});
+    const std::string header = pamHeader(render.range);
+    const std::filesystem::path path = directory / render.baseline;
+    if (update) {
+      std::ofstream file(path, std::ios::binary);
+      file << header;
+      file.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+      FRACTALISM_CHECK(file.good());
+      return;
+    }
+    std::ifstream file(path, std::ios::binary);
+    const std::string baseline{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    if (!baseline.starts_with(header) || baseline.size() != header.size() + image.size()) {
+      std::cerr << std::format("{}: Missing or malformed baseline {}\n", render.kernel, path.string());
+      failures()++;
+      return;
+    }
+    size_t differing = 0;
+    for (size_t texel = 0; texel < image.size() / 4; texel++) {
+      for (size_t channel = 0; channel < 4; channel++) {
+        const int expected = static_cast<unsigned char>(baseline[header.size() + texel * 4 + channel]);
+        if (std::abs(image[texel * 4 + channel] - expected) > channelTolerance) {
+          differing++;
+          break;
+        }
+      }
+    }
+    if (differing > static_cast<size_t>(texelTolerance * static_cast<double>(image.size() / 4))) {
+      std::cerr << std::format("{}: {} of {} texels differ from {}\n", render.kernel, differing, image.size() / 4, path.string());
+      failures()++;
+    }
+  }
+
+  // The tiles run on any thread in any order, the image must not tell.
+  static void deterministic(const Render& render) {
+    FRACTALISM_CHECK(run(render, {iterations}) == run(render, {iterations}));
+  }
+
+  // The work store carries each pixel from one pass to the next, so a frame
+  // computed in passes ends up as if computed at once.
+  static void resumable(const Render& render) {
+    FRACTALISM_CHECK(run(render, {5, 16, 40, iterations}) == run(render, {iterations}));
+  }
+}
+
+int main(int argc, char* argv[]) {
+  using namespace fractalism::tests;
+  // Run with --update to write the baselines after an intended change of the
+  // kernels, and check the images before committing them.
+  const bool update = argc > 1 && std::string_view(argv[1]) == "--update";
+  for (const Render& render : renders()) {
+    matchesBaseline(render, FRACTALISM_TEST_BASELINES, update);
+    deterministic(render);
+  }
+  // The translated kernels draw each pass over the last, only the escape
+  // kernels end up with the same image.
+  resumable(renders()[0]);
+  resumable(renders()[1]);
+  return result();
+}
@@ -0,0 +1,63 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include <Fractalism/GPU/OpenCL/ProgramCache.hpp>
+#include <Fractalism/Tests/Check.hpp>
+
+namespace fractalism::tests {
+  using gpu::opencl::ProgramCache;
+
+  static constexpr const char source[] = "__kernel void k() {}";
+  static constexpr const char options[] = "-I KernelHeaders";
+  static constexpr cl_ulong maxMemAllocSize = cl_ulong(1) << 30;
+
+  static std::filesystem::path pathOf(const std::string& source, const std::string& options) {
+    return ProgramCache::pathOf("Device", "OpenCL 3.0", "1.0", maxMemAllocSize, source, options);
+  }
+
+  // FNV-1a gives the same key on every run and platform.
+  static void stableKey() {
+    FRACTALISM_CHECK(pathOf(source, options) == std::filesystem::path("cl_cache") / "4664999d369fb5b2.bin");
+    FRACTALISM_CHECK(pathOf(source, options) == pathOf(source, options));
+  }
+
+  static void everyFieldCounts() {
+    const std::filesystem::path path = pathOf(source, options);
+    FRACTALISM_CHECK(pathOf("__kernel void k2() {}", options) != path);
+    FRACTALISM_CHECK(pathOf(source, "-I KernelHeaders -cl-fast-relaxed-math") != path);
+    FRACTALISM_CHECK(ProgramCache::pathOf("Other", "OpenCL 3.0", "1.0", maxMemAllocSize, source, options) != path);
+    FRACTALISM_CHECK(ProgramCache::pathOf("Device", "OpenCL 2.0", "1.0", maxMemAllocSize, source, options) != path);
+    FRACTALISM_CHECK(ProgramCache::pathOf("Device", "OpenCL 3.0", "1.1", maxMemAllocSize, source, options) != path);
+    FRACTALISM_CHECK(ProgramCache::pathOf("Device", "OpenCL 3.0", "1.0", maxMemAllocSize / 2, source, options) != path);
+    // Bytes moved from one field to the next make another key.
+    FRACTALISM_CHECK(pathOf("ab", "c") != pathOf("a", "bc"));
+  }
+
+  // The kernel headers are part of the source.
+  static void headersCount() {
+    const std::filesystem::path path = pathOf(source, options);
+    std::filesystem::create_directory(ProgramCache::includeDirectory);
+    const std::filesystem::path header = std::filesystem::path(ProgramCache::includeDirectory) / "kernels.h";
+    std::ofstream(header) << "#define A 1\n";
+    const std::filesystem::path withHeader = pathOf(source, options);
+    FRACTALISM_CHECK(withHeader != path);
+    std::ofstream(header) << "#define A 2\n";
+    FRACTALISM_CHECK(pathOf(source, options) != withHeader);
+    std::filesystem::remove_all(ProgramCache::includeDirectory);
+    FRACTALISM_CHECK(pathOf(source, options) == path);
+  }
+}
+
+int main() {
+  using namespace fractalism::tests;
+  // The headers are looked up relative to the working directory.
+  const std::filesystem::path directory = std::filesystem::temp_directory_path() / "fractalism_program_cache_test";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+  std::filesystem::current_path(directory);
+  stableKey();
+  everyFieldCounts();
+  headersCount();
+  return result();
+}
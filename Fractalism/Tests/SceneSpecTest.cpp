@@ -0,0 +1,131 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <Fractalism/Exceptions.hpp>
+#include <Fractalism/Perturbation/BigReal.hpp>
+#include <Fractalism/Render/SceneSpec.hpp>
+#include <Fractalism/Tests/Check.hpp>
+
+namespace fractalism::tests {
+  using render::Scene;
+
+  static std::filesystem::path writeSpec(const std::string& name, const std::string& text) {
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / ("fractalism_" + name + ".ini");
+    std::ofstream(path) << text;
+    return path;
+  }
+
+  static std::vector<Scene> read(const std::string& name, const std::string& text) {
+    return render::readScenes(writeSpec(name, text), "out");
+  }
+
+  static bool rejects(const std::string& name, const std::string& text) {
+    return throws<ParseError>([&name, &text]() { read(name, text); });
+  }
+
+  static void parsesScenes() {
+    const std::vector<Scene> scenes = read("scenes",
+      "# Defaults of every scene.\n"
+      "resolution = 256\n"
+      "number_system = quaternion ; trailing comment\n"
+      "\n"
+      "[first]\n"
+      "space = dynamical\n"
+      "center = -0.5 0.25\n"
+      "zoom = 2\n"
+      "mapping = 1 -2 3\n"
+      "parameter = 0.3 0.1 0 0\n"
+      "iteration_modifier = 50\n"
+      "iterations_per_frame = 20\n"
+      "precision = float\n"
+      "\n"
+      "[ second ]\n"
+      "resolution = 32\n"
+      "dimensions = 3\n"
+      "render_mode = translated\n"
+      "iterations = 7\n"
+      "output = /tmp/fractalism_second.nrrd\n");
+    FRACTALISM_CHECK(scenes.size() == 2);
+    const Scene& first = scenes[0];
+    FRACTALISM_CHECK(first.name == "first");
+    FRACTALISM_CHECK(first.numberSystem == options::NumberSystem::quaternion);
+    FRACTALISM_CHECK(first.dimensions == options::Dimensions::two);
+    FRACTALISM_CHECK(first.resolution == 256);
+    FRACTALISM_CHECK(first.window.space == options::Space::dynamical);
+    FRACTALISM_CHECK(first.window.renderMode == options::RenderMode::escape);
+    FRACTALISM_CHECK(first.window.view.center.raw[0] == -0.5 && first.window.view.center.raw[1] == 0.25);
+    FRACTALISM_CHECK(first.window.view.zoom == 2.0);
+    FRACTALISM_CHECK(first.window.view.mapping.x == 1 && first.window.view.mapping.y == -2 && first.window.view.mapping.z == 3);
+    FRACTALISM_CHECK(first.parameter.raw[0] == real(0.3) && first.parameter.raw[1] == real(0.1));
+    FRACTALISM_CHECK(first.window.iterationModifier == 50.0);
+    FRACTALISM_CHECK(first.window.iterationsPerFrame == 20);
+    FRACTALISM_CHECK(first.precision == options::Precision::fp32);
+    FRACTALISM_CHECK(first.output == std::filesystem::path("out") / "first.pam");
+
+    const Scene& second = scenes[1];
+    FRACTALISM_CHECK(second.name == "second");
+    FRACTALISM_CHECK(second.numberSystem == options::NumberSystem::quaternion);
+    FRACTALISM_CHECK(second.resolution == 32);
+    FRACTALISM_CHECK(second.dimensions == options::Dimensions::three);
+    FRACTALISM_CHECK(second.window.renderMode == options::RenderMode::translated);
+    FRACTALISM_CHECK(second.translatedIterations == 7);
+    FRACTALISM_CHECK(!second.precision);
+    FRACTALISM_CHECK(second.output == std::filesystem::path("/tmp/fractalism_second.nrrd"));
+  }
+
+  // Volumes are written as NRRD, but 3D distance scenes trace an image.
+  static void outputExtensions() {
+    const std::vector<Scene> scenes = read("outputs",
+      "dimensions = 3\n"
+      "[volume]\n"
+      "[traced]\n"
+      "render_mode = distance\n");
+    FRACTALISM_CHECK(scenes.size() == 2);
+    FRACTALISM_CHECK(scenes[0].output.filename() == "volume.nrrd");
+    FRACTALISM_CHECK(scenes[1].output.filename() == "traced.pam");
+  }
+
+  // Centers keep the digits a real can't hold.
+  static void deepCenter() {
+    const std::vector<Scene> scenes = read("deep",
+      "[deep]\n"
+      "zoom = 1e20\n"
+      "center = -1.74999999999999999999999999991 0.00000000000000000000000000003\n");
+    FRACTALISM_CHECK(scenes.size() == 1);
+    FRACTALISM_CHECK(scenes[0].window.view.center.raw[0] == real(-1.75));
+    const perturbation::BigNumber center = scenes[0].window.view.getPreciseCenter();
+    const perturbation::BigReal rounded = perturbation::BigReal::parse("-1.75", center[0].precision());
+    FRACTALISM_CHECK(!(center[0] - rounded).isZero());
+    FRACTALISM_CHECK(!center[1].isZero());
+  }
+
+  static void rejectsMistakes() {
+    FRACTALISM_CHECK(rejects("unknown_key", "[a]\nresolutoin = 5\n"));
+    FRACTALISM_CHECK(rejects("bad_enum", "[a]\nspace = hyperbolic\n"));
+    FRACTALISM_CHECK(rejects("bad_number", "[a]\nzoom = two\n"));
+    FRACTALISM_CHECK(rejects("trailing", "[a]\nresolution = 5 px\n"));
+    FRACTALISM_CHECK(rejects("header", "[a\n"));
+    FRACTALISM_CHECK(rejects("empty_header", "[]\n"));
+    FRACTALISM_CHECK(rejects("no_equals", "[a]\nresolution 5\n"));
+    FRACTALISM_CHECK(rejects("dimensions", "[a]\ndimensions = 4\n"));
+    FRACTALISM_CHECK(rejects("resolution", "[a]\nresolution = 0\n"));
+    FRACTALISM_CHECK(rejects("parameter", "[a]\nparameter = 1 2 3 4 5\n"));
+    FRACTALISM_CHECK(rejects("mapping", "[a]\nmapping = 1\n"));
+    FRACTALISM_CHECK(rejects("center", "[a]\ncenter = 0 x\n"));
+    FRACTALISM_CHECK(rejects("precision", "[a]\nprecision = half\n"));
+    FRACTALISM_CHECK(throws<ParseError>([]() {
+      render::readScenes(std::filesystem::temp_directory_path() / "fractalism_missing.ini", "out");
+    }));
+  }
+}
+
+int main() {
+  using namespace fractalism::tests;
+  parsesScenes();
+  outputExtensions();
+  deepCenter();
+  rejectsMistakes();
+  return result();
+}
@@ -0,0 +1,71 @@
+#include <vector>
+
+#include <Fractalism/GPU/OpenCL/SubdivisionQueue.hpp>
+#include <Fractalism/Tests/Check.hpp>
+
+namespace fractalism::tests {
+  using gpu::opencl::SubdivisionQueue;
+
+  static double focusDistance(const cl_uint4& rect, const std::array<double, 2>& focus) {
+    const double dx = (rect.s[0] + rect.s[2]) / 2.0 - focus[0];
+    const double dy = (rect.s[1] + rect.s[3]) / 2.0 - focus[1];
+    return dx * dx + dy * dy;
+  }
+
+  // The borders of the first rectangles cover every pixel, and no rectangle
+  // reaches past the output.
+  static void coversOutput() {
+    const std::vector<cl_uint4> rects = SubdivisionQueue::firstRects(cl::NDRange(130, 70), {65.0, 35.0});
+    FRACTALISM_CHECK(rects.size() == 6);
+    std::vector<int> covered(130 * 70, 0);
+    for (const cl_uint4& rect : rects) {
+      FRACTALISM_CHECK(rect.s[0] < rect.s[2] && rect.s[1] < rect.s[3]);
+      FRACTALISM_CHECK(rect.s[2] <= 129 && rect.s[3] <= 69);
+      FRACTALISM_CHECK(rect.s[2] - rect.s[0] <= SubdivisionQueue::tileSize);
+      FRACTALISM_CHECK(rect.s[3] - rect.s[1] <= SubdivisionQueue::tileSize);
+      for (cl_uint y = rect.s[1]; y <= rect.s[3]; y++) {
+        for (cl_uint x = rect.s[0]; x <= rect.s[2]; x++) {
+          covered[y * 130 + x]++;
+        }
+      }
+    }
+    for (int count : covered) {
+      FRACTALISM_CHECK(count >= 1);
+    }
+  }
+
+  // Neighbours share the edge between them.
+  static void sharedEdges() {
+    const std::vector<cl_uint4> rects = SubdivisionQueue::firstRects(cl::NDRange(256, 256), {0.0, 0.0});
+    FRACTALISM_CHECK(rects.size() == 16);
+    for (const cl_uint4& rect : rects) {
+      FRACTALISM_CHECK(rect.s[0] % SubdivisionQueue::tileSize == 0);
+      FRACTALISM_CHECK(rect.s[1] % SubdivisionQueue::tileSize == 0);
+      FRACTALISM_CHECK(rect.s[2] == (rect.s[0] == 192 ? 255u : rect.s[0] + SubdivisionQueue::tileSize));
+      FRACTALISM_CHECK(rect.s[3] == (rect.s[1] == 192 ? 255u : rect.s[1] + SubdivisionQueue::tileSize));
+    }
+  }
+
+  static void closestFirst() {
+    const std::array<double, 2> focus{200.0, 30.0};
+    const std::vector<cl_uint4> rects = SubdivisionQueue::firstRects(cl::NDRange(256, 256), focus);
+    FRACTALISM_CHECK(rects.front().s[0] == 192 && rects.front().s[1] == 0);
+    for (size_t index = 1; index < rects.size(); index++) {
+      FRACTALISM_CHECK(focusDistance(rects[index - 1], focus) <= focusDistance(rects[index], focus));
+    }
+  }
+
+  // A single pixel has no border to compute, nothing is queued.
+  static void singlePixel() {
+    FRACTALISM_CHECK(SubdivisionQueue::firstRects(cl::NDRange(1, 1), {0.0, 0.0}).empty());
+  }
+}
+
+int main() {
+  using namespace fractalism::tests;
+  coversOutput();
+  sharedEdges();
+  closestFirst();
+  singlePixel();
+  return result();
+}
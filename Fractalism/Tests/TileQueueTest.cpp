@@ -0,0 +1,123 @@
+#include <algorithm>
+#include <vector>
+
+#include <Fractalism/GPU/OpenCL/TileQueue.hpp>
+#include <Fractalism/Tests/Check.hpp>
+
+namespace fractalism::tests {
+  using gpu::opencl::Tile;
+  using gpu::opencl::TileQueue;
+
+  static std::vector<Tile> takeAll(TileQueue& tiles) {
+    std::vector<Tile> taken;
+    while (!tiles.isEmpty()) {
+      const std::vector<Tile> batch = tiles.take(1);
+      taken.insert(taken.end(), batch.begin(), batch.end());
+    }
+    return taken;
+  }
+
+  // Every pixel is in exactly one tile, the edge tiles are cut short.
+  static void coversFrame() {
+    TileQueue tiles;
+    tiles.reset(130, 70, 1, 64);
+    const std::vector<Tile> taken = takeAll(tiles);
+    FRACTALISM_CHECK(taken.size() == 6);
+    std::vector<int> covered(130 * 70, 0);
+    for (const Tile& tile : taken) {
+      FRACTALISM_CHECK(tile.z == 0 && tile.depth == 1);
+      FRACTALISM_CHECK(tile.width == (tile.x == 128 ? 2u : 64u));
+      FRACTALISM_CHECK(tile.height == (tile.y == 64 ? 6u : 64u));
+      for (cl_uint y = tile.y; y < tile.y + tile.height; y++) {
+        for (cl_uint x = tile.x; x < tile.x + tile.width; x++) {
+          covered[y * 130 + x]++;
+        }
+      }
+    }
+    FRACTALISM_CHECK(std::all_of(covered.begin(), covered.end(), [](int count) { return count == 1; }));
+  }
+
+  static void singleTile() {
+    TileQueue tiles;
+    tiles.reset(100, 50, 1, 100);
+    const std::vector<Tile> taken = tiles.take(1);
+    FRACTALISM_CHECK(taken.size() == 1);
+    FRACTALISM_CHECK(taken[0].pixels() == 100 * 50);
+    FRACTALISM_CHECK(tiles.isEmpty());
+  }
+
+  static void closestFirst() {
+    TileQueue tiles;
+    tiles.reset(256, 256, 1, 64);
+    tiles.setFocus(250.0, 10.0);
+    std::vector<Tile> taken = tiles.take(1);
+    FRACTALISM_CHECK(taken.size() == 1);
+    FRACTALISM_CHECK(taken[0].x == 192 && taken[0].y == 0);
+    // Moves by less than a tile keep the order.
+    tiles.setFocus(200.0, 40.0);
+    taken = tiles.take(1);
+    FRACTALISM_CHECK((taken[0].x == 128 && taken[0].y == 0) || (taken[0].x == 192 && taken[0].y == 64));
+    tiles.setFocus(10.0, 250.0);
+    taken = tiles.take(1);
+    FRACTALISM_CHECK(taken[0].x == 0 && taken[0].y == 192);
+    // Each tile comes out no closer than the one before it.
+    double last = 0.0;
+    for (const Tile& tile : takeAll(tiles)) {
+      const double dx = tile.x + tile.width / 2.0 - 10.0;
+      const double dy = tile.y + tile.height / 2.0 - 250.0;
+      FRACTALISM_CHECK(dx * dx + dy * dy >= last);
+      last = dx * dx + dy * dy;
+    }
+  }
+
+  static void batches() {
+    TileQueue tiles;
+    tiles.reset(256, 256, 1, 64);
+    // At least one tile, even for no pixels.
+    FRACTALISM_CHECK(tiles.take(0).size() == 1);
+    // As many tiles as it takes to cover the pixels.
+    FRACTALISM_CHECK(tiles.take(64 * 64 * 2 + 1).size() == 3);
+    FRACTALISM_CHECK(tiles.take(size_t(1) << 20).size() == 12);
+    FRACTALISM_CHECK(tiles.isEmpty());
+    FRACTALISM_CHECK(tiles.take(1).empty());
+  }
+
+  static void clearDropsTiles() {
+    TileQueue tiles;
+    tiles.reset(256, 256, 1, 64);
+    tiles.take(1);
+    tiles.clear();
+    FRACTALISM_CHECK(tiles.isEmpty());
+  }
+
+  // Volumes are taken front to back from a camera outside of them.
+  static void frontToBack() {
+    TileQueue tiles;
+    tiles.reset(40, 40, 40, TileQueue::volumeSide);
+    tiles.setFocus(20.0, 20.0, -100.0);
+    std::vector<Tile> taken = takeAll(tiles);
+    FRACTALISM_CHECK(taken.size() == 27);
+    size_t pixels = 0;
+    for (const Tile& tile : taken) {
+      pixels += tile.pixels();
+    }
+    FRACTALISM_CHECK(pixels == 40 * 40 * 40);
+    FRACTALISM_CHECK(taken.front().z == 0);
+    FRACTALISM_CHECK(taken.back().z == 32 && taken.back().depth == 8);
+    FRACTALISM_CHECK(std::is_sorted(taken.begin(), taken.end(), [](const Tile& a, const Tile& b) {
+      return a.z < b.z;
+    }));
+    FRACTALISM_CHECK(taken.front().offset()[2] == 0 && taken.back().range()[2] == 8);
+  }
+}
+
+int main() {
+  using namespace fractalism::tests;
+  coversFrame();
+  singleTile();
+  closestFirst();
+  batches();
+  clearDropsTiles();
+  frontToBack();
+  return result();
+}
@@ -0,0 +1,124 @@
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <Fractalism/Exceptions.hpp>
+#include <Fractalism/Tests/Check.hpp>
+#include <Fractalism/Timeline.hpp>
+
+namespace fractalism::tests {
+  using namespace std::chrono_literals;
+
+  static const std::filesystem::path tracePath = std::filesystem::temp_directory_path() / "fractalism_timeline_test.json";
+
+  static std::string exportTrace(const Timeline& timeline) {
+    timeline.write(tracePath);
+    std::ifstream file(tracePath, std::ios::binary);
+    std::stringstream text;
+    text << file.rdbuf();
+    return text.str();
+  }
+
+  static size_t count(const std::string& text, const std::string& part) {
+    size_t found = 0;
+    for (size_t at = text.find(part); at != std::string::npos; at = text.find(part, at + part.size())) {
+      found++;
+    }
+    return found;
+  }
+
+  static void emptyTrace() {
+    const std::string trace = exportTrace(Timeline());
+    FRACTALISM_CHECK(trace.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"));
+    FRACTALISM_CHECK(trace.ends_with("\n]}\n"));
+    // Only the names of the host and OpenGL tracks.
+    FRACTALISM_CHECK(count(trace, "\"ph\":\"M\"") == 2);
+    FRACTALISM_CHECK(count(trace, "\"args\":{\"name\":\"Host\"}") == 1);
+    FRACTALISM_CHECK(count(trace, "\"args\":{\"name\":\"OpenGL\"}") == 1);
+    FRACTALISM_CHECK(count(trace, "\"ph\":\"X\"") == 0);
+  }
+
+  static void disabledRecordsNothing() {
+    Timeline timeline;
+    timeline.addSpan("Startup", Timeline::Category::task, Timeline::Clock::now(), 1ms);
+    timeline.beginFrame();
+    FRACTALISM_CHECK(count(exportTrace(timeline), "\"ph\":\"X\"") == 0);
+  }
+
+  static void spans() {
+    Timeline timeline;
+    timeline.setEnabled(true);
+    timeline.addSpan("Load \"scene\"\n", Timeline::Category::task, Timeline::Clock::now(), 2ms);
+    timeline.beginFrame();
+    timeline.addSpan("Draw", Timeline::Category::draw, Timeline::Clock::now(), 1500us, Timeline::glTrack);
+    timeline.beginFrame();
+    const std::string trace = exportTrace(timeline);
+    FRACTALISM_CHECK(count(trace, "\"name\":\"Load \\\"scene\\\"\\n\",\"cat\":\"task\"") == 1);
+    FRACTALISM_CHECK(count(trace, "\"dur\":2000.000,\"args\":{\"frame\":0}") == 1);
+    FRACTALISM_CHECK(count(trace, "\"name\":\"Draw\",\"cat\":\"draw\",\"ph\":\"X\",\"pid\":1,\"tid\":1,") == 1);
+    FRACTALISM_CHECK(count(trace, "\"dur\":1500.000,\"args\":{\"frame\":1}") == 1);
+    // The frame ended by the second beginFrame().
+    FRACTALISM_CHECK(count(trace, "\"name\":\"Frame 1\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":0,") == 1);
+    FRACTALISM_CHECK(count(trace, "\"ph\":\"X\"") == 3);
+  }
+
+  // The startup tasks outlive the frames, the spans of old frames don't.
+  static void oldFramesDropped() {
+    Timeline timeline;
+    timeline.setEnabled(true);
+    timeline.addSpan("Startup", Timeline::Category::task, Timeline::Clock::now(), 1ms);
+    timeline.beginFrame();
+    timeline.addSpan("First draw", Timeline::Category::draw, Timeline::Clock::now(), 1ms, Timeline::glTrack);
+    for (size_t i = 0; i < Timeline::maxFrames + 1; i++) {
+      timeline.beginFrame();
+    }
+    const std::string trace = exportTrace(timeline);
+    FRACTALISM_CHECK(count(trace, "\"name\":\"Startup\"") == 1);
+    FRACTALISM_CHECK(count(trace, "\"name\":\"First draw\"") == 0);
+    FRACTALISM_CHECK(count(trace, "\"name\":\"Frame 1\"") == 0);
+    FRACTALISM_CHECK(count(trace, "\"name\":\"Frame 2\"") == 1);
+    FRACTALISM_CHECK(count(trace, "\"cat\":\"frame\"") == Timeline::maxFrames);
+  }
+
+  static void summary() {
+    Timeline timeline;
+    timeline.setEnabled(true);
+    FRACTALISM_CHECK(timeline.summarize().draw == 0);
+    timeline.beginFrame();
+    timeline.addSpan("Draw", Timeline::Category::draw, Timeline::Clock::now(), 2ms, Timeline::glTrack);
+    timeline.beginFrame();
+    timeline.addSpan("Draw", Timeline::Category::draw, Timeline::Clock::now(), 4ms, Timeline::glTrack);
+    timeline.addSpan("Upload", Timeline::Category::transfer, Timeline::Clock::now(), 1ms);
+    // The current frame is not averaged yet.
+    FRACTALISM_CHECK(std::abs(timeline.summarize().draw - 2e-3) < 1e-9);
+    FRACTALISM_CHECK(timeline.summarize().transfer == 0);
+    timeline.beginFrame();
+    const Timeline::Summary summary = timeline.summarize();
+    FRACTALISM_CHECK(std::abs(summary.draw - 3e-3) < 1e-9);
+    FRACTALISM_CHECK(std::abs(summary.transfer - 0.5e-3) < 1e-9);
+    FRACTALISM_CHECK(summary.kernel == 0);
+    FRACTALISM_CHECK(summary.frame > 0);
+  }
+
+  static void unwritable() {
+    Timeline timeline;
+    FRACTALISM_CHECK(throws<FractalismError>([&timeline] {
+      timeline.write(std::filesystem::temp_directory_path() / "fractalism_missing_directory" / "trace.json");
+    }));
+  }
+}
+
+int main() {
+  using namespace fractalism::tests;
+  emptyTrace();
+  disabledRecordsNothing();
+  spans();
+  oldFramesDropped();
+  summary();
+  unwritable();
+  std::filesystem::remove(tracePath);
+  return result();
+}
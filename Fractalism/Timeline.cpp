@@ -0,0 +1,260 @@
+#include <Fractalism/Timeline.hpp>
+
+#include <format>
+#include <fstream>
+#include <set>
+
+#include <Fractalism/Exceptions.hpp>
+
+namespace fractalism {
+  static inline const char* categoryName(Timeline::Category category) {
+    switch (category) {
+    case Timeline::Category::frame:
+      return "frame";
+    case Timeline::Category::task:
+      return "task";
+    case Timeline::Category::kernel:
+      return "kernel";
+    case Timeline::Category::transfer:
+      return "transfer";
+    case Timeline::Category::draw:
+      return "draw";
+    default:
+      throw AssertionError("Invalid timeline category");
+    }
+  }
+
+  static inline std::string escapeJson(const std::string& text) {
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (char c : text) {
+      switch (c) {
+      case '"':
+        escaped += "\\\"";
+        break;
+      case '\\':
+        escaped += "\\\\";
+        break;
+      case '\n':
+        escaped += "\\n";
+        break;
+      default:
+        escaped += c;
+      }
+    }
+    return escaped;
+  }
+
+  Timeline::Timeline() :
+        mutex(),
+        enabled(false),
+        epoch(Clock::now()),
+        spans(),
+        tasks(),
+        pending(),
+        queueTracks(),
+        trackNames{"Host", "OpenGL"},
+        frame(0),
+        frameStart(epoch) {}
+
+  void Timeline::setEnabled(bool enabled) {
+    std::lock_guard lock(mutex);
+    this->enabled = enabled;
+    if (!enabled) {
+      pending.clear();
+    }
+  }
+
+  bool Timeline::isEnabled() const {
+    std::lock_guard lock(mutex);
+    return enabled;
+  }
+
+  void Timeline::beginFrame() {
+    std::lock_guard lock(mutex);
+    if (!enabled) {
+      return;
+    }
+    const Clock::time_point now = Clock::now();
+    if (frame) {
+      spans.push_back(Span{
+        std::format("Frame {}", frame),
+        Category::frame,
+        hostTrack,
+        toMicroseconds(frameStart),
+        toMicroseconds(now) - toMicroseconds(frameStart),
+        frame});
+    }
+    resolve();
+    frame++;
+    frameStart = now;
+    while (!spans.empty() && spans.front().frame + maxFrames < frame) {
+      spans.pop_front();
+    }
+  }
+
+  void Timeline::record(const cl::Event& event, const std::string& name, Category category) {
+    if (!event()) {
+      return;
+    }
+    std::lock_guard lock(mutex);
+    if (!enabled) {
+      return;
+    }
+    pending.push_back(PendingCommand{event, name, category, Clock::now(), frame});
+    if (pending.size() > maxPending) {
+      pending.pop_front();
+    }
+  }
+
+  void Timeline::nameQueue(const cl::CommandQueue& queue, const std::string& name) {
+    std::lock_guard lock(mutex);
+    trackNames[queueTrack(queue())] = name;
+  }
+
+  void Timeline::addSpan(
+      const std::string& name,
+      Category category,
+      Clock::time_point start,
+      Clock::duration duration,
+      uint32_t track) {
+    std::lock_guard lock(mutex);
+    if (!enabled) {
+      return;
+    }
+    const Span span{
+      name,
+      category,
+      track,
+      toMicroseconds(start),
+      std::chrono::duration<double, std::micro>(duration).count(),
+      frame};
+    if (category == Category::task && !frame) {
+      tasks.push_back(span);
+    } else {
+      spans.push_back(span);
+    }
+  }
+
+  Timeline::Summary Timeline::summarize() const {
+    std::lock_guard lock(mutex);
+    Summary summary{};
+    // The current frame is still being recorded.
+    const uint64_t last = frame ? frame - 1 : 0;
+    const uint64_t first = last > summaryFrames ? last - summaryFrames + 1 : 1;
+    if (!last) {
+      return summary;
+    }
+    for (const Span& span : spans) {
+      if (span.frame < first || span.frame > last) {
+        continue;
+      }
+      const double seconds = span.duration * 1e-6;
+      switch (span.category) {
+      case Category::frame:
+        summary.frame += seconds;
+        break;
+      case Category::kernel:
+        summary.kernel += seconds;
+        break;
+      case Category::transfer:
+        summary.transfer += seconds;
+        break;
+      case Category::draw:
+        summary.draw += seconds;
+        break;
+      default:
+        break;
+      }
+    }
+    const double frames = static_cast<double>(last - first + 1);
+    summary.frame /= frames;
+    summary.kernel /= frames;
+    summary.transfer /= frames;
+    summary.draw /= frames;
+    return summary;
+  }
+
+  void Timeline::write(const std::filesystem::path& path) const {
+    std::lock_guard lock(mutex);
+    std::ofstream file(path, std::ios::binary);
+    if (!file) {
+      throw FractalismError(std::format("Could not open {} for writing", path.string()));
+    }
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto writeSpan = [&file, &first](const Span& span) {
+      file << std::format(
+        "{}{{\"name\":\"{}\",\"cat\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f},\"args\":{{\"frame\":{}}}}}",
+        first ? "" : ",\n",
+        escapeJson(span.name),
+        categoryName(span.category),
+        span.track,
+        span.start,
+        span.duration,
+        span.frame);
+      first = false;
+    };
+    for (size_t track = 0; track < trackNames.size(); track++) {
+      file << std::format(
+        "{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+        first ? "" : ",\n",
+        track,
+        escapeJson(trackNames[track]));
+      first = false;
+    }
+    for (const Span& span : tasks) {
+      writeSpan(span);
+    }
+    for (const Span& span : spans) {
+      writeSpan(span);
+    }
+    file << "\n]}\n";
+    file.flush();
+    if (!file) {
+      throw FractalismError(std::format("Could not write {}", path.string()));
+    }
+  }
+
+  void Timeline::resolve() {
+    std::set<cl_command_queue> blocked;
+    for (auto it = pending.begin(); it != pending.end();) {
+      cl_command_queue queue = nullptr;
+      try {
+        queue = it->event.getInfo<CL_EVENT_COMMAND_QUEUE>()();
+        // Commands on a queue complete in order, the later ones wait too.
+        if (blocked.contains(queue)
+            || it->event.getInfo<CL_EVENT_COMMAND_EXECUTION_STATUS>() > CL_COMPLETE) {
+          blocked.insert(queue);
+          ++it;
+          continue;
+        }
+        const cl_ulong queued = it->event.getProfilingInfo<CL_PROFILING_COMMAND_QUEUED>();
+        const cl_ulong start = it->event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+        const cl_ulong end = it->event.getProfilingInfo<CL_PROFILING_COMMAND_END>();
+        spans.push_back(Span{
+          it->name,
+          it->category,
+          queueTrack(queue),
+          toMicroseconds(it->recorded) + static_cast<double>(start - queued) * 1e-3,
+          static_cast<double>(end - start) * 1e-3,
+          it->frame});
+      } catch (const cl::Error&) {
+        // No profiling information, or the command failed.
+      }
+      it = pending.erase(it);
+    }
+  }
+
+  uint32_t Timeline::queueTrack(cl_command_queue queue) {
+    auto [it, added] = queueTracks.try_emplace(queue, static_cast<uint32_t>(trackNames.size()));
+    if (added) {
+      trackNames.push_back(std::format("OpenCL queue {}", queueTracks.size()));
+    }
+    return it->second;
+  }
+
+  double Timeline::toMicroseconds(Clock::time_point time) const {
+    return std::chrono::duration<double, std::micro>(time - epoch).count();
+  }
+}
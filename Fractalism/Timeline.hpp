@@ -0,0 +1,195 @@
+#ifndef _FRACTALISM_TIMELINE_HPP_
+#define _FRACTALISM_TIMELINE_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <Fractalism/GPU/OpenCL/CLCommon.hpp>
+
+namespace fractalism {
+
+/**
+ * @class Timeline
+ * @brief Records where the time of each frame goes, on the host, on the
+ * OpenCL queues and in OpenGL, for a rolling summary and for export as a
+ * Chrome trace.
+ *
+ * OpenCL commands are recorded by their events, and timed from their
+ * profiling information once they completed, which needs queues with
+ * profiling enabled. Commands without it, like user events, are dropped.
+ * Device timestamps are moved onto the host clock by the time the command
+ * was queued, which is about when it was recorded.
+ *
+ * Only the spans of the last maxFrames frames are kept. Tasks recorded before
+ * the first frame, the startup phases, are kept for good, later ones go with
+ * their frame.
+ */
+class Timeline {
+public:
+  using Clock = std::chrono::steady_clock; ///< The host clock spans are placed on.
+
+  static constexpr size_t maxFrames = 600;    ///< The frames kept for export, 10 s at 60 Hz.
+  static constexpr size_t summaryFrames = 60; ///< The frames summarize() averages over.
+  static constexpr size_t maxPending = 4096;  ///< The most OpenCL commands waiting to complete, older ones are dropped.
+  static constexpr uint32_t hostTrack = 0;    ///< The track of the frames and tasks.
+  static constexpr uint32_t glTrack = 1;      ///< The track of OpenGL drawing.
+
+  /**
+   * @enum Category
+   * @brief What a span spent its time on.
+   */
+  enum class Category {
+    frame,    ///< A whole frame of the UI.
+    task,     ///< A task shown with a status message, like the startup phases.
+    kernel,   ///< An OpenCL kernel.
+    transfer, ///< Memory moved or synchronized between OpenCL, OpenGL and the host.
+    draw      ///< OpenGL drawing a view.
+  };
+
+  /**
+   * @struct Summary
+   * @brief The average time per frame over the last frames, in seconds.
+   */
+  struct Summary {
+    double frame;    ///< From the start of a frame to the start of the next.
+    double kernel;   ///< In OpenCL kernels.
+    double transfer; ///< In OpenCL transfers and synchronization.
+    double draw;     ///< In OpenGL drawing.
+  };
+
+  /**
+   * @brief Constructs a disabled timeline.
+   */
+  Timeline();
+
+  /**
+   * @brief Enables or disables recording. Disabled, nothing is recorded, so
+   * that callers that never start frames don't pile up spans.
+   * @param enabled Whether to record.
+   */
+  void setEnabled(bool enabled);
+
+  /**
+   * @brief Checks if spans are recorded.
+   * @return True if enabled.
+   */
+  bool isEnabled() const;
+
+  /**
+   * @brief Ends the current frame and starts the next. Times the OpenCL
+   * commands that completed meanwhile.
+   */
+  void beginFrame();
+
+  /**
+   * @brief Records an OpenCL command, timed once it completed. It goes on
+   * the track of its queue.
+   * @param event The event of the command.
+   * @param name The name of the span.
+   * @param category What the command does.
+   */
+  void record(const cl::Event& event, const std::string& name, Category category);
+
+  /**
+   * @brief Names the track of an OpenCL queue. Queues without a name are
+   * numbered.
+   * @param queue The queue.
+   * @param name The name of its track.
+   */
+  void nameQueue(const cl::CommandQueue& queue, const std::string& name);
+
+  /**
+   * @brief Records a span that was timed already.
+   * @param name The name of the span.
+   * @param category What the span spent its time on.
+   * @param start When it started, on the host clock.
+   * @param duration How long it took.
+   * @param track The track it goes on, hostTrack or glTrack.
+   */
+  void addSpan(
+      const std::string& name,
+      Category category,
+      Clock::time_point start,
+      Clock::duration duration,
+      uint32_t track = hostTrack);
+
+  /**
+   * @brief Averages the spans of the last complete frames.
+   * @return The average time per frame, zeros before the first frame ended.
+   */
+  Summary summarize() const;
+
+  /**
+   * @brief Writes the kept spans as a Chrome trace, for chrome://tracing or
+   * Perfetto. Each span has the number of its frame as an argument.
+   * @param path The file to write.
+   * @throws FractalismError if the file could not be written.
+   */
+  void write(const std::filesystem::path& path) const;
+
+private:
+  /**
+   * @struct Span
+   * @brief A timed piece of work.
+   */
+  struct Span {
+    std::string name;  ///< What was done.
+    Category category; ///< What it spent its time on.
+    uint32_t track;    ///< The track it is drawn on.
+    double start;      ///< When it started, in microseconds since the timeline was constructed.
+    double duration;   ///< How long it took, in microseconds.
+    uint64_t frame;    ///< The frame it was recorded in, 0 before the first.
+  };
+
+  /**
+   * @struct PendingCommand
+   * @brief An OpenCL command that is not timed yet.
+   */
+  struct PendingCommand {
+    cl::Event event;            ///< The event of the command.
+    std::string name;           ///< The name of the span.
+    Category category;          ///< What the command does.
+    Clock::time_point recorded; ///< When it was recorded, about when it was queued.
+    uint64_t frame;             ///< The frame it was recorded in.
+  };
+
+  /**
+   * @brief Times the pending commands that completed. Must hold mutex.
+   */
+  void resolve();
+
+  /**
+   * @brief Gets the track of a queue, adding one if it has none. Must hold
+   * mutex.
+   * @param queue The queue.
+   * @return The track.
+   */
+  uint32_t queueTrack(cl_command_queue queue);
+
+  /**
+   * @brief Converts a host time to microseconds since the construction.
+   * @param time The time.
+   * @return The microseconds.
+   */
+  double toMicroseconds(Clock::time_point time) const;
+
+  mutable std::mutex mutex;                                   ///< Tasks may be timed on worker threads.
+  bool enabled;                                               ///< Whether spans are recorded.
+  Clock::time_point epoch;                                    ///< The time span starts are measured from.
+  std::deque<Span> spans;                                     ///< The spans of the kept frames, oldest first.
+  std::vector<Span> tasks;                                    ///< The tasks before the first frame, kept for good.
+  std::deque<PendingCommand> pending;                         ///< The OpenCL commands not timed yet.
+  std::unordered_map<cl_command_queue, uint32_t> queueTracks; ///< The track of each queue.
+  std::vector<std::string> trackNames;                        ///< The name of each track.
+  uint64_t frame;                                             ///< The number of the current frame, 0 before the first.
+  Clock::time_point frameStart;                               ///< When the current frame started.
+};
+} // namespace fractalism
+
+#endif
@@ -9,20 +9,20 @@ namespace fractalism::ui::controls {
         wxAuiToolBar(&parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxAUI_TB_TEXT | wxAUI_TB_VERTICAL),
         settings(settings),
         iterationModifier(*new wxSlider(this, wxID_ANY, settings.iterationModifier / 5, 1, 100)),
-        iterationsPerFrame(*new wxSlider(this, wxID_ANY, settings.iterationsPerFrame, 1, 1000)) {
+        priority(*new wxSlider(this, wxID_ANY, settings.priority, 1, 10)) {
     AddLabel(iterationModifier.GetId(), "Iteration Modifier");
     AddControl(&iterationModifier);
-    AddLabel(iterationsPerFrame.GetId(), "Iterations Per Frame");
-    AddControl(&iterationsPerFrame);
+    AddLabel(priority.GetId(), "Priority");
+    AddControl(&priority);
 
     iterationModifier.Bind(wxEVT_SLIDER, [this, &iterationModifier = settings.iterationModifier](wxCommandEvent& evt) {
       iterationModifier = evt.GetInt() * 5.0;
       events::IterationModifierChanged::fire(this, iterationModifier);
     });
 
-    iterationsPerFrame.Bind(wxEVT_SLIDER, [this, &iterationsPerFrame = settings.iterationsPerFrame](wxCommandEvent& evt) {
-      iterationsPerFrame = evt.GetInt();
-      events::IterationsPerFrameChanged::fire(this, iterationsPerFrame);
+    priority.Bind(wxEVT_SLIDER, [this, &priority = settings.priority](wxCommandEvent& evt) {
+      priority = evt.GetInt();
+      events::PriorityChanged::fire(this, priority);
     });
     Realize();
   }
@@ -31,7 +31,7 @@ namespace fractalism::ui::controls {
     iterationModifier.SetValue(settings.iterationModifier / 5);
   }
 
-  void IterationToolBar::updateIterationsPerFrame() {
-    iterationsPerFrame.SetValue(settings.iterationsPerFrame);
+  void IterationToolBar::updatePriority() {
+    priority.SetValue(settings.priority);
   }
 }
\ No newline at end of file
@@ -25,14 +25,14 @@ public:
   void updateIterationModifier();
 
   /**
-   * @brief Updates the iterations per frame.
+   * @brief Updates the priority.
    */
-  void updateIterationsPerFrame();
+  void updatePriority();
 
 private:
   ViewWindowSettings& settings; ///< The view window settings.
   wxSlider& iterationModifier;  ///< Slider for the iteration modifier.
-  wxSlider& iterationsPerFrame; ///< Slider for the iterations per frame.
+  wxSlider& priority;           ///< Slider for the priority.
 };
 } // namespace fractalism::ui::controls
 
@@ -1,5 +1,8 @@
 #include <Fractalism/UI/Controls/RenderSettingsToolBar.hpp>
 
+#include <algorithm>
+#include <format>
+
 #include <Fractalism/App.hpp>
 #include <Fractalism/Events.hpp>
 #include <Fractalism/Settings.hpp>
@@ -8,20 +11,43 @@ namespace fractalism::ui::controls {
   
   namespace {
     wxString dimensionLabels[] = { "2D", "3D" };
+    constexpr cl::size_type resolutionStep = 64;
+
+    // The largest step of the slider up to a resolution whose output fits on
+    // the device.
+    cl::size_type fittingResolution(cl::size_type resolution) {
+      const options::Dimensions renderDimensions = App::get<Settings>().renderDimensions;
+      const cl::size_type limit = App::get<gpu::opencl::ProgramManager>().maxResolution(renderDimensions);
+      if (resolution <= limit) {
+        return resolution;
+      }
+      Core::warn(std::format(
+        "A resolution of {} does not fit on the device in {}D.",
+        resolution,
+        renderDimensions == options::Dimensions::three ? 3 : 2));
+      return std::max(limit / resolutionStep * resolutionStep, resolutionStep);
+    }
   }
 
   RenderSettingsToolBar::RenderSettingsToolBar(wxWindow& parent) :
         wxAuiToolBar(&parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxAUI_TB_TEXT | wxAUI_TB_VERTICAL),
         dimensions(*new wxRadioBox(this, wxID_ANY, "Dimensions", wxDefaultPosition, wxDefaultSize, 2, dimensionLabels)),
-        resolution(*new wxSlider(this, wxID_ANY, App::get<Settings>().resolution[0] / 64, 1, 20)) {
+        resolution(*new wxSlider(this, wxID_ANY, App::get<Settings>().resolution[0] / resolutionStep, 1, 20)) {
     AddControl(&dimensions);
     AddLabel(resolution.GetId(), "Resolution");
     AddControl(&resolution);
     dimensions.Bind(wxEVT_RADIOBOX, [this](wxCommandEvent& evt) {
-      events::RenderDimensionsChanged::fire(this, App::get<Settings>().setRenderDimensions(utils::fromUnderlyingType<options::Dimensions>(evt.GetInt())));
+      Settings& settings = App::get<Settings>();
+      settings.setRenderDimensions(utils::fromUnderlyingType<options::Dimensions>(evt.GetInt()));
+      // A resolution that fits in 2D may not in 3D.
+      settings.setResolution(fittingResolution(settings.resolution[0]));
+      updateResolution();
+      events::RenderDimensionsChanged::fire(this, settings.renderDimensions);
     });
     resolution.Bind(wxEVT_SLIDER, [this](wxCommandEvent& evt) {
-      events::ResolutionChanged::fire(this, App::get<Settings>().setResolution(static_cast<cl::size_type>(evt.GetInt()) * 64));
+      App::get<Settings>().setResolution(fittingResolution(static_cast<cl::size_type>(evt.GetInt()) * resolutionStep));
+      updateResolution();
+      events::ResolutionChanged::fire(this, App::get<Settings>().resolution);
     });
     updateRenderDimensions();
     updateResolution();
@@ -33,6 +59,6 @@ namespace fractalism::ui::controls {
   }
 
   void RenderSettingsToolBar::updateResolution() {
-    resolution.SetValue(App::get<Settings>().resolution[0] / 64);
+    resolution.SetValue(App::get<Settings>().resolution[0] / resolutionStep);
   }
 }
\ No newline at end of file
@@ -1,15 +1,17 @@
 #include <Fractalism/UI/Controls/ZoomControl.hpp>
 
+#include <algorithm>
 #include <limits>
 #include <cmath>
 
+#include <Fractalism/App.hpp>
 #include <Fractalism/Events.hpp>
 
 namespace fractalism::ui::controls {
   namespace {
     static const real lnMax(std::log(gpu::types::Viewspace::maxZoom));
     static const real lnMin(std::log(gpu::types::Viewspace::minZoom));
-    static const unsigned int sliderSteps(100);
+    static const unsigned int sliderSteps(1000);
 
     static int zoomToInt(real zoom) {
       static const real modifier = real(sliderSteps) / (lnMax - lnMin);
@@ -34,7 +36,7 @@ namespace fractalism::ui::controls {
     wxSizer* sizer = new wxBoxSizer(wxVERTICAL);
     sizer->Add(&slider);
     slider.Bind(wxEVT_SLIDER, [this](wxCommandEvent& evt) {
-      this->zoom = intToZoom(evt.GetInt());
+      this->zoom = std::min(intToZoom(evt.GetInt()), App::get<gpu::opencl::ProgramManager>().maxZoom());
       events::ZoomChanged::fire(this, this->zoom);
     });
     SetSizerAndFit(sizer);
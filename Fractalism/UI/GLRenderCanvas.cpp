@@ -29,7 +29,8 @@ namespace fractalism::ui {
           wxDefaultSize,
           wxFULL_REPAINT_ON_RESIZE,
           "GLRenderCanvas"),
-        lastPoint(types::Coordinates::none) {
+        lastPoint(types::Coordinates::none),
+        panRemainder{0.0, 0.0} {
 
     SetCursor(*wxCROSS_CURSOR);
     const auto clearLastPoint = [this](wxMouseEvent&) { setLastPoint(types::Coordinates::none); };
@@ -45,7 +46,7 @@ namespace fractalism::ui {
         settings.view.zoom = std::clamp(
           std::exp(std::log(settings.view.zoom) + delta),
           gpu::types::Viewspace::minZoom,
-          gpu::types::Viewspace::maxZoom);
+          App::get<gpu::opencl::ProgramManager>().maxZoom());
         events::ZoomChanged::fire(this, settings.view);
         break;
       }
@@ -58,6 +59,9 @@ namespace fractalism::ui {
     });
 
     const auto mouseHandler = [this, &settings](wxMouseEvent& evt) {
+      if (evt.ButtonDown()) {
+        panRemainder = {0.0, 0.0};
+      }
       if (evt.ButtonDown() && !HasCapture()) {
         CaptureMouse();
       } else if (evt.ButtonUp() && HasCapture()) {
@@ -68,8 +72,23 @@ namespace fractalism::ui {
         types::Coordinates delta = lastPoint - currentPoint;
         switch (App::get<Settings>().renderDimensions) {
         case options::Dimensions::two: {
-          settings.view += delta;
-          events::ViewCenterChanged::fire(this, settings.view);
+          // Moved by whole pixels of the output, the kernels then keep the
+          // pixels that stay on screen.
+          delta = delta + panRemainder;
+          const cl::NDRange& resolution = App::get<Settings>().resolution;
+          const types::Coordinates pixels = {
+            std::round(delta.x * static_cast<real>(resolution[0]) / 2.0),
+            std::round(delta.y * static_cast<real>(resolution[1]) / 2.0)
+          };
+          const types::Coordinates snapped = {
+            pixels.x * 2.0 / static_cast<real>(resolution[0]),
+            pixels.y * 2.0 / static_cast<real>(resolution[1])
+          };
+          panRemainder = delta - snapped;
+          if (pixels.x != 0.0 || pixels.y != 0.0) {
+            settings.view += snapped;
+            events::ViewCenterChanged::fire(this, settings.view);
+          }
           break;
         }
         case options::Dimensions::three: {
@@ -26,8 +26,16 @@ public:
       ViewWindowSettings& settings,
       wxStatusBar& statusBar);
 
+  /**
+   * @brief Gets the last point hovered over.
+   * @return The point, in [-1, 1] with y up, or
+   * gpu::types::Coordinates::none if the cursor left the canvas.
+   */
+  inline const gpu::types::Coordinates& getLastPoint() const { return lastPoint; }
+
 private:
-  gpu::types::Coordinates lastPoint; ///< The last point hovered over.
+  gpu::types::Coordinates lastPoint;    ///< The last point hovered over.
+  gpu::types::Coordinates panRemainder; ///< The part of the drag not panned yet, less than an output pixel.
 
   /**
    * @brief Sets the last point hovered over.
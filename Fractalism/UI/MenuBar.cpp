@@ -1,16 +1,20 @@
 #include <Fractalism/UI/MenuBar.hpp>
 
+#include <wx/filedlg.h>
+
 #include <Fractalism/App.hpp>
 
 namespace fractalism::ui {
   namespace {
     enum {
-      ReloadShaders = wxID_HIGHEST + 1
+      ReloadShaders = wxID_HIGHEST + 1,
+      SaveTimeline
     };
   }
   MenuBar::MenuBar() {
     wxMenu* menuFile = new wxMenu;
     menuFile->Append(ReloadShaders, "&Reload Shaders\tCtrl-R", "Reload the active shaders from disk");
+    menuFile->Append(SaveTimeline, "Save &Timeline...\tCtrl-T", "Save where the time of the last frames went as a Chrome trace");
     menuFile->AppendSeparator();
     menuFile->Append(wxID_EXIT);
     Append(menuFile, "&File");
@@ -22,6 +26,23 @@ namespace fractalism::ui {
     Bind(wxEVT_MENU, [](wxCommandEvent&) {
       App::reloadShaders();
     }, ReloadShaders);
+    Bind(wxEVT_MENU, [](wxCommandEvent&) {
+      wxFileDialog dialog(
+        &App::get<wxFrame>(),
+        "Save Timeline",
+        wxEmptyString,
+        "timeline.json",
+        "Chrome trace (*.json)|*.json",
+        wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+      if (dialog.ShowModal() != wxID_OK) {
+        return;
+      }
+      try {
+        App::get<Timeline>().write(std::filesystem::path(dialog.GetPath().ToStdWstring()));
+      } catch (const FractalismError& e) {
+        wxMessageBox(e.what(), "Could not save the timeline", wxOK | wxICON_ERROR);
+      }
+    }, SaveTimeline);
     Bind(wxEVT_MENU, [](wxCommandEvent&) {
       wxMessageBox("A unique application for fractal rendering and exploration.", "About Fractalism", wxOK | wxICON_INFORMATION);
     }, wxID_ABOUT);
@@ -162,6 +162,15 @@ namespace fractalism::ui {
     if (isnan(fps) || isinf(fps)) {
       fps = 0.0;
     }
-    SetStatusText(std::format("{:.02f} FPS @ {}", fps, App::get<Settings>().resolution));
+    // Where the time of the last frames went, per frame.
+    const Timeline::Summary summary = App::get<Timeline>().summarize();
+    SetStatusText(std::format(
+      "{:.02f} FPS @ {} | frame {:.1f} ms: CL kernels {:.1f} ms, CL transfers {:.1f} ms, GL {:.1f} ms",
+      fps,
+      App::get<Settings>().resolution,
+      summary.frame * 1e3,
+      summary.kernel * 1e3,
+      summary.transfer * 1e3,
+      summary.draw * 1e3));
   }
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include <Fractalism/UI/ViewWindow.hpp>
 
+#include <algorithm>
 #include<format>
 
 #include <Fractalism/App.hpp>
@@ -10,7 +11,8 @@
 namespace fractalism::ui {
   ViewWindow::ViewWindow(wxWindow& parent, size_t index) :
       wxPanel(&parent),
-      kernel(index),
+      texture(),
+      kernel(index, texture),
       statusBar(*new wxStatusBar(this, wxID_ANY, wxSTB_SHOW_TIPS | wxSTB_ELLIPSIZE_END | wxFULL_REPAINT_ON_RESIZE)),
       renderCanvas(*new GLRenderCanvas(*new wxPanel(this), kernel.settings, statusBar)),
       viewspaceToolBar(*new controls::ViewspaceToolBar(*this, kernel.settings.view)),
@@ -47,7 +49,7 @@ namespace fractalism::ui {
       .CaptionVisible(true)
       .Dock()
       .Left()
-      .Show(kernel.settings.renderMode == options::RenderMode::escape)
+      .Show(kernel.settings.renderMode != options::RenderMode::translated)
       .CloseButton(false)
       .Gripper(false)
       .Floatable(false)
@@ -77,7 +79,7 @@ namespace fractalism::ui {
     });
     renderCanvas.Bind(events::ZoomChanged::tag, [this](events::ZoomChanged::eventType& event) {
       viewspaceToolBar.updateZoom();
-      statusBar.SetStatusText(std::format("zoom: {:.2f}", event.getValue()), 1);
+      statusBar.SetStatusText(std::format("zoom: {:.4g}", event.getValue()), 1);
       onViewChanged();
     });
     viewspaceToolBar.Bind(events::ViewCenterChanged::tag, [this](events::ViewCenterChanged::eventType& event) {
@@ -87,14 +89,14 @@ namespace fractalism::ui {
       onViewChanged();
     });
     viewspaceToolBar.Bind(events::ZoomChanged::tag, [this](events::ZoomChanged::eventType& event) {
-      statusBar.SetStatusText(std::format("zoom: {:.2f}", event.getValue()), 1);
+      statusBar.SetStatusText(std::format("zoom: {:.4g}", event.getValue()), 1);
       onViewChanged();
     });
     iterationToolBar.Bind(events::IterationModifierChanged::tag, [this](events::IterationModifierChanged::eventType& event) {
       statusBar.SetStatusText(std::format("Iteration Modifier: {:.4f}", event.getValue()), 2);
     });
-    iterationToolBar.Bind(events::IterationsPerFrameChanged::tag, [this](events::IterationsPerFrameChanged::eventType& event) {
-      statusBar.SetStatusText(std::format("Iterations Per Frame: {}", event.getValue()), 3);
+    iterationToolBar.Bind(events::PriorityChanged::tag, [this](events::PriorityChanged::eventType& event) {
+      statusBar.SetStatusText(std::format("Priority: {}", event.getValue()), 3);
     });
     // TODO: implement center parameter, screenshot, and video capture tools.
 
@@ -106,30 +108,49 @@ namespace fractalism::ui {
     viewspaceToolBar.updateRenderDimensions();
     // These are fine. They are picked up on kernel execution.
     updateIterationModifier();
-    updateIterationsPerFrame();
-    statusBar.SetStatusText(std::format("zoom: {:.2f}", kernel.settings.view.zoom), 1);
+    updatePriority();
+    statusBar.SetStatusText(std::format("zoom: {:.4g}", kernel.settings.view.zoom), 1);
     auiManager.Update();
   }
 
   void ViewWindow::init() {
+    // Interaction resets the kernel, coarse levels keep it responsive.
+    kernel.setProgressive(true);
+    kernel.setSubdivision(true);
     kernel.updateKernel();
   }
 
   void ViewWindow::maybeClearTexture() {
+    // Translated mode draws from scratch every frame, except while the last
+    // frame stands in for a kernel that is being built.
     if (kernel.settings.renderMode == options::RenderMode::translated
         && IsShownOnScreen()
+        && kernel.isReady()
+        && kernel.isFrameDone()
         && kernel.needsMore()) {
-      kernel.texture.clear();
+      kernel.clearTexture();
     }
   }
 
   void ViewWindow::enqueueRender(std::vector<cl::Event>& waitEvents) {
     if (IsShownOnScreen()) {
-      glFinish();
-      if (kernel.needsMore()) {
-        kernel.enqueue(waitEvents).wait();
+      const wxSize canvasSize = renderCanvas.GetSize();
+      kernel.setCanvasSize(
+        static_cast<cl_uint>(std::max(canvasSize.GetWidth(), 1)),
+        static_cast<cl_uint>(std::max(canvasSize.GetHeight(), 1)));
+      // One frame in flight, the last finished one is drawn meanwhile.
+      if (kernel.needsMore() && kernel.isFrameDone()) {
+        kernel.setFocus(renderCanvas.getLastPoint());
+        kernel.enqueue(waitEvents);
       }
-      App::get<gpu::GPU>().renderer.render(kernel.settings, renderCanvas, kernel.texture);
+      // The bricks belong to the texture present() picks.
+      const GLuint frameTexture = texture.present();
+      App::get<gpu::GPU>().renderer.render(
+        kernel.settings,
+        renderCanvas,
+        frameTexture,
+        texture.presentedBricks(),
+        kernel.getShownFrame());
     }
   }
 
@@ -142,7 +163,7 @@ namespace fractalism::ui {
     viewspaceToolBar.updateCenter();
     viewspaceToolBar.updateViewMapping();
     viewspaceToolBar.updateZoom();
-    statusBar.SetStatusText(std::format("zoom: {:.2f}", kernel.settings.view.zoom), 1);
+    statusBar.SetStatusText(std::format("zoom: {:.4g}", kernel.settings.view.zoom), 1);
   }
 
   void ViewWindow::updateCenter() {
@@ -158,7 +179,7 @@ namespace fractalism::ui {
   void ViewWindow::updateZoom() {
     kernel.updateView();
     viewspaceToolBar.updateZoom();
-    statusBar.SetStatusText(std::format("zoom: {:.2f}", kernel.settings.view.zoom), 1);
+    statusBar.SetStatusText(std::format("zoom: {:.4g}", kernel.settings.view.zoom), 1);
   }
 
   void ViewWindow::updateNumberSystem() {
@@ -176,9 +197,13 @@ namespace fractalism::ui {
     statusBar.SetStatusText(std::format("Iteration Modifier: {:.4f}", kernel.settings.iterationModifier), 2);
   }
 
-  void ViewWindow::updateIterationsPerFrame() {
-    iterationToolBar.updateIterationsPerFrame();
-    statusBar.SetStatusText(std::format("Iterations Per Frame: {}", kernel.settings.iterationsPerFrame), 3);
+  void ViewWindow::updatePriority() {
+    iterationToolBar.updatePriority();
+    statusBar.SetStatusText(std::format("Priority: {}", kernel.settings.priority), 3);
+  }
+
+  cl_uint ViewWindow::getSchedulingWeight() const {
+    return IsShownOnScreen() && kernel.needsMore() ? kernel.settings.priority : 0;
   }
 
   void ViewWindow::onViewChanged() {
@@ -2,6 +2,7 @@
 #define _FRACTALISM_VIEW_WINDOW_HPP_
 
 #include <Fractalism/GPU/OpenCL/KernelExecutor.hpp>
+#include <Fractalism/GPU/OpenGL/GLTextureTarget.hpp>
 #include <Fractalism/UI/Controls/IterationToolBar.hpp>
 #include <Fractalism/UI/Controls/ViewspaceToolBar.hpp>
 #include <Fractalism/UI/GLRenderCanvas.hpp>
@@ -41,7 +42,8 @@ public:
   void maybeClearTexture();
 
   /**
-   * @brief Enqueues a render operation.
+   * @brief Enqueues the next frame, unless the last one is still running,
+   * and draws the newest finished frame.
    * @param waitEvents A vector of events to wait for before rendering.
    */
   void enqueueRender(std::vector<cl::Event>& waitEvents);
@@ -93,9 +95,21 @@ public:
   void updateIterationModifier();
 
   /**
-   * @brief Updates the iterations per frame.
+   * @brief Updates the priority.
    */
-  void updateIterationsPerFrame();
+  void updatePriority();
+
+  /**
+   * @brief Gets the weight of the window in splitting the frame time.
+   * @return The priority if the window is shown and computing, 0 otherwise.
+   */
+  cl_uint getSchedulingWeight() const;
+
+  /**
+   * @brief Sets the device time the window's next frame may take.
+   * @param seconds The window's share of the frame time.
+   */
+  inline void setFrameBudget(double seconds) { kernel.setFrameBudget(seconds); }
 
   /**
    * @brief Returns the ViewWindowSettings for this window.
@@ -106,6 +120,7 @@ public:
   }
 
 private:
+  gpu::opengl::GLTextureTarget texture;         ///< The texture the kernel renders to.
   gpu::opencl::KernelExecutor kernel;           ///< The OpenCL kernel executor.
   wxAuiManager auiManager;                      ///< Manager for the frame layout.
   wxStatusBar& statusBar;                       ///< The status bar to update.
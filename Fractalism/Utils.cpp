@@ -1,8 +1,24 @@
 #include <fstream>
+#include <random>
+
+#if defined(_WIN32)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
 #include <Fractalism/Utils.hpp>
 
 namespace fractalism::utils {
+  namespace {
+    static inline long processId() {
+#if defined(_WIN32)
+      return static_cast<long>(_getpid());
+#else
+      return static_cast<long>(getpid());
+#endif
+    }
+  }
 
   std::string readFile(const char* filename) {
     std::ifstream file(filename, std::ios::binary);
@@ -20,4 +36,28 @@ namespace fractalism::utils {
 
     file.write(data, length);
   }
+
+  bool replaceFile(const std::filesystem::path& path, std::string_view data) {
+    std::error_code error;
+    if (path.has_parent_path()) {
+      std::filesystem::create_directories(path.parent_path(), error);
+    }
+    std::filesystem::path temporary = path;
+    temporary += std::format(".{}.{:08x}.tmp", processId(), std::random_device()());
+    bool written;
+    {
+      std::ofstream file(temporary, std::ios::binary);
+      file.write(data.data(), static_cast<std::streamsize>(data.size()));
+      file.close();
+      written = static_cast<bool>(file);
+    }
+    if (written) {
+      std::filesystem::rename(temporary, path, error);
+      if (!error) {
+        return true;
+      }
+    }
+    std::filesystem::remove(temporary, error);
+    return false;
+  }
 }
\ No newline at end of file
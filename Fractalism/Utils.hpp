@@ -3,8 +3,10 @@
 
 #include <cmath>
 #include <concepts>
+#include <filesystem>
 #include <format>
 #include <string>
+#include <string_view>
 #include <type_traits>
 
 namespace fractalism::utils {
@@ -24,6 +26,17 @@ std::string readFile(const char* filename);
  */
 void writeToFile(const char* filename, size_t length, const char* data);
 
+/**
+ * @brief Replaces a file in one step, so readers never see half of it.
+ * The data goes to a temporary file of its own first, named after the
+ * process and a random number so concurrent writers never share one, which
+ * is then renamed over the file. The directory is created if needed.
+ * @param path The file to replace.
+ * @param data The new contents.
+ * @return True if the file was replaced, false if it was left as it was.
+ */
+bool replaceFile(const std::filesystem::path& path, std::string_view data);
+
 /**
  * @brief Defines a multicomplex number system.
  * @param numberSystem The name of the number system.
@@ -31,15 +44,8 @@ void writeToFile(const char* filename, size_t length, const char* data);
  * @return The definition of the multicomplex number system as a string.
  */
 static inline std::string defineMulticomplexNumberSystem(std::string&& numberSystem, std::string&& elementSystem) {
-  return std::format("X("
-      /* number_system  */ "{0},"
-      /* element_system */ "{1},"
-      /* conj           */ "(a, b)," // not actually accurate. There are n unique, valid conjugates for Cn.
-      /* mul            */ "(sub_{1}(mul_{1}(a, c), mul_{1}(d, b)), add_{1}(mul_{1}(d, a), mul_{1}(b, c))),"
-      /* sqr            */ "(sub_{1}(sqr_{1}(a), sqr_{1}(b)), scale_{1}(mul_{1}(a, b), 2.0)),"
-      /* modulus_sq     */ "(modulus_sq_{1}(a) + modulus_sq_{1}(b)))",
-      numberSystem,
-      elementSystem);
+  // See KernelHeaders/number_system_constructions.h
+  return std::format("multicomplex_construction({}, {})", numberSystem, elementSystem);
 }
 
 /**
@@ -49,15 +55,8 @@ static inline std::string defineMulticomplexNumberSystem(std::string&& numberSys
  * @return The definition of the number system as a string.
  */
 static inline std::string cayleyDicksonConstruction(std::string&& numberSystem, std::string&& elementSystem) {
-  return std::format("X("
-      /* number_system  */ "{0},"
-      /* element_system */ "{1},"
-      /* conj           */ "(conj_{1}(a), neg_{1}(b)),"
-      /* mul            */ "(sub_{1}(mul_{1}(a, c), mul_{1}(conj_{1}(d), b)), add_{1}(mul_{1}(d, a), mul_{1}(b, conj_{1}(c)))),"
-      /* sqr            */ "(sub_{1}(sqr_{1}(a), mul_{1}(conj_{1}(b), b)), add_{1}(mul_{1}(b, a), mul_{1}(b, conj_{1}(a)))),"
-      /* modulus_sq     */ "(modulus_sq_{1}(a) + modulus_sq_{1}(b)))",
-      numberSystem,
-      elementSystem);
+  // See KernelHeaders/number_system_constructions.h
+  return std::format("cayley_dickson_construction({}, {})", numberSystem, elementSystem);
 }
 
 /**
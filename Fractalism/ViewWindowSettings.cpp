@@ -7,6 +7,7 @@ namespace fractalism {
         renderMode(renderMode),
         iterationModifier(125.0),
         iterationsPerFrame(100),
+        priority(1),
         view(space == options::Space::phase ? -0.5 : 0.0, 0.0, 0.0),
         camera(2.0, 1.0, 0.1) {}
 }
\ No newline at end of file
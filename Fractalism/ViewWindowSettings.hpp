@@ -34,6 +34,8 @@ struct ViewWindowSettings {
   inline cl_uint getIterationsPerFrame() const {
     switch (renderMode) {
     case options::RenderMode::escape:
+      [[fallthrough]];
+    case options::RenderMode::distance:
       return iterationsPerFrame;
     case options::RenderMode::translated:
       return 1;
@@ -50,6 +52,8 @@ struct ViewWindowSettings {
   inline cl_uint getMaxIterations() const {
     switch (renderMode) {
     case options::RenderMode::escape:
+      [[fallthrough]];
+    case options::RenderMode::distance:
       return static_cast<cl_uint>(std::clamp(
           iterationModifier * pow(2.0, log10((view.zoom))),
           minIterations,
@@ -64,7 +68,8 @@ struct ViewWindowSettings {
   gpu::types::Viewspace view;        ///< The viewspace settings.
   gpu::opengl::ArcballCamera camera; ///< The arcball camera settings.
   real iterationModifier;            ///< The iteration modifier.
-  cl_uint iterationsPerFrame;        ///< The number of iterations per frame.
+  cl_uint iterationsPerFrame;        ///< The number of iterations per frame, unless the frames are scheduled.
+  cl_uint priority;                  ///< The window's weight in splitting the frame time between windows.
   options::RenderMode renderMode;    ///< The render mode.
   options::Space space;              ///< The space setting.
 };